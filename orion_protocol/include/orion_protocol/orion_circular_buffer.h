@@ -46,15 +46,28 @@ void orion_circular_buffer_init(orion_circular_buffer_t * p_this, uint8_t * p_bu
 
 bool orion_circular_buffer_is_empty(const orion_circular_buffer_t * p_this);
 
+uint32_t orion_circular_buffer_get_size(const orion_circular_buffer_t * p_this);
+
+uint32_t orion_circular_buffer_get_free_size(const orion_circular_buffer_t * p_this);
+
 void orion_circular_buffer_add(orion_circular_buffer_t * p_this, const uint8_t * p_buffer, uint32_t size);
 
 uint32_t orion_circular_buffer_dequeue(orion_circular_buffer_t * p_this, uint8_t * p_buffer, uint32_t size);
 
 bool orion_circular_buffer_has_word(const orion_circular_buffer_t * p_this, uint8_t delimeter);
 
+uint32_t orion_circular_buffer_get_word_size(const orion_circular_buffer_t * p_this, uint8_t delimeter);
+
+bool orion_circular_buffer_drop_word(orion_circular_buffer_t * p_this, uint8_t delimeter);
+
 bool orion_circular_buffer_dequeue_word(orion_circular_buffer_t * p_this, uint8_t delimeter, uint8_t * p_buffer,
     uint32_t size, uint32_t * p_actual_size);
 
+bool orion_circular_buffer_peek_word(const orion_circular_buffer_t * p_this, uint8_t delimeter, uint8_t * p_buffer,
+    uint32_t size, uint32_t * p_actual_size);
+
+bool orion_circular_buffer_release_word(orion_circular_buffer_t * p_this, uint8_t delimeter);
+
 #ifdef __cplusplus
 }
 #endif
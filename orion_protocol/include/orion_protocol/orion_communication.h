@@ -56,6 +56,22 @@ typedef enum
 }
 orion_communication_error_t;
 
+typedef struct
+{
+  uint32_t bytes;
+  uint32_t calls;  // read or write system calls
+  uint32_t polls;  // select and ioctl system calls
+  uint32_t errors;
+}
+orion_communication_counters_t;
+
+typedef struct
+{
+  orion_communication_counters_t tx;
+  orion_communication_counters_t rx;
+}
+orion_communication_statistics_t;
+
 struct orion_communication_struct_t;
 
 typedef struct orion_communication_struct_t orion_communication_t;
@@ -63,12 +79,17 @@ typedef struct orion_communication_struct_t orion_communication_t;
 orion_communication_error_t orion_communication_new(orion_communication_t ** me);
 orion_communication_error_t orion_communication_delete(const orion_communication_t * me);
 
-ssize_t orion_communication_receive_available_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size);
-ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size,
+ssize_t orion_communication_receive_available_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size);
+ssize_t orion_communication_receive_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size,
   uint32_t timeout);
-bool orion_communication_has_available_buffer(const orion_communication_t * me);
-orion_communication_error_t orion_communication_send_buffer(const orion_communication_t * me, uint8_t *buffer,
+bool orion_communication_has_available_buffer(orion_communication_t * me);
+orion_communication_error_t orion_communication_send_buffer(orion_communication_t * me, uint8_t *buffer,
   uint32_t size, uint32_t timeout);
+/*
+  Safe to call from any thread, each of tx and rx sections is a consistent snapshot
+*/
+orion_communication_error_t orion_communication_get_statistics(const orion_communication_t * me,
+  orion_communication_statistics_t * statistics);
 
 #ifdef __cplusplus
 }
@@ -64,6 +64,13 @@ public:
     return (orion_communication_send_buffer(object_, buffer, size, timeout));
   }
 
+  orion_communication_statistics_t getStatistics()
+  {
+    orion_communication_statistics_t result;
+    orion_communication_get_statistics(object_, &result);
+    return (result);
+  }
+
   orion_communication_t* getObject()
   {
     return object_;
@@ -0,0 +1,267 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_CONTROL_H
+#define ORION_PROTOCOL_ORION_CONTROL_H
+
+#include <stdint.h>
+#include "orion_protocol/orion_header.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Message ids starting from ORION_CONTROL_MESSAGE_ID_FIRST are reserved for the protocol itself,
+  applications should not use them for own messages.
+*/
+#define ORION_CONTROL_MESSAGE_ID_FIRST (0xF0)
+#define ORION_CONTROL_MESSAGE_ID_HANDSHAKE (0xF0)
+#define ORION_CONTROL_MESSAGE_ID_SUBSCRIBE (0xF1)
+#define ORION_CONTROL_MESSAGE_ID_STREAM (0xF2)
+#define ORION_CONTROL_MESSAGE_ID_STREAM_ACK (0xF3)
+#define ORION_CONTROL_MESSAGE_ID_DELTA (0xF4)
+#define ORION_CONTROL_MESSAGE_ID_LINK (0xF5)
+#define ORION_CONTROL_MESSAGE_ID_BAUD (0xF6)
+#define ORION_CONTROL_MESSAGE_ID_ENVELOPE (0xFF)
+
+#define ORION_CONTROL_HANDSHAKE_VERSION (1)
+#define ORION_CONTROL_SUBSCRIBE_VERSION (1)
+#define ORION_CONTROL_STREAM_VERSION (1)
+#define ORION_CONTROL_DELTA_VERSION (1)
+#define ORION_CONTROL_LINK_VERSION (1)
+#define ORION_CONTROL_BAUD_VERSION (1)
+
+// Error codes of control results
+#define ORION_CONTROL_ERROR_UNKNOWN_MESSAGE (1)
+#define ORION_CONTROL_ERROR_NO_BANDWIDTH (2)
+#define ORION_CONTROL_ERROR_MALFORMED_MESSAGE (3)  // command shorter than its declared type
+#define ORION_CONTROL_ERROR_NOT_SUPPORTED (4)  // e.g. baud rate Minor could not switch to
+
+// Capabilities negotiated by handshake, result carries those requested by Major and supported by Minor
+#define ORION_CONTROL_CAPABILITY_CONTAINER (0x00000001)
+// Minor answers a command repeated with the same sequence id by its cached result instead of executing it again
+#define ORION_CONTROL_CAPABILITY_RESULT_CACHE (0x00000002)
+// Messages bigger than frame size are sent as fragment envelopes, see orion_transport_set_reassembly_buffer
+#define ORION_CONTROL_CAPABILITY_FRAGMENTS (0x00000004)
+// Frames which get smaller are sent compressed, see orion_transport_set_compression_buffer
+#define ORION_CONTROL_CAPABILITY_COMPRESSION (0x00000008)
+// Telemetry could be published as delta messages, see orion_delta.h
+#define ORION_CONTROL_CAPABILITY_DELTA (0x00000010)
+// Link parameters could be negotiated by ORION_CONTROL_MESSAGE_ID_LINK after handshake
+#define ORION_CONTROL_CAPABILITY_LINK (0x00000020)
+
+// Checksums of frame header, CRC16 is supported by every peer and is used till link is negotiated
+#define ORION_CONTROL_CHECKSUM_CRC16 (0x01)
+// Cheaper to compute on small targets, though misses more errors than CRC16
+#define ORION_CONTROL_CHECKSUM_FLETCHER16 (0x02)
+
+// Peers do not agree to frames smaller than this, so that any of them could still carry a fragment
+#define ORION_CONTROL_LINK_MIN_FRAME_SIZE (64)
+
+// Steps of baud rate switch
+#define ORION_CONTROL_BAUD_SWITCH (1)
+#define ORION_CONTROL_BAUD_PROBE (2)
+#define ORION_CONTROL_BAUD_COMMIT (3)
+#define ORION_CONTROL_BAUD_PATTERN_SIZE (32)
+
+// Envelope carries a frame of other messages instead of a single one, flags tell how it is packed
+#define ORION_ENVELOPE_VERSION (1)
+#define ORION_ENVELOPE_FLAG_CONTAINER (0x01)
+#define ORION_ENVELOPE_FLAG_FRAGMENT (0x02)
+// Envelope header is followed by message without its frame header compressed by orion_lz_compress
+#define ORION_ENVELOPE_FLAG_COMPRESSED (0x04)
+
+#pragma pack(push, 1)
+
+typedef struct
+{
+  orion_command_header_t header;
+  uint32_t capabilities;
+}
+orion_control_handshake_command_t;
+
+typedef struct
+{
+  orion_result_header_t header;
+  uint32_t capabilities;
+}
+orion_control_handshake_result_t;
+
+/*
+  Major offers the biggest frame it receives, baud rate it could switch communication to (0 when it could not),
+  stream window and checksums it supports. Minor answers with the best settings supported by both:
+  the smaller frame size, baud rate and window and a single checksum. Result goes with checksum used
+  before the command, Minor switches to the agreed settings right after sending it and Major after receiving it.
+  Frames with CRC16 are accepted whatever checksum is agreed, so a lost result is retried as usual.
+*/
+typedef struct
+{
+  orion_command_header_t header;
+  uint32_t frame_size;
+  uint32_t baud;
+  uint16_t window;
+  uint8_t checksums;
+}
+orion_control_link_command_t;
+
+typedef struct
+{
+  orion_result_header_t header;
+  uint32_t frame_size;
+  uint32_t baud;
+  uint16_t window;
+  uint8_t checksum;
+}
+orion_control_link_result_t;
+
+/*
+  Moves link to a faster baud rate, up to the one agreed by ORION_CONTROL_MESSAGE_ID_LINK. Switch is answered
+  at the current rate, then Minor moves to the new one and Major does so after receiving result. Major sends
+  a burst of probes, Minor echoes their pattern back, and when enough of them return intact Major commits.
+  Otherwise Major returns to the previous rate at once and Minor does so when no commit arrives within
+  timeout microseconds after the switch.
+*/
+typedef struct
+{
+  orion_command_header_t header;
+  uint8_t step;
+  uint32_t baud;
+  uint32_t timeout;
+  uint8_t pattern[ORION_CONTROL_BAUD_PATTERN_SIZE];
+}
+orion_control_baud_command_t;
+
+typedef struct
+{
+  orion_result_header_t header;
+  uint8_t step;
+  uint32_t baud;
+  uint8_t pattern[ORION_CONTROL_BAUD_PATTERN_SIZE];
+}
+orion_control_baud_result_t;
+
+/*
+  Asks Minor to publish telemetry message every period microseconds, 0 cancels subscription.
+  Result carries period granted by Minor, which could be longer than requested to fit link bandwidth,
+  and average period achieved since subscription (0 till the second message is published).
+  Subscribing again with the same period only reports these values.
+*/
+typedef struct
+{
+  orion_command_header_t header;
+  uint8_t message_id;
+  uint32_t period;
+}
+orion_control_subscribe_command_t;
+
+typedef struct
+{
+  orion_result_header_t header;
+  uint8_t message_id;
+  uint32_t period;
+  uint32_t achieved_period;
+}
+orion_control_subscribe_result_t;
+
+/*
+  Segment of reliable stream (see orion_stream.h), followed by segment_size bytes of data starting at offset,
+  the last segment could be shorter. Segments carry unsolicited sequence id and have no result,
+  receiver answers every one of them by stream acknowledgment.
+*/
+typedef struct
+{
+  orion_command_header_t header;
+  uint16_t stream_id;
+  uint16_t segment_size;
+  uint32_t offset;
+  uint32_t total_size;
+}
+orion_control_stream_segment_t;
+
+/*
+  Segments before cumulative are received, bit n of selective tells that segment cumulative + 1 + n is received too
+*/
+typedef struct
+{
+  orion_command_header_t header;
+  uint16_t stream_id;
+  uint32_t cumulative;
+  uint32_t selective;
+}
+orion_control_stream_ack_t;
+
+/*
+  Telemetry message of message_id sent as keyframe or as difference against the last keyframe (see orion_delta.h).
+  Keyframe is followed by the message without its frame header. Delta is followed by runs of XOR of message and
+  keyframe, each is a token byte and literals: high 5 bits of token count zero bytes before literals,
+  low 3 bits are count of literals minus one. 31 zero bytes make token of their own without literals.
+  Bytes after the last run equal keyframe.
+*/
+#define ORION_CONTROL_DELTA_FLAG_KEYFRAME (0x01)
+
+typedef struct
+{
+  orion_command_header_t header;
+  uint8_t message_id;
+  uint8_t flags;
+  uint8_t keyframe_id;
+}
+orion_control_delta_t;
+
+/*
+  Container envelope is followed by records of one byte size and a message without its frame header,
+  the whole container is protected by single CRC and a pair of frame delimiters.
+*/
+typedef struct
+{
+  orion_frame_header_t frame;
+  orion_common_header_t common;
+  uint8_t flags;
+}
+orion_envelope_header_t;
+
+/*
+  Fragment envelope is followed by bytes of a message without its frame header, starting at offset.
+  Fragments of a transfer are sent in order without waiting for each other, the message is complete when
+  all total_size bytes arrived. Each fragment has CRC of its own, loss of any of them drops the transfer.
+*/
+typedef struct
+{
+  orion_envelope_header_t envelope;
+  uint16_t transfer_id;
+  uint32_t offset;
+  uint32_t total_size;
+}
+orion_fragment_header_t;
+
+#pragma pack(pop)
+
+#define ORION_ENVELOPE_MAX_RECORD_SIZE (UINT8_MAX)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_CONTROL_H
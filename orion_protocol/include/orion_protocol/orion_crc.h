@@ -33,6 +33,10 @@ extern "C"
 #endif
 
 uint16_t orion_crc_calculate_crc16(const uint8_t *data, size_t length);
+/*
+  Fletcher-16 checksum, high byte is the sum of sums
+*/
+uint16_t orion_crc_calculate_fletcher16(const uint8_t *data, size_t length);
 
 #ifdef __cplusplus
 }
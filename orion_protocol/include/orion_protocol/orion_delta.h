@@ -0,0 +1,108 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_DELTA_H
+#define ORION_PROTOCOL_ORION_DELTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "orion_protocol/orion_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Delta coding of periodic messages which change little between samples, one encoder and decoder per message id.
+  Deltas are taken against the last keyframe rather than the previous message: telemetry is not acknowledged,
+  so a lost delta costs only itself, while a lost keyframe costs deltas till the next one. Keyframe is sent
+  every keyframe_interval messages, when size of message changes and when delta would not be smaller.
+  Both sides keep keyframe in buffer given by application, so no memory is allocated.
+*/
+
+// The biggest packet made of message of @size bytes
+#define ORION_DELTA_MAX_PACKET_SIZE(size) (sizeof(orion_control_delta_t) + (size) - sizeof(orion_frame_header_t))
+
+typedef enum
+{
+  ORION_DELTA_ERROR_NONE = 0,
+  ORION_DELTA_ERROR_NO_KEYFRAME = -1,  // keyframe of delta was lost, wait for the next one
+  ORION_DELTA_ERROR_DECODING_FAILED = -2,
+  ORION_DELTA_ERROR_BUFFER_TOO_SMALL = -3,
+  ORION_DELTA_ERROR_UNKNOWN = -4
+}
+orion_delta_error_t;
+
+typedef struct
+{
+  uint8_t * keyframe_;
+  uint32_t capacity_;
+  uint32_t size_;  // 0 till the first keyframe
+  uint8_t keyframe_id_;
+  uint32_t keyframe_interval_;
+  uint32_t deltas_;  // sent since the last keyframe
+}
+orion_delta_encoder_t;
+
+typedef struct
+{
+  uint8_t * keyframe_;
+  uint32_t capacity_;
+  uint32_t size_;
+  uint8_t keyframe_id_;
+}
+orion_delta_decoder_t;
+
+/*
+  @keyframe - buffer of the biggest message encoded
+  @keyframe_interval - every that many messages go as keyframe, 1 sends keyframes only
+*/
+void orion_delta_encoder_init(orion_delta_encoder_t * me, uint8_t * keyframe, uint32_t capacity,
+  uint32_t keyframe_interval);
+/*
+  Makes the next message a keyframe, e.g. when receiver starts over
+*/
+void orion_delta_encoder_reset(orion_delta_encoder_t * me);
+/*
+  Writes delta message of @message starting with orion_command_header_t into @packet, which has to take
+  ORION_DELTA_MAX_PACKET_SIZE(size) bytes. Returns size of packet, sequence id of it is unsolicited.
+*/
+ssize_t orion_delta_encode(orion_delta_encoder_t * me, const uint8_t * message, uint32_t size, uint8_t * packet,
+  uint32_t packet_size);
+
+void orion_delta_decoder_init(orion_delta_decoder_t * me, uint8_t * keyframe, uint32_t capacity);
+/*
+  Reconstructs message from delta packet into @message with zero CRC in its frame header.
+  Returns size of message or orion_delta_error_t.
+*/
+ssize_t orion_delta_decode(orion_delta_decoder_t * me, const uint8_t * packet, uint32_t size, uint8_t * message,
+  uint32_t message_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_DELTA_H
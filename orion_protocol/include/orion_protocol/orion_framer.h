@@ -36,11 +36,18 @@ extern "C"
 
 #define ORION_FRAMER_FRAME_DELIMETER (0)
 
+/*
+  Worst case size of encoded frame for @size bytes of data:
+  one code byte per 254 data bytes plus leading code byte and two delimiters
+*/
+#define ORION_FRAMER_MAX_ENCODED_SIZE(size) ((size) + ((size) / 254) + 3)
+
 typedef enum
 {
   ORION_FRM_ERROR_NONE = 0,
   ORION_FRM_ERROR_DECODING_FAILED = -1,
-  ORION_FRM_ERROR_UNKNOWN = -2
+  ORION_FRM_ERROR_BUFFER_TOO_SMALL = -2,
+  ORION_FRM_ERROR_UNKNOWN = -3
 }
 orion_framer_error_t;
 
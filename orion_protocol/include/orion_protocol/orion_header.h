@@ -31,6 +31,18 @@ extern "C"
 {
 #endif
 
+// Messages sent by Minor on its own, not as a result of command, carry this sequence id
+#define ORION_UNSOLICITED_SEQUENCE_ID (0)
+
+/*
+  Logical channels sharing one link take separate ranges of sequence ids, the top bits of sequence id
+  carry the channel. Minor echoes sequence id in result, so results find their channel and cached results
+  of different channels never mix, while Minor knows nothing of channels.
+*/
+#define ORION_CHANNEL_COUNT (8)
+#define ORION_CHANNEL_SEQUENCE_BITS (13)
+#define ORION_CHANNEL_OF_SEQUENCE_ID(sequence_id) ((uint8_t)((sequence_id) >> ORION_CHANNEL_SEQUENCE_BITS))
+
 #pragma pack(push, 1)
 
 typedef struct
@@ -0,0 +1,112 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_INSTRUMENTATION_HPP
+#define ORION_PROTOCOL_ORION_INSTRUMENTATION_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+#include "orion_protocol/orion_major.hpp"
+
+namespace orion
+{
+
+/*
+  Log-linear histogram of microsecond values with relative error below 1/16 and fixed footprint.
+  Every record is a relaxed atomic increment, so it could be updated and read from any thread.
+*/
+class LatencyHistogram
+{
+public:
+  static const uint32_t SUB_BUCKET_BITS = 4;
+  static const uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  static const uint32_t BUCKET_COUNT = (32 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  LatencyHistogram();
+
+  void record(uint32_t value);
+
+  uint32_t getCount() const;
+  uint32_t getMax() const;
+
+  /*
+    @percentile - from 0 to 100
+    Returns the highest value which is equivalent to the one at percentile
+  */
+  uint32_t getValueAtPercentile(double percentile) const;
+
+private:
+  static uint32_t getIndex(uint32_t value);
+  static uint32_t getHighestValue(uint32_t index);
+
+  std::atomic<uint32_t> counts_[BUCKET_COUNT];
+  std::atomic<uint32_t> max_;
+};
+
+/*
+  Latency, attempts and outcome of Major::invoke per message_id.
+  Memory for message_id is allocated on its first invoke, after that recording does not lock or allocate.
+*/
+class Instrumentation
+{
+public:
+  static const uint32_t MESSAGE_ID_COUNT = 256;
+  static const uint32_t ATTEMPTS_COUNT = 8;  // last one counts all invokes with more attempts
+  static const uint32_t OUTCOME_COUNT = ORION_MAJOR_ERROR_UNKNOW + 1;
+
+  struct Message
+  {
+    LatencyHistogram latency;  // from the first send till result, only invokes with result received
+    std::atomic<uint32_t> attempts[ATTEMPTS_COUNT];
+    std::atomic<uint32_t> outcomes[OUTCOME_COUNT];
+  };
+
+  Instrumentation();
+  ~Instrumentation();
+
+  void record(uint8_t message_id, uint32_t latency, uint8_t attempts, orion_major_error_t outcome);
+
+  /*
+    Returns nullptr if message_id was never invoked
+  */
+  const Message* getMessage(uint8_t message_id) const;
+
+  /*
+    Writes one line per invoked message_id: count, p50, p90, p99, p99.9 and max latency in microseconds,
+    attempts and failures
+  */
+  void dump(std::ostream &output) const;
+
+private:
+  Instrumentation(const Instrumentation&) = delete;
+  Instrumentation& operator=(const Instrumentation&) = delete;
+
+  Message* getOrCreateMessage(uint8_t message_id);
+
+  std::atomic<Message*> messages_[MESSAGE_ID_COUNT];
+};
+
+}  // namespace orion
+
+#endif  // ORION_PROTOCOL_ORION_INSTRUMENTATION_HPP
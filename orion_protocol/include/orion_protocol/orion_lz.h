@@ -0,0 +1,83 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_LZ_H
+#define ORION_PROTOCOL_ORION_LZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Byte oriented LZ77 codec for frames of slow links, close to LZ4 block format.
+  Data is a chain of sequences: token byte with count of literals in high nibble and
+  length of match minus ORION_LZ_MIN_MATCH in low nibble (15 continues in bytes up to first one below 255),
+  literals, little endian 16 bit offset of match back into output. Last sequence has literals only.
+  Decompression needs no memory besides output, so it fits Minor. Compression needs hash table of
+  2^table_bits positions: Major uses big one for ratio, Minor could compress with a tiny one.
+*/
+#define ORION_LZ_MIN_MATCH (4)
+#define ORION_LZ_MAX_INPUT_SIZE (UINT16_MAX + 1)
+#define ORION_LZ_MIN_TABLE_BITS (6)
+#define ORION_LZ_MAX_TABLE_BITS (16)
+#define ORION_LZ_TABLE_SIZE(table_bits) (sizeof(uint16_t) << (table_bits))
+
+/*
+  Worst case size of compressed @size bytes: input that does not compress gets a token and length bytes
+*/
+#define ORION_LZ_MAX_COMPRESSED_SIZE(size) ((size) + ((size) / 255) + 2)
+
+typedef enum
+{
+  ORION_LZ_ERROR_NONE = 0,
+  ORION_LZ_ERROR_DECODING_FAILED = -1,
+  ORION_LZ_ERROR_BUFFER_TOO_SMALL = -2,
+  ORION_LZ_ERROR_UNKNOWN = -3
+}
+orion_lz_error_t;
+
+/*
+  @table - ORION_LZ_TABLE_SIZE(table_bits) bytes, contents do not have to be kept between calls
+  Returns compressed size or ORION_LZ_ERROR_BUFFER_TOO_SMALL, so passing output smaller than input
+  stops compression as soon as it can not pay off.
+*/
+ssize_t orion_lz_compress(const uint8_t * input, uint32_t input_size, uint8_t * output, uint32_t output_size,
+  uint16_t * table, uint32_t table_bits);
+
+/*
+  Returns decompressed size, ORION_LZ_ERROR_DECODING_FAILED for malformed input
+  or ORION_LZ_ERROR_BUFFER_TOO_SMALL. Never reads or writes outside of given buffers.
+*/
+ssize_t orion_lz_decompress(const uint8_t * input, uint32_t input_size, uint8_t * output, uint32_t output_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_LZ_H
@@ -26,11 +26,22 @@
 
 #include "orion_protocol/orion_transport.hpp"
 #include "orion_protocol/orion_header.hpp"
+#include "orion_protocol/orion_control.h"
+#include "orion_protocol/orion_delta.h"
 #include "orion_protocol/orion_timeout.hpp"
+#include "orion_protocol/orion_rtt_estimator.hpp"
 #include "orion_protocol/orion_assert.h"
 #include <stdint.h>
 #include <cstring>
 #include <cstdio>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 
 typedef enum
 {
@@ -44,6 +55,7 @@ typedef enum
   ORION_MAJOR_ERROR_APPLICATION_ERROR_RECEIVED,
   ORION_MAJOR_ERROR_DIFFERENT_MESSAGE_ID_RECEIVED,
   ORION_MAJOR_ERROR_NOT_COMPATIBLE_PACKET_VERSION,
+  ORION_MAJOR_ERROR_RESULT_TOO_BIG,
   ORION_MAJOR_ERROR_UNKNOW
 }
 orion_major_error_t;
@@ -51,82 +63,580 @@ orion_major_error_t;
 namespace orion
 {
 
+typedef struct
+{
+  uint32_t invocations;
+  uint32_t successes;
+  uint32_t retries;
+  uint32_t timeouts;
+  uint32_t send_errors;
+  uint32_t foreign_packets;  // results with sequence id of other command, e.g. late replies to previous retries
+  uint32_t application_errors;
+  uint32_t validation_errors;  // wrong header size, message id or version of result or result too big
+  uint32_t unsolicited_messages;  // messages pushed by Minor and passed to handlers
+  uint32_t unhandled_messages;  // messages pushed by Minor without registered handler or too short for it
+  uint32_t dropped_deltas;  // delta messages which could not be reconstructed, e.g. after their keyframe was lost
+}
+MajorStatistics;
+
+class Instrumentation;
+
+/*
+  Could be shared by any number of threads. Commands are sent one by one, while waiting callers take turns
+  in reading transport and every received result is delivered to the caller with the same sequence id.
+  Messages pushed by Minor are passed to handlers by whichever thread reads transport at the moment,
+  spinOnce() reads transport when there are no commands in flight.
+  Asynchronous invokes share mailboxes and receiving with blocking ones and are completed by poll(),
+  so an event loop could drive any number of them from a single thread.
+*/
 class Major
 {
 public:
-  explicit Major(Transport *transport) : transport_(transport) {}
+  explicit Major(Transport *transport) : transport_(transport), result_buffer_(transport->getFrameSize()) {}
 
   Major(Transport *transport, uint32_t retry_timeout, uint8_t retry_count) : transport_(transport),
     default_timeout_(retry_timeout),
-    default_retry_count_(retry_count) {}
+    default_retry_count_(retry_count),
+    result_buffer_(transport->getFrameSize()) {}
+
+  /*
+    @buffer_size - biggest result packet expected, other constructors take frame size of transport
+  */
+  Major(Transport *transport, uint32_t retry_timeout, uint8_t retry_count, uint32_t buffer_size) :
+    transport_(transport),
+    default_timeout_(retry_timeout),
+    default_retry_count_(retry_count),
+    result_buffer_(buffer_size) {}
 
   template<class Command, class Result>
   orion_major_error_t invoke(Command command, Result *result)
   {
-    return (this->invoke<Command, Result>(command, result, this->default_timeout_, this->default_retry_count_));
+    return (this->invokeCommand<Command, Result>(command, result, this->default_timeout_, this->default_retry_count_,
+      nullptr != this->rtt_));
   }
 
   template<class Command, class Result>
   orion_major_error_t invoke(Command command, Result *result, uint32_t retry_timeout)
   {
-    return (this->invoke<Command, Result>(command, result, retry_timeout, this->default_retry_count_));
+    return (this->invokeCommand<Command, Result>(command, result, retry_timeout, this->default_retry_count_, false));
   }
 
   template<class Command, class Result>
   orion_major_error_t invoke(Command command, Result *result, uint32_t retry_timeout, uint8_t retry_count)
+  {
+    return (this->invokeCommand<Command, Result>(command, result, retry_timeout, retry_count, false));
+  }
+
+  /*
+    Message of runtime size, e.g. header followed by as many elements as needed, bounded by frame size
+  */
+  struct Payload
+  {
+    uint8_t *data;
+    uint32_t size;
+  };
+
+  /*
+    Sends only command.size bytes and receives result of any size up to result->size,
+    which is set to the size of received result on success. Content of result is undefined on failure.
+    @command - starts with CommandHeader
+    @result - starts with ResultHeader with expected message id and version
+  */
+  orion_major_error_t invoke(Payload command, Payload *result)
+  {
+    return (this->invokePayload(command, result, this->default_timeout_, this->default_retry_count_,
+      nullptr != this->rtt_));
+  }
+
+  orion_major_error_t invoke(Payload command, Payload *result, uint32_t retry_timeout)
+  {
+    return (this->invokePayload(command, result, retry_timeout, this->default_retry_count_, false));
+  }
+
+  orion_major_error_t invoke(Payload command, Payload *result, uint32_t retry_timeout, uint8_t retry_count)
+  {
+    return (this->invokePayload(command, result, retry_timeout, retry_count, false));
+  }
+
+  /*
+    Commands of any type invoked together: all of them are sent with a single write
+    and results are gathered by sequence id, so the whole batch costs about one round trip.
+    Commands and results are kept by pointer and should outlive invoke of the batch,
+    sequence id of every command is assigned by Major.
+  */
+  class Batch
+  {
+  public:
+    template<class Command, class Result>
+    size_t add(Command *command, Result *result)
+    {
+      ORION_ASSERT_NOT_NULL(command);
+      ORION_ASSERT_NOT_NULL(result);
+      ORION_ASSERT(sizeof(Command) >= sizeof(CommandHeader));
+      ORION_ASSERT(sizeof(Result) >= sizeof(ResultHeader));
+
+      Item item;
+      item.command = reinterpret_cast<uint8_t*>(command);
+      item.command_size = sizeof(Command);
+      item.result = reinterpret_cast<uint8_t*>(result);
+      item.result_size = sizeof(Result);
+      item.status = ORION_MAJOR_ERROR_UNKNOW;
+      this->items_.push_back(item);
+      return (this->items_.size() - 1);
+    }
+
+    size_t size() const
+    {
+      return (this->items_.size());
+    }
+
+    orion_major_error_t getStatus(size_t index) const
+    {
+      ORION_ASSERT(index < this->items_.size());
+      return (this->items_[index].status);
+    }
+
+    // Keeps allocated memory, so the same batch could be refilled every control cycle without allocations
+    void clear()
+    {
+      this->items_.clear();
+    }
+
+  private:
+    friend class Major;
+
+    struct Item
+    {
+      uint8_t *command;
+      uint32_t command_size;
+      uint8_t *result;
+      uint32_t result_size;
+      orion_major_error_t status;
+    };
+
+    std::vector<Item> items_;
+    std::vector<uint8_t> replies_;
+    std::vector<orion_transport_packet_t> packets_;
+  };
+
+  /*
+    Returns ORION_MAJOR_ERROR_NONE when every command succeeded, otherwise status of the first failed one.
+    Only commands without result are sent again on retry.
+  */
+  orion_major_error_t invoke(Batch *batch)
+  {
+    return (this->invoke(batch, this->default_timeout_, this->default_retry_count_));
+  }
+
+  orion_major_error_t invoke(Batch *batch, uint32_t retry_timeout)
+  {
+    return (this->invoke(batch, retry_timeout, this->default_retry_count_));
+  }
+
+  orion_major_error_t invoke(Batch *batch, uint32_t retry_timeout, uint8_t retry_count);
+
+  typedef std::function<void(orion_major_error_t status)> Completion;
+
+  /*
+    Sends command and returns at once, completion is called by poll() when result arrives or retries run out.
+    Result is kept by pointer and should outlive completion, it is filled before completion is called.
+  */
+  template<class Command, class Result>
+  void invokeAsync(Command command, Result *result, Completion completion)
+  {
+    this->invokeAsyncCommand<Command, Result>(command, result, completion, this->default_timeout_,
+      this->default_retry_count_, nullptr != this->rtt_);
+  }
+
+  template<class Command, class Result>
+  void invokeAsync(Command command, Result *result, Completion completion, uint32_t retry_timeout)
+  {
+    this->invokeAsyncCommand<Command, Result>(command, result, completion, retry_timeout,
+      this->default_retry_count_, false);
+  }
+
+  template<class Command, class Result>
+  void invokeAsync(Command command, Result *result, Completion completion, uint32_t retry_timeout,
+    uint8_t retry_count)
+  {
+    this->invokeAsyncCommand<Command, Result>(command, result, completion, retry_timeout, retry_count, false);
+  }
+
+  /*
+    Reads transport for at most timeout, but not longer than till the next deadline of asynchronous invokes,
+    then resends or completes those which are due. Meant to be called by event loop when link has data
+    to read and when timer set to getPollTimeout() expires, completions run on the calling thread.
+    Should not be called by several threads at once. Returns count of completed invokes.
+  */
+  size_t poll(uint32_t timeout);
+
+  // Microseconds till the earliest deadline of asynchronous invokes, UINT32_MAX when there are none
+  uint32_t getPollTimeout() const;
+
+  /*
+    Registers handler of messages with given id pushed by Minor, Message should start with CommandHeader.
+    Handler runs on the thread reading transport, so it should be short and must not invoke commands.
+    Messages published as deltas (see ORION_CONTROL_CAPABILITY_DELTA) reach handler reconstructed.
+  */
+  template<class Message>
+  void setHandler(uint8_t message_id, std::function<void(const Message&)> handler)
+  {
+    ORION_ASSERT(sizeof(Message) >= sizeof(CommandHeader));
+    ORION_ASSERT(message_id < ORION_CONTROL_MESSAGE_ID_FIRST);
+
+    std::lock_guard<std::mutex> lock(this->handlers_mutex_);
+    this->handlers_[message_id] = [handler](const uint8_t *buffer, size_t size) -> bool
+      {
+        if (size < sizeof(Message))
+        {
+          return (false);
+        }
+        Message message;
+        std::memcpy(reinterpret_cast<uint8_t*>(&message), buffer, sizeof(Message));
+        handler(message);
+        return (true);
+      };
+  }
+
+  void removeHandler(uint8_t message_id)
+  {
+    std::lock_guard<std::mutex> lock(this->handlers_mutex_);
+    this->handlers_.erase(message_id);
+  }
+
+  /*
+    Receives and dispatches one message pushed by Minor, waits for it at most timeout.
+    Returns false if nothing was received or other thread reads transport at the moment,
+    in the latter case messages are dispatched by that thread.
+  */
+  bool spinOnce(uint32_t timeout);
+
+  /*
+    Asks Minor to publish telemetry message every period microseconds, 0 cancels subscription.
+    @granted_period - period Minor agreed to, could be longer than requested to fit link bandwidth
+    @achieved_period - average period of publications so far, subscribing with the same period just reports it
+  */
+  orion_major_error_t subscribe(uint8_t message_id, uint32_t period, uint32_t *granted_period = nullptr,
+    uint32_t *achieved_period = nullptr);
+
+  /*
+    Sends data bigger than a frame to Minor over a lossy link with long round trip (see orion_stream.h):
+    up to window segments of segment_size bytes are in flight, only segments Minor did not acknowledge are sent
+    again after retry timeout of Major. Minor needs a stream buffer big enough for the whole data.
+    Acknowledgments are received by this call itself or by the thread reading transport at the moment.
+    Acknowledgments reach the call by stream id, so calls of several threads do not disturb each other, although
+    Minor with a single stream buffer keeps only the newest stream. Segments go with priority of
+    ORION_CONTROL_MESSAGE_ID_STREAM.
+    @timeout - microseconds for the whole transfer
+  */
+  orion_major_error_t sendStream(const uint8_t *data, uint32_t size, uint16_t segment_size, uint32_t window,
+    uint32_t timeout);
+
+  /*
+    Confines sequence ids of commands to the range of logical channel, so that Majors of several clients
+    could share one link through Multiplexer (see orion_multiplexer.hpp). Should be called before any invoke.
+  */
+  void setChannel(uint8_t channel);
+
+  /*
+    Negotiates optional protocol features with Minor, should be called once link is up and before Major is shared.
+    Containers are enabled for sending when Minor supports them. With ORION_CONTROL_CAPABILITY_RESULT_CACHE
+    retries resend the first frame with its sequence id and Minor answers them without executing command again.
+    With ORION_CONTROL_CAPABILITY_COMPRESSION commands are compressed whenever that makes them smaller.
+    With ORION_CONTROL_CAPABILITY_DELTA Minor could publish telemetry as deltas, handlers still get whole messages.
+    With ORION_CONTROL_CAPABILITY_LINK frame size, checksum, stream window and baud rate are negotiated too
+    (see setLinkLimits). Link starts from defaults on every handshake, agreed settings are cached in transport.
+  */
+  orion_major_error_t handshake(uint32_t capabilities = ORION_CONTROL_CAPABILITY_CONTAINER);
+
+  // Capabilities agreed by the last successful handshake
+  uint32_t getCapabilities() const
+  {
+    return (this->capabilities_);
+  }
+
+  /*
+    Offered by handshake with ORION_CONTROL_CAPABILITY_LINK, frame size and window are those of Major itself.
+    @max_baud - the fastest baud rate communication could switch to, 0 when it could not
+    @checksums - ORION_CONTROL_CHECKSUM_* Major accepts, CRC16 is always among them
+  */
+  void setLinkLimits(uint32_t max_baud, uint8_t checksums)
+  {
+    this->max_baud_ = max_baud;
+    this->checksums_ = checksums | ORION_CONTROL_CHECKSUM_CRC16;
+  }
+
+  // Link settings agreed by the last handshake, window of sendStream is limited by them
+  orion_transport_link_t getLink() const
+  {
+    return (this->link_);
+  }
+
+  /*
+    Moves link from the conservative baud rate it came up at to the fastest one which works, should be called
+    after handshake agreed the link and before Major is shared. The agreed rate is tried first, then standard
+    rates below it. Each is verified by a burst of probes echoed by Minor and kept when the share of lost or
+    damaged ones is within limit, otherwise both peers return to the previous rate.
+    @set_baud - switches communication of Major, e.g. by SerialPort::setBaud, returns false when it could not
+    @baud - rate communication is at, set to the rate link is left at
+    @max_loss_per_mille - probes out of a thousand which could be lost at a rate still kept
+  */
+  orion_major_error_t rampBaud(const std::function<bool(uint32_t baud)> &set_baud, uint32_t *baud,
+    uint32_t probes = 16, uint32_t max_loss_per_mille = 100);
+
+  /*
+    Safe to call from any thread, every counter is read atomically
+  */
+  MajorStatistics getStatistics() const;
+
+  /*
+    Records latency, attempts and outcome of every invoke, nullptr disables it.
+    Instrumentation should outlive Major, one instance could be shared by several of them.
+  */
+  void setInstrumentation(Instrumentation *instrumentation)
+  {
+    this->instrumentation_ = instrumentation;
+  }
+
+  /*
+    Retry timeout of invokes without explicit one is derived from measured round trip time instead of default one
+    and doubles on every next attempt. Default timeout is used till the first round trip is measured.
+    @per_message_id - separate estimate for every message_id, link estimate is used till message_id is measured
+    Should be called before Major is shared.
+  */
+  void setAdaptiveTimeout(uint32_t min_timeout, uint32_t max_timeout, bool per_message_id = false);
+
+  /*
+    Returns false if adaptive timeout is not enabled or message_id has no estimate of its own yet
+  */
+  bool getRttStatistics(RttStatistics *statistics) const;
+  bool getRttStatistics(uint8_t message_id, RttStatistics *statistics) const;
+
+  enum Interval { Microsecond = 1, Millisecond = 1000 * Microsecond, Second = 1000 * Millisecond };
+
+  /*
+    Senders waiting for the link are served by priority, senders of the same priority in any order.
+    Transport is never interrupted in the middle of a write, so urgent command waits at most for one write.
+  */
+  enum Priority { Urgent = 0, Control = 1, Bulk = 2 };
+
+  // Priority of commands with message_id, Control unless set
+  void setPriority(uint8_t message_id, Priority priority);
+
+  /*
+    Splits writes of several packets, e.g. batches, so that none of them occupies link of link_rate bytes
+    per second for longer than max_write_time microseconds, urgent commands get the link between the parts.
+    Packet bigger than that is split into parts of its fragments once Minor supports them (see handshake),
+    otherwise it is still written at once. Zero max_write_time disables splitting.
+  */
+  void setMaxWriteTime(uint32_t max_write_time, uint32_t link_rate);
+
+private:
+  template<class Command, class Result>
+  orion_major_error_t invokeCommand(Command command, Result *result, uint32_t retry_timeout, uint8_t retry_count,
+    bool adaptive)
   {
     ORION_ASSERT_NOT_NULL(this->transport_);
     ORION_ASSERT(sizeof(Command) >= sizeof(CommandHeader));
     ORION_ASSERT(sizeof(Result) >= sizeof(ResultHeader));
+    ORION_ASSERT(sizeof(Result) <= this->result_buffer_.size());
 
     CommandHeader *command_header = reinterpret_cast<CommandHeader*>(&command);
     ResultHeader *result_header = reinterpret_cast<ResultHeader*>(result);
+    uint8_t reply[sizeof(Result)];
+    Mailbox mailbox(reply, sizeof(reply));
+    uint8_t frame[ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(Command))];
 
-    orion_major_error_t return_value = ORION_MAJOR_ERROR_UNKNOW;
-    ssize_t size_received = -1;
-    while ((retry_count > 0) && (size_received < 0))
+    std::chrono::steady_clock::time_point start_time;
+    if (nullptr != this->instrumentation_)
     {
-      Timeout timeout(retry_timeout);
-      command_header->common.sequence_id = ++(this->sequence_id_);
-      orion_transport_error_t send_status = this->transport_->sendPacket(reinterpret_cast<uint8_t*>(&command),
-        sizeof(command), retry_timeout);
-      if (ORION_TRAN_ERROR_NONE == send_status)
-      {
-          size_received = this->processPacket(command_header, result_header, timeout);
-      }
-      retry_count--;
+      start_time = std::chrono::steady_clock::now();
     }
-    if (0 > size_received)
+    uint8_t attempts = 0;
+    ssize_t size_received = this->exchangePacket(reinterpret_cast<uint8_t*>(&command), sizeof(command), &mailbox,
+      frame, sizeof(frame), retry_timeout, retry_count, adaptive, &attempts);
+    orion_major_error_t return_value = this->completeResult(command_header, result_header, sizeof(Result), reply,
+      size_received);
+    if (nullptr != this->instrumentation_)
     {
-      return_value = ORION_MAJOR_ERROR_TIMEOUT;
+      this->recordInstrumentation(command_header->common.message_id, start_time, attempts, return_value);
     }
-    else
+    return (return_value);
+  }
+
+  orion_major_error_t invokePayload(Payload command, Payload *result, uint32_t retry_timeout, uint8_t retry_count,
+    bool adaptive);
+
+  struct Mailbox
+  {
+    Mailbox(uint8_t *buffer, uint32_t capacity) : buffer(buffer), capacity(capacity) {}
+
+    uint8_t *buffer;
+    uint32_t capacity;
+    uint16_t sequence_id = 0;
+    ssize_t size = -1;
+    bool ready = false;
+    bool async = false;  // nobody waits on condition
+    bool waiting = false;  // owner sleeps on condition right now
+    std::condition_variable condition;
+  };
+
+  struct AsyncRequest
+  {
+    AsyncRequest(uint32_t reply_size, Completion completion) : reply(reply_size),
+      mailbox(reply.data(), reply_size),
+      completion(completion)
     {
-      return_value = this->validateResult(command_header, result_header, size_received);
-      if (ORION_MAJOR_ERROR_NONE == return_value)
-      {
-        std::memcpy(reinterpret_cast<uint8_t*>(result), this->result_buffer_, sizeof(Result));
-      }
+      mailbox.async = true;
     }
-    return (return_value);
+
+    std::vector<uint8_t> command;
+    std::vector<uint8_t> reply;
+    std::vector<uint8_t> frame;
+    ssize_t encoded_size = -1;
+    Mailbox mailbox;
+    uint8_t *result = nullptr;
+    uint32_t result_size = 0;
+    Completion completion;
+    uint32_t retry_timeout = 0;
+    uint8_t retry_count = 0;
+    uint8_t attempts = 0;
+    bool adaptive = false;
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point send_time;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  template<class Command, class Result>
+  void invokeAsyncCommand(Command command, Result *result, Completion completion, uint32_t retry_timeout,
+    uint8_t retry_count, bool adaptive)
+  {
+    ORION_ASSERT_NOT_NULL(this->transport_);
+    ORION_ASSERT_NOT_NULL(result);
+    ORION_ASSERT(sizeof(Command) >= sizeof(CommandHeader));
+    ORION_ASSERT(sizeof(Result) >= sizeof(ResultHeader));
+    ORION_ASSERT(sizeof(Result) <= this->result_buffer_.size());
+    ORION_ASSERT(retry_count > 0);
+
+    std::unique_ptr<AsyncRequest> request(new AsyncRequest(sizeof(Result), completion));
+    const uint8_t *command_data = reinterpret_cast<const uint8_t*>(&command);
+    request->command.assign(command_data, command_data + sizeof(command));
+    request->result = reinterpret_cast<uint8_t*>(result);
+    request->result_size = sizeof(Result);
+    request->retry_timeout = retry_timeout;
+    request->retry_count = retry_count;
+    request->adaptive = adaptive;
+    this->startAsync(std::move(request));
   }
 
-  enum Interval { Microsecond = 1, Millisecond = 1000 * Microsecond, Second = 1000 * Millisecond };
+  void startAsync(std::unique_ptr<AsyncRequest> request);
+  void sendAsync(AsyncRequest *request);
+  size_t completeAsync();
 
-private:
-  ssize_t processPacket(const CommandHeader *command_header, const ResultHeader *result_header, Timeout &timeout);
+  uint16_t openMailbox(Mailbox *mailbox);
+  void closeMailbox(Mailbox *mailbox);
+  Priority getPriority(uint8_t message_id) const;
+  void acquireLink(Priority priority);
+  void releaseLink();
+  orion_transport_error_t sendPacket(uint8_t *buffer, uint32_t size, uint32_t timeout);
+  orion_transport_error_t sendParts(uint8_t *buffer, uint32_t size, Priority priority, uint32_t max_write_size,
+    uint32_t timeout);
+  orion_transport_error_t sendPackets(orion_transport_packet_t *packets, uint32_t count, uint32_t timeout);
+  orion_transport_error_t sendFrame(uint8_t *frame, uint32_t size, Priority priority, uint32_t timeout);
+  bool retransmits() const;
+  orion_transport_error_t sendCommand(uint8_t *command, uint32_t command_size, Mailbox *mailbox, uint8_t *frame,
+    uint32_t frame_size, ssize_t *encoded_size, bool first_attempt, uint32_t timeout);
+  ssize_t exchangePacket(uint8_t *command, uint32_t command_size, Mailbox *mailbox, uint8_t *frame,
+    uint32_t frame_size, uint32_t retry_timeout, uint8_t retry_count, bool adaptive, uint8_t *attempts);
+  ssize_t processPacket(Mailbox *mailbox, Timeout &timeout);
+  ssize_t receivePacket(std::unique_lock<std::mutex> &lock, uint32_t timeout);
+  bool dispatchMessage(ssize_t size);
+  const uint8_t* decodeDelta(ssize_t *size);
+  orion_major_error_t negotiateLink();
+  orion_major_error_t tryBaud(const std::function<bool(uint32_t baud)> &set_baud, uint32_t *baud, uint32_t candidate,
+    uint32_t probes, uint32_t max_loss_per_mille);
+  uint32_t sendProbes(uint32_t probes, uint32_t timeout);
+  void deliverResult(ssize_t size);
+  void handOverReceiving();
+  orion_major_error_t completeResult(const CommandHeader *command_header, ResultHeader *result_header,
+    uint32_t result_size, const uint8_t *reply, ssize_t size_received);
   orion_major_error_t validateResult(const CommandHeader *command_header, const ResultHeader *result_header,
-    size_t size_received);
+    const ResultHeader *received_header, size_t size_received);
+  void recordInstrumentation(uint8_t message_id, std::chrono::steady_clock::time_point start_time, uint8_t attempts,
+    orion_major_error_t outcome);
+  uint32_t getRetryTimeout(uint8_t message_id, uint8_t attempt) const;
+  void recordRtt(uint8_t message_id, std::chrono::steady_clock::time_point send_time);
 
   uint32_t default_timeout_ = 100 * Interval::Millisecond;
   uint8_t default_retry_count_ = 1;
 
   Transport *transport_;
 
-  static const uint32_t BUFFER_SIZE = 500;
-  uint8_t result_buffer_[BUFFER_SIZE];
+  // Guards link arbitration, transport is written by the single sender owning the link
+  mutable std::mutex send_mutex_;
+  std::condition_variable send_condition_;
+  bool link_busy_ = false;
+  uint32_t link_waiters_[Bulk + 1] = {};
+  std::map<uint8_t, Priority> priorities_;
+  uint32_t max_write_size_ = 0;
+
+  // Guards all members below except result buffer, which belongs to the thread reading transport
+  mutable std::mutex mailbox_mutex_;
+  std::map<uint16_t, Mailbox*> mailboxes_;
+  std::vector<std::unique_ptr<AsyncRequest>> async_requests_;
+  bool receiving_ = false;
+  uint16_t sequence_id_ = 0;
+  uint16_t sequence_base_ = 0;  // of the channel, the whole range of sequence ids is used without channels
+  uint16_t sequence_mask_ = UINT16_MAX;
+  uint16_t stream_id_ = 0;
+
+  std::vector<uint8_t> result_buffer_;
+  std::vector<uint8_t> reassembly_buffer_;
+
+  // Keyframe and reconstructed message per message id, allocated by its first delta and touched only by reader
+  struct DeltaSlot
+  {
+    std::vector<uint8_t> keyframe;
+    std::vector<uint8_t> message;
+    orion_delta_decoder_t decoder;
+  };
+  std::map<uint8_t, DeltaSlot> delta_slots_;
+  std::vector<uint16_t> compression_buffer_;  // 16 bit elements keep hash table of compressor aligned
+
+  std::mutex handlers_mutex_;
+  std::map<uint8_t, std::function<bool(const uint8_t*, size_t)>> handlers_;
+  std::map<uint16_t, std::function<bool(const uint8_t*, size_t)>> stream_senders_;  // by stream id
+
+  Instrumentation *instrumentation_ = nullptr;
+
+  uint32_t capabilities_ = 0;
+  orion_transport_link_t link_ = {};
+  uint32_t max_baud_ = 0;
+  uint8_t checksums_ = ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16;
+  // Host has memory to spare for better ratio, buffer is sized by handshake() from frame size of transport
+  static const uint32_t COMPRESSION_TABLE_BITS = 12;
+
+  mutable std::mutex rtt_mutex_;
+  std::unique_ptr<RttEstimator> rtt_;
+  bool rtt_per_message_id_ = false;
+  std::map<uint8_t, RttEstimator> message_rtt_;
+
+  struct Counters
+  {
+    std::atomic<uint32_t> invocations{0};
+    std::atomic<uint32_t> successes{0};
+    std::atomic<uint32_t> retries{0};
+    std::atomic<uint32_t> timeouts{0};
+    std::atomic<uint32_t> send_errors{0};
+    std::atomic<uint32_t> foreign_packets{0};
+    std::atomic<uint32_t> application_errors{0};
+    std::atomic<uint32_t> validation_errors{0};
+    std::atomic<uint32_t> unsolicited_messages{0};
+    std::atomic<uint32_t> unhandled_messages{0};
+    std::atomic<uint32_t> dropped_deltas{0};
+  };
 
-  uint32_t sequence_id_ = 0;
+  Counters counters_;
 };
 
 }  // namespace orion
@@ -0,0 +1,89 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_MAJOR_AWAITABLE_HPP
+#define ORION_PROTOCOL_ORION_MAJOR_AWAITABLE_HPP
+
+/*
+  Coroutine front end of Major::invokeAsync(), available to C++20 users only, the library itself stays C++11.
+  Coroutine is resumed by whichever thread calls Major::poll() when result arrives or retries run out:
+
+    std::pair<orion_major_error_t, StatusResult> reply = co_await orion::invokeAwaitable<StatusResult>(major, command);
+*/
+
+#if __cplusplus >= 202002L
+
+#include "orion_protocol/orion_major.hpp"
+#include <coroutine>
+#include <utility>
+
+namespace orion
+{
+
+template<class Command, class Result>
+class InvokeAwaitable
+{
+public:
+  InvokeAwaitable(Major *major, const Command &command) : major_(major),
+    command_(command)
+  {
+  }
+
+  bool await_ready() const
+  {
+    return (false);
+  }
+
+  void await_suspend(std::coroutine_handle<> handle)
+  {
+    this->major_->invokeAsync(this->command_, &(this->result_), [this, handle](orion_major_error_t status)
+      {
+        this->status_ = status;
+        handle.resume();
+      });
+  }
+
+  std::pair<orion_major_error_t, Result> await_resume() const
+  {
+    return (std::make_pair(this->status_, this->result_));
+  }
+
+private:
+  Major *major_;
+  Command command_;
+  Result result_;
+  orion_major_error_t status_ = ORION_MAJOR_ERROR_UNKNOW;
+};
+
+template<class Result, class Command>
+InvokeAwaitable<Command, Result> invokeAwaitable(Major &major, const Command &command)
+{
+  return (InvokeAwaitable<Command, Result>(&major, command));
+}
+
+}  // namespace orion
+
+#endif  // __cplusplus >= 202002L
+
+#endif  // ORION_PROTOCOL_ORION_MAJOR_AWAITABLE_HPP
@@ -29,13 +29,66 @@
 #include <sys/types.h>
 
 #include "orion_protocol/orion_header.h"
+#include "orion_protocol/orion_control.h"
 #include "orion_protocol/orion_transport.h"
+#include "orion_protocol/orion_token_bucket.h"
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/*
+  Recent results kept for commands retransmitted by Major, results bigger than max size are not cached.
+  Cache size 0 removes the cache and its capability.
+*/
+#ifndef ORION_MINOR_RESULT_CACHE_SIZE
+#define ORION_MINOR_RESULT_CACHE_SIZE (4)
+#endif
+
+#ifndef ORION_MINOR_MAX_CACHED_RESULT_SIZE
+#define ORION_MINOR_MAX_CACHED_RESULT_SIZE (64)
+#endif
+
+/*
+  Capabilities Minor agrees to during handshake, could be narrowed by build for small targets.
+  Results bigger than frame size are sent as fragments, commands bigger than it are received only
+  after application gives transport a reassembly buffer. Compressed commands are always decompressed,
+  results are compressed only after application gives Minor a compression buffer.
+  Delta telemetry is published only for sources given a keyframe buffer.
+  Link negotiated after handshake switches transport to the agreed settings (see orion_transport_set_link).
+*/
+#ifndef ORION_MINOR_CAPABILITIES
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+#define ORION_MINOR_CAPABILITIES (ORION_CONTROL_CAPABILITY_CONTAINER | ORION_CONTROL_CAPABILITY_RESULT_CACHE | \
+  ORION_CONTROL_CAPABILITY_FRAGMENTS | ORION_CONTROL_CAPABILITY_COMPRESSION | ORION_CONTROL_CAPABILITY_DELTA | \
+  ORION_CONTROL_CAPABILITY_LINK)
+#else
+#define ORION_MINOR_CAPABILITIES (ORION_CONTROL_CAPABILITY_CONTAINER | ORION_CONTROL_CAPABILITY_FRAGMENTS | \
+  ORION_CONTROL_CAPABILITY_COMPRESSION | ORION_CONTROL_CAPABILITY_DELTA | ORION_CONTROL_CAPABILITY_LINK)
+#endif
+#endif
+
+/*
+  Link settings Minor agrees to, the cheapest checksum supported by both peers is chosen.
+  Small window keeps bursts of stream segments within receive buffer of UART.
+*/
+#ifndef ORION_MINOR_CHECKSUMS
+#define ORION_MINOR_CHECKSUMS (ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16)
+#endif
+
+#ifndef ORION_MINOR_STREAM_WINDOW
+#define ORION_MINOR_STREAM_WINDOW (ORION_STREAM_MAX_WINDOW)
+#endif
+
+#ifndef ORION_MINOR_MAX_TELEMETRY_SOURCES
+#define ORION_MINOR_MAX_TELEMETRY_SOURCES (8)
+#endif
+
+#ifndef ORION_MINOR_MAX_TELEMETRY_SIZE
+#define ORION_MINOR_MAX_TELEMETRY_SIZE (64)
+#endif
+
 typedef enum
 {
   ORION_MINOR_ERROR_NONE = 0,
@@ -44,10 +97,33 @@ typedef enum
   ORION_MINOR_ERROR_TIMEOUT = -3,
   ORION_MINOR_ERROR_RECEIVING_PACKET = -4,
   ORION_MINOR_ERROR_SENDING_PACKET = -5,
-  ORION_MINOR_ERROR_UNKNOWN = -6
+  ORION_MINOR_ERROR_NO_ROOM = -6,
+  ORION_MINOR_ERROR_NOT_FOUND = -7,
+  ORION_MINOR_ERROR_UNKNOWN = -8
 }
 orion_minor_error_t;
 
+/*
+  Writes telemetry message starting with orion_command_header_t into buffer and returns its size,
+  returning 0 skips this publication
+*/
+typedef size_t (*orion_minor_telemetry_callback_t)(void * context, uint8_t * buffer, size_t buffer_size);
+
+/*
+  Switches communication to another baud rate after waiting till bytes already written leave UART,
+  returns false when it could not
+*/
+typedef bool (*orion_minor_baud_callback_t)(void * context, uint32_t baud);
+
+typedef struct
+{
+  uint32_t period;  // microseconds granted to Major, 0 when not subscribed
+  uint32_t achieved_period;  // average since subscription
+  uint32_t published;
+  uint32_t decimated;  // skipped because telemetry budget of link was exhausted
+}
+orion_minor_telemetry_statistics_t;
+
 struct orion_minor_struct_t;
 
 typedef struct orion_minor_struct_t orion_minor_t;
@@ -57,8 +133,88 @@ orion_minor_error_t orion_minor_delete(const orion_minor_t * me);
 
 ssize_t orion_minor_wait_and_receive_command(const orion_minor_t * me, uint8_t * buffer, size_t buffer_size,
   uint32_t timeout);
-ssize_t orion_minor_receive_command(const orion_minor_t * me, uint8_t * buffer, size_t buffer_size);
-orion_minor_error_t orion_minor_send_result(const orion_minor_t * me, uint8_t * buffer, const size_t size);
+/*
+  Control messages (see orion_control.h) are handled by Minor itself and are not returned, 0 is returned instead.
+  The same goes for commands retransmitted by Major, which are answered from result cache when it was negotiated.
+*/
+ssize_t orion_minor_receive_command(orion_minor_t * me, uint8_t * buffer, size_t buffer_size);
+/*
+  Result is kept in cache for retransmitted command if Major negotiated it
+*/
+orion_minor_error_t orion_minor_send_result(orion_minor_t * me, uint8_t * buffer, const size_t size);
+/*
+  Sends results with a single write, packed into containers when Major supports them.
+  These results are not cached, Major does not retransmit commands of a batch.
+*/
+orion_minor_error_t orion_minor_send_results(const orion_minor_t * me, orion_transport_packet_t * packets,
+  uint32_t count);
+/*
+  Pushes message to Major without command, e.g. telemetry, message should start with orion_command_header_t.
+  Sequence id is set to ORION_UNSOLICITED_SEQUENCE_ID.
+*/
+orion_minor_error_t orion_minor_publish(orion_minor_t * me, uint8_t * buffer, const size_t size);
+
+/*
+  Registers telemetry source which Major could subscribe to with ORION_CONTROL_MESSAGE_ID_SUBSCRIBE
+  @max_size - biggest message callback writes, used to fit subscriptions into link budget
+*/
+orion_minor_error_t orion_minor_add_telemetry(orion_minor_t * me, uint8_t message_id, size_t max_size,
+  orion_minor_telemetry_callback_t callback, void * context);
+/*
+  Publishes telemetry as deltas against keyframe (see orion_delta.h) once Major agrees to it by handshake,
+  every keyframe_interval messages go whole. Budget is still consumed for the whole message.
+  @keyframe - buffer of ORION_MINOR_MAX_TELEMETRY_SIZE bytes, NULL publishes whole messages again
+*/
+orion_minor_error_t orion_minor_set_telemetry_delta(orion_minor_t * me, uint8_t message_id, uint8_t * keyframe,
+  uint32_t keyframe_interval);
+/*
+  @bytes_per_second - share of link telemetry could use, e.g. 80% of baud rate / 10, 0 means unlimited
+  @time_now - microseconds of any monotonic clock, the same as passed to orion_minor_publish_telemetry
+*/
+orion_minor_error_t orion_minor_set_telemetry_budget(orion_minor_t * me, uint32_t bytes_per_second,
+  uint64_t time_now);
+/*
+  Should be called from main loop of firmware, publishes subscribed telemetry which is due.
+  When budget is exhausted publication is skipped till the next period, i.e. telemetry is decimated.
+  Returns count of published messages.
+*/
+uint32_t orion_minor_publish_telemetry(orion_minor_t * me, uint64_t time_now);
+orion_minor_error_t orion_minor_get_telemetry_statistics(const orion_minor_t * me, uint8_t message_id,
+  orion_minor_telemetry_statistics_t * statistics);
+
+/*
+  Gives buffer for streams sent by Major (see orion_stream.h), segments are received and acknowledged
+  by orion_minor_receive_command. Stream bigger than buffer is not received, no buffer means no streams.
+*/
+void orion_minor_set_stream_buffer(orion_minor_t * me, uint8_t * buffer, uint32_t size);
+/*
+  Returns true when the last stream is received completely into stream buffer
+  @size - size of the stream, could be NULL
+*/
+bool orion_minor_get_stream(const orion_minor_t * me, uint32_t * size);
+/*
+  Buffer passed to transport by handshake when Major agrees to compression,
+  see orion_transport_set_compression_buffer for its size. Small table is enough to gain on repetitive results.
+*/
+void orion_minor_set_compression_buffer(orion_minor_t * me, uint8_t * buffer, uint32_t size);
+/*
+  The fastest baud rate communication of Minor could switch to, offered when Major negotiates link.
+  0 (default) keeps baud rate as it is.
+*/
+void orion_minor_set_max_baud(orion_minor_t * me, uint32_t baud);
+/*
+  Lets Major move link to a faster baud rate up to max baud (see ORION_CONTROL_MESSAGE_ID_BAUD),
+  without callback switch is refused.
+  @baud - rate communication is at now
+*/
+void orion_minor_set_baud_callback(orion_minor_t * me, orion_minor_baud_callback_t callback, void * context,
+  uint32_t baud);
+/*
+  Should be called from main loop of firmware, returns to the previous baud rate when Major has not committed
+  the switch within its timeout. Returns rate communication is at.
+  @time_now - microseconds of any monotonic clock
+*/
+uint32_t orion_minor_update_baud(orion_minor_t * me, uint64_t time_now);
 
 #ifdef __cplusplus
 }
@@ -62,6 +62,74 @@ public:
     return (orion_minor_send_result(object_, buffer, size));
   }
 
+  virtual orion_minor_error_t sendResults(orion_transport_packet_t *packets, uint32_t count)
+  {
+    return (orion_minor_send_results(object_, packets, count));
+  }
+
+  virtual orion_minor_error_t publish(uint8_t * buffer, const size_t size)
+  {
+    return (orion_minor_publish(object_, buffer, size));
+  }
+
+  orion_minor_error_t addTelemetry(uint8_t message_id, size_t max_size, orion_minor_telemetry_callback_t callback,
+    void * context)
+  {
+    return (orion_minor_add_telemetry(object_, message_id, max_size, callback, context));
+  }
+
+  orion_minor_error_t setTelemetryDelta(uint8_t message_id, uint8_t * keyframe, uint32_t keyframe_interval)
+  {
+    return (orion_minor_set_telemetry_delta(object_, message_id, keyframe, keyframe_interval));
+  }
+
+  orion_minor_error_t setTelemetryBudget(uint32_t bytes_per_second, uint64_t time_now)
+  {
+    return (orion_minor_set_telemetry_budget(object_, bytes_per_second, time_now));
+  }
+
+  uint32_t publishTelemetry(uint64_t time_now)
+  {
+    return (orion_minor_publish_telemetry(object_, time_now));
+  }
+
+  orion_minor_telemetry_statistics_t getTelemetryStatistics(uint8_t message_id)
+  {
+    orion_minor_telemetry_statistics_t result = {};
+    orion_minor_get_telemetry_statistics(object_, message_id, &result);
+    return (result);
+  }
+
+  void setStreamBuffer(uint8_t * buffer, uint32_t size)
+  {
+    orion_minor_set_stream_buffer(object_, buffer, size);
+  }
+
+  bool getStream(uint32_t * size)
+  {
+    return (orion_minor_get_stream(object_, size));
+  }
+
+  void setCompressionBuffer(uint8_t * buffer, uint32_t size)
+  {
+    orion_minor_set_compression_buffer(object_, buffer, size);
+  }
+
+  void setMaxBaud(uint32_t baud)
+  {
+    orion_minor_set_max_baud(object_, baud);
+  }
+
+  void setBaudCallback(orion_minor_baud_callback_t callback, void * context, uint32_t baud)
+  {
+    orion_minor_set_baud_callback(object_, callback, context, baud);
+  }
+
+  uint32_t updateBaud(uint64_t time_now)
+  {
+    return (orion_minor_update_baud(object_, time_now));
+  }
+
   orion_minor_t* getObject()
   {
     return object_;
@@ -0,0 +1,120 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_MULTIPLEXER_HPP
+#define ORION_PROTOCOL_ORION_MULTIPLEXER_HPP
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "orion_protocol/orion_header.hpp"
+#include "orion_protocol/orion_transport.hpp"
+
+namespace orion
+{
+
+typedef struct
+{
+  uint32_t sent;  // packets and frames written to the link
+  uint32_t received;  // packets routed to the channel
+  uint32_t dropped;  // packets routed to the channel while its queue was full
+}
+ChannelStatistics;
+
+/*
+  Shares one link between several local clients, e.g. control, diagnostics and firmware logging,
+  each of them running its own Major on a logical channel:
+
+    orion::Major diagnostics(multiplexer.getChannel(2));
+    diagnostics.setChannel(2);
+
+  Channels have separate ranges of sequence ids (see orion_header.h), received results are routed
+  by sequence id into queues of their channels and messages pushed by Minor are copied to every channel.
+  Whichever client waits for a packet reads the link for all of them, nobody holds a lock while reading
+  or writing. Writes of waiting channels take the link in turns, so a busy client does not starve others.
+  Queue of every channel is bounded, a client which does not read in time loses its own packets only.
+  Multiplexer should outlive Majors on its channels.
+*/
+class Multiplexer
+{
+public:
+  /*
+    @buffer_size - biggest packet expected, also the size of reassembly buffer for fragments
+    @queue_size - packets kept for a channel till its client reads them
+  */
+  Multiplexer(Transport *transport, uint32_t buffer_size, uint32_t queue_size);
+  ~Multiplexer();
+
+  // Transport of logical channel, created on the first call and owned by multiplexer
+  Transport* getChannel(uint8_t channel);
+
+  ChannelStatistics getStatistics(uint8_t channel) const;
+
+  // Results with sequence id of channel nobody opened
+  uint32_t getUnroutedPackets() const;
+
+private:
+  class Channel;
+
+  struct ChannelState
+  {
+    std::unique_ptr<Channel> transport;
+    std::deque<std::vector<uint8_t>> queue;
+    uint32_t writers = 0;  // waiting for the link
+    ChannelStatistics statistics = {};
+  };
+
+  void acquireLink(uint8_t channel);
+  // @written - false when the link was taken without writing to it, e.g. to encode a frame
+  void releaseLink(uint8_t channel, bool written);
+  ssize_t receivePacket(uint8_t channel, uint8_t *output_buffer, uint32_t output_size, uint32_t timeout);
+  bool hasReceivedPacket(uint8_t channel);
+  void routePacket(ssize_t size);
+  orion_transport_error_t setReassembly();
+  orion_transport_error_t setCompression(uint32_t size);
+
+  Transport *transport_;
+  uint32_t queue_size_;
+  std::vector<uint8_t> buffer_;  // belongs to the client reading the link at the moment
+  std::vector<uint8_t> reassembly_buffer_;
+  std::vector<uint16_t> compression_buffer_;  // 16 bit elements keep hash table of compressor aligned
+
+  // Guards all members below, held only to update them and never during I/O
+  mutable std::mutex mutex_;
+  std::condition_variable link_condition_;
+  std::condition_variable received_condition_;
+  ChannelState channels_[ORION_CHANNEL_COUNT];
+  bool link_busy_ = false;
+  uint8_t last_writer_ = ORION_CHANNEL_COUNT - 1;
+  bool reading_ = false;
+  bool reassembly_ = false;
+  uint32_t unrouted_packets_ = 0;
+};
+
+}  // namespace orion
+
+#endif  // ORION_PROTOCOL_ORION_MULTIPLEXER_HPP
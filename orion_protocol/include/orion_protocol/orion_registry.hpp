@@ -0,0 +1,326 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_REGISTRY_HPP
+#define ORION_PROTOCOL_ORION_REGISTRY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <cstring>
+#include <type_traits>
+#include "orion_protocol/orion_header.hpp"
+#include "orion_protocol/orion_control.h"
+#include "orion_protocol/orion_transport.h"
+#include "orion_protocol/orion_assert.h"
+
+namespace orion
+{
+
+/*
+  Declares command and result types of message_id once, their layout is checked at compile time.
+  Both should be packed structs starting with member header of CommandHeader and ResultHeader respectively.
+*/
+template<uint8_t MESSAGE_ID, class CommandType, class ResultType, uint8_t VERSION = 1,
+  uint8_t OLDEST_COMPATIBLE_VERSION = VERSION>
+struct MessageDefinition
+{
+  typedef CommandType Command;
+  typedef ResultType Result;
+
+  static constexpr uint8_t message_id = MESSAGE_ID;
+  static constexpr uint8_t version = VERSION;
+  static constexpr uint8_t oldest_compatible_version = OLDEST_COMPATIBLE_VERSION;
+
+  static_assert(MESSAGE_ID < ORION_CONTROL_MESSAGE_ID_FIRST, "Message id is reserved for the protocol");
+  static_assert(OLDEST_COMPATIBLE_VERSION <= VERSION, "Oldest compatible version is newer than version");
+  static_assert(std::is_standard_layout<Command>::value && std::is_trivially_copyable<Command>::value,
+    "Command should be a plain struct");
+  static_assert(std::is_standard_layout<Result>::value && std::is_trivially_copyable<Result>::value,
+    "Result should be a plain struct");
+  static_assert(std::is_same<decltype(Command::header), CommandHeader>::value && (0 == offsetof(Command, header)),
+    "Command should start with CommandHeader header");
+  static_assert(std::is_same<decltype(Result::header), ResultHeader>::value && (0 == offsetof(Result, header)),
+    "Result should start with ResultHeader header");
+  static_assert((1 == alignof(Command)) && (1 == alignof(Result)), "Command and result should be packed");
+  static_assert((sizeof(Command) <= ORION_TRANSPORT_DEFAULT_FRAME_SIZE) &&
+    (sizeof(Result) <= ORION_TRANSPORT_DEFAULT_FRAME_SIZE), "Command and result should fit into frame");
+
+  static void prepare(Command *command)
+  {
+    command->header.frame.crc = 0;
+    command->header.common.message_id = MESSAGE_ID;
+    command->header.common.version = VERSION;
+    command->header.common.oldest_compatible_version = OLDEST_COMPATIBLE_VERSION;
+  }
+
+  static void prepare(Result *result)
+  {
+    result->header.frame.crc = 0;
+    result->header.common.message_id = MESSAGE_ID;
+    result->header.common.version = VERSION;
+    result->header.common.oldest_compatible_version = OLDEST_COMPATIBLE_VERSION;
+    result->header.error_code = 0;
+  }
+};
+
+template<uint8_t MESSAGE_ID, class CommandType, class ResultType, uint8_t VERSION, uint8_t OLDEST_COMPATIBLE_VERSION>
+constexpr uint8_t MessageDefinition<MESSAGE_ID, CommandType, ResultType, VERSION, OLDEST_COMPATIBLE_VERSION>::message_id;
+template<uint8_t MESSAGE_ID, class CommandType, class ResultType, uint8_t VERSION, uint8_t OLDEST_COMPATIBLE_VERSION>
+constexpr uint8_t MessageDefinition<MESSAGE_ID, CommandType, ResultType, VERSION, OLDEST_COMPATIBLE_VERSION>::version;
+template<uint8_t MESSAGE_ID, class CommandType, class ResultType, uint8_t VERSION, uint8_t OLDEST_COMPATIBLE_VERSION>
+constexpr uint8_t MessageDefinition<MESSAGE_ID, CommandType, ResultType, VERSION,
+  OLDEST_COMPATIBLE_VERSION>::oldest_compatible_version;
+
+namespace registry
+{
+
+template<size_t... Indexes>
+struct IndexSequence {};
+
+template<size_t N, size_t... Indexes>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Indexes...> {};
+
+template<size_t... Indexes>
+struct MakeIndexSequence<0, Indexes...>
+{
+  typedef IndexSequence<Indexes...> type;
+};
+
+template<class... Definitions>
+struct TypeList {};
+
+// Definition of message_id or void
+template<size_t MessageId, class... Definitions>
+struct FindById
+{
+  typedef void type;
+};
+
+template<size_t MessageId, class First, class... Rest>
+struct FindById<MessageId, First, Rest...>
+{
+  typedef typename std::conditional<MessageId == First::message_id, First,
+    typename FindById<MessageId, Rest...>::type>::type type;
+};
+
+// Definition with given command type or void
+template<class Command, class... Definitions>
+struct FindByCommand
+{
+  typedef void type;
+};
+
+template<class Command, class First, class... Rest>
+struct FindByCommand<Command, First, Rest...>
+{
+  typedef typename std::conditional<std::is_same<Command, typename First::Command>::value, First,
+    typename FindByCommand<Command, Rest...>::type>::type type;
+};
+
+template<class... Definitions>
+struct IsUnique : std::true_type {};
+
+template<class First, class... Rest>
+struct IsUnique<First, Rest...> : std::integral_constant<bool,
+  std::is_void<typename FindById<First::message_id, Rest...>::type>::value &&
+  std::is_void<typename FindByCommand<typename First::Command, Rest...>::type>::value && IsUnique<Rest...>::value> {};
+
+template<class... Definitions>
+struct MaxSize
+{
+  static constexpr size_t command = sizeof(CommandHeader);
+  static constexpr size_t result = sizeof(ResultHeader);
+};
+
+template<class First, class... Rest>
+struct MaxSize<First, Rest...>
+{
+  static constexpr size_t command = (sizeof(typename First::Command) > MaxSize<Rest...>::command) ?
+    sizeof(typename First::Command) : MaxSize<Rest...>::command;
+  static constexpr size_t result = (sizeof(typename First::Result) > MaxSize<Rest...>::result) ?
+    sizeof(typename First::Result) : MaxSize<Rest...>::result;
+};
+
+template<class Handler>
+using Entry = size_t (*)(Handler &handler, const uint8_t *command, size_t command_size, uint8_t *result);
+
+inline size_t writeError(const CommandHeader *command_header, uint8_t error_code, uint8_t *result)
+{
+  ResultHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.common = command_header->common;
+  header.error_code = error_code;
+  std::memcpy(result, &header, sizeof(header));
+  return (sizeof(header));
+}
+
+template<class Handler, class Definition>
+size_t call(Handler &handler, const uint8_t *command, size_t command_size, uint8_t *result)
+{
+  const CommandHeader *command_header = reinterpret_cast<const CommandHeader*>(command);
+  if (command_size < sizeof(typename Definition::Command))
+  {
+    return (writeError(command_header, ORION_CONTROL_ERROR_MALFORMED_MESSAGE, result));
+  }
+  typename Definition::Command typed_command;
+  std::memcpy(&typed_command, command, sizeof(typed_command));
+  typename Definition::Result typed_result;
+  Definition::prepare(&typed_result);
+  typed_result.header.common.sequence_id = command_header->common.sequence_id;
+  handler.handle(typed_command, &typed_result);
+  std::memcpy(result, &typed_result, sizeof(typed_result));
+  return (sizeof(typed_result));
+}
+
+template<class Handler, class Definition>
+constexpr Entry<Handler> entry(Definition*)
+{
+  return (&call<Handler, Definition>);
+}
+
+template<class Handler>
+constexpr Entry<Handler> entry(void*)
+{
+  return (nullptr);
+}
+
+template<class Handler, class Sequence, class List>
+struct Table;
+
+template<class Handler, size_t... Indexes, class... Definitions>
+struct Table<Handler, IndexSequence<Indexes...>, TypeList<Definitions...>>
+{
+  static constexpr Entry<Handler> entries[sizeof...(Indexes)] =
+  {
+    entry<Handler>(static_cast<typename FindById<Indexes, Definitions...>::type*>(nullptr))...
+  };
+};
+
+template<class Handler, size_t... Indexes, class... Definitions>
+constexpr Entry<Handler> Table<Handler, IndexSequence<Indexes...>, TypeList<Definitions...>>::entries[
+  sizeof...(Indexes)];
+
+}  // namespace registry
+
+/*
+  Set of messages of an application, e.g.
+    typedef MessageRegistry<MessageDefinition<1, StatusCommand, StatusResult>, ...> Messages;
+  Major side calls Messages::invoke(major, command, &result) with message id and version filled from definition
+  and result type checked at compile time. Minor side passes commands to Messages::Dispatcher<Handler>,
+  which calls handler.handle(const Command&, Result*) through a table indexed by message_id.
+*/
+template<class... Definitions>
+class MessageRegistry
+{
+  static_assert(registry::IsUnique<Definitions...>::value, "Every message id and command type is registered once");
+
+public:
+  static constexpr size_t MAX_COMMAND_SIZE = registry::MaxSize<Definitions...>::command;
+  static constexpr size_t MAX_RESULT_SIZE = registry::MaxSize<Definitions...>::result;
+
+  template<class Command>
+  struct DefinitionOf
+  {
+    typedef typename registry::FindByCommand<Command, Definitions...>::type type;
+    static_assert(!std::is_void<type>::value, "Command is not registered");
+  };
+
+  template<class Command>
+  static void prepare(Command *command, typename DefinitionOf<Command>::type::Result *result)
+  {
+    DefinitionOf<Command>::type::prepare(command);
+    DefinitionOf<Command>::type::prepare(result);
+  }
+
+  /*
+    Fills headers of command and expected result and calls major.invoke with the rest of arguments
+  */
+  template<class Major, class Command, class... Arguments>
+  static auto invoke(Major &major, Command command, typename DefinitionOf<Command>::type::Result *result,
+    Arguments... arguments) -> decltype(major.invoke(command, result, arguments...))
+  {
+    prepare(&command, result);
+    return (major.invoke(command, result, arguments...));
+  }
+
+  /*
+    Handler should have handle(const Command&, Result*) for every registered message,
+    result header is filled before the call, so that handler sets only payload and error code if needed.
+  */
+  template<class Handler>
+  class Dispatcher
+  {
+  public:
+    /*
+      Returns size of result written, unknown or short commands get result with error code from orion_control.h
+      @result - at least MAX_RESULT_SIZE bytes
+    */
+    static size_t dispatch(Handler &handler, const uint8_t *command, size_t command_size, uint8_t *result)
+    {
+      ORION_ASSERT_NOT_NULL(command);
+      ORION_ASSERT_NOT_NULL(result);
+      ORION_ASSERT(command_size >= sizeof(CommandHeader));
+
+      const CommandHeader *command_header = reinterpret_cast<const CommandHeader*>(command);
+      registry::Entry<Handler> entry = Table::entries[command_header->common.message_id];
+      if (nullptr == entry)
+      {
+        return (registry::writeError(command_header, ORION_CONTROL_ERROR_UNKNOWN_MESSAGE, result));
+      }
+      return (entry(handler, command, command_size, result));
+    }
+
+    /*
+      Receives one command from minor, dispatches it and sends its result.
+      Returns size of handled command, 0 when there was none or negative orion_minor_error_t.
+    */
+    template<class Minor>
+    static ssize_t spinOnce(Minor &minor, Handler &handler)
+    {
+      uint8_t command[MAX_COMMAND_SIZE];
+      uint8_t result[MAX_RESULT_SIZE];
+      ssize_t size = minor.receiveCommand(command, sizeof(command));
+      if (size < static_cast<ssize_t>(sizeof(CommandHeader)))
+      {
+        return ((size < 0) ? size : 0);
+      }
+      size_t result_size = dispatch(handler, command, size, result);
+      ssize_t status = minor.sendResult(result, result_size);
+      return ((0 == status) ? size : status);
+    }
+
+  private:
+    typedef registry::Table<Handler, typename registry::MakeIndexSequence<UINT8_MAX + 1>::type,
+      registry::TypeList<Definitions...>> Table;
+  };
+};
+
+template<class... Definitions>
+constexpr size_t MessageRegistry<Definitions...>::MAX_COMMAND_SIZE;
+template<class... Definitions>
+constexpr size_t MessageRegistry<Definitions...>::MAX_RESULT_SIZE;
+
+}  // namespace orion
+
+#endif  // ORION_PROTOCOL_ORION_REGISTRY_HPP
@@ -0,0 +1,81 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_RTT_ESTIMATOR_HPP
+#define ORION_PROTOCOL_ORION_RTT_ESTIMATOR_HPP
+
+#include <stdint.h>
+
+namespace orion
+{
+
+typedef struct
+{
+  uint32_t srtt;  // smoothed round trip time
+  uint32_t rttvar;  // smoothed mean deviation of round trip time
+  uint32_t timeout;  // retransmission timeout of the first attempt
+  uint32_t samples;
+}
+RttStatistics;
+
+/*
+  Retransmission timeout by Jacobson/Karels: SRTT + 4 * RTTVAR with gains 1/8 and 1/4,
+  doubled for every next attempt and clamped. Till the first sample initial timeout is used.
+  Times are in microseconds, not thread safe.
+*/
+class RttEstimator
+{
+public:
+  RttEstimator(uint32_t initial_timeout, uint32_t min_timeout, uint32_t max_timeout);
+
+  /*
+    Only round trips of commands answered on the first attempt should be sampled,
+    result of a retry could belong to any of the attempts (Karn's algorithm)
+  */
+  void addSample(uint32_t rtt);
+
+  /*
+    @attempt - 0 for the first send of the command
+  */
+  uint32_t getTimeout(uint8_t attempt) const;
+
+  RttStatistics getStatistics() const;
+
+  // Forgets all samples, e.g. after link was reestablished
+  void reset();
+
+private:
+  uint32_t clamp(uint64_t timeout) const;
+
+  uint32_t initial_timeout_;
+  uint32_t min_timeout_;
+  uint32_t max_timeout_;
+  uint32_t timeout_;
+  uint64_t srtt_scaled_;  // SRTT * 8
+  uint64_t rttvar_scaled_;  // RTTVAR * 4
+  uint32_t samples_;
+};
+
+}  // namespace orion
+
+#endif  // ORION_PROTOCOL_ORION_RTT_ESTIMATOR_HPP
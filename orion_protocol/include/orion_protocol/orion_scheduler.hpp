@@ -0,0 +1,161 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_SCHEDULER_HPP
+#define ORION_PROTOCOL_ORION_SCHEDULER_HPP
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "orion_protocol/orion_major.hpp"
+#include "orion_protocol/orion_instrumentation.hpp"
+
+namespace orion
+{
+
+typedef struct
+{
+  uint32_t cycles;  // ticks with at least one transaction due
+  uint32_t transactions;
+  uint32_t failures;  // transactions completed with other status than ORION_MAJOR_ERROR_NONE
+  uint32_t overruns;  // ticks skipped because the previous cycle did not finish in time
+}
+SchedulerStatistics;
+
+/*
+  Runs periodic transactions of fixed-rate control loops on a grid of ticks.
+  Every transaction is due at ticks where tick % period == phase, transactions due at the same tick
+  are sent as one Batch, so that they share a write and a single wait for results.
+  Phase chosen by add() puts transaction where the busiest of its ticks carries the fewest bytes,
+  e.g. 10 Hz reads are kept away from ticks already loaded by others instead of all firing together.
+  Cycles missed while the link was busy are dropped rather than caught up, so the link never gets a burst.
+  Not thread safe, spinOnce() is expected to be called in a loop by a dedicated thread.
+*/
+class Scheduler
+{
+public:
+  typedef std::function<void(orion_major_error_t status)> Callback;
+
+  static const uint32_t MAX_HYPERPERIOD = 1 << 16;  // in ticks, bounds cost of phase selection
+
+  /*
+    @tick - granularity of the schedule in microseconds, periods and phases are multiples of it
+  */
+  Scheduler(Major *major, uint32_t tick, uint32_t retry_timeout, uint8_t retry_count);
+
+  /*
+    Command and result are kept by pointer, so command could be updated and result read by callback,
+    which is called after every cycle of the transaction.
+    @period - in microseconds
+    Returns index of the transaction
+  */
+  template<class Command, class Result>
+  size_t add(Command *command, Result *result, uint32_t period, Callback callback)
+  {
+    ORION_ASSERT(0 == period % this->tick_);
+    uint32_t phase = this->selectPhase(period / this->tick_, sizeof(Command) + sizeof(Result));
+    return (this->add(command, result, period, phase * this->tick_, callback));
+  }
+
+  /*
+    @phase - offset of the transaction within its period in microseconds
+  */
+  template<class Command, class Result>
+  size_t add(Command *command, Result *result, uint32_t period, uint32_t phase, Callback callback)
+  {
+    ORION_ASSERT_NOT_NULL(command);
+    ORION_ASSERT_NOT_NULL(result);
+    ORION_ASSERT(sizeof(Command) >= sizeof(CommandHeader));
+    ORION_ASSERT(sizeof(Result) >= sizeof(ResultHeader));
+
+    Transaction transaction;
+    transaction.command = reinterpret_cast<uint8_t*>(command);
+    transaction.result = reinterpret_cast<uint8_t*>(result);
+    transaction.size = sizeof(Command) + sizeof(Result);
+    transaction.callback = callback;
+    transaction.add = [](Major::Batch *batch, const Transaction &item)
+      {
+        return (batch->add(reinterpret_cast<Command*>(item.command), reinterpret_cast<Result*>(item.result)));
+      };
+    return (this->addTransaction(transaction, period, phase));
+  }
+
+  uint32_t getPhase(size_t index) const;
+
+  /*
+    Waits for the next tick with transactions due, invokes them and calls their callbacks.
+    Returns count of transactions invoked.
+  */
+  size_t spinOnce();
+
+  // Restarts the schedule from tick 0 at the next spinOnce()
+  void restart();
+
+  SchedulerStatistics getStatistics() const;
+
+  // Lateness of cycles against the schedule in microseconds
+  const LatencyHistogram& getJitter() const
+  {
+    return (this->jitter_);
+  }
+
+private:
+  struct Transaction
+  {
+    uint8_t *command;
+    uint8_t *result;
+    uint32_t size;  // of command and result, load the transaction puts on the link
+    Callback callback;
+    uint32_t period;  // in ticks
+    uint32_t phase;  // in ticks
+    std::function<size_t(Major::Batch *batch, const Transaction &transaction)> add;
+  };
+
+  size_t addTransaction(const Transaction &transaction, uint32_t period, uint32_t phase);
+  uint32_t selectPhase(uint32_t period, uint32_t size) const;
+  uint64_t getNextTick(uint64_t tick) const;
+  std::chrono::steady_clock::time_point getTickTime(uint64_t tick) const;
+
+  Major *major_;
+  uint32_t tick_;
+  uint32_t retry_timeout_;
+  uint8_t retry_count_;
+  uint32_t hyperperiod_ = 1;  // in ticks, least common multiple of all periods
+
+  std::vector<Transaction> transactions_;
+  std::vector<size_t> due_;
+  Major::Batch batch_;
+
+  bool started_ = false;
+  std::chrono::steady_clock::time_point start_time_;
+  uint64_t next_tick_ = 0;
+
+  SchedulerStatistics statistics_ = {};
+  LatencyHistogram jitter_;
+};
+
+}  // namespace orion
+
+#endif  // ORION_PROTOCOL_ORION_SCHEDULER_HPP
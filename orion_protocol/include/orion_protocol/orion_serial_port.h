@@ -37,6 +37,11 @@ extern "C"
 orion_communication_error_t orion_communication_connect(orion_communication_t * me, const char* port_name,
     const uint32_t baud);
 orion_communication_error_t orion_communication_disconnect(orion_communication_t * me);
+/*
+  Switches connected port to another baud rate, bytes already written are sent at the previous one.
+  @baud - bits per second, e.g. 921600, or speed_t constant such as B921600
+*/
+orion_communication_error_t orion_communication_set_baud(orion_communication_t * me, const uint32_t baud);
 
 #ifdef __cplusplus
 }
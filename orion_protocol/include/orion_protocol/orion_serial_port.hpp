@@ -46,6 +46,11 @@ public:
   {
     return (orion_communication_disconnect(getObject()));
   }
+
+  orion_communication_error_t setBaud(const uint32_t baud)
+  {
+    return (orion_communication_set_baud(getObject(), baud));
+  }
 };
 
 }  // namespace orion
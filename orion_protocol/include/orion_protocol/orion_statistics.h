@@ -0,0 +1,64 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_STATISTICS_H
+#define ORION_PROTOCOL_ORION_STATISTICS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Sequence lock guarding a section of uint32_t counters.
+  Section has a single writer (e.g. receiving or sending thread), any number of readers get consistent copy of it.
+  Writer never waits and uses only plain atomic loads and stores, so it works on cores without atomic increment.
+*/
+typedef struct
+{
+  uint32_t sequence_;
+}
+orion_statistics_lock_t;
+
+void orion_statistics_init(orion_statistics_lock_t * lock);
+
+/*
+  @counter - field of section guarded by lock
+*/
+void orion_statistics_add(orion_statistics_lock_t * lock, uint32_t * counter, uint32_t value);
+void orion_statistics_update_max(orion_statistics_lock_t * lock, uint32_t * counter, uint32_t value);
+
+/*
+  @section - struct consisting of uint32_t counters only
+  @size - size of section in bytes
+*/
+void orion_statistics_read(const orion_statistics_lock_t * lock, const void * section, void * copy, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_STATISTICS_H
@@ -0,0 +1,136 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#ifndef ORION_PROTOCOL_ORION_STREAM_H
+#define ORION_PROTOCOL_ORION_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "orion_protocol/orion_control.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Reliable transfer of a buffer bigger than a frame over lossy link with high latency.
+  Sender keeps up to window segments unacknowledged instead of waiting for every one of them,
+  receiver acknowledges cumulatively and selectively, so only missing segments are sent again.
+  Both sides are plain state machines without I/O: caller sends packets they build and passes them packets
+  received, time is passed in microseconds of any monotonic clock.
+*/
+
+// Window is limited by selective acknowledgment bitmap
+#define ORION_STREAM_MAX_WINDOW (32)
+
+typedef struct
+{
+  uint32_t segments;  // sent, including retransmissions
+  uint32_t retransmissions;
+  uint32_t acks;
+}
+orion_stream_statistics_t;
+
+typedef struct
+{
+  const uint8_t * data_;
+  uint32_t size_;
+  uint16_t stream_id_;
+  uint16_t segment_size_;
+  uint32_t segment_count_;
+  uint32_t window_;
+  uint32_t retransmit_timeout_;
+  uint32_t acknowledged_;  // segments received by peer before the first missing one
+  uint32_t next_;  // the first segment never sent
+  uint32_t selective_;  // bit n set when segment acknowledged_ + n is received
+  uint32_t lost_;  // bit n set when segment acknowledged_ + n is known to be lost and is not sent again yet
+  uint64_t send_times_[ORION_STREAM_MAX_WINDOW];  // last transmission, by segment % MAX_WINDOW
+  orion_stream_statistics_t statistics_;
+}
+orion_stream_sender_t;
+
+typedef struct
+{
+  uint8_t * buffer_;
+  uint32_t buffer_size_;
+  bool active_;
+  uint16_t stream_id_;
+  uint32_t size_;
+  uint32_t segment_count_;
+  uint32_t received_;  // segments received before the first missing one
+  uint32_t selective_;  // bit n set when segment received_ + n is received
+}
+orion_stream_receiver_t;
+
+/*
+  @data - should stay unchanged till transfer is complete
+  @segment_size - bytes of data in a segment, segment header is added to them
+  @window - up to ORION_STREAM_MAX_WINDOW segments sent but not acknowledged
+  @retransmit_timeout - segment without acknowledgment is sent again after that many microseconds
+*/
+void orion_stream_sender_init(orion_stream_sender_t * me, uint16_t stream_id, const uint8_t * data, uint32_t size,
+  uint16_t segment_size, uint32_t window, uint32_t retransmit_timeout);
+/*
+  Builds the next segment to send into @packet: segment reported lost first, then segment whose acknowledgment
+  is overdue, then a new one if window allows. Returns its size or 0 if nothing should be sent now.
+*/
+ssize_t orion_stream_sender_poll(orion_stream_sender_t * me, uint64_t time_now, uint8_t * packet,
+  uint32_t packet_size);
+/*
+  Segment which is not acknowledged while a segment sent after it is, is lost and is sent again at once,
+  others wait for retransmit timeout.
+*/
+void orion_stream_sender_on_ack(orion_stream_sender_t * me, const orion_control_stream_ack_t * ack);
+// Microseconds till the sender has something to send, 0 when it has it now, UINT32_MAX when it is complete
+uint32_t orion_stream_sender_get_wait_time(const orion_stream_sender_t * me, uint64_t time_now);
+bool orion_stream_sender_is_complete(const orion_stream_sender_t * me);
+orion_stream_statistics_t orion_stream_sender_get_statistics(const orion_stream_sender_t * me);
+
+/*
+  @buffer - receives data of streams up to buffer_size bytes, bigger ones are ignored
+*/
+void orion_stream_receiver_init(orion_stream_receiver_t * me, uint8_t * buffer, uint32_t buffer_size);
+/*
+  Forgets the current stream but keeps the buffer, e.g. when sender starts over and numbers streams from 1 again
+*/
+void orion_stream_receiver_reset(orion_stream_receiver_t * me);
+/*
+  Takes data of segment and fills acknowledgment which should be sent back.
+  Stream with newer id than the current one replaces it. Returns false for malformed segment.
+*/
+bool orion_stream_receiver_on_segment(orion_stream_receiver_t * me, const uint8_t * packet, uint32_t size,
+  orion_control_stream_ack_t * ack);
+/*
+  Returns true when all data of the current stream is in the buffer
+  @size - size of the stream, could be NULL
+*/
+bool orion_stream_receiver_is_complete(const orion_stream_receiver_t * me, uint32_t * size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_STREAM_H
@@ -41,7 +41,7 @@ orion_timeout_error_t;
 
 typedef struct
 {
-  clock_t till_time_;
+  uint64_t till_time_;  // microseconds of monotonic clock
 }
 orion_timeout_t;
 
@@ -53,6 +53,12 @@ orion_timeout_error_t orion_timeout_init(orion_timeout_t * me, uint32_t timeout)
 bool orion_timeout_has_time(const orion_timeout_t * me);
 uint32_t orion_timeout_time_left(const orion_timeout_t * me);
 
+/*
+  Microseconds of monotonic clock, CLOCK_MONOTONIC where it is available.
+  Firmware without it, or with a timer it prefers, is built with ORION_TIMEOUT_EXTERNAL_CLOCK and implements this.
+*/
+uint64_t orion_timeout_get_time_now(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,56 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef ORION_PROTOCOL_ORION_TOKEN_BUCKET_H
+#define ORION_PROTOCOL_ORION_TOKEN_BUCKET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+  Limits average rate of tokens (e.g. bytes sent) while allowing bursts up to capacity.
+  Time is passed by caller in microseconds of any monotonic clock, so it works with timers of MCU.
+*/
+typedef struct
+{
+  uint32_t rate_;  // tokens per second, 0 means unlimited
+  uint32_t capacity_;
+  uint32_t tokens_;
+  uint32_t remainder_;  // fraction of token accumulated, in millionths
+  uint64_t last_time_;
+}
+orion_token_bucket_t;
+
+void orion_token_bucket_init(orion_token_bucket_t * me, uint32_t rate, uint32_t capacity, uint64_t time_now);
+bool orion_token_bucket_consume(orion_token_bucket_t * me, uint32_t tokens, uint64_t time_now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ORION_PROTOCOL_ORION_TOKEN_BUCKET_H
@@ -29,12 +29,43 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include "orion_protocol/orion_communication.h"
+#include "orion_protocol/orion_framer.h"
+#include "orion_protocol/orion_lz.h"
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/*
+  Frame size is the biggest packet (including frame header) transport can send or receive,
+  queue size is the amount of raw bytes buffered from communication while looking for frame delimiters.
+  Both could be overridden by build for small targets.
+*/
+#ifndef ORION_TRANSPORT_DEFAULT_FRAME_SIZE
+#define ORION_TRANSPORT_DEFAULT_FRAME_SIZE (512)
+#endif
+
+#ifndef ORION_TRANSPORT_DEFAULT_QUEUE_SIZE
+#define ORION_TRANSPORT_DEFAULT_QUEUE_SIZE (1024)
+#endif
+
+#define ORION_TRANSPORT_MAX_FRAME_SIZE (65536)
+
+/*
+  Bytes of buffer passed to orion_transport_set_compression_buffer: compressed frame followed by
+  hash table of compressor with 2^table_bits entries
+*/
+#define ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(frame_size, table_bits) \
+  (((frame_size) + 1) / 2 * 2 + ORION_LZ_TABLE_SIZE(table_bits))
+
+/*
+  Bytes of buffers allocated by transport in addition to its control structure:
+  receive and send frame buffers, buffer for packing sent containers and receive queue
+*/
+#define ORION_TRANSPORT_BUFFERS_FOOTPRINT(frame_size, queue_size) \
+  (2 * ORION_FRAMER_MAX_ENCODED_SIZE(frame_size) + (frame_size) + (queue_size))
+
 typedef enum
 {
   ORION_TRAN_ERROR_NONE = 0,
@@ -46,22 +77,182 @@ typedef enum
   ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET = -6,
   ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET = -7,
   ORION_TRAN_ERROR_CRC_CHECK_FAILED = -8,
-  ORION_TRAN_ERROR_UNKNOWN = -9
+  ORION_TRAN_ERROR_PACKET_TOO_BIG = -9,
+  ORION_TRAN_ERROR_INCOMPLETE_MESSAGE = -10,  // fragment received, the rest of message is still on its way
+  ORION_TRAN_ERROR_UNKNOWN = -11
 }
 orion_transport_error_t;
 
+/*
+  Behaviour when received bytes do not fit into transport queue:
+  BACKPRESSURE - read from communication only as much as queue can take, the rest stays in OS or peer buffers
+  DROP_OLDEST - discard complete frames from the head of the queue to make room for new bytes
+  DROP_NEWEST - keep queued frames and discard incoming bytes till the next frame delimiter
+*/
+typedef enum
+{
+  ORION_TRAN_OVERFLOW_POLICY_BACKPRESSURE = 0,
+  ORION_TRAN_OVERFLOW_POLICY_DROP_OLDEST,
+  ORION_TRAN_OVERFLOW_POLICY_DROP_NEWEST
+}
+orion_transport_overflow_policy_t;
+
+typedef struct
+{
+  uint32_t dropped_frames;
+  uint32_t dropped_bytes;
+  uint32_t backpressure_events;  // reads cut short because queue was full or had no room for more
+}
+orion_transport_overflow_counters_t;
+
+typedef struct
+{
+  uint32_t frames;
+  uint32_t bytes;  // encoded bytes passed to communication
+  uint32_t encode_errors;
+  uint32_t communication_errors;
+  uint32_t too_big_errors;
+  uint32_t packed_messages;  // messages sent inside containers
+  uint32_t fragments;
+  uint32_t compressed_frames;
+  uint32_t compression_saved_bytes;  // frame bytes (before encoding) saved by compression
+}
+orion_transport_tx_statistics_t;
+
+typedef struct
+{
+  uint32_t frames;  // frames which passed all checks
+  uint32_t bytes;  // raw bytes received from communication
+  uint32_t decode_errors;
+  uint32_t partial_frames;  // frames too short to contain frame header
+  uint32_t crc_errors;
+  uint32_t too_big_errors;
+  uint32_t garbage_bytes;  // bytes skipped while looking for the start of frame
+  uint32_t communication_errors;
+  uint32_t queue_high_water_mark;
+  uint32_t unpacked_messages;  // messages received inside containers
+  uint32_t fragments;
+  uint32_t reassembly_errors;  // transfers dropped because of lost fragment or no room in reassembly buffer
+  uint32_t decompressed_frames;
+  orion_transport_overflow_counters_t overflow;
+}
+orion_transport_rx_statistics_t;
+
+typedef struct
+{
+  orion_transport_tx_statistics_t tx;
+  orion_transport_rx_statistics_t rx;
+}
+orion_transport_statistics_t;
+
+/*
+  Settings of link agreed with peer by handshake (see orion_control.h), transport starts with
+  no capabilities, its own frame size and CRC16
+*/
+typedef struct
+{
+  uint32_t capabilities;
+  uint32_t frame_size;  // biggest frame sent, received ones are limited by frame size of transport only
+  uint32_t baud;  // 0 when peers could not switch baud rate
+  uint16_t window;  // segments of stream in flight, 0 when not negotiated
+  uint8_t checksum;  // ORION_CONTROL_CHECKSUM_*
+}
+orion_transport_link_t;
+
+/*
+  One of packets sent together by orion_transport_send_packets
+*/
+typedef struct
+{
+  uint8_t *buffer;
+  uint32_t size;
+}
+orion_transport_packet_t;
+
 struct orion_transport_struct_t;
 
 typedef struct orion_transport_struct_t orion_transport_t;
 
 orion_transport_error_t orion_transport_new(orion_transport_t ** me, orion_communication_t * communication);
+orion_transport_error_t orion_transport_new_with_size(orion_transport_t ** me, orion_communication_t * communication,
+  uint32_t frame_size, uint32_t queue_size);
 orion_transport_error_t orion_transport_delete(const orion_transport_t * me);
 
 orion_transport_error_t orion_transport_send_packet(orion_transport_t * me, uint8_t *input_buffer,
   uint32_t input_size, uint32_t timeout);
+/*
+  Frames all packets back to back and sends them with as few writes as send buffer allows, usually one.
+  When containers are enabled, consecutive packets which fit into frame size share a single container frame.
+  When fragments are enabled, packets bigger than frame size are streamed as fragments back to back,
+  otherwise nothing is sent if any packet is bigger than frame size.
+*/
+orion_transport_error_t orion_transport_send_packets(orion_transport_t * me, orion_transport_packet_t *packets,
+  uint32_t count, uint32_t timeout);
+/*
+  Sends packet in parts, so that the link could carry other frames between them without breaking the transfer.
+  Packet bigger than frame size goes as fragments till about @max_size bytes of them are written, at least one,
+  any other packet goes whole.
+  @offset - 0 for the first part, then the value returned for the previous one
+  Returns offset of the next part, which is input_size when the whole packet is sent, or error
+*/
+ssize_t orion_transport_send_part(orion_transport_t * me, uint8_t *input_buffer, uint32_t input_size,
+  uint32_t offset, uint32_t max_size, uint32_t timeout);
+/*
+  Frames packet into @frame without sending it, so that the same frame could be sent again by
+  orion_transport_send_frame without encoding. Returns size of encoded frame.
+*/
+ssize_t orion_transport_encode_packet(orion_transport_t * me, uint8_t *input_buffer, uint32_t input_size,
+  uint8_t *frame, uint32_t frame_size);
+/*
+  Sends frame made by orion_transport_encode_packet as is
+*/
+orion_transport_error_t orion_transport_send_frame(orion_transport_t * me, uint8_t *frame, uint32_t size,
+  uint32_t timeout);
 ssize_t orion_transport_receive_packet(orion_transport_t * me, uint8_t *output_buffer, uint32_t output_size,
   uint32_t timeout);
 bool orion_transport_has_received_packet(orion_transport_t * me);
+uint32_t orion_transport_get_frame_size(const orion_transport_t * me);
+orion_transport_error_t orion_transport_set_overflow_policy(orion_transport_t * me,
+  orion_transport_overflow_policy_t policy);
+/*
+  Containers are sent only when peer supports them (see handshake in orion_control.h),
+  received ones are always unpacked and returned message by message.
+*/
+orion_transport_error_t orion_transport_set_containers(orion_transport_t * me, bool enabled);
+/*
+  Fragments are sent only when peer supports them (see handshake in orion_control.h)
+*/
+orion_transport_error_t orion_transport_set_fragments(orion_transport_t * me, bool enabled);
+/*
+  Received fragments are collected in @buffer, which should outlive transport or be replaced by another one.
+  Complete message is copied into output buffer of orion_transport_receive_packet, which returns
+  ORION_TRAN_ERROR_INCOMPLETE_MESSAGE for every fragment before the last one.
+  @size - biggest message expected including its frame header, NULL buffer stops reassembly
+*/
+orion_transport_error_t orion_transport_set_reassembly_buffer(orion_transport_t * me, uint8_t *buffer,
+  uint32_t size);
+/*
+  Frames sent by orion_transport_send_packets (containers included) are compressed when that makes them smaller,
+  the rest go raw. Compression should be enabled only when peer supports it (see handshake in orion_control.h),
+  received compressed frames are always decompressed. orion_transport_encode_packet never compresses.
+  @buffer - 2 byte aligned, at least ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(frame_size, ORION_LZ_MIN_TABLE_BITS),
+  the rest of it makes the hash table bigger, which finds more matches. NULL buffer stops compression.
+*/
+orion_transport_error_t orion_transport_set_compression_buffer(orion_transport_t * me, uint8_t *buffer,
+  uint32_t size);
+/*
+  Caches link settings, frames are sent up to their frame size and with their checksum from now on.
+  Received frames pass with either agreed checksum or CRC16.
+*/
+orion_transport_error_t orion_transport_set_link(orion_transport_t * me, const orion_transport_link_t * link);
+orion_transport_error_t orion_transport_get_link(const orion_transport_t * me, orion_transport_link_t * link);
+orion_transport_error_t orion_transport_get_overflow_counters(const orion_transport_t * me,
+  orion_transport_overflow_counters_t * counters);
+/*
+  Safe to call from any thread, each of tx and rx sections is a consistent snapshot
+*/
+orion_transport_error_t orion_transport_get_statistics(const orion_transport_t * me,
+  orion_transport_statistics_t * statistics);
 
 #ifdef __cplusplus
 }
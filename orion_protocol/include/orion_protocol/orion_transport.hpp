@@ -42,9 +42,18 @@ public:
     orion_transport_new(&object_, communication->getObject());
   }
 
+  Transport(Communication * communication, uint32_t frame_size, uint32_t queue_size)
+  {
+    ORION_ASSERT_NOT_NULL(communication);
+    orion_transport_new_with_size(&object_, communication->getObject(), frame_size, queue_size);
+  }
+
   virtual ~Transport()
   {
-    orion_transport_delete(object_);
+    if (owned_)
+    {
+      orion_transport_delete(object_);
+    }
   }
 
   virtual orion_transport_error_t sendPacket(uint8_t *input_buffer, uint32_t input_size, uint32_t timeout)
@@ -52,6 +61,27 @@ public:
     return (orion_transport_send_packet(object_, input_buffer, input_size, timeout));
   }
 
+  virtual orion_transport_error_t sendPackets(orion_transport_packet_t *packets, uint32_t count, uint32_t timeout)
+  {
+    return (orion_transport_send_packets(object_, packets, count, timeout));
+  }
+
+  virtual ssize_t sendPart(uint8_t *input_buffer, uint32_t input_size, uint32_t offset, uint32_t max_size,
+    uint32_t timeout)
+  {
+    return (orion_transport_send_part(object_, input_buffer, input_size, offset, max_size, timeout));
+  }
+
+  virtual ssize_t encodePacket(uint8_t *input_buffer, uint32_t input_size, uint8_t *frame, uint32_t frame_size)
+  {
+    return (orion_transport_encode_packet(object_, input_buffer, input_size, frame, frame_size));
+  }
+
+  virtual orion_transport_error_t sendFrame(uint8_t *frame, uint32_t size, uint32_t timeout)
+  {
+    return (orion_transport_send_frame(object_, frame, size, timeout));
+  }
+
   virtual ssize_t receivePacket(uint8_t *output_buffer, uint32_t output_size, uint32_t timeout)
   {
     return (orion_transport_receive_packet(object_, output_buffer, output_size, timeout));
@@ -62,13 +92,74 @@ public:
     return (orion_transport_has_received_packet(object_));
   }
 
-  orion_transport_t* getObject()
+  virtual orion_transport_error_t setContainers(bool enabled)
+  {
+    return (orion_transport_set_containers(object_, enabled));
+  }
+
+  virtual orion_transport_error_t setFragments(bool enabled)
+  {
+    return (orion_transport_set_fragments(object_, enabled));
+  }
+
+  virtual orion_transport_error_t setReassemblyBuffer(uint8_t *buffer, uint32_t size)
   {
-    return object_;
+    return (orion_transport_set_reassembly_buffer(object_, buffer, size));
   }
 
+  virtual orion_transport_error_t setCompressionBuffer(uint8_t *buffer, uint32_t size)
+  {
+    return (orion_transport_set_compression_buffer(object_, buffer, size));
+  }
+
+  virtual uint32_t getFrameSize()
+  {
+    return (orion_transport_get_frame_size(object_));
+  }
+
+  virtual orion_transport_error_t setLink(const orion_transport_link_t &link)
+  {
+    return (orion_transport_set_link(object_, &link));
+  }
+
+  virtual orion_transport_link_t getLink()
+  {
+    orion_transport_link_t result;
+    orion_transport_get_link(object_, &result);
+    return (result);
+  }
+
+  virtual orion_transport_error_t setOverflowPolicy(orion_transport_overflow_policy_t policy)
+  {
+    return (orion_transport_set_overflow_policy(object_, policy));
+  }
+
+  virtual orion_transport_overflow_counters_t getOverflowCounters()
+  {
+    orion_transport_overflow_counters_t result;
+    orion_transport_get_overflow_counters(object_, &result);
+    return (result);
+  }
+
+  virtual orion_transport_statistics_t getStatistics()
+  {
+    orion_transport_statistics_t result;
+    orion_transport_get_statistics(object_, &result);
+    return (result);
+  }
+
+  virtual orion_transport_t* getObject()
+  {
+    return (object_);
+  }
+
+protected:
+  // Transport without C object of its own, e.g. logical channel which overrides all virtual methods
+  Transport() : object_(nullptr), owned_(false) {}
+
 private:
   orion_transport_t * object_;
+  bool owned_ = true;
 };
 
 }  // namespace orion
@@ -58,6 +58,32 @@ bool orion_circular_buffer_is_empty(const orion_circular_buffer_t * p_this)
     return (result);
 }
 
+uint32_t orion_circular_buffer_get_size(const orion_circular_buffer_t * p_this)
+{
+    assert(NULL != p_this);
+    uint32_t result = 0;
+    if (p_this->is_full)
+    {
+        result = p_this->buffer_size;
+    }
+    else if (p_this->tail_index >= p_this->head_index)
+    {
+        result = p_this->tail_index - p_this->head_index;
+    }
+    else
+    {
+        result = p_this->buffer_size - p_this->head_index + p_this->tail_index;
+    }
+    return (result);
+}
+
+uint32_t orion_circular_buffer_get_free_size(const orion_circular_buffer_t * p_this)
+{
+    assert(NULL != p_this);
+    uint32_t result = p_this->buffer_size - orion_circular_buffer_get_size(p_this);
+    return (result);
+}
+
 void orion_circular_buffer_add(orion_circular_buffer_t * p_this, const uint8_t * p_buffer, uint32_t size)
 {
     assert(NULL != p_this);
@@ -244,6 +270,31 @@ bool orion_circular_buffer_has_word(const orion_circular_buffer_t * p_this, uint
     return (result);
 }
 
+uint32_t orion_circular_buffer_get_word_size(const orion_circular_buffer_t * p_this, uint8_t delimeter)
+{
+    uint32_t start_index = 0;
+    uint32_t end_index = 0;
+    uint32_t result = 0;
+    if (find_word(p_this, &start_index, &end_index, delimeter))
+    {
+        result = get_word_size(p_this, start_index, end_index);
+    }
+    return (result);
+}
+
+bool orion_circular_buffer_drop_word(orion_circular_buffer_t * p_this, uint8_t delimeter)
+{
+    uint32_t start_index = 0;
+    uint32_t end_index = 0;
+    bool result = find_word(p_this, &start_index, &end_index, delimeter);
+    if (result)
+    {
+        p_this->head_index = (end_index + 1) % p_this->buffer_size;
+        p_this->is_full = false;
+    }
+    return (result);
+}
+
 bool orion_circular_buffer_dequeue_word(orion_circular_buffer_t * p_this, uint8_t delimeter, uint8_t * p_buffer, 
     uint32_t size, uint32_t * p_actual_size)
 {
@@ -261,3 +312,43 @@ bool orion_circular_buffer_dequeue_word(orion_circular_buffer_t * p_this, uint8_
     }
     return (result);
 }
+
+bool orion_circular_buffer_peek_word(const orion_circular_buffer_t * p_this, uint8_t delimeter, uint8_t * p_buffer,
+    uint32_t size, uint32_t * p_actual_size)
+{
+    assert(NULL != p_buffer);
+    assert(NULL != p_actual_size);
+
+    uint32_t start_index = 0;
+    uint32_t end_index = 0;
+    bool result = find_word(p_this, &start_index, &end_index, delimeter);
+    if (result)
+    {
+        uint32_t word_size = get_word_size(p_this, start_index, end_index);
+        assert(size >= word_size);
+
+        uint32_t first_part = p_this->buffer_size - start_index;
+        if (first_part > word_size)
+        {
+            first_part = word_size;
+        }
+        memcpy(&p_buffer[0], &p_this->p_buffer[start_index], first_part);
+        memcpy(&p_buffer[first_part], &p_this->p_buffer[0], word_size - first_part);
+        *p_actual_size = word_size;
+    }
+    return (result);
+}
+
+bool orion_circular_buffer_release_word(orion_circular_buffer_t * p_this, uint8_t delimeter)
+{
+    uint32_t start_index = 0;
+    uint32_t end_index = 0;
+    bool result = find_word(p_this, &start_index, &end_index, delimeter);
+    if (result)
+    {
+        // Closing delimiter stays in buffer, it could be the opening one of the next word
+        p_this->head_index = end_index;
+        p_this->is_full = false;
+    }
+    return (result);
+}
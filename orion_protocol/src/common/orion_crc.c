@@ -43,3 +43,23 @@ uint16_t orion_crc_calculate_crc16(const uint8_t *data, size_t length)
   }
   return result;
 }
+
+uint16_t orion_crc_calculate_fletcher16(const uint8_t *data, size_t length)
+{
+  uint32_t sum1 = 0;
+  uint32_t sum2 = 0;
+  while (length > 0)
+  {
+    // Sums of this many bytes fit into 32 bits, so modulo is taken once per block instead of every byte
+    size_t block = (length < 5802) ? length : 5802;
+    length -= block;
+    for (; block > 0; block--)
+    {
+      sum1 += *data++;
+      sum2 += sum1;
+    }
+    sum1 %= 255;
+    sum2 %= 255;
+  }
+  return (uint16_t)((sum2 << 8) | sum1);
+}
@@ -0,0 +1,233 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include <string.h>
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_header.h"
+#include "orion_protocol/orion_delta.h"
+
+#define ZEROS_SHIFT (3)
+#define ZEROS_SKIP (31)  // zeros of token without literals
+#define LITERALS_MAX (8)
+
+static ssize_t encode_runs(const uint8_t * keyframe, const uint8_t * message, uint32_t size, uint8_t * output,
+  uint32_t limit);
+static bool decode_runs(const uint8_t * input, uint32_t input_size, uint8_t * message, uint32_t size);
+
+void orion_delta_encoder_init(orion_delta_encoder_t * me, uint8_t * keyframe, uint32_t capacity,
+  uint32_t keyframe_interval)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(keyframe);
+  ORION_ASSERT(capacity >= sizeof(orion_command_header_t));
+  ORION_ASSERT(keyframe_interval > 0);
+
+  memset(me, 0, sizeof(*me));
+  me->keyframe_ = keyframe;
+  me->capacity_ = capacity;
+  me->keyframe_interval_ = keyframe_interval;
+}
+
+void orion_delta_encoder_reset(orion_delta_encoder_t * me)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  me->size_ = 0;
+}
+
+ssize_t orion_delta_encode(orion_delta_encoder_t * me, const uint8_t * message, uint32_t size, uint8_t * packet,
+  uint32_t packet_size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(message);
+  ORION_ASSERT_NOT_NULL(packet);
+  ORION_ASSERT((size >= sizeof(orion_command_header_t)) && (size <= me->capacity_));
+  ORION_ASSERT(packet_size >= ORION_DELTA_MAX_PACKET_SIZE(size));
+
+  orion_control_delta_t *header = (orion_control_delta_t*)packet;
+  memset(header, 0, sizeof(*header));
+  header->header.common.message_id = ORION_CONTROL_MESSAGE_ID_DELTA;
+  header->header.common.version = ORION_CONTROL_DELTA_VERSION;
+  header->header.common.oldest_compatible_version = ORION_CONTROL_DELTA_VERSION;
+  header->header.common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+  header->message_id = ((const orion_command_header_t*)message)->common.message_id;
+
+  uint32_t raw_size = size - sizeof(orion_frame_header_t);
+  ssize_t delta_size = -1;
+  if ((size == me->size_) && (me->deltas_ + 1 < me->keyframe_interval_))
+  {
+    delta_size = encode_runs(me->keyframe_, message, size, packet + sizeof(orion_control_delta_t), raw_size);
+  }
+
+  if (delta_size < 0)
+  {
+    memcpy(me->keyframe_, message, size);
+    me->size_ = size;
+    me->keyframe_id_++;
+    me->deltas_ = 0;
+    header->flags = ORION_CONTROL_DELTA_FLAG_KEYFRAME;
+    header->keyframe_id = me->keyframe_id_;
+    memcpy(packet + sizeof(orion_control_delta_t), message + sizeof(orion_frame_header_t), raw_size);
+    return (sizeof(orion_control_delta_t) + raw_size);
+  }
+
+  me->deltas_++;
+  header->keyframe_id = me->keyframe_id_;
+  return (sizeof(orion_control_delta_t) + delta_size);
+}
+
+void orion_delta_decoder_init(orion_delta_decoder_t * me, uint8_t * keyframe, uint32_t capacity)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(keyframe);
+
+  memset(me, 0, sizeof(*me));
+  me->keyframe_ = keyframe;
+  me->capacity_ = capacity;
+}
+
+ssize_t orion_delta_decode(orion_delta_decoder_t * me, const uint8_t * packet, uint32_t size, uint8_t * message,
+  uint32_t message_size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(packet);
+  ORION_ASSERT_NOT_NULL(message);
+
+  const orion_control_delta_t *header = (const orion_control_delta_t*)packet;
+  if (size < sizeof(orion_control_delta_t))
+  {
+    return (ORION_DELTA_ERROR_DECODING_FAILED);
+  }
+  const uint8_t *body = packet + sizeof(orion_control_delta_t);
+  uint32_t body_size = size - sizeof(orion_control_delta_t);
+
+  if (0 != (header->flags & ORION_CONTROL_DELTA_FLAG_KEYFRAME))
+  {
+    uint32_t keyframe_size = sizeof(orion_frame_header_t) + body_size;
+    if (keyframe_size < sizeof(orion_command_header_t))
+    {
+      return (ORION_DELTA_ERROR_DECODING_FAILED);
+    }
+    if ((keyframe_size > me->capacity_) || (keyframe_size > message_size))
+    {
+      return (ORION_DELTA_ERROR_BUFFER_TOO_SMALL);
+    }
+    memset(me->keyframe_, 0, sizeof(orion_frame_header_t));
+    memcpy(me->keyframe_ + sizeof(orion_frame_header_t), body, body_size);
+    me->size_ = keyframe_size;
+    me->keyframe_id_ = header->keyframe_id;
+    memcpy(message, me->keyframe_, me->size_);
+    return (me->size_);
+  }
+
+  // Message keeps size of its keyframe, the encoder sends a new keyframe otherwise
+  if ((0 == me->size_) || (header->keyframe_id != me->keyframe_id_))
+  {
+    return (ORION_DELTA_ERROR_NO_KEYFRAME);
+  }
+  if (me->size_ > message_size)
+  {
+    return (ORION_DELTA_ERROR_BUFFER_TOO_SMALL);
+  }
+  memcpy(message, me->keyframe_, me->size_);
+  if (!decode_runs(body, body_size, message, me->size_))
+  {
+    return (ORION_DELTA_ERROR_DECODING_FAILED);
+  }
+  return (me->size_);
+}
+
+ssize_t encode_runs(const uint8_t * keyframe, const uint8_t * message, uint32_t size, uint8_t * output,
+  uint32_t limit)
+{
+  // Frame header is not coded, delta pays off only when it is smaller than message without frame header
+  uint32_t position = sizeof(orion_frame_header_t);
+  uint32_t output_size = 0;
+  while (position < size)
+  {
+    uint32_t zeros = 0;
+    while ((position < size) && (keyframe[position] == message[position]))
+    {
+      zeros++;
+      position++;
+    }
+    if (position == size)
+    {
+      break;
+    }
+    for (; zeros >= ZEROS_SKIP; zeros -= ZEROS_SKIP)
+    {
+      if (output_size + 1 >= limit)
+      {
+        return (-1);
+      }
+      output[output_size++] = ZEROS_SKIP << ZEROS_SHIFT;
+    }
+
+    // Single equal byte is cheaper as a literal than as a new run
+    uint32_t start = position;
+    while ((position < size) && (position - start < LITERALS_MAX) && !((keyframe[position] == message[position]) &&
+      ((position + 1 == size) || (keyframe[position + 1] == message[position + 1]))))
+    {
+      position++;
+    }
+    uint32_t literals = position - start;
+    if (output_size + 1 + literals >= limit)
+    {
+      return (-1);
+    }
+    output[output_size++] = (uint8_t)((zeros << ZEROS_SHIFT) | (literals - 1));
+    for (uint32_t index = start; index < position; index++)
+    {
+      output[output_size++] = keyframe[index] ^ message[index];
+    }
+  }
+  return (output_size);
+}
+
+bool decode_runs(const uint8_t * input, uint32_t input_size, uint8_t * message, uint32_t size)
+{
+  uint32_t position = sizeof(orion_frame_header_t);
+  uint32_t index = 0;
+  while (index < input_size)
+  {
+    uint8_t token = input[index++];
+    position += token >> ZEROS_SHIFT;
+    if (ZEROS_SKIP == (token >> ZEROS_SHIFT))
+    {
+      continue;
+    }
+    uint32_t literals = (token & (LITERALS_MAX - 1)) + 1;
+    if ((literals > input_size - index) || (position > size) || (literals > size - position))
+    {
+      return (false);
+    }
+    for (uint32_t offset = 0; offset < literals; offset++)
+    {
+      message[position + offset] ^= input[index + offset];
+    }
+    position += literals;
+    index += literals;
+  }
+  return (true);
+}
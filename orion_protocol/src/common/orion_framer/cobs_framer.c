@@ -27,22 +27,27 @@
 #define FinishBlock() (*code_ptr = index)
 
 static size_t encode(const uint8_t *input, size_t length, uint8_t *output);
-static size_t decode(const uint8_t *input, size_t length, uint8_t *output);
+static ssize_t decode(const uint8_t *input, size_t length, uint8_t *output, size_t buffer_length);
 
-// TODO(Andriy): fix parameter description
 /**
  *
- * @param data[in] 			pointer on data that should be encoded. At the end should be reserved memory for header
- * @param len[in]			len of data that should be encoded plus reserved size.
- * @param packet[out]		pointer on output buffer that will contain complete frame.
- * @param avail_len[in]		Available len in out buffer.
- * @return Resulting length of encoded data.
+ * @param data[in]          pointer on data that should be encoded.
+ * @param length[in]        length of data that should be encoded.
+ * @param packet[out]       pointer on output buffer that will contain complete frame.
+ * @param buffer_length[in] available length in output buffer,
+ *                          should be at least ORION_FRAMER_MAX_ENCODED_SIZE(length).
+ * @return Resulting length of encoded frame or ORION_FRM_ERROR_BUFFER_TOO_SMALL.
  */
 ssize_t orion_framer_encode_packet(const uint8_t* data, size_t length, uint8_t* packet, size_t buffer_length)
 {
   ssize_t result = 0;
   size_t value = 0;
 
+  if (ORION_FRAMER_MAX_ENCODED_SIZE(length) > buffer_length)
+  {
+    return (ORION_FRM_ERROR_BUFFER_TOO_SMALL);
+  }
+
   // Start 0
   packet[result++] = ORION_FRAMER_FRAME_DELIMETER;
 
@@ -62,23 +67,21 @@ ssize_t orion_framer_encode_packet(const uint8_t* data, size_t length, uint8_t*
   return (result);
 }
 
-// TODO(Andriy): fix parameter description
 /**
  *
- * @param packet[in]		Pointer on data that should be decoded.
- * @param len[in]			Length on data
- * @param data[out]			Pointer on output buffer where decoded data will be placed.
- * @param avail_len[out]	Available size of data buffer
- * @return Length of decoded data
+ * @param packet[in]        pointer on frame that should be decoded including both delimiters.
+ * @param length[in]        length of frame.
+ * @param data[out]         pointer on output buffer where decoded data will be placed.
+ * @param buffer_length[in] available size of data buffer.
+ * @return Length of decoded data, ORION_FRM_ERROR_DECODING_FAILED or ORION_FRM_ERROR_BUFFER_TOO_SMALL.
  */
 ssize_t orion_framer_decode_packet(const uint8_t* packet, size_t length, uint8_t* data, size_t buffer_length)
 {
-  ssize_t result = decode(&packet[1], length, data);
-  if (result < 1)
+  if ((length < 2) || (ORION_FRAMER_FRAME_DELIMETER != packet[0]))
   {
     return (ORION_FRM_ERROR_DECODING_FAILED);
   }
-  result--;  // TODO(Andriy): Understand why ?
+  ssize_t result = decode(&packet[1], length - 1, data, buffer_length);
   return (result);
 }
 
@@ -110,41 +113,54 @@ size_t encode(const uint8_t *input, size_t length, uint8_t *output)
 }
 
 /*
- * decode - decodes "length" bytes of data at
- * the location pointed to by "input", writing the
- * output to the location pointed to by "output".
+ * decode - decodes at most "length" bytes of data at
+ * the location pointed to by "input" till the end delimiter,
+ * writing the output to the location pointed to by "output".
  *
- * Returns the length of the decoded data
- * (which is guaranteed to be <= length).
+ * Returns the length of the decoded data or negative error
+ * when code byte points outside of the input, block contains
+ * delimiter, frame is not closed by the last byte or output does not fit.
  */
-size_t decode(const uint8_t *input, size_t length, uint8_t *output)
+ssize_t decode(const uint8_t *input, size_t length, uint8_t *output, size_t buffer_length)
 {
   const uint8_t *start = output;
   const uint8_t *end = input + length;
-  uint8_t index = 0xFF;
-  uint8_t inverse_index = 0;
+  const uint8_t *output_end = output + buffer_length;
 
-  while (input < end)
+  while ((input < end) && (ORION_FRAMER_FRAME_DELIMETER != *input))
   {
-    if (0 != inverse_index)
+    uint8_t index = *input++;
+    if ((size_t)(end - input) < (size_t)(index - 1))
     {
-      *output++ = *input++;
+      return (ORION_FRM_ERROR_DECODING_FAILED);
+    }
+    if ((size_t)(output_end - output) < (size_t)(index - 1))
+    {
+      return (ORION_FRM_ERROR_BUFFER_TOO_SMALL);
     }
-    else
+    for (uint8_t counter = 1; counter < index; counter++)
     {
-      if (0xFF != index)
+      if (ORION_FRAMER_FRAME_DELIMETER == *input)
       {
-        *output++ = ORION_FRAMER_FRAME_DELIMETER;
+        // Delimiter inside of block means that bytes were lost
+        return (ORION_FRM_ERROR_DECODING_FAILED);
       }
-      index = *input++;
-      inverse_index = index;
-      if (0 == index)
+      *output++ = *input++;
+    }
+    // Block shorter than maximum is followed by zero unless it is the last one
+    if ((0xFF != index) && (input < end) && (ORION_FRAMER_FRAME_DELIMETER != *input))
+    {
+      if (output >= output_end)
       {
-        // Source length exceeded limits of 255 symbols
-        break;
+        return (ORION_FRM_ERROR_BUFFER_TOO_SMALL);
       }
+      *output++ = ORION_FRAMER_FRAME_DELIMETER;
     }
-    inverse_index--;
   }
-  return output - start;
+  // Frame has to be closed by delimiter which is the last byte
+  if ((input + 1) != end)
+  {
+    return (ORION_FRM_ERROR_DECODING_FAILED);
+  }
+  return (output - start);
 }
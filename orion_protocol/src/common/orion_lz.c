@@ -0,0 +1,251 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include <string.h>
+#include <stdbool.h>
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_lz.h"
+
+#define NIBBLE_MAX (15)
+#define LENGTH_BYTE_MAX (255)
+// Literal runs longer than this make compressor step faster over data that does not compress
+#define SKIP_TRIGGER_BITS (5)
+
+static uint32_t read_word(const uint8_t * data);
+static uint32_t hash_word(uint32_t word, uint32_t table_bits);
+static bool write_length(uint8_t * output, uint32_t output_size, uint32_t * position, uint32_t length);
+static bool read_length(const uint8_t * input, uint32_t input_size, uint32_t * position, uint32_t * length);
+static bool write_sequence(uint8_t * output, uint32_t output_size, uint32_t * position,
+  const uint8_t * literals, uint32_t literal_count, uint32_t offset, uint32_t match_length);
+
+ssize_t orion_lz_compress(const uint8_t * input, uint32_t input_size, uint8_t * output, uint32_t output_size,
+  uint16_t * table, uint32_t table_bits)
+{
+  ORION_ASSERT((NULL != input) || (0 == input_size));
+  ORION_ASSERT_NOT_NULL(output);
+  ORION_ASSERT_NOT_NULL(table);
+  ORION_ASSERT(input_size <= ORION_LZ_MAX_INPUT_SIZE);
+  ORION_ASSERT((table_bits >= ORION_LZ_MIN_TABLE_BITS) && (table_bits <= ORION_LZ_MAX_TABLE_BITS));
+
+  memset(table, 0, ORION_LZ_TABLE_SIZE(table_bits));
+
+  uint32_t position = 0;
+  uint32_t anchor = 0;
+  uint32_t index = 0;
+  while (index + ORION_LZ_MIN_MATCH <= input_size)
+  {
+    uint32_t word = read_word(input + index);
+    uint32_t hash = hash_word(word, table_bits);
+    uint32_t candidate = table[hash];
+    table[hash] = (uint16_t)index;
+
+    // Empty slots point to start of input, so every candidate is checked by its contents
+    if ((candidate < index) && (read_word(input + candidate) == word))
+    {
+      uint32_t length = ORION_LZ_MIN_MATCH;
+      while ((index + length < input_size) && (input[candidate + length] == input[index + length]))
+      {
+        length++;
+      }
+      if (!write_sequence(output, output_size, &position, input + anchor, index - anchor, index - candidate, length))
+      {
+        return (ORION_LZ_ERROR_BUFFER_TOO_SMALL);
+      }
+      index += length;
+      anchor = index;
+    }
+    else
+    {
+      index += 1 + ((index - anchor) >> SKIP_TRIGGER_BITS);
+    }
+  }
+
+  if ((anchor < input_size) &&
+    !write_sequence(output, output_size, &position, input + anchor, input_size - anchor, 0, 0))
+  {
+    return (ORION_LZ_ERROR_BUFFER_TOO_SMALL);
+  }
+
+  return (position);
+}
+
+ssize_t orion_lz_decompress(const uint8_t * input, uint32_t input_size, uint8_t * output, uint32_t output_size)
+{
+  ORION_ASSERT((NULL != input) || (0 == input_size));
+  ORION_ASSERT((NULL != output) || (0 == output_size));
+
+  uint32_t position = 0;
+  uint32_t size = 0;
+  while (position < input_size)
+  {
+    uint8_t token = input[position++];
+
+    uint32_t literal_count = token >> 4;
+    if ((NIBBLE_MAX == literal_count) && !read_length(input, input_size, &position, &literal_count))
+    {
+      return (ORION_LZ_ERROR_DECODING_FAILED);
+    }
+    if (literal_count > input_size - position)
+    {
+      return (ORION_LZ_ERROR_DECODING_FAILED);
+    }
+    if (literal_count > output_size - size)
+    {
+      return (ORION_LZ_ERROR_BUFFER_TOO_SMALL);
+    }
+    memcpy(output + size, input + position, literal_count);
+    position += literal_count;
+    size += literal_count;
+
+    if (input_size == position)
+    {
+      break;
+    }
+
+    if (input_size - position < sizeof(uint16_t))
+    {
+      return (ORION_LZ_ERROR_DECODING_FAILED);
+    }
+    uint32_t offset = input[position] | ((uint32_t)input[position + 1] << 8);
+    position += sizeof(uint16_t);
+
+    uint32_t length = token & NIBBLE_MAX;
+    if ((NIBBLE_MAX == length) && !read_length(input, input_size, &position, &length))
+    {
+      return (ORION_LZ_ERROR_DECODING_FAILED);
+    }
+    length += ORION_LZ_MIN_MATCH;
+
+    if ((0 == offset) || (offset > size))
+    {
+      return (ORION_LZ_ERROR_DECODING_FAILED);
+    }
+    if (length > output_size - size)
+    {
+      return (ORION_LZ_ERROR_BUFFER_TOO_SMALL);
+    }
+
+    // Match could overlap bytes it produces (e.g. run of one byte), so it is copied forward byte by byte
+    for (uint32_t i = 0; i < length; i++)
+    {
+      output[size + i] = output[size + i - offset];
+    }
+    size += length;
+  }
+
+  return (size);
+}
+
+uint32_t read_word(const uint8_t * data)
+{
+  uint32_t result = 0;
+  memcpy(&result, data, sizeof(result));
+  return (result);
+}
+
+uint32_t hash_word(uint32_t word, uint32_t table_bits)
+{
+  // Knuth's multiplicative hashing, top bits are the best mixed ones
+  return ((word * 2654435761u) >> (32 - table_bits));
+}
+
+bool write_length(uint8_t * output, uint32_t output_size, uint32_t * position, uint32_t length)
+{
+  while (length >= LENGTH_BYTE_MAX)
+  {
+    if (*position >= output_size)
+    {
+      return (false);
+    }
+    output[(*position)++] = LENGTH_BYTE_MAX;
+    length -= LENGTH_BYTE_MAX;
+  }
+
+  if (*position >= output_size)
+  {
+    return (false);
+  }
+  output[(*position)++] = (uint8_t)length;
+  return (true);
+}
+
+bool read_length(const uint8_t * input, uint32_t input_size, uint32_t * position, uint32_t * length)
+{
+  uint8_t value = 0;
+  do
+  {
+    if (*position >= input_size)
+    {
+      return (false);
+    }
+    value = input[(*position)++];
+    *length += value;
+  }
+  while (LENGTH_BYTE_MAX == value);
+
+  return (true);
+}
+
+bool write_sequence(uint8_t * output, uint32_t output_size, uint32_t * position,
+  const uint8_t * literals, uint32_t literal_count, uint32_t offset, uint32_t match_length)
+{
+  if (*position >= output_size)
+  {
+    return (false);
+  }
+  uint32_t token_position = (*position)++;
+
+  uint8_t token = (uint8_t)(((literal_count >= NIBBLE_MAX) ? NIBBLE_MAX : literal_count) << 4);
+  if ((literal_count >= NIBBLE_MAX) && !write_length(output, output_size, position, literal_count - NIBBLE_MAX))
+  {
+    return (false);
+  }
+  if (literal_count > output_size - *position)
+  {
+    return (false);
+  }
+  memcpy(output + *position, literals, literal_count);
+  *position += literal_count;
+
+  // Zero length of match marks last sequence with literals only
+  if (match_length > 0)
+  {
+    if (output_size - *position < sizeof(uint16_t))
+    {
+      return (false);
+    }
+    output[(*position)++] = (uint8_t)(offset & 0xFF);
+    output[(*position)++] = (uint8_t)(offset >> 8);
+
+    uint32_t length = match_length - ORION_LZ_MIN_MATCH;
+    token |= (uint8_t)((length >= NIBBLE_MAX) ? NIBBLE_MAX : length);
+    if ((length >= NIBBLE_MAX) && !write_length(output, output_size, position, length - NIBBLE_MAX))
+    {
+      return (false);
+    }
+  }
+
+  output[token_position] = token;
+  return (true);
+}
@@ -0,0 +1,92 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_statistics.h"
+
+static void write_begin(orion_statistics_lock_t * lock);
+static void write_end(orion_statistics_lock_t * lock);
+
+void orion_statistics_init(orion_statistics_lock_t * lock)
+{
+  ORION_ASSERT_NOT_NULL(lock);
+  __atomic_store_n(&(lock->sequence_), 0, __ATOMIC_RELAXED);
+}
+
+void orion_statistics_add(orion_statistics_lock_t * lock, uint32_t * counter, uint32_t value)
+{
+  write_begin(lock);
+  __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+  write_end(lock);
+}
+
+void orion_statistics_update_max(orion_statistics_lock_t * lock, uint32_t * counter, uint32_t value)
+{
+  if (value > __atomic_load_n(counter, __ATOMIC_RELAXED))
+  {
+    write_begin(lock);
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+    write_end(lock);
+  }
+}
+
+void orion_statistics_read(const orion_statistics_lock_t * lock, const void * section, void * copy, size_t size)
+{
+  ORION_ASSERT_NOT_NULL(lock);
+  ORION_ASSERT_NOT_NULL(section);
+  ORION_ASSERT_NOT_NULL(copy);
+  ORION_ASSERT(0 == (size % sizeof(uint32_t)));
+
+  const uint32_t * source = (const uint32_t*)section;
+  uint32_t * destination = (uint32_t*)copy;
+  uint32_t sequence = 0;
+  do
+  {
+    // Odd sequence means writer is in the middle of update
+    do
+    {
+      sequence = __atomic_load_n(&(lock->sequence_), __ATOMIC_ACQUIRE);
+    }
+    while (0 != (sequence & 1));
+
+    for (size_t index = 0; index < (size / sizeof(uint32_t)); index++)
+    {
+      destination[index] = __atomic_load_n(&(source[index]), __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }
+  while (sequence != __atomic_load_n(&(lock->sequence_), __ATOMIC_RELAXED));
+}
+
+void write_begin(orion_statistics_lock_t * lock)
+{
+  uint32_t sequence = __atomic_load_n(&(lock->sequence_), __ATOMIC_RELAXED);
+  __atomic_store_n(&(lock->sequence_), sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void write_end(orion_statistics_lock_t * lock)
+{
+  uint32_t sequence = __atomic_load_n(&(lock->sequence_), __ATOMIC_RELAXED);
+  __atomic_store_n(&(lock->sequence_), sequence + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,311 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include <string.h>
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_stream.h"
+
+static uint32_t shift_bits(uint32_t bits, uint32_t count);
+static uint32_t get_data_size(uint32_t size, uint16_t segment_size, uint32_t segment);
+static uint64_t get_send_time(const orion_stream_sender_t * me, uint32_t segment);
+
+void orion_stream_sender_init(orion_stream_sender_t * me, uint16_t stream_id, const uint8_t * data, uint32_t size,
+  uint16_t segment_size, uint32_t window, uint32_t retransmit_timeout)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT((NULL != data) || (0 == size));
+  ORION_ASSERT(segment_size > 0);
+  ORION_ASSERT((window > 0) && (window <= ORION_STREAM_MAX_WINDOW));
+
+  memset(me, 0, sizeof(*me));
+  me->data_ = data;
+  me->size_ = size;
+  me->stream_id_ = stream_id;
+  me->segment_size_ = segment_size;
+  me->segment_count_ = size / segment_size + ((0 == size % segment_size) ? 0 : 1);
+  me->window_ = window;
+  me->retransmit_timeout_ = retransmit_timeout;
+}
+
+ssize_t orion_stream_sender_poll(orion_stream_sender_t * me, uint64_t time_now, uint8_t * packet,
+  uint32_t packet_size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(packet);
+
+  uint32_t in_flight = me->next_ - me->acknowledged_;
+  uint32_t segment = me->segment_count_;
+  if (0 != me->lost_)
+  {
+    uint32_t index = 0;
+    while (0 == (me->lost_ & (1u << index)))
+    {
+      index++;
+    }
+    me->lost_ &= ~(1u << index);
+    segment = me->acknowledged_ + index;
+  }
+  else
+  {
+    for (uint32_t index = 0; index < in_flight; index++)
+    {
+      if ((0 == (me->selective_ & (1u << index))) &&
+        (time_now - get_send_time(me, me->acknowledged_ + index) >= me->retransmit_timeout_))
+      {
+        segment = me->acknowledged_ + index;
+        break;
+      }
+    }
+  }
+  bool retransmission = segment < me->segment_count_;
+  if (!retransmission && (me->next_ < me->segment_count_) && (in_flight < me->window_))
+  {
+    segment = me->next_;
+    me->next_++;
+  }
+  if (segment >= me->segment_count_)
+  {
+    return (0);
+  }
+
+  uint32_t data_size = get_data_size(me->size_, me->segment_size_, segment);
+  ORION_ASSERT(packet_size >= sizeof(orion_control_stream_segment_t) + data_size);
+  orion_control_stream_segment_t * header = (orion_control_stream_segment_t*)packet;
+  header->header.frame.crc = 0;
+  header->header.common.message_id = ORION_CONTROL_MESSAGE_ID_STREAM;
+  header->header.common.version = ORION_CONTROL_STREAM_VERSION;
+  header->header.common.oldest_compatible_version = ORION_CONTROL_STREAM_VERSION;
+  header->header.common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+  header->stream_id = me->stream_id_;
+  header->segment_size = me->segment_size_;
+  header->offset = segment * me->segment_size_;
+  header->total_size = me->size_;
+  memcpy(packet + sizeof(orion_control_stream_segment_t), me->data_ + header->offset, data_size);
+
+  me->send_times_[segment % ORION_STREAM_MAX_WINDOW] = time_now;
+  me->statistics_.segments++;
+  if (retransmission)
+  {
+    me->statistics_.retransmissions++;
+  }
+  return (sizeof(orion_control_stream_segment_t) + data_size);
+}
+
+void orion_stream_sender_on_ack(orion_stream_sender_t * me, const orion_control_stream_ack_t * ack)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(ack);
+
+  // Acknowledgments could be reordered or duplicated, older ones carry nothing new
+  if ((me->stream_id_ != ack->stream_id) || (ack->cumulative < me->acknowledged_) || (ack->cumulative > me->next_))
+  {
+    return;
+  }
+  me->statistics_.acks++;
+
+  uint32_t advance = ack->cumulative - me->acknowledged_;
+  me->selective_ = shift_bits(me->selective_, advance);
+  me->lost_ = shift_bits(me->lost_, advance);
+  me->acknowledged_ = ack->cumulative;
+
+  uint32_t in_flight = me->next_ - me->acknowledged_;
+  uint32_t in_flight_mask = (in_flight >= 32) ? UINT32_MAX : ((1u << in_flight) - 1);
+  me->selective_ |= (ack->selective << 1) & in_flight_mask;
+  me->lost_ &= ~me->selective_;
+
+  // Link keeps order, so segment sent before the latest one received and still missing is lost
+  if (0 != me->selective_)
+  {
+    uint32_t latest = 31;
+    while (0 == (me->selective_ & (1u << latest)))
+    {
+      latest--;
+    }
+    uint64_t latest_time = get_send_time(me, me->acknowledged_ + latest);
+    for (uint32_t index = 0; index < latest; index++)
+    {
+      if ((0 == (me->selective_ & (1u << index))) &&
+        (get_send_time(me, me->acknowledged_ + index) < latest_time))
+      {
+        me->lost_ |= 1u << index;
+      }
+    }
+  }
+}
+
+uint32_t orion_stream_sender_get_wait_time(const orion_stream_sender_t * me, uint64_t time_now)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  if (orion_stream_sender_is_complete(me))
+  {
+    return (UINT32_MAX);
+  }
+  uint32_t in_flight = me->next_ - me->acknowledged_;
+  if ((0 != me->lost_) || ((me->next_ < me->segment_count_) && (in_flight < me->window_)))
+  {
+    return (0);
+  }
+
+  uint64_t result = UINT32_MAX;
+  for (uint32_t index = 0; index < in_flight; index++)
+  {
+    if (0 == (me->selective_ & (1u << index)))
+    {
+      uint64_t deadline = get_send_time(me, me->acknowledged_ + index) + me->retransmit_timeout_;
+      if (deadline <= time_now)
+      {
+        return (0);
+      }
+      if (deadline - time_now < result)
+      {
+        result = deadline - time_now;
+      }
+    }
+  }
+  return ((uint32_t)result);
+}
+
+bool orion_stream_sender_is_complete(const orion_stream_sender_t * me)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  return (me->acknowledged_ == me->segment_count_);
+}
+
+orion_stream_statistics_t orion_stream_sender_get_statistics(const orion_stream_sender_t * me)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  return (me->statistics_);
+}
+
+void orion_stream_receiver_init(orion_stream_receiver_t * me, uint8_t * buffer, uint32_t buffer_size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT((NULL != buffer) || (0 == buffer_size));
+  memset(me, 0, sizeof(*me));
+  me->buffer_ = buffer;
+  me->buffer_size_ = buffer_size;
+}
+
+void orion_stream_receiver_reset(orion_stream_receiver_t * me)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  me->active_ = false;
+  me->received_ = 0;
+  me->selective_ = 0;
+}
+
+bool orion_stream_receiver_on_segment(orion_stream_receiver_t * me, const uint8_t * packet, uint32_t size,
+  orion_control_stream_ack_t * ack)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(packet);
+  ORION_ASSERT_NOT_NULL(ack);
+
+  const orion_control_stream_segment_t * header = (const orion_control_stream_segment_t*)packet;
+  if ((size < sizeof(orion_control_stream_segment_t)) ||
+    (ORION_CONTROL_MESSAGE_ID_STREAM != header->header.common.message_id) ||
+    (ORION_CONTROL_STREAM_VERSION < header->header.common.oldest_compatible_version) ||
+    (0 == header->segment_size) || (header->total_size > me->buffer_size_))
+  {
+    return (false);
+  }
+
+  uint32_t data_size = size - sizeof(orion_control_stream_segment_t);
+  uint32_t segment_count = header->total_size / header->segment_size +
+    ((0 == header->total_size % header->segment_size) ? 0 : 1);
+  uint32_t segment = header->offset / header->segment_size;
+  if ((0 != header->offset % header->segment_size) || (segment >= segment_count) ||
+    (get_data_size(header->total_size, header->segment_size, segment) != data_size))
+  {
+    return (false);
+  }
+
+  // Stream ids wrap around, segments of the previous stream could still arrive after the next one started
+  if (!me->active_ || ((int16_t)(header->stream_id - me->stream_id_) > 0))
+  {
+    me->active_ = true;
+    me->stream_id_ = header->stream_id;
+    me->size_ = header->total_size;
+    me->segment_count_ = segment_count;
+    me->received_ = 0;
+    me->selective_ = 0;
+  }
+  if ((me->stream_id_ != header->stream_id) || (me->size_ != header->total_size))
+  {
+    return (false);
+  }
+
+  // Duplicates and segments beyond the window are only acknowledged
+  uint32_t index = segment - me->received_;
+  if ((segment >= me->received_) && (index < ORION_STREAM_MAX_WINDOW) && (0 == (me->selective_ & (1u << index))))
+  {
+    memcpy(me->buffer_ + header->offset, packet + sizeof(orion_control_stream_segment_t), data_size);
+    me->selective_ |= 1u << index;
+    while (0 != (me->selective_ & 1u))
+    {
+      me->selective_ >>= 1;
+      me->received_++;
+    }
+  }
+
+  memset(ack, 0, sizeof(*ack));
+  ack->header.common.message_id = ORION_CONTROL_MESSAGE_ID_STREAM_ACK;
+  ack->header.common.version = ORION_CONTROL_STREAM_VERSION;
+  ack->header.common.oldest_compatible_version = ORION_CONTROL_STREAM_VERSION;
+  ack->header.common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+  ack->stream_id = me->stream_id_;
+  ack->cumulative = me->received_;
+  ack->selective = me->selective_ >> 1;
+  return (true);
+}
+
+bool orion_stream_receiver_is_complete(const orion_stream_receiver_t * me, uint32_t * size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  if (!me->active_ || (me->received_ < me->segment_count_))
+  {
+    return (false);
+  }
+  if (NULL != size)
+  {
+    *size = me->size_;
+  }
+  return (true);
+}
+
+uint32_t shift_bits(uint32_t bits, uint32_t count)
+{
+  return ((count >= 32) ? 0 : (bits >> count));
+}
+
+uint32_t get_data_size(uint32_t size, uint16_t segment_size, uint32_t segment)
+{
+  uint32_t offset = segment * segment_size;
+  return ((size - offset < segment_size) ? (size - offset) : segment_size);
+}
+
+uint64_t get_send_time(const orion_stream_sender_t * me, uint32_t segment)
+{
+  return (me->send_times_[segment % ORION_STREAM_MAX_WINDOW]);
+}
@@ -21,22 +21,29 @@
 *
 */
 
+// clock_gettime and CLOCK_MONOTONIC are hidden by strict -std=c99 without it
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
 #include <time.h>
 #include "orion_protocol/orion_timeout.h"
 #include "orion_protocol/orion_memory.h"
 #include "orion_protocol/orion_assert.h"
 
 #define ORION_MICROSECONDS_IN_SECOND (1000000)
+#define ORION_NANOSECONDS_IN_MICROSECOND (1000)
 
-static uint32_t convert_ticks_to_microseconds(const long int value);
-static long int convert_microseconds_to_ticks(const uint32_t value);
+// Firmware without POSIX clocks implements orion_timeout_get_time_now() on a timer of its own
+#if !defined(ORION_TIMEOUT_EXTERNAL_CLOCK) && !defined(CLOCK_MONOTONIC)
+#define ORION_TIMEOUT_EXTERNAL_CLOCK
+#endif
 
 orion_timeout_error_t orion_timeout_init(orion_timeout_t * me, uint32_t timeout)
 {
   ORION_ASSERT_NOT_NULL(me);
- 
-  clock_t time_now = clock();
-  me->till_time_ = (clock_t) ((long int)(time_now) + convert_microseconds_to_ticks(timeout));
+
+  me->till_time_ = orion_timeout_get_time_now() + timeout;
   return (ORION_TOT_ERROR_NONE);
 }
 
@@ -56,29 +63,21 @@ uint32_t orion_timeout_time_left(const orion_timeout_t * me)
   ORION_ASSERT_NOT_NULL(me);
 
   uint32_t result = 0;
-  clock_t time_now = clock();
-  long int difference = (long int)me->till_time_ - (long int)time_now;
-  if (difference > 0)
+  uint64_t time_now = orion_timeout_get_time_now();
+  if (me->till_time_ > time_now)
   {
-	  result = convert_ticks_to_microseconds(difference);
+    result = (uint32_t)(me->till_time_ - time_now);
   }
   return (result);
 }
 
-uint32_t convert_ticks_to_microseconds(const long int value)
+#ifndef ORION_TIMEOUT_EXTERNAL_CLOCK
+uint64_t orion_timeout_get_time_now(void)
 {
-  if (value > CLOCKS_PER_SEC)
-  {
-	return ((uint32_t)(value / CLOCKS_PER_SEC * ORION_MICROSECONDS_IN_SECOND));
-  }
-  return ((uint32_t)(value * ORION_MICROSECONDS_IN_SECOND / CLOCKS_PER_SEC));
-}
-
-long int convert_microseconds_to_ticks(const uint32_t value)
-{
-  if (value > ORION_MICROSECONDS_IN_SECOND)
-  {
-	return ((uint32_t)(value / ORION_MICROSECONDS_IN_SECOND * CLOCKS_PER_SEC));
-  }
-  return ((uint32_t)(value * CLOCKS_PER_SEC / ORION_MICROSECONDS_IN_SECOND));
+  // Wall time which is not affected by clock adjustments, unlike clock() it goes on while process is blocked
+  struct timespec time_now;
+  clock_gettime(CLOCK_MONOTONIC, &time_now);
+  return ((uint64_t)time_now.tv_sec * ORION_MICROSECONDS_IN_SECOND +
+    (uint64_t)time_now.tv_nsec / ORION_NANOSECONDS_IN_MICROSECOND);
 }
+#endif
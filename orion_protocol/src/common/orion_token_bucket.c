@@ -0,0 +1,74 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <stddef.h>
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_token_bucket.h"
+
+#define ORION_MICROSECONDS_IN_SECOND (1000000)
+
+static void refill(orion_token_bucket_t * me, uint64_t time_now);
+
+void orion_token_bucket_init(orion_token_bucket_t * me, uint32_t rate, uint32_t capacity, uint64_t time_now)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  me->rate_ = rate;
+  me->capacity_ = capacity;
+  me->tokens_ = capacity;
+  me->remainder_ = 0;
+  me->last_time_ = time_now;
+}
+
+bool orion_token_bucket_consume(orion_token_bucket_t * me, uint32_t tokens, uint64_t time_now)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  if (0 == me->rate_)
+  {
+    return (true);
+  }
+  refill(me, time_now);
+  if (tokens > me->tokens_)
+  {
+    return (false);
+  }
+  me->tokens_ -= tokens;
+  return (true);
+}
+
+void refill(orion_token_bucket_t * me, uint64_t time_now)
+{
+  if (time_now <= me->last_time_)
+  {
+    return;
+  }
+  uint64_t amount = (time_now - me->last_time_) * me->rate_ + me->remainder_;
+  me->last_time_ = time_now;
+  uint64_t tokens = me->tokens_ + amount / ORION_MICROSECONDS_IN_SECOND;
+  me->remainder_ = (uint32_t)(amount % ORION_MICROSECONDS_IN_SECOND);
+  if (tokens >= me->capacity_)
+  {
+    tokens = me->capacity_;
+    me->remainder_ = 0;
+  }
+  me->tokens_ = (uint32_t)tokens;
+}
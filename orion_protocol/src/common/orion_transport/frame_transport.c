@@ -21,39 +21,132 @@
 *
 */
 
+#include <string.h>
 #include "orion_protocol/orion_assert.h"
 #include "orion_protocol/orion_header.h"
+#include "orion_protocol/orion_control.h"
 #include "orion_protocol/orion_framer.h"
 #include "orion_protocol/orion_crc.h"
+#include "orion_protocol/orion_lz.h"
 #include "orion_protocol/orion_timeout.h"
 #include "orion_protocol/orion_transport.h"
 #include "orion_protocol/orion_circular_buffer.h"
 #include "orion_protocol/orion_memory.h"
+#include "orion_protocol/orion_statistics.h"
 
-#define ORION_FRAME_TRANSPORT_BUFFER_SIZE (512)
-#define ORION_FRAME_TRANSPORT_QUEUE_BUFFER_SIZE (1024)
+// Smallest frame that could hold frame header: delimiter, code byte, header and delimiter
+#define ORION_TRANSPORT_MIN_ENCODED_SIZE (sizeof(orion_frame_header_t) + 3)
 
 struct orion_transport_struct_t
 {
   orion_communication_t * communication_;
-  uint8_t buffer_[ORION_FRAME_TRANSPORT_BUFFER_SIZE];
-  uint8_t queue_buffer_[ORION_FRAME_TRANSPORT_QUEUE_BUFFER_SIZE];
+  uint32_t frame_size_;
+  orion_transport_link_t link_;
+  uint8_t * buffer_;  // receiving side
+  uint8_t * tx_buffer_;  // sending side, separate so that one thread could send while other receives
+  uint8_t * container_buffer_;  // sent container before encoding
+  uint32_t buffer_size_;
+  uint32_t unpack_offset_;  // records of received container are kept in receive buffer till all are returned
+  uint32_t unpack_size_;
+  bool containers_;
+  bool fragments_;
+  uint16_t transfer_id_;  // of the last fragmented message sent
+  uint8_t * reassembly_buffer_;
+  uint32_t reassembly_size_;
+  bool reassembling_;
+  uint16_t reassembly_transfer_id_;
+  uint32_t reassembled_size_;  // bytes of message received so far, fragments arrive in order
+  uint8_t * compression_buffer_;  // compressed frame followed by hash table of compressor
+  uint16_t * compression_table_;
+  uint32_t compression_table_bits_;
   orion_circular_buffer_t circular_queue_;
+  orion_transport_overflow_policy_t overflow_policy_;
+  orion_statistics_lock_t tx_lock_;
+  orion_statistics_lock_t rx_lock_;
+  orion_transport_statistics_t statistics_;
+  bool discard_till_delimiter_;
 };
 
 static bool orion_transport_has_frame_in_queue(const orion_transport_t * me);
+static void orion_transport_add_to_queue(orion_transport_t * me, uint32_t size);
+static uint32_t orion_transport_get_read_size(orion_transport_t * me);
+static void orion_transport_count_backpressure(orion_transport_t * me, uint32_t read_size, ssize_t received_size);
+static uint32_t orion_transport_make_room(orion_transport_t * me, const uint8_t * data, uint32_t size);
+static void orion_transport_drop_queue(orion_transport_t * me);
+static ssize_t orion_transport_encode(orion_transport_t * me, orion_transport_packet_t * packet, uint32_t offset);
+static orion_transport_error_t orion_transport_flush(orion_transport_t * me, uint32_t frames, uint32_t size,
+  orion_timeout_t * duration);
+static orion_transport_error_t orion_transport_append(orion_transport_t * me, orion_transport_packet_t * frame,
+  uint32_t * frames, uint32_t * used_size, orion_timeout_t * duration);
+static void orion_transport_init_envelope(orion_envelope_header_t * header, uint8_t flags);
+static orion_transport_error_t orion_transport_send_fragments(orion_transport_t * me,
+  const orion_transport_packet_t * packet, uint32_t * offset, uint32_t max_size, uint32_t * frames,
+  uint32_t * used_size, orion_timeout_t * duration);
+static void orion_transport_compress(orion_transport_t * me, orion_transport_packet_t * frame);
+static uint16_t orion_transport_checksum(const orion_transport_t * me, const uint8_t * packet, uint32_t size);
+static uint32_t orion_transport_pack(orion_transport_t * me, const orion_transport_packet_t * packets,
+  uint32_t count, orion_transport_packet_t * frame);
+static ssize_t orion_transport_open_envelope(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size);
+static ssize_t orion_transport_unpack(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size);
+static ssize_t orion_transport_reassemble(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size);
+static ssize_t orion_transport_decompress(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size);
 
 orion_transport_error_t orion_transport_new(orion_transport_t ** me, orion_communication_t * communication)
+{
+  orion_transport_error_t result = orion_transport_new_with_size(me, communication,
+    ORION_TRANSPORT_DEFAULT_FRAME_SIZE, ORION_TRANSPORT_DEFAULT_QUEUE_SIZE);
+  return (result);
+}
+
+orion_transport_error_t orion_transport_new_with_size(orion_transport_t ** me, orion_communication_t * communication,
+  uint32_t frame_size, uint32_t queue_size)
 {
   ORION_ASSERT_NOT_NULL(me);
   ORION_ASSERT_NOT_NULL(communication);
-  orion_memory_error_t status = orion_memory_allocate(sizeof(orion_transport_t), (void**)me);
+  ORION_ASSERT(frame_size >= sizeof(orion_frame_header_t));
+  ORION_ASSERT(frame_size <= ORION_TRANSPORT_MAX_FRAME_SIZE);
+  // Queue should be able to keep at least one complete frame
+  ORION_ASSERT(queue_size >= ORION_FRAMER_MAX_ENCODED_SIZE(frame_size));
+
+  uint32_t buffer_size = ORION_FRAMER_MAX_ENCODED_SIZE(frame_size);
+  orion_memory_error_t status = orion_memory_allocate(sizeof(orion_transport_t) +
+    ORION_TRANSPORT_BUFFERS_FOOTPRINT(frame_size, queue_size), (void**)me);
   if (ORION_MEM_ERROR_NONE != status)
   {
       return (ORION_TRAN_ERROR_COULD_NOT_ALLOCATE_MEMORY);
   }
+  uint8_t * buffers = (uint8_t*)(*me) + sizeof(orion_transport_t);
   (*me)->communication_ = communication;
-  orion_circular_buffer_init(&((*me)->circular_queue_), (*me)->queue_buffer_, ORION_FRAME_TRANSPORT_QUEUE_BUFFER_SIZE);
+  (*me)->frame_size_ = frame_size;
+  memset(&((*me)->link_), 0, sizeof((*me)->link_));
+  (*me)->link_.frame_size = frame_size;
+  (*me)->link_.checksum = ORION_CONTROL_CHECKSUM_CRC16;
+  (*me)->buffer_ = buffers;
+  (*me)->tx_buffer_ = buffers + buffer_size;
+  (*me)->container_buffer_ = buffers + 2 * buffer_size;
+  (*me)->buffer_size_ = buffer_size;
+  (*me)->unpack_offset_ = 0;
+  (*me)->unpack_size_ = 0;
+  (*me)->containers_ = false;
+  (*me)->fragments_ = false;
+  (*me)->transfer_id_ = 0;
+  (*me)->reassembly_buffer_ = NULL;
+  (*me)->reassembly_size_ = 0;
+  (*me)->reassembling_ = false;
+  (*me)->reassembly_transfer_id_ = 0;
+  (*me)->reassembled_size_ = 0;
+  (*me)->compression_buffer_ = NULL;
+  (*me)->compression_table_ = NULL;
+  (*me)->compression_table_bits_ = 0;
+  orion_circular_buffer_init(&((*me)->circular_queue_), buffers + 2 * buffer_size + frame_size, queue_size);
+  (*me)->overflow_policy_ = ORION_TRAN_OVERFLOW_POLICY_BACKPRESSURE;
+  orion_statistics_init(&((*me)->tx_lock_));
+  orion_statistics_init(&((*me)->rx_lock_));
+  memset(&((*me)->statistics_), 0, sizeof((*me)->statistics_));
+  (*me)->discard_till_delimiter_ = false;
   return (ORION_TRAN_ERROR_NONE);
 }
 
@@ -70,35 +163,152 @@ orion_transport_error_t orion_transport_delete(const orion_transport_t * me)
 
 orion_transport_error_t orion_transport_send_packet(orion_transport_t * me, uint8_t *input_buffer,
     uint32_t input_size, uint32_t timeout)
+{
+  orion_transport_packet_t packet = { .buffer = input_buffer, .size = input_size };
+  orion_transport_error_t result = orion_transport_send_packets(me, &packet, 1, timeout);
+  return (result);
+}
+
+orion_transport_error_t orion_transport_send_packets(orion_transport_t * me, orion_transport_packet_t *packets,
+  uint32_t count, uint32_t timeout)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(packets);
+
+  for (uint32_t index = 0; index < count; index++)
+  {
+    ORION_ASSERT(packets[index].size >= sizeof(orion_frame_header_t));
+    if ((packets[index].size > me->link_.frame_size) && !me->fragments_)
+    {
+      orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.too_big_errors), 1);
+      return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+    }
+  }
+
+  orion_timeout_t duration;
+  orion_timeout_init(&duration, timeout);
+
+  orion_transport_error_t result = ORION_TRAN_ERROR_NONE;
+  uint32_t frames = 0;
+  uint32_t used_size = 0;
+  uint32_t index = 0;
+  while ((index < count) && (ORION_TRAN_ERROR_NONE == result))
+  {
+    if (packets[index].size > me->link_.frame_size)
+    {
+      uint32_t offset = 0;
+      result = orion_transport_send_fragments(me, &(packets[index]), &offset, 0, &frames, &used_size, &duration);
+      index++;
+    }
+    else
+    {
+      orion_transport_packet_t frame = packets[index];
+      uint32_t packed = 1;
+      if (me->containers_)
+      {
+        packed = orion_transport_pack(me, &(packets[index]), count - index, &frame);
+      }
+      if (NULL != me->compression_buffer_)
+      {
+        orion_transport_compress(me, &frame);
+      }
+      result = orion_transport_append(me, &frame, &frames, &used_size, &duration);
+      index += packed;
+    }
+  }
+  if ((ORION_TRAN_ERROR_NONE == result) && (used_size > 0))
+  {
+    result = orion_transport_flush(me, frames, used_size, &duration);
+  }
+  return (result);
+}
+
+ssize_t orion_transport_send_part(orion_transport_t * me, uint8_t *input_buffer, uint32_t input_size,
+  uint32_t offset, uint32_t max_size, uint32_t timeout)
 {
   ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(input_buffer);
   ORION_ASSERT(input_size >= sizeof(orion_frame_header_t));
+  ORION_ASSERT(offset < input_size);
+
+  if ((input_size <= me->link_.frame_size) || !me->fragments_)
+  {
+    orion_transport_error_t status = orion_transport_send_packet(me, input_buffer, input_size, timeout);
+    return ((ORION_TRAN_ERROR_NONE == status) ? (ssize_t)input_size : status);
+  }
 
   orion_timeout_t duration;
   orion_timeout_init(&duration, timeout);
 
-  orion_frame_header_t *frame_header = (orion_frame_header_t*)input_buffer;
-  frame_header->crc = orion_crc_calculate_crc16(input_buffer + sizeof(orion_frame_header_t),
-    input_size - sizeof(orion_frame_header_t));
-  ssize_t packet_size = orion_framer_encode_packet(input_buffer, input_size, me->buffer_, 
-    ORION_FRAME_TRANSPORT_BUFFER_SIZE);
-  if (packet_size >= 0)
+  orion_transport_packet_t packet = { .buffer = input_buffer, .size = input_size };
+  uint32_t message_offset = (0 == offset) ? 0 : offset - sizeof(orion_frame_header_t);
+  uint32_t frames = 0;
+  uint32_t used_size = 0;
+  orion_transport_error_t result = orion_transport_send_fragments(me, &packet, &message_offset, max_size, &frames,
+    &used_size, &duration);
+  if ((ORION_TRAN_ERROR_NONE == result) && (used_size > 0))
+  {
+    result = orion_transport_flush(me, frames, used_size, &duration);
+  }
+  return ((ORION_TRAN_ERROR_NONE == result) ? (ssize_t)(sizeof(orion_frame_header_t) + message_offset) : result);
+}
+
+ssize_t orion_transport_encode_packet(orion_transport_t * me, uint8_t *input_buffer, uint32_t input_size,
+  uint8_t *frame, uint32_t frame_size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(input_buffer);
+  ORION_ASSERT_NOT_NULL(frame);
+  ORION_ASSERT(input_size >= sizeof(orion_frame_header_t));
+
+  if (input_size > me->link_.frame_size)
   {
-    orion_communication_error_t send_status = orion_communication_send_buffer(me->communication_, me->buffer_, 
-      packet_size, orion_timeout_time_left(&duration));
-    if (ORION_COM_ERROR_NONE == send_status)
+    // Fragmented packet could still be sent by orion_transport_send_packet
+    if (!me->fragments_)
     {
-      return (ORION_TRAN_ERROR_NONE);
+      orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.too_big_errors), 1);
     }
-    return (ORION_TRAN_ERROR_FAILED_TO_SEND_PACKET);
+    return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
   }
-  return (ORION_TRAN_ERROR_FAILED_TO_ENCODE_PACKET);
+  orion_frame_header_t *frame_header = (orion_frame_header_t*)input_buffer;
+  frame_header->crc = orion_transport_checksum(me, input_buffer, input_size);
+  ssize_t result = orion_framer_encode_packet(input_buffer, input_size, frame, frame_size);
+  if (result < 0)
+  {
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.encode_errors), 1);
+    result = ORION_TRAN_ERROR_FAILED_TO_ENCODE_PACKET;
+  }
+  return (result);
+}
+
+orion_transport_error_t orion_transport_send_frame(orion_transport_t * me, uint8_t *frame, uint32_t size,
+  uint32_t timeout)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(frame);
+  ORION_ASSERT(size >= ORION_TRANSPORT_MIN_ENCODED_SIZE);
+
+  orion_communication_error_t send_status = orion_communication_send_buffer(me->communication_, frame, size,
+    timeout);
+  if (ORION_COM_ERROR_NONE == send_status)
+  {
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.frames), 1);
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.bytes), size);
+    return (ORION_TRAN_ERROR_NONE);
+  }
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.communication_errors), 1);
+  return (ORION_TRAN_ERROR_FAILED_TO_SEND_PACKET);
 }
 
 ssize_t orion_transport_receive_packet(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
   uint32_t timeout)
 {
   ORION_ASSERT_NOT_NULL(me);
+  if (me->unpack_size_ > 0)
+  {
+    return (orion_transport_unpack(me, output_buffer, output_size));
+  }
+
   orion_timeout_t duration;
   orion_timeout_init(&duration, timeout);
 
@@ -106,11 +316,21 @@ ssize_t orion_transport_receive_packet(orion_transport_t * me, uint8_t * output_
   bool decode = orion_transport_has_received_packet(me);
   if (false == decode)
   {
-    ssize_t size = orion_communication_receive_buffer(me->communication_, me->buffer_, 
-      ORION_FRAME_TRANSPORT_BUFFER_SIZE, orion_timeout_time_left(&duration) * 3 / 4); 
-    if (size > 0)
+    ssize_t size = 0;
+    uint32_t read_size = orion_transport_get_read_size(me);
+    if (read_size > 0)
+    {
+      size = orion_communication_receive_buffer(me->communication_, me->buffer_, read_size,
+        orion_timeout_time_left(&duration) * 3 / 4);
+    }
+    orion_transport_count_backpressure(me, read_size, size);
+    if (size < 0)
+    {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.communication_errors), 1);
+    }
+    else if (size > 0)
     {
-      orion_circular_buffer_add(&(me->circular_queue_), me->buffer_, size);
+      orion_transport_add_to_queue(me, size);
 
       if (orion_transport_has_frame_in_queue(me))
       {
@@ -121,27 +341,55 @@ ssize_t orion_transport_receive_packet(orion_transport_t * me, uint8_t * output_
 
   if (decode)
   {
-    uint32_t size = 0;
-    bool status = orion_circular_buffer_dequeue_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER, me->buffer_,
-      ORION_FRAME_TRANSPORT_BUFFER_SIZE, &size);
+    // Closing delimiter of every word stays in queue, so losing it or opening delimiter of the next frame
+    // costs only the damaged frame and not the one which follows
+    uint32_t size = orion_circular_buffer_get_word_size(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER);
+    if (size > me->buffer_size_)
+    {
+      orion_circular_buffer_release_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER);
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.too_big_errors), 1);
+      return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+    }
+    bool status = orion_circular_buffer_peek_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER, me->buffer_,
+      me->buffer_size_, &size);
     ORION_ASSERT(status);
+    orion_circular_buffer_release_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER);
+    if (size < ORION_TRANSPORT_MIN_ENCODED_SIZE)
+    {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.partial_frames), 1);
+      return (ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET);
+    }
     result = orion_framer_decode_packet(me->buffer_, size, output_buffer, output_size);
     if (result < 0)
     {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decode_errors), 1);
       result = ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET;
     }
     else if (result < sizeof(orion_frame_header_t))
     {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.partial_frames), 1);
       result = ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET;
     }
     else
     {
       orion_frame_header_t *frame_header = (orion_frame_header_t*)output_buffer;
-      if (orion_crc_calculate_crc16(output_buffer + sizeof(orion_frame_header_t), 
-        result - sizeof(orion_frame_header_t)) != frame_header->crc)
+      uint16_t crc = orion_transport_checksum(me, output_buffer, result);
+      if ((crc != frame_header->crc) && (ORION_CONTROL_CHECKSUM_CRC16 != me->link_.checksum))
       {
+        // Peer falls back to CRC16 when it restarts or negotiates link again
+        crc = orion_crc_calculate_crc16(output_buffer + sizeof(orion_frame_header_t),
+          result - sizeof(orion_frame_header_t));
+      }
+      if (crc != frame_header->crc)
+      {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.crc_errors), 1);
         result = ORION_TRAN_ERROR_CRC_CHECK_FAILED;
       }
+      else
+      {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.frames), 1);
+        result = orion_transport_open_envelope(me, output_buffer, output_size, result);
+      }
     }
   }
   return (result);
@@ -152,29 +400,589 @@ bool orion_transport_has_received_packet(orion_transport_t * me)
   ORION_ASSERT_NOT_NULL(me);
   bool result = false;
 
-  if (orion_transport_has_frame_in_queue(me))
+  if ((me->unpack_size_ > 0) || orion_transport_has_frame_in_queue(me))
   {
     result = true;
   }
   else if (orion_communication_has_available_buffer(me->communication_))
   {
-    ssize_t received_size = orion_communication_receive_available_buffer(me->communication_, me->buffer_,
-      ORION_FRAME_TRANSPORT_BUFFER_SIZE);
-    if (received_size >= 0)
+    uint32_t read_size = orion_transport_get_read_size(me);
+    if (read_size > 0)
     {
-      orion_circular_buffer_add(&(me->circular_queue_), me->buffer_, received_size);
-      if (orion_transport_has_frame_in_queue(me))
+      ssize_t received_size = orion_communication_receive_available_buffer(me->communication_, me->buffer_,
+        read_size);
+      orion_transport_count_backpressure(me, read_size, received_size);
+      if (received_size < 0)
+      {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.communication_errors), 1);
+      }
+      else if (received_size > 0)
       {
-        result = true;
+        orion_transport_add_to_queue(me, received_size);
+        if (orion_transport_has_frame_in_queue(me))
+        {
+          result = true;
+        }
       }
     }
   }
   return (result);
 }
 
+uint32_t orion_transport_get_frame_size(const orion_transport_t * me)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  return (me->frame_size_);
+}
+
+orion_transport_error_t orion_transport_set_overflow_policy(orion_transport_t * me,
+  orion_transport_overflow_policy_t policy)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  me->overflow_policy_ = policy;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_set_containers(orion_transport_t * me, bool enabled)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  me->containers_ = enabled;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_set_fragments(orion_transport_t * me, bool enabled)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  // Fragment should carry at least one byte of message
+  ORION_ASSERT(!enabled || (me->link_.frame_size > sizeof(orion_fragment_header_t)));
+  me->fragments_ = enabled;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_set_reassembly_buffer(orion_transport_t * me, uint8_t *buffer,
+  uint32_t size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT((NULL == buffer) || (size >= sizeof(orion_frame_header_t)));
+  me->reassembly_buffer_ = buffer;
+  me->reassembly_size_ = (NULL == buffer) ? 0 : size;
+  me->reassembling_ = false;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_set_compression_buffer(orion_transport_t * me, uint8_t *buffer,
+  uint32_t size)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT((NULL == buffer) ||
+    (size >= ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(me->frame_size_, ORION_LZ_MIN_TABLE_BITS)));
+  ORION_ASSERT(0 == ((uintptr_t)buffer % sizeof(uint16_t)));
+
+  me->compression_buffer_ = buffer;
+  me->compression_table_ = NULL;
+  me->compression_table_bits_ = 0;
+  if (NULL != buffer)
+  {
+    // The biggest table which fits the rest of buffer
+    uint32_t frame_area = ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(me->frame_size_, 0) - ORION_LZ_TABLE_SIZE(0);
+    uint32_t table_bits = ORION_LZ_MIN_TABLE_BITS;
+    while ((table_bits < ORION_LZ_MAX_TABLE_BITS) && (frame_area + ORION_LZ_TABLE_SIZE(table_bits + 1) <= size))
+    {
+      table_bits++;
+    }
+    me->compression_table_ = (uint16_t*)(buffer + frame_area);
+    me->compression_table_bits_ = table_bits;
+  }
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_set_link(orion_transport_t * me, const orion_transport_link_t * link)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(link);
+  ORION_ASSERT((link->frame_size >= sizeof(orion_frame_header_t)) && (link->frame_size <= me->frame_size_));
+  ORION_ASSERT(!me->fragments_ || (link->frame_size > sizeof(orion_fragment_header_t)));
+  ORION_ASSERT((ORION_CONTROL_CHECKSUM_CRC16 == link->checksum) ||
+    (ORION_CONTROL_CHECKSUM_FLETCHER16 == link->checksum));
+  me->link_ = *link;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_get_link(const orion_transport_t * me, orion_transport_link_t * link)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(link);
+  *link = me->link_;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_get_overflow_counters(const orion_transport_t * me,
+  orion_transport_overflow_counters_t * counters)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(counters);
+  orion_transport_rx_statistics_t statistics;
+  orion_statistics_read(&(me->rx_lock_), &(me->statistics_.rx), &statistics, sizeof(statistics));
+  *counters = statistics.overflow;
+  return (ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t orion_transport_get_statistics(const orion_transport_t * me,
+  orion_transport_statistics_t * statistics)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(statistics);
+  orion_statistics_read(&(me->tx_lock_), &(me->statistics_.tx), &(statistics->tx), sizeof(statistics->tx));
+  orion_statistics_read(&(me->rx_lock_), &(me->statistics_.rx), &(statistics->rx), sizeof(statistics->rx));
+  return (ORION_TRAN_ERROR_NONE);
+}
+
 bool orion_transport_has_frame_in_queue(const orion_transport_t * me)
 {
   ORION_ASSERT_NOT_NULL(me);
   bool result = orion_circular_buffer_has_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER);
   return (result);
 }
+
+uint32_t orion_transport_get_read_size(orion_transport_t * me)
+{
+  uint32_t result = me->buffer_size_;
+  if (ORION_TRAN_OVERFLOW_POLICY_BACKPRESSURE == me->overflow_policy_)
+  {
+    uint32_t free_size = orion_circular_buffer_get_free_size(&(me->circular_queue_));
+    if (result > free_size)
+    {
+      result = free_size;
+    }
+  }
+  return (result);
+}
+
+void orion_transport_count_backpressure(orion_transport_t * me, uint32_t read_size, ssize_t received_size)
+{
+  // Partial frame in queue often caps the read without holding anything back, only a full queue or a read
+  // which took all the room left means that the link had more to deliver
+  if ((read_size < me->buffer_size_) && ((0 == read_size) || ((ssize_t)read_size == received_size)))
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.backpressure_events), 1);
+  }
+}
+
+void orion_transport_add_to_queue(orion_transport_t * me, uint32_t size)
+{
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.bytes), size);
+
+  uint32_t start = 0;
+  // Every frame starts with delimiter, so anything before it in empty queue is a tail of lost frame or line noise
+  if (me->discard_till_delimiter_ || orion_circular_buffer_is_empty(&(me->circular_queue_)))
+  {
+    while ((start < size) && (ORION_FRAMER_FRAME_DELIMETER != me->buffer_[start]))
+    {
+      start++;
+    }
+    if (me->discard_till_delimiter_)
+    {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_bytes), start);
+      me->discard_till_delimiter_ = (start == size);
+    }
+    else
+    {
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.garbage_bytes), start);
+    }
+  }
+
+  uint32_t accepted = orion_transport_make_room(me, me->buffer_ + start, size - start);
+  if (accepted > 0)
+  {
+    orion_circular_buffer_add(&(me->circular_queue_), me->buffer_ + start, accepted);
+    orion_statistics_update_max(&(me->rx_lock_), &(me->statistics_.rx.queue_high_water_mark),
+      orion_circular_buffer_get_size(&(me->circular_queue_)));
+  }
+
+  if ((0 == orion_circular_buffer_get_free_size(&(me->circular_queue_))) && !orion_transport_has_frame_in_queue(me))
+  {
+    // Queue is full but there is no complete frame, nothing would ever be dequeued
+    orion_transport_drop_queue(me);
+  }
+}
+
+uint32_t orion_transport_make_room(orion_transport_t * me, const uint8_t * data, uint32_t size)
+{
+  uint32_t free_size = orion_circular_buffer_get_free_size(&(me->circular_queue_));
+  if (size <= free_size)
+  {
+    return (size);
+  }
+
+  uint32_t result = size;
+  if (ORION_TRAN_OVERFLOW_POLICY_DROP_NEWEST == me->overflow_policy_)
+  {
+    // Keep bytes till the last delimiter which fits so queue ends on frame boundary
+    result = free_size;
+    while ((result > 0) && (ORION_FRAMER_FRAME_DELIMETER != data[result - 1]))
+    {
+      result--;
+    }
+    // Every run of bytes between delimiters is a frame lost, also the partial one at either end
+    uint32_t frames = 0;
+    for (uint32_t index = result; index < size; index++)
+    {
+      if ((ORION_FRAMER_FRAME_DELIMETER != data[index]) &&
+        ((result == index) || (ORION_FRAMER_FRAME_DELIMETER == data[index - 1])))
+      {
+        frames++;
+      }
+    }
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_frames), frames);
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_bytes), size - result);
+    me->discard_till_delimiter_ = true;
+  }
+  else
+  {
+    while ((size > free_size) && orion_transport_has_frame_in_queue(me))
+    {
+      uint32_t queued_size = orion_circular_buffer_get_size(&(me->circular_queue_));
+      orion_circular_buffer_drop_word(&(me->circular_queue_), ORION_FRAMER_FRAME_DELIMETER);
+      free_size = orion_circular_buffer_get_free_size(&(me->circular_queue_));
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_frames), 1);
+      orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_bytes),
+        queued_size - orion_circular_buffer_get_size(&(me->circular_queue_)));
+    }
+    if (size > free_size)
+    {
+      orion_transport_drop_queue(me);
+    }
+  }
+  return (result);
+}
+
+void orion_transport_drop_queue(orion_transport_t * me)
+{
+  uint32_t queued_size = orion_circular_buffer_get_size(&(me->circular_queue_));
+  if (queued_size > 0)
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_frames), 1);
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.overflow.dropped_bytes), queued_size);
+  }
+  orion_circular_buffer_init(&(me->circular_queue_), me->circular_queue_.p_buffer, me->circular_queue_.buffer_size);
+}
+
+ssize_t orion_transport_encode(orion_transport_t * me, orion_transport_packet_t * packet, uint32_t offset)
+{
+  orion_frame_header_t *frame_header = (orion_frame_header_t*)packet->buffer;
+  frame_header->crc = orion_transport_checksum(me, packet->buffer, packet->size);
+  ssize_t result = orion_framer_encode_packet(packet->buffer, packet->size, me->tx_buffer_ + offset,
+    me->buffer_size_ - offset);
+  return (result);
+}
+
+orion_transport_error_t orion_transport_flush(orion_transport_t * me, uint32_t frames, uint32_t size,
+  orion_timeout_t * duration)
+{
+  orion_communication_error_t send_status = orion_communication_send_buffer(me->communication_, me->tx_buffer_,
+    size, orion_timeout_time_left(duration));
+  if (ORION_COM_ERROR_NONE == send_status)
+  {
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.frames), frames);
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.bytes), size);
+    return (ORION_TRAN_ERROR_NONE);
+  }
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.communication_errors), 1);
+  return (ORION_TRAN_ERROR_FAILED_TO_SEND_PACKET);
+}
+
+orion_transport_error_t orion_transport_append(orion_transport_t * me, orion_transport_packet_t * frame,
+  uint32_t * frames, uint32_t * used_size, orion_timeout_t * duration)
+{
+  orion_transport_error_t result = ORION_TRAN_ERROR_NONE;
+  ssize_t packet_size = orion_transport_encode(me, frame, *used_size);
+  if ((packet_size < 0) && (*used_size > 0))
+  {
+    // Send buffer is full, flush frames encoded so far and start over
+    result = orion_transport_flush(me, *frames, *used_size, duration);
+    *frames = 0;
+    *used_size = 0;
+    packet_size = orion_transport_encode(me, frame, *used_size);
+  }
+  if (packet_size < 0)
+  {
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.encode_errors), 1);
+    result = ORION_TRAN_ERROR_FAILED_TO_ENCODE_PACKET;
+  }
+  else
+  {
+    (*frames)++;
+    *used_size += packet_size;
+  }
+  return (result);
+}
+
+void orion_transport_init_envelope(orion_envelope_header_t * header, uint8_t flags)
+{
+  header->common.message_id = ORION_CONTROL_MESSAGE_ID_ENVELOPE;
+  header->common.version = ORION_ENVELOPE_VERSION;
+  header->common.oldest_compatible_version = ORION_ENVELOPE_VERSION;
+  header->common.sequence_id = 0;
+  header->flags = flags;
+}
+
+orion_transport_error_t orion_transport_send_fragments(orion_transport_t * me,
+  const orion_transport_packet_t * packet, uint32_t * offset, uint32_t max_size, uint32_t * frames,
+  uint32_t * used_size, orion_timeout_t * duration)
+{
+  // Fragments are framed one after another into send buffer, which is flushed whenever full, no waiting for peer
+  orion_fragment_header_t *header = (orion_fragment_header_t*)me->container_buffer_;
+  orion_transport_init_envelope(&(header->envelope), ORION_ENVELOPE_FLAG_FRAGMENT);
+  if (0 == *offset)
+  {
+    me->transfer_id_++;
+  }
+  header->transfer_id = me->transfer_id_;
+  header->total_size = packet->size - sizeof(orion_frame_header_t);
+
+  const uint8_t *message = packet->buffer + sizeof(orion_frame_header_t);
+  uint32_t max_fragment_size = me->link_.frame_size - sizeof(orion_fragment_header_t);
+  uint32_t sent_size = 0;
+  uint32_t fragments = 0;
+  orion_transport_error_t result = ORION_TRAN_ERROR_NONE;
+  while ((*offset < header->total_size) && (ORION_TRAN_ERROR_NONE == result))
+  {
+    uint32_t fragment_size = header->total_size - *offset;
+    if (fragment_size > max_fragment_size)
+    {
+      fragment_size = max_fragment_size;
+    }
+    // Part carries at least one fragment
+    if ((0 != max_size) && (fragments > 0) && (sent_size + sizeof(orion_fragment_header_t) + fragment_size > max_size))
+    {
+      break;
+    }
+    header->offset = *offset;
+    memcpy(me->container_buffer_ + sizeof(orion_fragment_header_t), message + *offset, fragment_size);
+    orion_transport_packet_t frame = { .buffer = me->container_buffer_,
+      .size = sizeof(orion_fragment_header_t) + fragment_size };
+    result = orion_transport_append(me, &frame, frames, used_size, duration);
+    *offset += fragment_size;
+    sent_size += frame.size;
+    fragments++;
+  }
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.fragments), fragments);
+  return (result);
+}
+
+uint16_t orion_transport_checksum(const orion_transport_t * me, const uint8_t * packet, uint32_t size)
+{
+  if (ORION_CONTROL_CHECKSUM_FLETCHER16 == me->link_.checksum)
+  {
+    return (orion_crc_calculate_fletcher16(packet + sizeof(orion_frame_header_t), size - sizeof(orion_frame_header_t)));
+  }
+  return (orion_crc_calculate_crc16(packet + sizeof(orion_frame_header_t), size - sizeof(orion_frame_header_t)));
+}
+
+void orion_transport_compress(orion_transport_t * me, orion_transport_packet_t * frame)
+{
+  // Compressed frame pays for envelope header instead of frame header and has to be smaller than original one
+  uint32_t overhead = sizeof(orion_envelope_header_t) - sizeof(orion_frame_header_t);
+  uint32_t size = frame->size - sizeof(orion_frame_header_t);
+  if (size <= overhead + 1)
+  {
+    return;
+  }
+
+  ssize_t compressed_size = orion_lz_compress(frame->buffer + sizeof(orion_frame_header_t), size,
+    me->compression_buffer_ + sizeof(orion_envelope_header_t), size - overhead - 1, me->compression_table_,
+    me->compression_table_bits_);
+  if (compressed_size < 0)
+  {
+    return;
+  }
+
+  orion_transport_init_envelope((orion_envelope_header_t*)me->compression_buffer_, ORION_ENVELOPE_FLAG_COMPRESSED);
+  frame->buffer = me->compression_buffer_;
+  frame->size = sizeof(orion_envelope_header_t) + compressed_size;
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.compressed_frames), 1);
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.compression_saved_bytes),
+    size + sizeof(orion_frame_header_t) - frame->size);
+}
+
+uint32_t orion_transport_pack(orion_transport_t * me, const orion_transport_packet_t * packets, uint32_t count,
+  orion_transport_packet_t * frame)
+{
+  uint32_t size = sizeof(orion_envelope_header_t);
+  uint32_t packed = 0;
+  while (packed < count)
+  {
+    uint32_t record_size = packets[packed].size - sizeof(orion_frame_header_t);
+    if ((record_size > ORION_ENVELOPE_MAX_RECORD_SIZE) || ((size + 1 + record_size) > me->link_.frame_size))
+    {
+      break;
+    }
+    size += 1 + record_size;
+    packed++;
+  }
+
+  // Container of a single message only adds overhead
+  if (packed < 2)
+  {
+    *frame = packets[0];
+    return (1);
+  }
+
+  orion_transport_init_envelope((orion_envelope_header_t*)me->container_buffer_, ORION_ENVELOPE_FLAG_CONTAINER);
+  uint8_t *record = me->container_buffer_ + sizeof(orion_envelope_header_t);
+  for (uint32_t index = 0; index < packed; index++)
+  {
+    uint32_t record_size = packets[index].size - sizeof(orion_frame_header_t);
+    *record = (uint8_t)record_size;
+    memcpy(record + 1, packets[index].buffer + sizeof(orion_frame_header_t), record_size);
+    record += 1 + record_size;
+  }
+  frame->buffer = me->container_buffer_;
+  frame->size = size;
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.packed_messages), packed);
+  return (packed);
+}
+
+ssize_t orion_transport_open_envelope(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size)
+{
+  if ((size < sizeof(orion_command_header_t)) ||
+    (ORION_CONTROL_MESSAGE_ID_ENVELOPE != ((orion_command_header_t*)output_buffer)->common.message_id))
+  {
+    return (size);
+  }
+
+  const orion_envelope_header_t *header = (const orion_envelope_header_t*)output_buffer;
+  if ((size > sizeof(orion_envelope_header_t)) && (ORION_ENVELOPE_FLAG_FRAGMENT == header->flags) &&
+    (ORION_ENVELOPE_VERSION >= header->common.oldest_compatible_version))
+  {
+    return (orion_transport_reassemble(me, output_buffer, output_size, size));
+  }
+  if ((size > sizeof(orion_envelope_header_t)) && (ORION_ENVELOPE_FLAG_COMPRESSED == header->flags) &&
+    (ORION_ENVELOPE_VERSION >= header->common.oldest_compatible_version))
+  {
+    return (orion_transport_decompress(me, output_buffer, output_size, size));
+  }
+  if ((size <= sizeof(orion_envelope_header_t)) || (ORION_ENVELOPE_FLAG_CONTAINER != header->flags) ||
+    (ORION_ENVELOPE_VERSION < header->common.oldest_compatible_version))
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decode_errors), 1);
+    return (ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET);
+  }
+
+  // Encoded frame is already decoded, so its buffer is free to keep the records
+  me->unpack_offset_ = 0;
+  me->unpack_size_ = size - sizeof(orion_envelope_header_t);
+  memcpy(me->buffer_, output_buffer + sizeof(orion_envelope_header_t), me->unpack_size_);
+  return (orion_transport_unpack(me, output_buffer, output_size));
+}
+
+ssize_t orion_transport_unpack(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size)
+{
+  uint32_t record_size = me->buffer_[me->unpack_offset_];
+  uint32_t next_offset = me->unpack_offset_ + 1 + record_size;
+  if ((next_offset > me->unpack_size_) || (record_size < sizeof(orion_common_header_t)) ||
+    ((sizeof(orion_frame_header_t) + record_size) > output_size))
+  {
+    me->unpack_size_ = 0;
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decode_errors), 1);
+    return (ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET);
+  }
+
+  // CRC of the whole container was checked already
+  orion_frame_header_t *frame_header = (orion_frame_header_t*)output_buffer;
+  frame_header->crc = 0;
+  memcpy(output_buffer + sizeof(orion_frame_header_t), me->buffer_ + me->unpack_offset_ + 1, record_size);
+  me->unpack_offset_ = next_offset;
+  if (me->unpack_offset_ >= me->unpack_size_)
+  {
+    me->unpack_size_ = 0;
+  }
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.unpacked_messages), 1);
+  return (sizeof(orion_frame_header_t) + record_size);
+}
+
+ssize_t orion_transport_reassemble(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size)
+{
+  const orion_fragment_header_t *header = (const orion_fragment_header_t*)output_buffer;
+  if (size <= sizeof(orion_fragment_header_t))
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decode_errors), 1);
+    return (ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET);
+  }
+  uint32_t fragment_size = size - sizeof(orion_fragment_header_t);
+
+  if (0 == header->offset)
+  {
+    me->reassembling_ = true;
+    me->reassembly_transfer_id_ = header->transfer_id;
+    me->reassembled_size_ = 0;
+  }
+  else if (!me->reassembling_ || (me->reassembly_transfer_id_ != header->transfer_id) ||
+    (me->reassembled_size_ != header->offset))
+  {
+    // Fragment before this one was lost, the rest of transfer is useless
+    me->reassembling_ = false;
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.reassembly_errors), 1);
+    return (ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET);
+  }
+  if ((NULL == me->reassembly_buffer_) ||
+    (header->total_size > me->reassembly_size_ - sizeof(orion_frame_header_t)) ||
+    (fragment_size > header->total_size - header->offset))
+  {
+    me->reassembling_ = false;
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.reassembly_errors), 1);
+    return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+  }
+
+  memcpy(me->reassembly_buffer_ + sizeof(orion_frame_header_t) + header->offset,
+    output_buffer + sizeof(orion_fragment_header_t), fragment_size);
+  me->reassembled_size_ += fragment_size;
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.fragments), 1);
+  if (me->reassembled_size_ < header->total_size)
+  {
+    return (ORION_TRAN_ERROR_INCOMPLETE_MESSAGE);
+  }
+
+  me->reassembling_ = false;
+  uint32_t message_size = sizeof(orion_frame_header_t) + me->reassembled_size_;
+  if (message_size > output_size)
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.too_big_errors), 1);
+    return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+  }
+  // CRC of every fragment was checked already
+  orion_frame_header_t *frame_header = (orion_frame_header_t*)me->reassembly_buffer_;
+  frame_header->crc = 0;
+  memcpy(output_buffer, me->reassembly_buffer_, message_size);
+  return (message_size);
+}
+
+ssize_t orion_transport_decompress(orion_transport_t * me, uint8_t * output_buffer, uint32_t output_size,
+  uint32_t size)
+{
+  // Encoded frame is already decoded, so its buffer is free to keep compressed data
+  uint32_t compressed_size = size - sizeof(orion_envelope_header_t);
+  memcpy(me->buffer_, output_buffer + sizeof(orion_envelope_header_t), compressed_size);
+
+  // Only frames which fit frame size are compressed, so anything bigger is damaged
+  uint32_t max_size = (output_size < me->frame_size_) ? output_size : me->frame_size_;
+  ssize_t result = orion_lz_decompress(me->buffer_, compressed_size, output_buffer + sizeof(orion_frame_header_t),
+    max_size - sizeof(orion_frame_header_t));
+  const orion_envelope_header_t *header = (const orion_envelope_header_t*)output_buffer;
+  if ((result < (ssize_t)sizeof(orion_common_header_t)) ||
+    ((ORION_CONTROL_MESSAGE_ID_ENVELOPE == header->common.message_id) &&
+    (ORION_ENVELOPE_FLAG_CONTAINER != header->flags)))
+  {
+    // Sender compresses only plain messages and containers
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decode_errors), 1);
+    return (ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET);
+  }
+
+  // CRC of compressed frame was checked already
+  orion_frame_header_t *frame_header = (orion_frame_header_t*)output_buffer;
+  frame_header->crc = 0;
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.decompressed_frames), 1);
+  return (orion_transport_open_envelope(me, output_buffer, output_size, sizeof(orion_frame_header_t) + result));
+}
@@ -28,17 +28,30 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <unistd.h>
+#include <string.h>
 #include "orion_protocol/orion_assert.h"
 #include "orion_protocol/orion_serial_port.h"
 #include "orion_protocol/orion_timeout.h"
 #include "orion_protocol/orion_memory.h"
+#include "orion_protocol/orion_statistics.h"
+
+#define ORION_MICROSECONDS_IN_SECOND (1000000)
 
 struct orion_communication_struct_t
 {
     int file_descriptor_;
+    orion_statistics_lock_t tx_lock_;
+    orion_statistics_lock_t rx_lock_;
+    orion_communication_statistics_t statistics_;
 };
 
+static void set_interval(struct timeval * interval, uint32_t timeout);
+static void count_receive(orion_communication_t * me, uint32_t calls, uint32_t polls, ssize_t result);
+static void count_send(orion_communication_t * me, uint32_t calls, uint32_t polls, uint32_t bytes,
+  orion_communication_error_t result);
+
 static orion_communication_error_t set_interface_attributes(const orion_communication_t * me, uint32_t speed);
+static speed_t get_speed(uint32_t baud);
 
 orion_communication_error_t orion_communication_new(orion_communication_t ** me)
 {
@@ -49,6 +62,9 @@ orion_communication_error_t orion_communication_new(orion_communication_t ** me)
       return (ORION_COM_ERROR_COULD_NOT_ALLOCATE_MEMORY);
   }
   (*me)->file_descriptor_ = -1;
+  orion_statistics_init(&((*me)->tx_lock_));
+  orion_statistics_init(&((*me)->rx_lock_));
+  memset(&((*me)->statistics_), 0, sizeof((*me)->statistics_));
   return (ORION_COM_ERROR_NONE);
 }
 
@@ -97,7 +113,31 @@ orion_communication_error_t orion_communication_disconnect(orion_communication_t
     return (ORION_COM_ERROR_NONE);
 }
 
-ssize_t orion_communication_receive_available_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size)
+orion_communication_error_t orion_communication_set_baud(orion_communication_t * me, const uint32_t baud)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT(-1 != me->file_descriptor_);
+
+    struct termios tty;
+    if (tcgetattr(me->file_descriptor_, &tty) < 0)
+    {
+        return (ORION_COM_ERROR_GETTING_TERMINAL_ATTRIBUTES);
+    }
+
+    speed_t speed = get_speed(baud);
+    if ((0 != cfsetospeed(&tty, speed)) || (0 != cfsetispeed(&tty, speed)))
+    {
+        return (ORION_COM_ERROR_SETTING_TERMINAL_ATTRIBUTES);
+    }
+    // Bytes already written leave at the previous rate
+    if (0 != tcsetattr(me->file_descriptor_, TCSADRAIN, &tty))
+    {
+        return (ORION_COM_ERROR_SETTING_TERMINAL_ATTRIBUTES);
+    }
+    return (ORION_COM_ERROR_NONE);
+}
+
+ssize_t orion_communication_receive_available_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT(-1 != me->file_descriptor_);
@@ -113,11 +153,12 @@ ssize_t orion_communication_receive_available_buffer(const orion_communication_t
     {
         result = ORION_COM_ERROR_READING_SERIAL_PORT;
     }
+    count_receive(me, 1, 0, result);
 
     return (result);
 }
 
-ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size,
+ssize_t orion_communication_receive_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size,
   uint32_t timeout)
 {
     ORION_ASSERT_NOT_NULL(me);
@@ -131,10 +172,10 @@ ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uin
     FD_ZERO(&set);
     FD_SET(me->file_descriptor_, &set);
 
-    duration.tv_sec = 0;
-    duration.tv_usec = timeout;
+    set_interval(&duration, timeout);
 
     status = select(me->file_descriptor_ + 1, &set, NULL, NULL, &duration);
+    count_receive(me, 0, 1, (-1 == status) ? ORION_COM_ERROR_UNKNOWN : 0);
 
     if (-1 == status)
     {
@@ -147,13 +188,14 @@ ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uin
     return (result);
 }
 
-bool orion_communication_has_available_buffer(const orion_communication_t * me)
+bool orion_communication_has_available_buffer(orion_communication_t * me)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT(-1 != me->file_descriptor_);
 
     int bytes_available;
     ioctl(me->file_descriptor_, FIONREAD, &bytes_available);
+    count_receive(me, 0, 1, 0);
     if (bytes_available > 0)
     {
         return true;
@@ -161,7 +203,7 @@ bool orion_communication_has_available_buffer(const orion_communication_t * me)
     return false;
 }
 
-orion_communication_error_t orion_communication_send_buffer(const orion_communication_t * me, uint8_t *buffer, 
+orion_communication_error_t orion_communication_send_buffer(orion_communication_t * me, uint8_t *buffer, 
   uint32_t size, uint32_t timeout)
 {
     // Current implementation is select based as PySerial implementation
@@ -176,13 +218,17 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
     size_t bytes_to_send = size;
     int select_status = -1;
     uint32_t position = 0;
+    uint32_t calls = 0;
+    uint32_t polls = 0;
 
     fd_set set;
     struct timeval interval;
 
-    while ((bytes_to_send > 0) && orion_timeout_has_time(&duration))
+    // The first write is made even without time left, Minor sends with zero timeout and does not wait
+    while ((bytes_to_send > 0) && ((0 == calls) || orion_timeout_has_time(&duration)))
     {
         ssize_t write_result = write(me->file_descriptor_, buffer + position, bytes_to_send);
+        calls++;
         if (-1 == write_result)
         {
             result = ORION_COM_ERROR_WRITING_TO_SERIAL_PORT;
@@ -197,10 +243,10 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
             FD_ZERO(&set);
             FD_SET(me->file_descriptor_, &set);
 
-            interval.tv_sec = 0;
-            interval.tv_usec = orion_timeout_time_left(&duration);
+            set_interval(&interval, orion_timeout_time_left(&duration));
 
             select_status = select(me->file_descriptor_ + 1, NULL, &set, NULL, &interval);
+            polls++;
             if (-1 == select_status)
             {
                 result = ORION_COM_ERROR_WRITING_TO_SERIAL_PORT;
@@ -213,10 +259,21 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
     {
         result = ORION_COM_ERROR_TIMEOUT;
     }
+    count_send(me, calls, polls, position, result);
 
     return (result);
 }
 
+orion_communication_error_t orion_communication_get_statistics(const orion_communication_t * me,
+  orion_communication_statistics_t * statistics)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(statistics);
+    orion_statistics_read(&(me->tx_lock_), &(me->statistics_.tx), &(statistics->tx), sizeof(statistics->tx));
+    orion_statistics_read(&(me->rx_lock_), &(me->statistics_.rx), &(statistics->rx), sizeof(statistics->rx));
+    return (ORION_COM_ERROR_NONE);
+}
+
 orion_communication_error_t set_interface_attributes(const orion_communication_t *object, uint32_t speed)
 {
     struct termios tty;
@@ -227,8 +284,8 @@ orion_communication_error_t set_interface_attributes(const orion_communication_t
         return (ORION_COM_ERROR_GETTING_TERMINAL_ATTRIBUTES);
     }
 
-    cfsetospeed(&tty, (speed_t)speed);
-    cfsetispeed(&tty, (speed_t)speed);
+    cfsetospeed(&tty, get_speed(speed));
+    cfsetispeed(&tty, get_speed(speed));
 
     tty.c_cflag |= (CLOCAL | CREAD);  // ignore modem controls
     tty.c_cflag &= ~CSIZE;
@@ -253,3 +310,65 @@ orion_communication_error_t set_interface_attributes(const orion_communication_t
 
     return (ORION_COM_ERROR_NONE);
 }
+
+speed_t get_speed(uint32_t baud)
+{
+    static const struct
+    {
+        uint32_t baud;
+        speed_t speed;
+    }
+    speeds[] =
+    {
+        { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 },
+        { 230400, B230400 },
+#ifdef B460800
+        { 460800, B460800 }, { 500000, B500000 }, { 576000, B576000 }, { 921600, B921600 },
+        { 1000000, B1000000 }, { 1152000, B1152000 }, { 1500000, B1500000 }, { 2000000, B2000000 },
+        { 2500000, B2500000 }, { 3000000, B3000000 }, { 3500000, B3500000 }, { 4000000, B4000000 },
+#endif
+    };
+
+    for (size_t index = 0; index < sizeof(speeds) / sizeof(speeds[0]); index++)
+    {
+        if (baud == speeds[index].baud)
+        {
+            return (speeds[index].speed);
+        }
+    }
+    // Other values are taken for speed_t constants, as connect always accepted them
+    return ((speed_t)baud);
+}
+
+void count_receive(orion_communication_t * me, uint32_t calls, uint32_t polls, ssize_t result)
+{
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.calls), calls);
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.polls), polls);
+    if (result > 0)
+    {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.bytes), result);
+    }
+    else if (result < 0)
+    {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.errors), 1);
+    }
+}
+
+void count_send(orion_communication_t * me, uint32_t calls, uint32_t polls, uint32_t bytes,
+  orion_communication_error_t result)
+{
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.calls), calls);
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.polls), polls);
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.bytes), bytes);
+    if (ORION_COM_ERROR_NONE != result)
+    {
+        orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.errors), 1);
+    }
+}
+
+void set_interval(struct timeval * interval, uint32_t timeout)
+{
+    // select() rejects microseconds part bigger than a second
+    interval->tv_sec = timeout / ORION_MICROSECONDS_IN_SECOND;
+    interval->tv_usec = timeout % ORION_MICROSECONDS_IN_SECOND;
+}
@@ -34,13 +34,24 @@
 #include "orion_protocol/orion_assert.h"
 #include "orion_protocol/orion_timeout.h"
 #include "orion_protocol/orion_memory.h"
+#include "orion_protocol/orion_statistics.h"
 #include "orion_protocol/orion_tcp_serial_bridge.h"
 
+#define ORION_MICROSECONDS_IN_SECOND (1000000)
+
 struct orion_communication_struct_t
 {
   int socket_descriptor_;
+  orion_statistics_lock_t tx_lock_;
+  orion_statistics_lock_t rx_lock_;
+  orion_communication_statistics_t statistics_;
 };
 
+static void set_interval(struct timeval * interval, uint32_t timeout);
+static void count_receive(orion_communication_t * me, uint32_t calls, uint32_t polls, ssize_t result);
+static void count_send(orion_communication_t * me, uint32_t calls, uint32_t polls, uint32_t bytes,
+  orion_communication_error_t result);
+
 orion_communication_error_t orion_communication_new(orion_communication_t ** me)
 {
   ORION_ASSERT_NOT_NULL(me);
@@ -50,6 +61,9 @@ orion_communication_error_t orion_communication_new(orion_communication_t ** me)
       return (ORION_COM_ERROR_COULD_NOT_ALLOCATE_MEMORY);
   }
   (*me)->socket_descriptor_ = -1;
+  orion_statistics_init(&((*me)->tx_lock_));
+  orion_statistics_init(&((*me)->rx_lock_));
+  memset(&((*me)->statistics_), 0, sizeof((*me)->statistics_));
   return (ORION_COM_ERROR_NONE);
 }
 
@@ -115,7 +129,7 @@ orion_communication_error_t orion_communication_disconnect(orion_communication_t
   return (ORION_COM_ERROR_NONE);
 }
 
-ssize_t orion_communication_receive_available_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size)
+ssize_t orion_communication_receive_available_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size)
 {
 
   ORION_ASSERT_NOT_NULL(me);
@@ -130,11 +144,12 @@ ssize_t orion_communication_receive_available_buffer(const orion_communication_t
   {
       result = ORION_COM_ERROR_READING_SOCKET;
   }
+  count_receive(me, 1, 0, result);
 
   return (result);
 }
 
-ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size,
+ssize_t orion_communication_receive_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size,
   uint32_t timeout)
 {
   ORION_ASSERT_NOT_NULL(me);
@@ -148,10 +163,10 @@ ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uin
   FD_ZERO(&set);
   FD_SET(me->socket_descriptor_, &set);
 
-  duration.tv_sec = 0;
-  duration.tv_usec = timeout;
+  set_interval(&duration, timeout);
 
   status = select(me->socket_descriptor_ + 1, &set, NULL, NULL, &duration);
+  count_receive(me, 0, 1, (-1 == status) ? ORION_COM_ERROR_UNKNOWN : 0);
 
   if (-1 == status)
   {
@@ -164,13 +179,14 @@ ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uin
   return (result);
 }
 
-bool orion_communication_has_available_buffer(const orion_communication_t * me)
+bool orion_communication_has_available_buffer(orion_communication_t * me)
 {
   ORION_ASSERT_NOT_NULL(me);
   ORION_ASSERT(-1 != me->socket_descriptor_);
 
   int bytes_available;
   ioctl(me->socket_descriptor_, FIONREAD, &bytes_available);
+  count_receive(me, 0, 1, 0);
   if (bytes_available > 0)
   {
     return true;
@@ -178,7 +194,7 @@ bool orion_communication_has_available_buffer(const orion_communication_t * me)
   return false;
 }
 
-orion_communication_error_t orion_communication_send_buffer(const orion_communication_t * me, uint8_t *buffer,
+orion_communication_error_t orion_communication_send_buffer(orion_communication_t * me, uint8_t *buffer,
   uint32_t size, uint32_t timeout)
 {
   // Current implementation is select based as PySerial implementation
@@ -194,6 +210,8 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
   size_t bytes_to_send = size;
   int select_status = -1;
   uint32_t position = 0;
+  uint32_t calls = 0;
+  uint32_t polls = 0;
 
   fd_set set;
   struct timeval interval;
@@ -201,6 +219,7 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
   while ((bytes_to_send > 0) && orion_timeout_has_time(&duration))
   {
     ssize_t write_result = write(me->socket_descriptor_, buffer + position, bytes_to_send);
+    calls++;
     if (-1 == write_result)
     {
         result = ORION_COM_ERROR_WRITING_TO_SOCKET;
@@ -215,10 +234,10 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
       FD_ZERO(&set);
       FD_SET(me->socket_descriptor_, &set);
 
-      interval.tv_sec = 0;
-      interval.tv_usec = orion_timeout_time_left(&duration);
+      set_interval(&interval, orion_timeout_time_left(&duration));
 
       select_status = select(me->socket_descriptor_ + 1, NULL, &set, NULL, &interval);
+      polls++;
       if (-1 == select_status)
       {
           result = ORION_COM_ERROR_WRITING_TO_SOCKET;
@@ -231,6 +250,50 @@ orion_communication_error_t orion_communication_send_buffer(const orion_communic
   {
       result = ORION_COM_ERROR_TIMEOUT;
   }
+  count_send(me, calls, polls, position, result);
 
   return (result);
 }
+
+orion_communication_error_t orion_communication_get_statistics(const orion_communication_t * me,
+  orion_communication_statistics_t * statistics)
+{
+  ORION_ASSERT_NOT_NULL(me);
+  ORION_ASSERT_NOT_NULL(statistics);
+  orion_statistics_read(&(me->tx_lock_), &(me->statistics_.tx), &(statistics->tx), sizeof(statistics->tx));
+  orion_statistics_read(&(me->rx_lock_), &(me->statistics_.rx), &(statistics->rx), sizeof(statistics->rx));
+  return (ORION_COM_ERROR_NONE);
+}
+
+void count_receive(orion_communication_t * me, uint32_t calls, uint32_t polls, ssize_t result)
+{
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.calls), calls);
+  orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.polls), polls);
+  if (result > 0)
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.bytes), result);
+  }
+  else if (result < 0)
+  {
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.errors), 1);
+  }
+}
+
+void count_send(orion_communication_t * me, uint32_t calls, uint32_t polls, uint32_t bytes,
+  orion_communication_error_t result)
+{
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.calls), calls);
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.polls), polls);
+  orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.bytes), bytes);
+  if (ORION_COM_ERROR_NONE != result)
+  {
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.errors), 1);
+  }
+}
+
+void set_interval(struct timeval * interval, uint32_t timeout)
+{
+  // select() rejects microseconds part bigger than a second
+  interval->tv_sec = timeout / ORION_MICROSECONDS_IN_SECOND;
+  interval->tv_usec = timeout % ORION_MICROSECONDS_IN_SECOND;
+}
@@ -0,0 +1,224 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include "orion_protocol/orion_instrumentation.hpp"
+#include <cmath>
+
+namespace orion
+{
+
+const uint32_t LatencyHistogram::SUB_BUCKET_BITS;
+const uint32_t LatencyHistogram::SUB_BUCKET_COUNT;
+const uint32_t LatencyHistogram::BUCKET_COUNT;
+const uint32_t Instrumentation::MESSAGE_ID_COUNT;
+const uint32_t Instrumentation::ATTEMPTS_COUNT;
+const uint32_t Instrumentation::OUTCOME_COUNT;
+
+LatencyHistogram::LatencyHistogram() : max_(0)
+{
+  for (uint32_t index = 0; index < BUCKET_COUNT; index++)
+  {
+    this->counts_[index].store(0, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::record(uint32_t value)
+{
+  this->counts_[getIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  uint32_t max = this->max_.load(std::memory_order_relaxed);
+  while ((value > max) && !this->max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+uint32_t LatencyHistogram::getCount() const
+{
+  uint32_t result = 0;
+  for (uint32_t index = 0; index < BUCKET_COUNT; index++)
+  {
+    result += this->counts_[index].load(std::memory_order_relaxed);
+  }
+  return (result);
+}
+
+uint32_t LatencyHistogram::getMax() const
+{
+  return (this->max_.load(std::memory_order_relaxed));
+}
+
+uint32_t LatencyHistogram::getValueAtPercentile(double percentile) const
+{
+  uint32_t counts[BUCKET_COUNT];
+  uint64_t total = 0;
+  for (uint32_t index = 0; index < BUCKET_COUNT; index++)
+  {
+    counts[index] = this->counts_[index].load(std::memory_order_relaxed);
+    total += counts[index];
+  }
+  if (0 == total)
+  {
+    return (0);
+  }
+
+  uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+  if (target < 1)
+  {
+    target = 1;
+  }
+  uint64_t accumulated = 0;
+  uint32_t result = this->getMax();
+  for (uint32_t index = 0; index < BUCKET_COUNT; index++)
+  {
+    accumulated += counts[index];
+    if (accumulated >= target)
+    {
+      uint32_t highest = getHighestValue(index);
+      if (highest < result)
+      {
+        result = highest;
+      }
+      break;
+    }
+  }
+  return (result);
+}
+
+uint32_t LatencyHistogram::getIndex(uint32_t value)
+{
+  if (value < SUB_BUCKET_COUNT)
+  {
+    return (value);
+  }
+  uint32_t shift = 31 - __builtin_clz(value) - SUB_BUCKET_BITS;
+  return ((shift + 1) * SUB_BUCKET_COUNT + (value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint32_t LatencyHistogram::getHighestValue(uint32_t index)
+{
+  if (index < SUB_BUCKET_COUNT)
+  {
+    return (index);
+  }
+  uint32_t shift = index / SUB_BUCKET_COUNT - 1;
+  uint64_t mantissa = SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT;
+  uint64_t result = ((mantissa + 1) << shift) - 1;
+  if (result > UINT32_MAX)
+  {
+    result = UINT32_MAX;
+  }
+  return (static_cast<uint32_t>(result));
+}
+
+Instrumentation::Instrumentation()
+{
+  for (uint32_t index = 0; index < MESSAGE_ID_COUNT; index++)
+  {
+    this->messages_[index].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Instrumentation::~Instrumentation()
+{
+  for (uint32_t index = 0; index < MESSAGE_ID_COUNT; index++)
+  {
+    delete this->messages_[index].load(std::memory_order_relaxed);
+  }
+}
+
+void Instrumentation::record(uint8_t message_id, uint32_t latency, uint8_t attempts, orion_major_error_t outcome)
+{
+  Message *message = this->getOrCreateMessage(message_id);
+  if (ORION_MAJOR_ERROR_TIMEOUT != outcome)
+  {
+    message->latency.record(latency);
+  }
+  uint32_t attempts_index = (attempts > 0) ? (attempts - 1) : 0;
+  if (attempts_index >= ATTEMPTS_COUNT)
+  {
+    attempts_index = ATTEMPTS_COUNT - 1;
+  }
+  message->attempts[attempts_index].fetch_add(1, std::memory_order_relaxed);
+  uint32_t outcome_index = static_cast<uint32_t>(outcome);
+  if (outcome_index >= OUTCOME_COUNT)
+  {
+    outcome_index = ORION_MAJOR_ERROR_UNKNOW;
+  }
+  message->outcomes[outcome_index].fetch_add(1, std::memory_order_relaxed);
+}
+
+const Instrumentation::Message* Instrumentation::getMessage(uint8_t message_id) const
+{
+  return (this->messages_[message_id].load(std::memory_order_acquire));
+}
+
+void Instrumentation::dump(std::ostream &output) const
+{
+  for (uint32_t message_id = 0; message_id < MESSAGE_ID_COUNT; message_id++)
+  {
+    const Message *message = this->getMessage(message_id);
+    if (nullptr == message)
+    {
+      continue;
+    }
+    uint32_t invokes = 0;
+    for (uint32_t index = 0; index < OUTCOME_COUNT; index++)
+    {
+      invokes += message->outcomes[index].load(std::memory_order_relaxed);
+    }
+    const LatencyHistogram &latency = message->latency;
+    output << "message_id " << message_id << ": invokes " << invokes <<
+      ", failed " << (invokes - message->outcomes[ORION_MAJOR_ERROR_NONE].load(std::memory_order_relaxed)) <<
+      ", timeouts " << message->outcomes[ORION_MAJOR_ERROR_TIMEOUT].load(std::memory_order_relaxed) <<
+      ", latency us p50 " << latency.getValueAtPercentile(50.0) <<
+      " p90 " << latency.getValueAtPercentile(90.0) <<
+      " p99 " << latency.getValueAtPercentile(99.0) <<
+      " p99.9 " << latency.getValueAtPercentile(99.9) <<
+      " max " << latency.getMax() << ", attempts";
+    for (uint32_t index = 0; index < ATTEMPTS_COUNT; index++)
+    {
+      output << " " << message->attempts[index].load(std::memory_order_relaxed);
+    }
+    output << std::endl;
+  }
+}
+
+Instrumentation::Message* Instrumentation::getOrCreateMessage(uint8_t message_id)
+{
+  Message *result = this->messages_[message_id].load(std::memory_order_acquire);
+  if (nullptr == result)
+  {
+    Message *created = new Message();
+    if (this->messages_[message_id].compare_exchange_strong(result, created, std::memory_order_acq_rel))
+    {
+      result = created;
+    }
+    else
+    {
+      // Other thread was first, result holds its message now
+      delete created;
+    }
+  }
+  return (result);
+}
+
+}  // namespace orion
@@ -22,58 +22,1221 @@
 */
 
 #include "orion_protocol/orion_major.hpp"
+#include "orion_protocol/orion_instrumentation.hpp"
+#include "orion_protocol/orion_stream.h"
+#include <algorithm>
+#include <deque>
+#include <thread>
 
 namespace orion
 {
 
-ssize_t Major::processPacket(const CommandHeader *command_header, const ResultHeader *result_header, Timeout &timeout)
+// Tried by baud rate ramp-up below the agreed rate, from the fastest
+static const uint32_t STANDARD_BAUD_RATES[] = { 4000000, 3000000, 2000000, 1500000, 1000000, 921600, 460800, 230400,
+  115200, 57600, 38400, 19200 };
+
+uint16_t Major::openMailbox(Mailbox *mailbox)
 {
-  ssize_t result = this->transport_->receivePacket(this->result_buffer_, BUFFER_SIZE, timeout.timeLeft());
-  ResultHeader *received_header;
-  bool received_same_sequence_id = false;
+  std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
   do
   {
-    if (result >= sizeof(ResultHeader))
+    this->sequence_id_ = this->sequence_base_ | ((this->sequence_id_ + 1) & this->sequence_mask_);
+  }
+  while ((ORION_UNSOLICITED_SEQUENCE_ID == this->sequence_id_) ||
+    (this->mailboxes_.end() != this->mailboxes_.find(this->sequence_id_)));
+
+  mailbox->sequence_id = this->sequence_id_;
+  mailbox->size = -1;
+  mailbox->ready = false;
+  this->mailboxes_[mailbox->sequence_id] = mailbox;
+  return (mailbox->sequence_id);
+}
+
+void Major::closeMailbox(Mailbox *mailbox)
+{
+  std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+  this->mailboxes_.erase(mailbox->sequence_id);
+}
+
+void Major::setChannel(uint8_t channel)
+{
+  ORION_ASSERT(channel < ORION_CHANNEL_COUNT);
+  std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+  this->sequence_base_ = static_cast<uint16_t>(channel << ORION_CHANNEL_SEQUENCE_BITS);
+  this->sequence_mask_ = (1 << ORION_CHANNEL_SEQUENCE_BITS) - 1;
+  this->sequence_id_ = this->sequence_base_;
+}
+
+void Major::setPriority(uint8_t message_id, Priority priority)
+{
+  std::lock_guard<std::mutex> lock(this->send_mutex_);
+  this->priorities_[message_id] = priority;
+}
+
+void Major::setMaxWriteTime(uint32_t max_write_time, uint32_t link_rate)
+{
+  std::lock_guard<std::mutex> lock(this->send_mutex_);
+  uint64_t max_write_size = static_cast<uint64_t>(max_write_time) * link_rate / Interval::Second;
+  this->max_write_size_ = (0 == max_write_time) ? 0 : std::max<uint64_t>(1, std::min<uint64_t>(max_write_size,
+    UINT32_MAX));
+}
+
+Major::Priority Major::getPriority(uint8_t message_id) const
+{
+  std::lock_guard<std::mutex> lock(this->send_mutex_);
+  std::map<uint8_t, Priority>::const_iterator item = this->priorities_.find(message_id);
+  return ((this->priorities_.end() == item) ? Control : item->second);
+}
+
+void Major::acquireLink(Priority priority)
+{
+  std::unique_lock<std::mutex> lock(this->send_mutex_);
+  this->link_waiters_[priority]++;
+  this->send_condition_.wait(lock, [this, priority]() -> bool
+    {
+      if (this->link_busy_)
+      {
+        return (false);
+      }
+      for (uint32_t index = Urgent; index < priority; index++)
+      {
+        if (this->link_waiters_[index] > 0)
+        {
+          return (false);
+        }
+      }
+      return (true);
+    });
+  this->link_waiters_[priority]--;
+  this->link_busy_ = true;
+}
+
+void Major::releaseLink()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->send_mutex_);
+    this->link_busy_ = false;
+  }
+  this->send_condition_.notify_all();
+}
+
+orion_transport_error_t Major::sendPacket(uint8_t *buffer, uint32_t size, uint32_t timeout)
+{
+  uint32_t max_write_size = 0;
+  {
+    std::lock_guard<std::mutex> lock(this->send_mutex_);
+    max_write_size = this->max_write_size_;
+  }
+  Priority priority = this->getPriority(reinterpret_cast<CommandHeader*>(buffer)->common.message_id);
+  if ((0 != max_write_size) && (size > max_write_size))
+  {
+    return (this->sendParts(buffer, size, priority, max_write_size, timeout));
+  }
+  this->acquireLink(priority);
+  orion_transport_error_t result = this->transport_->sendPacket(buffer, size, timeout);
+  this->releaseLink();
+  return (result);
+}
+
+orion_transport_error_t Major::sendParts(uint8_t *buffer, uint32_t size, Priority priority, uint32_t max_write_size,
+  uint32_t timeout)
+{
+  // Fragments of packet bigger than a write take the link part by part, urgent commands get it between them
+  Timeout duration(timeout);
+  ssize_t offset = 0;
+  while ((offset >= 0) && (offset < static_cast<ssize_t>(size)))
+  {
+    this->acquireLink(priority);
+    offset = this->transport_->sendPart(buffer, size, offset, max_write_size, (0 == offset) ? timeout :
+      duration.timeLeft());
+    this->releaseLink();
+  }
+  return ((offset < 0) ? static_cast<orion_transport_error_t>(offset) : ORION_TRAN_ERROR_NONE);
+}
+
+orion_transport_error_t Major::sendPackets(orion_transport_packet_t *packets, uint32_t count, uint32_t timeout)
+{
+  uint32_t max_write_size = 0;
+  {
+    std::lock_guard<std::mutex> lock(this->send_mutex_);
+    max_write_size = this->max_write_size_;
+  }
+
+  // Every part takes the link with priority of its most urgent command and gives it up when written
+  Timeout duration(timeout);
+  orion_transport_error_t result = ORION_TRAN_ERROR_NONE;
+  uint32_t index = 0;
+  while ((index < count) && (ORION_TRAN_ERROR_NONE == result))
+  {
+    uint32_t part_count = 0;
+    uint32_t part_size = 0;
+    Priority priority = Bulk;
+    while ((index + part_count < count) && ((0 == part_count) || (0 == max_write_size) ||
+      (part_size + packets[index + part_count].size <= max_write_size)))
+    {
+      const CommandHeader *header = reinterpret_cast<const CommandHeader*>(packets[index + part_count].buffer);
+      priority = std::min(priority, this->getPriority(header->common.message_id));
+      part_size += packets[index + part_count].size;
+      part_count++;
+    }
+    uint32_t time_left = (0 == index) ? timeout : duration.timeLeft();
+    if ((0 != max_write_size) && (part_size > max_write_size))
+    {
+      result = this->sendParts(packets[index].buffer, packets[index].size, priority, max_write_size, time_left);
+    }
+    else
+    {
+      this->acquireLink(priority);
+      result = this->transport_->sendPackets(&(packets[index]), part_count, time_left);
+      this->releaseLink();
+    }
+    index += part_count;
+  }
+  return (result);
+}
+
+orion_transport_error_t Major::sendFrame(uint8_t *frame, uint32_t size, Priority priority, uint32_t timeout)
+{
+  this->acquireLink(priority);
+  orion_transport_error_t result = this->transport_->sendFrame(frame, size, timeout);
+  this->releaseLink();
+  return (result);
+}
+
+bool Major::retransmits() const
+{
+  return (0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_RESULT_CACHE));
+}
+
+orion_transport_error_t Major::sendCommand(uint8_t *command, uint32_t command_size, Mailbox *mailbox,
+  uint8_t *frame, uint32_t frame_size, ssize_t *encoded_size, bool first_attempt, uint32_t timeout)
+{
+  // Retries repeat the frame of the first attempt, so that Minor could recognize and answer them from cache
+  bool retransmit = this->retransmits();
+  // Mailbox is registered before sending, so that result could not outrun it
+  if (!retransmit || first_attempt)
+  {
+    reinterpret_cast<CommandHeader*>(command)->common.sequence_id = this->openMailbox(mailbox);
+  }
+  Priority priority = this->getPriority(reinterpret_cast<CommandHeader*>(command)->common.message_id);
+  if (retransmit && (*encoded_size < 0) && (ORION_TRAN_ERROR_PACKET_TOO_BIG != *encoded_size))
+  {
+    // Encoder counts into tx statistics of transport, whose only writer is the thread holding the link
+    this->acquireLink(priority);
+    *encoded_size = this->transport_->encodePacket(command, command_size, frame, frame_size);
+    this->releaseLink();
+  }
+  // Command bigger than frame goes as fragments, which are framed anew on every attempt
+  if (!retransmit || (ORION_TRAN_ERROR_PACKET_TOO_BIG == *encoded_size))
+  {
+    return (this->sendPacket(command, command_size, timeout));
+  }
+  if (*encoded_size < 0)
+  {
+    return (static_cast<orion_transport_error_t>(*encoded_size));
+  }
+  return (this->sendFrame(frame, *encoded_size, priority, timeout));
+}
+
+ssize_t Major::exchangePacket(uint8_t *command, uint32_t command_size, Mailbox *mailbox, uint8_t *frame,
+  uint32_t frame_size, uint32_t retry_timeout, uint8_t retry_count, bool adaptive, uint8_t *attempts)
+{
+  CommandHeader *command_header = reinterpret_cast<CommandHeader*>(command);
+  bool retransmit = this->retransmits();
+  ssize_t encoded_size = -1;
+  ssize_t size_received = -1;
+
+  *attempts = 0;
+  this->counters_.invocations++;
+  while ((retry_count > 0) && (size_received < 0))
+  {
+    if (*attempts > 0)
+    {
+      this->counters_.retries++;
+    }
+    uint32_t attempt_timeout = adaptive ? this->getRetryTimeout(command_header->common.message_id, *attempts) :
+      retry_timeout;
+    (*attempts)++;
+    Timeout timeout(attempt_timeout);
+    std::chrono::steady_clock::time_point send_time;
+    if (nullptr != this->rtt_)
+    {
+      send_time = std::chrono::steady_clock::now();
+    }
+    orion_transport_error_t send_status = this->sendCommand(command, command_size, mailbox, frame, frame_size,
+      &encoded_size, 1 == *attempts, attempt_timeout);
+    if (ORION_TRAN_ERROR_NONE == send_status)
+    {
+      size_received = this->processPacket(mailbox, timeout);
+      if ((size_received >= 0) && (1 == *attempts) && (nullptr != this->rtt_))
+      {
+        this->recordRtt(command_header->common.message_id, send_time);
+      }
+    }
+    else
+    {
+      this->counters_.send_errors++;
+    }
+    if (!retransmit)
+    {
+      this->closeMailbox(mailbox);
+    }
+    retry_count--;
+  }
+  if (retransmit)
+  {
+    this->closeMailbox(mailbox);
+  }
+  return (size_received);
+}
+
+void Major::startAsync(std::unique_ptr<AsyncRequest> request)
+{
+  this->counters_.invocations++;
+  request->start_time = std::chrono::steady_clock::now();
+  if (this->retransmits())
+  {
+    request->frame.resize(ORION_FRAMER_MAX_ENCODED_SIZE(request->command.size()));
+  }
+  this->sendAsync(request.get());
+
+  std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+  this->async_requests_.push_back(std::move(request));
+}
+
+void Major::sendAsync(AsyncRequest *request)
+{
+  const CommandHeader *command_header = reinterpret_cast<const CommandHeader*>(request->command.data());
+  uint32_t attempt_timeout = request->adaptive ?
+    this->getRetryTimeout(command_header->common.message_id, request->attempts) : request->retry_timeout;
+  if (request->attempts > 0)
+  {
+    this->counters_.retries++;
+    if (!this->retransmits())
+    {
+      this->closeMailbox(&(request->mailbox));
+    }
+  }
+  request->send_time = std::chrono::steady_clock::now();
+  request->deadline = request->send_time + std::chrono::microseconds(attempt_timeout);
+  orion_transport_error_t send_status = this->sendCommand(request->command.data(), request->command.size(),
+    &(request->mailbox), request->frame.data(), request->frame.size(), &(request->encoded_size),
+    0 == request->attempts, attempt_timeout);
+  request->attempts++;
+  request->retry_count--;
+  if (ORION_TRAN_ERROR_NONE != send_status)
+  {
+    // Failed attempt is due at once, so that the next one is sent by the next poll
+    this->counters_.send_errors++;
+    request->deadline = request->send_time;
+  }
+}
+
+size_t Major::poll(uint32_t timeout)
+{
+  uint32_t poll_timeout = this->getPollTimeout();
+  if (poll_timeout > timeout)
+  {
+    poll_timeout = timeout;
+  }
+  {
+    std::unique_lock<std::mutex> lock(this->mailbox_mutex_);
+    if (!this->receiving_)
+    {
+      // Frames already queued by transport are taken at once, only the first receive waits
+      do
+      {
+        this->receivePacket(lock, poll_timeout);
+        poll_timeout = 0;
+      }
+      while (this->transport_->hasReceivedPacket());
+      this->handOverReceiving();
+    }
+  }
+  return (this->completeAsync());
+}
+
+uint32_t Major::getPollTimeout() const
+{
+  std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  int64_t result = UINT32_MAX;
+  for (const std::unique_ptr<AsyncRequest> &request : this->async_requests_)
+  {
+    int64_t time_left = std::chrono::duration_cast<std::chrono::microseconds>(request->deadline - now).count();
+    if (request->mailbox.ready || (time_left <= 0))
+    {
+      return (0);
+    }
+    if (time_left < result)
+    {
+      result = time_left;
+    }
+  }
+  return (static_cast<uint32_t>(result));
+}
+
+size_t Major::completeAsync()
+{
+  std::vector<std::unique_ptr<AsyncRequest>> completed;
+  std::vector<AsyncRequest*> due;
+  {
+    std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    size_t index = 0;
+    while (index < this->async_requests_.size())
+    {
+      AsyncRequest *request = this->async_requests_[index].get();
+      if (request->mailbox.ready || ((now >= request->deadline) && (0 == request->retry_count)))
+      {
+        completed.push_back(std::move(this->async_requests_[index]));
+        this->async_requests_[index] = std::move(this->async_requests_.back());
+        this->async_requests_.pop_back();
+        continue;
+      }
+      if (now >= request->deadline)
+      {
+        due.push_back(request);
+      }
+      index++;
+    }
+  }
+
+  // Requests stay in the list while being resent, only the thread calling poll removes them
+  for (AsyncRequest *request : due)
+  {
+    this->sendAsync(request);
+  }
+
+  for (std::unique_ptr<AsyncRequest> &request : completed)
+  {
+    this->closeMailbox(&(request->mailbox));
+    CommandHeader *command_header = reinterpret_cast<CommandHeader*>(request->command.data());
+    ssize_t size_received = request->mailbox.ready ? request->mailbox.size : -1;
+    if ((size_received >= 0) && (1 == request->attempts) && (nullptr != this->rtt_))
+    {
+      this->recordRtt(command_header->common.message_id, request->send_time);
+    }
+    orion_major_error_t status = this->completeResult(command_header,
+      reinterpret_cast<ResultHeader*>(request->result), request->result_size, request->reply.data(), size_received);
+    if (nullptr != this->instrumentation_)
+    {
+      this->recordInstrumentation(command_header->common.message_id, request->start_time, request->attempts, status);
+    }
+    if (request->completion)
+    {
+      request->completion(status);
+    }
+  }
+  return (completed.size());
+}
+
+orion_major_error_t Major::invokePayload(Payload command, Payload *result, uint32_t retry_timeout,
+  uint8_t retry_count, bool adaptive)
+{
+  ORION_ASSERT_NOT_NULL(this->transport_);
+  ORION_ASSERT_NOT_NULL(command.data);
+  ORION_ASSERT_NOT_NULL(result);
+  ORION_ASSERT_NOT_NULL(result->data);
+  ORION_ASSERT(command.size >= sizeof(CommandHeader));
+  ORION_ASSERT(result->size >= sizeof(ResultHeader));
+
+  // Result is received right into the buffer of caller, so expected header is kept aside for validation
+  CommandHeader *command_header = reinterpret_cast<CommandHeader*>(command.data);
+  ResultHeader expected_header;
+  std::memcpy(&expected_header, result->data, sizeof(expected_header));
+  Mailbox mailbox(result->data, result->size);
+  std::vector<uint8_t> frame;
+  if (0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_RESULT_CACHE))
+  {
+    frame.resize(ORION_FRAMER_MAX_ENCODED_SIZE(command.size));
+  }
+
+  std::chrono::steady_clock::time_point start_time;
+  if (nullptr != this->instrumentation_)
+  {
+    start_time = std::chrono::steady_clock::now();
+  }
+  uint8_t attempts = 0;
+  ssize_t size_received = this->exchangePacket(command.data, command.size, &mailbox, frame.data(), frame.size(),
+    retry_timeout, retry_count, adaptive, &attempts);
+  orion_major_error_t return_value = ORION_MAJOR_ERROR_RESULT_TOO_BIG;
+  if (size_received > static_cast<ssize_t>(result->size))
+  {
+    this->counters_.validation_errors++;
+  }
+  else
+  {
+    return_value = this->completeResult(command_header, &expected_header, sizeof(expected_header), result->data,
+      size_received);
+  }
+  if (ORION_MAJOR_ERROR_NONE == return_value)
+  {
+    result->size = static_cast<uint32_t>(size_received);
+  }
+  if (nullptr != this->instrumentation_)
+  {
+    this->recordInstrumentation(command_header->common.message_id, start_time, attempts, return_value);
+  }
+  return (return_value);
+}
+
+orion_major_error_t Major::invoke(Batch *batch, uint32_t retry_timeout, uint8_t retry_count)
+{
+  ORION_ASSERT_NOT_NULL(this->transport_);
+  ORION_ASSERT_NOT_NULL(batch);
+
+  std::vector<Batch::Item> &items = batch->items_;
+  size_t replies_size = 0;
+  for (const Batch::Item &item : items)
+  {
+    ORION_ASSERT(item.result_size <= this->result_buffer_.size());
+    replies_size += item.result_size;
+  }
+  batch->replies_.resize(replies_size);
+
+  // Deque keeps mailboxes in place, they are neither copyable nor movable
+  std::deque<Mailbox> mailboxes;
+  std::vector<uint8_t> attempts(items.size(), 0);
+  std::vector<bool> waiting(items.size(), false);
+  uint8_t *reply = batch->replies_.data();
+  for (const Batch::Item &item : items)
+  {
+    mailboxes.emplace_back(reply, item.result_size);
+    reply += item.result_size;
+  }
+
+  std::chrono::steady_clock::time_point start_time;
+  if (nullptr != this->instrumentation_)
+  {
+    start_time = std::chrono::steady_clock::now();
+  }
+  this->counters_.invocations += items.size();
+  bool has_pending = !items.empty();
+  while ((retry_count > 0) && has_pending)
+  {
+    Timeout timeout(retry_timeout);
+    batch->packets_.clear();
+    for (size_t index = 0; index < items.size(); index++)
+    {
+      if (mailboxes[index].size < 0)
+      {
+        waiting[index] = true;
+        if (attempts[index] > 0)
+        {
+          this->counters_.retries++;
+        }
+        attempts[index]++;
+        CommandHeader *command_header = reinterpret_cast<CommandHeader*>(items[index].command);
+        command_header->common.sequence_id = this->openMailbox(&(mailboxes[index]));
+        orion_transport_packet_t packet = { items[index].command, items[index].command_size };
+        batch->packets_.push_back(packet);
+      }
+    }
+
+    orion_transport_error_t send_status = this->sendPackets(batch->packets_.data(), batch->packets_.size(),
+      retry_timeout);
+    if (ORION_TRAN_ERROR_NONE != send_status)
+    {
+      this->counters_.send_errors++;
+    }
+    has_pending = false;
+    for (size_t index = 0; index < items.size(); index++)
+    {
+      if (waiting[index])
+      {
+        Mailbox *mailbox = &(mailboxes[index]);
+        if ((ORION_TRAN_ERROR_NONE != send_status) || (this->processPacket(mailbox, timeout) < 0))
+        {
+          has_pending = true;
+        }
+        this->closeMailbox(mailbox);
+        waiting[index] = false;
+      }
+    }
+    retry_count--;
+  }
+
+  orion_major_error_t result = ORION_MAJOR_ERROR_NONE;
+  for (size_t index = 0; index < items.size(); index++)
+  {
+    Batch::Item &item = items[index];
+    CommandHeader *command_header = reinterpret_cast<CommandHeader*>(item.command);
+    item.status = this->completeResult(command_header, reinterpret_cast<ResultHeader*>(item.result),
+      item.result_size, mailboxes[index].buffer, mailboxes[index].size);
+    if ((ORION_MAJOR_ERROR_NONE == result) && (ORION_MAJOR_ERROR_NONE != item.status))
+    {
+      result = item.status;
+    }
+    if (nullptr != this->instrumentation_)
+    {
+      this->recordInstrumentation(command_header->common.message_id, start_time, attempts[index], item.status);
+    }
+  }
+  return (result);
+}
+
+ssize_t Major::processPacket(Mailbox *mailbox, Timeout &timeout)
+{
+  std::unique_lock<std::mutex> lock(this->mailbox_mutex_);
+  while (!mailbox->ready && timeout.hasTime())
+  {
+    if (!this->receiving_)
+    {
+      // Nobody reads transport, so this thread does it and delivers results to other waiting callers.
+      // Receive blocks on communication till bytes arrive or time runs out, so waiting does not spin.
+      this->receivePacket(lock, timeout.timeLeft());
+      if (mailbox->ready || !timeout.hasTime())
+      {
+        this->handOverReceiving();
+      }
+    }
+    else
+    {
+      mailbox->waiting = true;
+      mailbox->condition.wait_for(lock, std::chrono::microseconds(timeout.timeLeft()));
+      mailbox->waiting = false;
+    }
+  }
+
+  if (!mailbox->ready)
+  {
+    return (-1);
+  }
+  return (mailbox->size);
+}
+
+bool Major::spinOnce(uint32_t timeout)
+{
+  std::unique_lock<std::mutex> lock(this->mailbox_mutex_);
+  if (this->receiving_)
+  {
+    return (false);
+  }
+  ssize_t size = this->receivePacket(lock, timeout);
+  this->handOverReceiving();
+  return (size >= 0);
+}
+
+ssize_t Major::receivePacket(std::unique_lock<std::mutex> &lock, uint32_t timeout)
+{
+  this->receiving_ = true;
+  lock.unlock();
+  ssize_t size = this->transport_->receivePacket(this->result_buffer_.data(), this->result_buffer_.size(), timeout);
+  bool dispatched = this->dispatchMessage(size);
+  lock.lock();
+  this->receiving_ = false;
+  if (!dispatched)
+  {
+    this->deliverResult(size);
+  }
+  return (size);
+}
+
+bool Major::dispatchMessage(ssize_t size)
+{
+  if (size < static_cast<ssize_t>(sizeof(CommandHeader)))
+  {
+    return (false);
+  }
+  const CommandHeader *header = reinterpret_cast<const CommandHeader*>(this->result_buffer_.data());
+  if (ORION_UNSOLICITED_SEQUENCE_ID != header->common.sequence_id)
+  {
+    return (false);
+  }
+
+  const uint8_t *message = this->result_buffer_.data();
+  if (ORION_CONTROL_MESSAGE_ID_DELTA == header->common.message_id)
+  {
+    message = this->decodeDelta(&size);
+    if (nullptr == message)
+    {
+      this->counters_.dropped_deltas++;
+      return (true);
+    }
+    header = reinterpret_cast<const CommandHeader*>(message);
+  }
+
+  std::function<bool(const uint8_t*, size_t)> handler;
+  {
+    std::lock_guard<std::mutex> lock(this->handlers_mutex_);
+    if (ORION_CONTROL_MESSAGE_ID_STREAM_ACK == header->common.message_id)
     {
-      received_header = reinterpret_cast<ResultHeader*>(this->result_buffer_);
-      if (command_header->common.sequence_id == received_header->common.sequence_id)
+      // Every stream in flight has a sender of its own
+      const orion_control_stream_ack_t *ack = reinterpret_cast<const orion_control_stream_ack_t*>(message);
+      std::map<uint16_t, std::function<bool(const uint8_t*, size_t)>>::iterator found =
+        this->stream_senders_.find(ack->stream_id);
+      if ((size >= static_cast<ssize_t>(sizeof(orion_control_stream_ack_t))) && (this->stream_senders_.end() != found))
       {
-        received_same_sequence_id = true;
+        handler = found->second;
       }
     }
-    if (!received_same_sequence_id && this->transport_->hasReceivedPacket() && timeout.hasTime())
+    else
+    {
+      std::map<uint8_t, std::function<bool(const uint8_t*, size_t)>>::iterator found =
+        this->handlers_.find(header->common.message_id);
+      if (this->handlers_.end() != found)
+      {
+        handler = found->second;
+      }
+    }
+  }
+  if (handler && handler(message, size))
+  {
+    this->counters_.unsolicited_messages++;
+  }
+  else
+  {
+    this->counters_.unhandled_messages++;
+  }
+  return (true);
+}
+
+const uint8_t* Major::decodeDelta(ssize_t *size)
+{
+  const orion_control_delta_t *delta = reinterpret_cast<const orion_control_delta_t*>(this->result_buffer_.data());
+  if ((*size < static_cast<ssize_t>(sizeof(orion_control_delta_t))) ||
+    (ORION_CONTROL_DELTA_VERSION < delta->header.common.oldest_compatible_version) ||
+    (ORION_CONTROL_MESSAGE_ID_FIRST <= delta->message_id))
+  {
+    return (nullptr);
+  }
+
+  std::map<uint8_t, DeltaSlot>::iterator found = this->delta_slots_.find(delta->message_id);
+  if (this->delta_slots_.end() == found)
+  {
+    // Reconstructed message could not be bigger than any other message Major receives
+    found = this->delta_slots_.emplace(delta->message_id, DeltaSlot()).first;
+    found->second.keyframe.resize(this->result_buffer_.size());
+    found->second.message.resize(this->result_buffer_.size());
+    orion_delta_decoder_init(&(found->second.decoder), found->second.keyframe.data(),
+      found->second.keyframe.size());
+  }
+  DeltaSlot &slot = found->second;
+  *size = orion_delta_decode(&(slot.decoder), this->result_buffer_.data(), *size, slot.message.data(),
+    slot.message.size());
+  if (*size < 0)
+  {
+    return (nullptr);
+  }
+  return (slot.message.data());
+}
+
+void Major::deliverResult(ssize_t size)
+{
+  if (size < static_cast<ssize_t>(sizeof(ResultHeader)))
+  {
+    return;
+  }
+  const ResultHeader *received_header = reinterpret_cast<const ResultHeader*>(this->result_buffer_.data());
+  std::map<uint16_t, Mailbox*>::iterator found = this->mailboxes_.find(received_header->common.sequence_id);
+  if ((this->mailboxes_.end() == found) || found->second->ready)
+  {
+    this->counters_.foreign_packets++;
+    return;
+  }
+  Mailbox *mailbox = found->second;
+  std::memcpy(mailbox->buffer, this->result_buffer_.data(),
+    (static_cast<uint32_t>(size) < mailbox->capacity) ? size : mailbox->capacity);
+  mailbox->size = size;
+  mailbox->ready = true;
+  mailbox->condition.notify_one();
+}
+
+void Major::handOverReceiving()
+{
+  // Wake up one of callers still waiting, it takes over reading transport. Only mailboxes whose owner sleeps
+  // on condition qualify: the reader's own mailbox and mailboxes of a batch in progress would swallow notify.
+  for (std::map<uint16_t, Mailbox*>::iterator item = this->mailboxes_.begin(); item != this->mailboxes_.end(); ++item)
+  {
+    if (!item->second->ready && item->second->waiting)
+    {
+      item->second->condition.notify_one();
+      break;
+    }
+  }
+}
+
+orion_major_error_t Major::handshake(uint32_t capabilities)
+{
+  // Restarted Minor knows nothing of link settings agreed before
+  this->link_ = orion_transport_link_t();
+  this->link_.frame_size = this->transport_->getFrameSize();
+  this->link_.checksum = ORION_CONTROL_CHECKSUM_CRC16;
+  this->transport_->setLink(this->link_);
+
+  orion_control_handshake_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  command.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+  command.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+  command.capabilities = capabilities;
+
+  orion_control_handshake_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  result.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+
+  orion_major_error_t status = this->invoke(command, &result);
+  if (ORION_MAJOR_ERROR_NONE == status)
+  {
+    this->capabilities_ = result.capabilities & capabilities;
+    this->transport_->setContainers(0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_CONTAINER));
+    bool fragments = 0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_FRAGMENTS);
+    this->transport_->setFragments(fragments);
+    if (fragments && this->reassembly_buffer_.empty())
+    {
+      // Results are reassembled up to the size of result buffer given to constructor
+      this->reassembly_buffer_.resize(this->result_buffer_.size());
+      this->transport_->setReassemblyBuffer(this->reassembly_buffer_.data(), this->reassembly_buffer_.size());
+    }
+    bool compression = 0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_COMPRESSION);
+    if (compression && this->compression_buffer_.empty())
+    {
+      // Frame size of link is still that of transport, negotiation below may only shrink it
+      uint32_t compression_size = ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(this->link_.frame_size,
+        COMPRESSION_TABLE_BITS);
+      this->compression_buffer_.resize(compression_size / sizeof(uint16_t));
+      this->transport_->setCompressionBuffer(reinterpret_cast<uint8_t*>(this->compression_buffer_.data()),
+        compression_size);
+    }
+    else if (!compression && !this->compression_buffer_.empty())
+    {
+      this->transport_->setCompressionBuffer(nullptr, 0);
+      this->compression_buffer_.clear();
+    }
+    this->link_.capabilities = this->capabilities_;
+    if (0 != (this->capabilities_ & ORION_CONTROL_CAPABILITY_LINK))
+    {
+      status = this->negotiateLink();
+    }
+    this->transport_->setLink(this->link_);
+  }
+  return (status);
+}
+
+orion_major_error_t Major::negotiateLink()
+{
+  orion_control_link_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+  command.header.common.version = ORION_CONTROL_LINK_VERSION;
+  command.header.common.oldest_compatible_version = ORION_CONTROL_LINK_VERSION;
+  command.frame_size = this->link_.frame_size;
+  command.baud = this->max_baud_;
+  command.window = ORION_STREAM_MAX_WINDOW;
+  command.checksums = this->checksums_;
+
+  orion_control_link_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+  result.header.common.version = ORION_CONTROL_LINK_VERSION;
+
+  orion_major_error_t status = this->invoke(command, &result);
+  if (ORION_MAJOR_ERROR_NONE == status)
+  {
+    // Minor never answers beyond the offer, limits only keep a broken one from misconfiguring transport
+    this->link_.frame_size = std::min(std::max(result.frame_size,
+      static_cast<uint32_t>(ORION_CONTROL_LINK_MIN_FRAME_SIZE)), command.frame_size);
+    this->link_.baud = std::min(result.baud, command.baud);
+    this->link_.window = std::min(result.window, command.window);
+    bool single = (0 != result.checksum) && (0 == (result.checksum & (result.checksum - 1)));
+    if (single && (0 != (result.checksum & command.checksums)))
+    {
+      this->link_.checksum = result.checksum;
+    }
+  }
+  return (status);
+}
+
+orion_major_error_t Major::rampBaud(const std::function<bool(uint32_t baud)> &set_baud, uint32_t *baud,
+  uint32_t probes, uint32_t max_loss_per_mille)
+{
+  ORION_ASSERT_NOT_NULL(baud);
+  ORION_ASSERT(probes > 0);
+
+  std::vector<uint32_t> candidates;
+  if (this->link_.baud > *baud)
+  {
+    candidates.push_back(this->link_.baud);
+  }
+  for (uint32_t rate : STANDARD_BAUD_RATES)
+  {
+    if ((rate < this->link_.baud) && (rate > *baud))
+    {
+      candidates.push_back(rate);
+    }
+  }
+
+  for (uint32_t candidate : candidates)
+  {
+    uint32_t previous = *baud;
+    orion_major_error_t status = this->tryBaud(set_baud, baud, candidate, probes, max_loss_per_mille);
+    if ((ORION_MAJOR_ERROR_NONE != status) || (previous != *baud))
+    {
+      return (status);
+    }
+  }
+  return (ORION_MAJOR_ERROR_NONE);
+}
+
+orion_major_error_t Major::tryBaud(const std::function<bool(uint32_t baud)> &set_baud, uint32_t *baud,
+  uint32_t candidate, uint32_t probes, uint32_t max_loss_per_mille)
+{
+  // Burst is a round trip of every probe at the new rate, with 10 bits on the wire per byte
+  uint64_t burst_bytes = static_cast<uint64_t>(probes) *
+    (ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(orion_control_baud_command_t)) +
+    ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(orion_control_baud_result_t)));
+  uint32_t burst_timeout = this->default_timeout_ + static_cast<uint32_t>(burst_bytes * 10 * Interval::Second /
+    candidate);
+  // Minor waits for commit as long as burst and every attempt of commit could take
+  uint32_t commit_timeout = burst_timeout + this->default_timeout_ * this->default_retry_count_;
+
+  orion_control_baud_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+  command.header.common.version = ORION_CONTROL_BAUD_VERSION;
+  command.header.common.oldest_compatible_version = ORION_CONTROL_BAUD_VERSION;
+  command.step = ORION_CONTROL_BAUD_SWITCH;
+  command.baud = candidate;
+  command.timeout = commit_timeout;
+
+  orion_control_baud_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+  result.header.common.version = ORION_CONTROL_BAUD_VERSION;
+
+  std::chrono::steady_clock::time_point switch_time = std::chrono::steady_clock::now();
+  orion_major_error_t status = this->invoke(command, &result);
+  if (ORION_MAJOR_ERROR_APPLICATION_ERROR_RECEIVED == status)
+  {
+    // Minor could not switch to this rate and stays at the current one
+    return (ORION_MAJOR_ERROR_NONE);
+  }
+  // Minor is back at the previous rate by then whenever it did not get commit, its timeout starts a bit later
+  std::chrono::steady_clock::time_point fallback_time = switch_time +
+    std::chrono::microseconds(commit_timeout + this->default_timeout_);
+  uint32_t previous = *baud;
+  if ((ORION_MAJOR_ERROR_NONE != status) || !set_baud(candidate))
+  {
+    std::this_thread::sleep_until(fallback_time);
+    return (status);
+  }
+
+  uint32_t lost = this->sendProbes(probes, burst_timeout);
+  if (static_cast<uint64_t>(lost) * 1000 > static_cast<uint64_t>(max_loss_per_mille) * probes)
+  {
+    set_baud(previous);
+    std::this_thread::sleep_until(fallback_time);
+    return (ORION_MAJOR_ERROR_NONE);
+  }
+
+  command.step = ORION_CONTROL_BAUD_COMMIT;
+  status = this->invoke(command, &result);
+  if (ORION_MAJOR_ERROR_NONE == status)
+  {
+    *baud = candidate;
+    return (status);
+  }
+
+  // Either commit or its result was lost, in the first case Minor returns to the previous rate
+  std::this_thread::sleep_until(fallback_time);
+  if (0 == this->sendProbes(1, this->default_timeout_))
+  {
+    *baud = candidate;
+    return (ORION_MAJOR_ERROR_NONE);
+  }
+  set_baud(previous);
+  return ((0 == this->sendProbes(1, this->default_timeout_)) ? ORION_MAJOR_ERROR_NONE : status);
+}
+
+uint32_t Major::sendProbes(uint32_t probes, uint32_t timeout)
+{
+  std::vector<orion_control_baud_command_t> commands(probes);
+  std::vector<orion_control_baud_result_t> results(probes);
+  Batch batch;
+  for (uint32_t probe = 0; probe < probes; probe++)
+  {
+    orion_control_baud_command_t &command = commands[probe];
+    std::memset(&command, 0, sizeof(command));
+    command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+    command.header.common.version = ORION_CONTROL_BAUD_VERSION;
+    command.header.common.oldest_compatible_version = ORION_CONTROL_BAUD_VERSION;
+    command.step = ORION_CONTROL_BAUD_PROBE;
+    // Alternating bits are the hardest for receiver to sample, zeros exercise framing
+    for (uint32_t index = 0; index < sizeof(command.pattern); index++)
+    {
+      command.pattern[index] = static_cast<uint8_t>(((index & 1) ? 0x55 : 0xAA) ^ (probe * index));
+    }
+    orion_control_baud_result_t &result = results[probe];
+    std::memset(&result, 0, sizeof(result));
+    result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+    result.header.common.version = ORION_CONTROL_BAUD_VERSION;
+    batch.add(&command, &result);
+  }
+
+  // Single attempt, retries would hide the loss being measured
+  this->invoke(&batch, timeout, 1);
+  uint32_t lost = 0;
+  for (uint32_t probe = 0; probe < probes; probe++)
+  {
+    if ((ORION_MAJOR_ERROR_NONE != batch.getStatus(probe)) ||
+      (0 != std::memcmp(commands[probe].pattern, results[probe].pattern, sizeof(commands[probe].pattern))))
+    {
+      lost++;
+    }
+  }
+  return (lost);
+}
+
+orion_major_error_t Major::subscribe(uint8_t message_id, uint32_t period, uint32_t *granted_period,
+  uint32_t *achieved_period)
+{
+  orion_control_subscribe_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_SUBSCRIBE;
+  command.header.common.version = ORION_CONTROL_SUBSCRIBE_VERSION;
+  command.header.common.oldest_compatible_version = ORION_CONTROL_SUBSCRIBE_VERSION;
+  command.message_id = message_id;
+  command.period = period;
+
+  orion_control_subscribe_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_SUBSCRIBE;
+  result.header.common.version = ORION_CONTROL_SUBSCRIBE_VERSION;
+
+  orion_major_error_t status = this->invoke(command, &result);
+  if (ORION_MAJOR_ERROR_NONE == status)
+  {
+    if (nullptr != granted_period)
+    {
+      *granted_period = result.period;
+    }
+    if (nullptr != achieved_period)
     {
-      result = this->transport_->receivePacket(this->result_buffer_, BUFFER_SIZE, timeout.timeLeft());
+      *achieved_period = result.achieved_period;
     }
   }
-  while (!received_same_sequence_id && timeout.hasTime());
+  return (status);
+}
+
+orion_major_error_t Major::sendStream(const uint8_t *data, uint32_t size, uint16_t segment_size, uint32_t window,
+  uint32_t timeout)
+{
+  ORION_ASSERT_NOT_NULL(this->transport_);
+  ORION_ASSERT((nullptr != data) || (0 == size));
+  ORION_ASSERT(segment_size > 0);
+  ORION_ASSERT((window > 0) && (window <= ORION_STREAM_MAX_WINDOW));
 
-  if (0 > result)
+  if ((0 != this->link_.window) && (window > this->link_.window))
   {
-    if (!received_same_sequence_id)
+    window = this->link_.window;
+  }
+  uint16_t stream_id = 0;
+  {
+    std::lock_guard<std::mutex> lock(this->mailbox_mutex_);
+    stream_id = ++this->stream_id_;
+  }
+  std::mutex sender_mutex;
+  std::condition_variable acknowledged;
+  orion_stream_sender_t sender;
+  orion_stream_sender_init(&sender, stream_id, data, size, segment_size, window, this->default_timeout_);
+  {
+    std::lock_guard<std::mutex> lock(this->handlers_mutex_);
+    this->stream_senders_[stream_id] = [&sender_mutex, &acknowledged, &sender](const uint8_t *buffer,
+      size_t /*size*/) -> bool
+      {
+        {
+          std::lock_guard<std::mutex> lock(sender_mutex);
+          orion_stream_sender_on_ack(&sender, reinterpret_cast<const orion_control_stream_ack_t*>(buffer));
+        }
+        acknowledged.notify_all();
+        return (true);
+      };
+  }
+
+  auto time_now = []() -> uint64_t
     {
-      result = ORION_MAJOR_ERROR_COMMUNICATION_ERROR;
+      return (std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    };
+  std::vector<uint8_t> packet(sizeof(orion_control_stream_segment_t) + segment_size);
+  Timeout duration(timeout);
+  orion_major_error_t result = ORION_MAJOR_ERROR_NONE;
+  while (ORION_MAJOR_ERROR_NONE == result)
+  {
+    ssize_t packet_size = 0;
+    uint32_t wait_time = 0;
+    {
+      std::lock_guard<std::mutex> lock(sender_mutex);
+      if (orion_stream_sender_is_complete(&sender))
+      {
+        break;
+      }
+      packet_size = orion_stream_sender_poll(&sender, time_now(), packet.data(), packet.size());
+      wait_time = std::min(orion_stream_sender_get_wait_time(&sender, time_now()), duration.timeLeft());
     }
-    else if (!timeout.hasTime())
+    if (!duration.hasTime())
     {
       result = ORION_MAJOR_ERROR_TIMEOUT;
     }
+    else if (packet_size > 0)
+    {
+      if (ORION_TRAN_ERROR_NONE != this->sendPacket(packet.data(), packet_size, duration.timeLeft()))
+      {
+        this->counters_.send_errors++;
+        result = ORION_MAJOR_ERROR_COMMUNICATION_ERROR;
+      }
+    }
+    else if ((wait_time > 0) && !this->spinOnce(wait_time))
+    {
+      // Nothing arrived in time or other thread reads transport and passes acknowledgments to the handler
+      std::unique_lock<std::mutex> lock(sender_mutex);
+      acknowledged.wait_for(lock, std::chrono::microseconds(std::min(orion_stream_sender_get_wait_time(&sender,
+        time_now()), duration.timeLeft())));
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(this->handlers_mutex_);
+  this->stream_senders_.erase(stream_id);
+  return (result);
+}
+
+MajorStatistics Major::getStatistics() const
+{
+  MajorStatistics result;
+  result.invocations = this->counters_.invocations.load(std::memory_order_relaxed);
+  result.successes = this->counters_.successes.load(std::memory_order_relaxed);
+  result.retries = this->counters_.retries.load(std::memory_order_relaxed);
+  result.timeouts = this->counters_.timeouts.load(std::memory_order_relaxed);
+  result.send_errors = this->counters_.send_errors.load(std::memory_order_relaxed);
+  result.foreign_packets = this->counters_.foreign_packets.load(std::memory_order_relaxed);
+  result.application_errors = this->counters_.application_errors.load(std::memory_order_relaxed);
+  result.validation_errors = this->counters_.validation_errors.load(std::memory_order_relaxed);
+  result.unsolicited_messages = this->counters_.unsolicited_messages.load(std::memory_order_relaxed);
+  result.unhandled_messages = this->counters_.unhandled_messages.load(std::memory_order_relaxed);
+  result.dropped_deltas = this->counters_.dropped_deltas.load(std::memory_order_relaxed);
+  return (result);
+}
+
+void Major::recordInstrumentation(uint8_t message_id, std::chrono::steady_clock::time_point start_time,
+  uint8_t attempts, orion_major_error_t outcome)
+{
+  int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+    start_time).count();
+  if (latency > UINT32_MAX)
+  {
+    latency = UINT32_MAX;
   }
+  this->instrumentation_->record(message_id, static_cast<uint32_t>(latency), attempts, outcome);
+}
 
+void Major::setAdaptiveTimeout(uint32_t min_timeout, uint32_t max_timeout, bool per_message_id)
+{
+  std::lock_guard<std::mutex> lock(this->rtt_mutex_);
+  this->rtt_.reset(new RttEstimator(this->default_timeout_, min_timeout, max_timeout));
+  this->rtt_per_message_id_ = per_message_id;
+  this->message_rtt_.clear();
+}
+
+bool Major::getRttStatistics(RttStatistics *statistics) const
+{
+  ORION_ASSERT_NOT_NULL(statistics);
+
+  std::lock_guard<std::mutex> lock(this->rtt_mutex_);
+  if (nullptr == this->rtt_)
+  {
+    return (false);
+  }
+  *statistics = this->rtt_->getStatistics();
+  return (true);
+}
+
+bool Major::getRttStatistics(uint8_t message_id, RttStatistics *statistics) const
+{
+  ORION_ASSERT_NOT_NULL(statistics);
+
+  std::lock_guard<std::mutex> lock(this->rtt_mutex_);
+  auto estimator = this->message_rtt_.find(message_id);
+  if (this->message_rtt_.end() == estimator)
+  {
+    return (false);
+  }
+  *statistics = estimator->second.getStatistics();
+  return (true);
+}
+
+uint32_t Major::getRetryTimeout(uint8_t message_id, uint8_t attempt) const
+{
+  std::lock_guard<std::mutex> lock(this->rtt_mutex_);
+  auto estimator = this->message_rtt_.find(message_id);
+  if (this->message_rtt_.end() != estimator)
+  {
+    return (estimator->second.getTimeout(attempt));
+  }
+  return (this->rtt_->getTimeout(attempt));
+}
+
+void Major::recordRtt(uint8_t message_id, std::chrono::steady_clock::time_point send_time)
+{
+  int64_t rtt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+    send_time).count();
+  if (rtt > UINT32_MAX)
+  {
+    rtt = UINT32_MAX;
+  }
+
+  std::lock_guard<std::mutex> lock(this->rtt_mutex_);
+  if (this->rtt_per_message_id_)
+  {
+    auto estimator = this->message_rtt_.find(message_id);
+    if (this->message_rtt_.end() == estimator)
+    {
+      // Estimate of message_id starts from its own first sample, not from the link one
+      estimator = this->message_rtt_.emplace(message_id, *this->rtt_).first;
+      estimator->second.reset();
+    }
+    estimator->second.addSample(static_cast<uint32_t>(rtt));
+  }
+  this->rtt_->addSample(static_cast<uint32_t>(rtt));
+}
+
+orion_major_error_t Major::completeResult(const CommandHeader *command_header, ResultHeader *result_header,
+  uint32_t result_size, const uint8_t *reply, ssize_t size_received)
+{
+  if (0 > size_received)
+  {
+    this->counters_.timeouts++;
+    return (ORION_MAJOR_ERROR_TIMEOUT);
+  }
+
+  orion_major_error_t result = this->validateResult(command_header, result_header,
+    reinterpret_cast<const ResultHeader*>(reply), size_received);
+  if (ORION_MAJOR_ERROR_NONE == result)
+  {
+    this->counters_.successes++;
+    std::memcpy(reinterpret_cast<uint8_t*>(result_header), reply, result_size);
+  }
+  else if (ORION_MAJOR_ERROR_APPLICATION_ERROR_RECEIVED == result)
+  {
+    this->counters_.application_errors++;
+  }
+  else
+  {
+    this->counters_.validation_errors++;
+  }
   return (result);
 }
 
 orion_major_error_t Major::validateResult(const CommandHeader *command_header, const ResultHeader *result_header,
-  size_t size_received)
+  const ResultHeader *received_header, size_t size_received)
 {
   orion_major_error_t result = ORION_MAJOR_ERROR_UNKNOW;
 
-  ResultHeader *received_header;
   if (size_received < sizeof(ResultHeader))
   {
     return (ORION_MAJOR_ERROR_WRONG_PACKET_HEADER_SIZE);
   }
-  received_header = reinterpret_cast<ResultHeader*>(this->result_buffer_);
   if (command_header->common.sequence_id != received_header->common.sequence_id)
   {
     return (ORION_MAJOR_ERROR_NO_PACKET_WITH_THE_SAME_SEQUENCE_ID);
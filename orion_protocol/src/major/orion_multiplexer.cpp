@@ -0,0 +1,381 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+
+#include "orion_protocol/orion_multiplexer.hpp"
+#include "orion_protocol/orion_assert.h"
+#include "orion_protocol/orion_timeout.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace orion
+{
+
+/*
+  Transport of one client, every call is passed to the link through multiplexer
+*/
+class Multiplexer::Channel : public Transport
+{
+public:
+  Channel(Multiplexer *multiplexer, uint8_t channel) : multiplexer_(multiplexer), channel_(channel) {}
+
+  virtual orion_transport_error_t sendPacket(uint8_t *input_buffer, uint32_t input_size, uint32_t timeout)
+  {
+    this->multiplexer_->acquireLink(this->channel_);
+    orion_transport_error_t result = this->multiplexer_->transport_->sendPacket(input_buffer, input_size, timeout);
+    this->multiplexer_->releaseLink(this->channel_, true);
+    return (result);
+  }
+
+  virtual orion_transport_error_t sendPackets(orion_transport_packet_t *packets, uint32_t count, uint32_t timeout)
+  {
+    this->multiplexer_->acquireLink(this->channel_);
+    orion_transport_error_t result = this->multiplexer_->transport_->sendPackets(packets, count, timeout);
+    this->multiplexer_->releaseLink(this->channel_, true);
+    return (result);
+  }
+
+  virtual ssize_t sendPart(uint8_t *input_buffer, uint32_t input_size, uint32_t offset, uint32_t max_size,
+    uint32_t timeout)
+  {
+    this->multiplexer_->acquireLink(this->channel_);
+    ssize_t result = this->multiplexer_->transport_->sendPart(input_buffer, input_size, offset, max_size, timeout);
+    this->multiplexer_->releaseLink(this->channel_, true);
+    return (result);
+  }
+
+  virtual ssize_t encodePacket(uint8_t *input_buffer, uint32_t input_size, uint8_t *frame, uint32_t frame_size)
+  {
+    // Encoder counts into tx statistics of the link, which are written by the client holding it only
+    this->multiplexer_->acquireLink(this->channel_);
+    ssize_t result = this->multiplexer_->transport_->encodePacket(input_buffer, input_size, frame, frame_size);
+    this->multiplexer_->releaseLink(this->channel_, false);
+    return (result);
+  }
+
+  virtual orion_transport_error_t sendFrame(uint8_t *frame, uint32_t size, uint32_t timeout)
+  {
+    this->multiplexer_->acquireLink(this->channel_);
+    orion_transport_error_t result = this->multiplexer_->transport_->sendFrame(frame, size, timeout);
+    this->multiplexer_->releaseLink(this->channel_, true);
+    return (result);
+  }
+
+  virtual ssize_t receivePacket(uint8_t *output_buffer, uint32_t output_size, uint32_t timeout)
+  {
+    return (this->multiplexer_->receivePacket(this->channel_, output_buffer, output_size, timeout));
+  }
+
+  virtual bool hasReceivedPacket()
+  {
+    return (this->multiplexer_->hasReceivedPacket(this->channel_));
+  }
+
+  // Link settings are negotiated by handshake of any client and apply to all of them
+  virtual orion_transport_error_t setContainers(bool enabled)
+  {
+    return (this->multiplexer_->transport_->setContainers(enabled));
+  }
+
+  virtual orion_transport_error_t setFragments(bool enabled)
+  {
+    return (this->multiplexer_->transport_->setFragments(enabled));
+  }
+
+  // Buffer of a client could go away with it, so fragments are reassembled into buffer of multiplexer
+  virtual orion_transport_error_t setReassemblyBuffer(uint8_t * /*buffer*/, uint32_t /*size*/)
+  {
+    return (this->multiplexer_->setReassembly());
+  }
+
+  virtual orion_transport_error_t setCompressionBuffer(uint8_t *buffer, uint32_t size)
+  {
+    return (this->multiplexer_->setCompression((nullptr == buffer) ? 0 : size));
+  }
+
+  virtual uint32_t getFrameSize()
+  {
+    return (this->multiplexer_->transport_->getFrameSize());
+  }
+
+  virtual orion_transport_error_t setLink(const orion_transport_link_t &link)
+  {
+    return (this->multiplexer_->transport_->setLink(link));
+  }
+
+  virtual orion_transport_link_t getLink()
+  {
+    return (this->multiplexer_->transport_->getLink());
+  }
+
+  // Receive queue and its counters belong to the link, per channel counters are in Multiplexer::getStatistics
+  virtual orion_transport_error_t setOverflowPolicy(orion_transport_overflow_policy_t policy)
+  {
+    return (this->multiplexer_->transport_->setOverflowPolicy(policy));
+  }
+
+  virtual orion_transport_overflow_counters_t getOverflowCounters()
+  {
+    return (this->multiplexer_->transport_->getOverflowCounters());
+  }
+
+  virtual orion_transport_statistics_t getStatistics()
+  {
+    return (this->multiplexer_->transport_->getStatistics());
+  }
+
+  // C object of the link, a Minor built on it bypasses multiplexer
+  virtual orion_transport_t* getObject()
+  {
+    return (this->multiplexer_->transport_->getObject());
+  }
+
+private:
+  Multiplexer *multiplexer_;
+  uint8_t channel_;
+};
+
+Multiplexer::Multiplexer(Transport *transport, uint32_t buffer_size, uint32_t queue_size) :
+  transport_(transport),
+  queue_size_(queue_size),
+  buffer_(buffer_size)
+{
+  ORION_ASSERT_NOT_NULL(transport);
+  ORION_ASSERT(buffer_size >= sizeof(CommandHeader));
+  ORION_ASSERT(queue_size > 0);
+}
+
+Multiplexer::~Multiplexer() = default;
+
+Transport* Multiplexer::getChannel(uint8_t channel)
+{
+  ORION_ASSERT(channel < ORION_CHANNEL_COUNT);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  ChannelState &state = this->channels_[channel];
+  if (!state.transport)
+  {
+    state.transport.reset(new Channel(this, channel));
+  }
+  return (state.transport.get());
+}
+
+ChannelStatistics Multiplexer::getStatistics(uint8_t channel) const
+{
+  ORION_ASSERT(channel < ORION_CHANNEL_COUNT);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return (this->channels_[channel].statistics);
+}
+
+uint32_t Multiplexer::getUnroutedPackets() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return (this->unrouted_packets_);
+}
+
+void Multiplexer::acquireLink(uint8_t channel)
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->channels_[channel].writers++;
+  this->link_condition_.wait(lock, [this, channel]() -> bool
+    {
+      if (this->link_busy_)
+      {
+        return (false);
+      }
+      // Round robin starting after the channel which wrote last
+      for (uint8_t index = 1; index <= ORION_CHANNEL_COUNT; index++)
+      {
+        uint8_t next = (this->last_writer_ + index) % ORION_CHANNEL_COUNT;
+        if (this->channels_[next].writers > 0)
+        {
+          return (next == channel);
+        }
+      }
+      return (false);
+    });
+  this->channels_[channel].writers--;
+  this->link_busy_ = true;
+  this->last_writer_ = channel;
+}
+
+void Multiplexer::releaseLink(uint8_t channel, bool written)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->link_busy_ = false;
+    if (written)
+    {
+      this->channels_[channel].statistics.sent++;
+    }
+  }
+  this->link_condition_.notify_all();
+}
+
+ssize_t Multiplexer::receivePacket(uint8_t channel, uint8_t *output_buffer, uint32_t output_size, uint32_t timeout)
+{
+  Timeout duration(timeout);
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  std::deque<std::vector<uint8_t>> &queue = this->channels_[channel].queue;
+  while (true)
+  {
+    if (!queue.empty())
+    {
+      std::vector<uint8_t> packet = std::move(queue.front());
+      queue.pop_front();
+      if (packet.size() > output_size)
+      {
+        return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+      }
+      std::memcpy(output_buffer, packet.data(), packet.size());
+      return (packet.size());
+    }
+    if (!duration.hasTime())
+    {
+      return (ORION_TRAN_ERROR_TIMEOUT);
+    }
+    if (this->reading_)
+    {
+      this->received_condition_.wait_for(lock, std::chrono::microseconds(duration.timeLeft()));
+      continue;
+    }
+
+    this->reading_ = true;
+    lock.unlock();
+    ssize_t size = this->transport_->receivePacket(this->buffer_.data(), this->buffer_.size(),
+      duration.timeLeft());
+    lock.lock();
+    this->reading_ = false;
+    // Packet or not, some other client could be waiting to take over reading
+    this->received_condition_.notify_all();
+    if (size >= static_cast<ssize_t>(sizeof(CommandHeader)))
+    {
+      this->routePacket(size);
+    }
+    else if (ORION_TRAN_ERROR_INCOMPLETE_MESSAGE != size)
+    {
+      // Errors of the link and packets too short to route belong to the client which read them
+      if ((size > 0) && (static_cast<uint32_t>(size) > output_size))
+      {
+        return (ORION_TRAN_ERROR_PACKET_TOO_BIG);
+      }
+      if (size > 0)
+      {
+        std::memcpy(output_buffer, this->buffer_.data(), size);
+      }
+      return (size);
+    }
+  }
+}
+
+bool Multiplexer::hasReceivedPacket(uint8_t channel)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->channels_[channel].queue.empty())
+    {
+      return (true);
+    }
+    // Client reading the link routes whatever arrives
+    if (this->reading_)
+    {
+      return (false);
+    }
+    this->reading_ = true;
+  }
+  // Packet could belong to other channel, then receivePacket() routes it and times out
+  bool result = this->transport_->hasReceivedPacket();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->reading_ = false;
+  }
+  this->received_condition_.notify_all();
+  return (result);
+}
+
+void Multiplexer::routePacket(ssize_t size)
+{
+  const CommandHeader *header = reinterpret_cast<const CommandHeader*>(this->buffer_.data());
+  uint8_t first = 0;
+  uint8_t last = ORION_CHANNEL_COUNT - 1;
+  if (ORION_UNSOLICITED_SEQUENCE_ID != header->common.sequence_id)
+  {
+    first = ORION_CHANNEL_OF_SEQUENCE_ID(header->common.sequence_id);
+    last = first;
+    if (!this->channels_[first].transport)
+    {
+      this->unrouted_packets_++;
+      return;
+    }
+  }
+
+  for (uint8_t channel = first; channel <= last; channel++)
+  {
+    ChannelState &state = this->channels_[channel];
+    if (!state.transport)
+    {
+      continue;
+    }
+    if (state.queue.size() >= this->queue_size_)
+    {
+      state.statistics.dropped++;
+      continue;
+    }
+    state.queue.emplace_back(this->buffer_.begin(), this->buffer_.begin() + size);
+    state.statistics.received++;
+  }
+}
+
+orion_transport_error_t Multiplexer::setReassembly()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->reassembly_)
+    {
+      return (ORION_TRAN_ERROR_NONE);
+    }
+    this->reassembly_ = true;
+    this->reassembly_buffer_.resize(this->buffer_.size());
+  }
+  return (this->transport_->setReassemblyBuffer(this->reassembly_buffer_.data(), this->reassembly_buffer_.size()));
+}
+
+orion_transport_error_t Multiplexer::setCompression(uint32_t size)
+{
+  if (0 == size)
+  {
+    return (this->transport_->setCompressionBuffer(nullptr, 0));
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->compression_buffer_.empty())
+    {
+      return (ORION_TRAN_ERROR_NONE);
+    }
+    this->compression_buffer_.resize((size + 1) / sizeof(uint16_t));
+  }
+  return (this->transport_->setCompressionBuffer(reinterpret_cast<uint8_t*>(this->compression_buffer_.data()),
+    this->compression_buffer_.size() * sizeof(uint16_t)));
+}
+
+}  // namespace orion
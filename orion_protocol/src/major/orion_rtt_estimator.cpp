@@ -0,0 +1,108 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include "orion_protocol/orion_rtt_estimator.hpp"
+#include "orion_protocol/orion_assert.h"
+
+namespace orion
+{
+
+RttEstimator::RttEstimator(uint32_t initial_timeout, uint32_t min_timeout, uint32_t max_timeout) :
+  initial_timeout_(initial_timeout),
+  min_timeout_(min_timeout),
+  max_timeout_(max_timeout)
+{
+  ORION_ASSERT(min_timeout <= max_timeout);
+  this->reset();
+}
+
+void RttEstimator::reset()
+{
+  this->timeout_ = this->clamp(this->initial_timeout_);
+  this->srtt_scaled_ = 0;
+  this->rttvar_scaled_ = 0;
+  this->samples_ = 0;
+}
+
+void RttEstimator::addSample(uint32_t rtt)
+{
+  if (0 == this->samples_)
+  {
+    this->srtt_scaled_ = static_cast<uint64_t>(rtt) << 3;
+    this->rttvar_scaled_ = static_cast<uint64_t>(rtt) << 1;
+  }
+  else
+  {
+    // SRTT += (RTT - SRTT) / 8, RTTVAR += (|RTT - SRTT| - RTTVAR) / 4 in scaled integers
+    int64_t error = static_cast<int64_t>(rtt) - static_cast<int64_t>(this->srtt_scaled_ >> 3);
+    this->srtt_scaled_ = static_cast<uint64_t>(static_cast<int64_t>(this->srtt_scaled_) + error);
+    if (error < 0)
+    {
+      error = -error;
+    }
+    error -= static_cast<int64_t>(this->rttvar_scaled_ >> 2);
+    this->rttvar_scaled_ = static_cast<uint64_t>(static_cast<int64_t>(this->rttvar_scaled_) + error);
+  }
+  if (this->samples_ < UINT32_MAX)
+  {
+    this->samples_++;
+  }
+  this->timeout_ = this->clamp((this->srtt_scaled_ >> 3) + this->rttvar_scaled_);
+}
+
+uint32_t RttEstimator::getTimeout(uint8_t attempt) const
+{
+  uint64_t timeout = this->timeout_;
+  while ((attempt > 0) && (timeout < this->max_timeout_))
+  {
+    timeout <<= 1;
+    attempt--;
+  }
+  return (this->clamp(timeout));
+}
+
+RttStatistics RttEstimator::getStatistics() const
+{
+  RttStatistics result;
+  // Both are averages of 32 bit samples, so they fit 32 bits
+  result.srtt = static_cast<uint32_t>(this->srtt_scaled_ >> 3);
+  result.rttvar = static_cast<uint32_t>(this->rttvar_scaled_ >> 2);
+  result.timeout = this->timeout_;
+  result.samples = this->samples_;
+  return (result);
+}
+
+uint32_t RttEstimator::clamp(uint64_t timeout) const
+{
+  if (timeout < this->min_timeout_)
+  {
+    return (this->min_timeout_);
+  }
+  if (timeout > this->max_timeout_)
+  {
+    return (this->max_timeout_);
+  }
+  return (static_cast<uint32_t>(timeout));
+}
+
+}  // namespace orion
@@ -0,0 +1,202 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include "orion_protocol/orion_scheduler.hpp"
+#include "orion_protocol/orion_assert.h"
+#include <thread>
+
+namespace orion
+{
+
+static uint64_t getLeastCommonMultiple(uint64_t a, uint64_t b)
+{
+  uint64_t x = a;
+  uint64_t y = b;
+  while (0 != y)
+  {
+    uint64_t remainder = x % y;
+    x = y;
+    y = remainder;
+  }
+  return (a / x * b);
+}
+
+Scheduler::Scheduler(Major *major, uint32_t tick, uint32_t retry_timeout, uint8_t retry_count) :
+  major_(major),
+  tick_(tick),
+  retry_timeout_(retry_timeout),
+  retry_count_(retry_count)
+{
+  ORION_ASSERT_NOT_NULL(major);
+  ORION_ASSERT(tick > 0);
+}
+
+size_t Scheduler::addTransaction(const Transaction &transaction, uint32_t period, uint32_t phase)
+{
+  ORION_ASSERT(period > 0);
+  ORION_ASSERT(0 == period % this->tick_);
+  ORION_ASSERT(0 == phase % this->tick_);
+  ORION_ASSERT(phase < period);
+
+  uint64_t hyperperiod = getLeastCommonMultiple(this->hyperperiod_, period / this->tick_);
+  ORION_ASSERT(hyperperiod <= MAX_HYPERPERIOD);
+  this->hyperperiod_ = static_cast<uint32_t>(hyperperiod);
+
+  this->transactions_.push_back(transaction);
+  this->transactions_.back().period = period / this->tick_;
+  this->transactions_.back().phase = phase / this->tick_;
+  return (this->transactions_.size() - 1);
+}
+
+uint32_t Scheduler::selectPhase(uint32_t period, uint32_t size) const
+{
+  uint64_t hyperperiod = getLeastCommonMultiple(this->hyperperiod_, period);
+  ORION_ASSERT(hyperperiod <= MAX_HYPERPERIOD);
+
+  uint32_t result = 0;
+  uint64_t lowest_peak = UINT64_MAX;
+  for (uint32_t phase = 0; phase < period; phase++)
+  {
+    uint64_t peak = 0;
+    for (uint64_t tick = phase; tick < hyperperiod; tick += period)
+    {
+      uint64_t load = size;
+      for (const Transaction &transaction : this->transactions_)
+      {
+        if (transaction.phase == tick % transaction.period)
+        {
+          load += transaction.size;
+        }
+      }
+      if (load > peak)
+      {
+        peak = load;
+      }
+    }
+    if (peak < lowest_peak)
+    {
+      lowest_peak = peak;
+      result = phase;
+    }
+  }
+  return (result);
+}
+
+uint32_t Scheduler::getPhase(size_t index) const
+{
+  ORION_ASSERT(index < this->transactions_.size());
+  return (this->transactions_[index].phase * this->tick_);
+}
+
+uint64_t Scheduler::getNextTick(uint64_t tick) const
+{
+  uint64_t result = UINT64_MAX;
+  for (const Transaction &transaction : this->transactions_)
+  {
+    uint64_t offset = (transaction.period + transaction.phase - tick % transaction.period) % transaction.period;
+    if (tick + offset < result)
+    {
+      result = tick + offset;
+    }
+  }
+  return (result);
+}
+
+std::chrono::steady_clock::time_point Scheduler::getTickTime(uint64_t tick) const
+{
+  return (this->start_time_ + std::chrono::microseconds(tick * this->tick_));
+}
+
+size_t Scheduler::spinOnce()
+{
+  if (this->transactions_.empty())
+  {
+    return (0);
+  }
+  if (!this->started_)
+  {
+    this->start_time_ = std::chrono::steady_clock::now();
+    this->next_tick_ = 0;
+    this->started_ = true;
+  }
+
+  // Cycles whose tick is already over are dropped, the late one of the current tick still runs
+  uint64_t current_tick = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - this->start_time_).count() / this->tick_;
+  uint64_t tick = this->getNextTick(this->next_tick_);
+  while (tick < current_tick)
+  {
+    this->statistics_.overruns++;
+    tick = this->getNextTick(tick + 1);
+  }
+
+  std::chrono::steady_clock::time_point tick_time = this->getTickTime(tick);
+  std::this_thread::sleep_until(tick_time);
+  int64_t lateness = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - tick_time).count();
+  this->jitter_.record(lateness > 0 ? static_cast<uint32_t>(lateness) : 0);
+
+  this->due_.clear();
+  this->batch_.clear();
+  for (size_t index = 0; index < this->transactions_.size(); index++)
+  {
+    const Transaction &transaction = this->transactions_[index];
+    if (transaction.phase == tick % transaction.period)
+    {
+      transaction.add(&(this->batch_), transaction);
+      this->due_.push_back(index);
+    }
+  }
+  this->major_->invoke(&(this->batch_), this->retry_timeout_, this->retry_count_);
+
+  this->statistics_.cycles++;
+  for (size_t index = 0; index < this->due_.size(); index++)
+  {
+    orion_major_error_t status = this->batch_.getStatus(index);
+    this->statistics_.transactions++;
+    if (ORION_MAJOR_ERROR_NONE != status)
+    {
+      this->statistics_.failures++;
+    }
+    const Transaction &transaction = this->transactions_[this->due_[index]];
+    if (transaction.callback)
+    {
+      transaction.callback(status);
+    }
+  }
+  this->next_tick_ = tick + 1;
+  return (this->due_.size());
+}
+
+void Scheduler::restart()
+{
+  this->started_ = false;
+}
+
+SchedulerStatistics Scheduler::getStatistics() const
+{
+  return (this->statistics_);
+}
+
+}  // namespace orion
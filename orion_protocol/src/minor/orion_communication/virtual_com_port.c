@@ -23,14 +23,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "orion_protocol/orion_communication.h"
 #include "orion_protocol/orion_buffered_io.h"
 #include "orion_protocol/orion_assert.h"
 #include "orion_protocol/orion_memory.h"
+#include "orion_protocol/orion_statistics.h"
 
 struct orion_communication_struct_t
 {
     uint8_t dummy_;
+    orion_statistics_lock_t tx_lock_;
+    orion_statistics_lock_t rx_lock_;
+    orion_communication_statistics_t statistics_;
 };
 
 
@@ -43,6 +48,9 @@ orion_communication_error_t orion_communication_new(orion_communication_t ** me)
       return (ORION_COM_ERROR_COULD_NOT_ALLOCATE_MEMORY);
   }
   (*me)->dummy_ = 0;
+  orion_statistics_init(&((*me)->tx_lock_));
+  orion_statistics_init(&((*me)->rx_lock_));
+  memset(&((*me)->statistics_), 0, sizeof((*me)->statistics_));
   return (ORION_COM_ERROR_NONE);
 }
 
@@ -51,17 +59,27 @@ orion_communication_error_t orion_communication_delete(const orion_communication
     return (ORION_COM_ERROR_NONE);
 }
 
-ssize_t orion_communication_receive_available_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size)
+ssize_t orion_communication_receive_available_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT_NOT_NULL(buffer);
     ORION_ASSERT(0 < size);
 
     ssize_t result = orion_buffered_io_read(buffer, size);
+
+    orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.calls), 1);
+    if (result > 0)
+    {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.bytes), result);
+    }
+    else if (result < 0)
+    {
+        orion_statistics_add(&(me->rx_lock_), &(me->statistics_.rx.errors), 1);
+    }
     return (result);
 }
 
-ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uint8_t * buffer, uint32_t size,
+ssize_t orion_communication_receive_buffer(orion_communication_t * me, uint8_t * buffer, uint32_t size,
   uint32_t timeout)
 {
     ORION_ASSERT_NOT_NULL(me);
@@ -73,7 +91,7 @@ ssize_t orion_communication_receive_buffer(const orion_communication_t * me, uin
     return (result);
 }
 
-bool orion_communication_has_available_buffer(const orion_communication_t * me)
+bool orion_communication_has_available_buffer(orion_communication_t * me)
 {
     ORION_ASSERT_NOT_NULL(me);
     bool result = true;
@@ -84,16 +102,30 @@ bool orion_communication_has_available_buffer(const orion_communication_t * me)
     return (result);
 }
 
-orion_communication_error_t orion_communication_send_buffer(const orion_communication_t * me, uint8_t *buffer, 
+orion_communication_error_t orion_communication_send_buffer(orion_communication_t * me, uint8_t *buffer, 
   uint32_t size, uint32_t timeout)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT_NOT_NULL(buffer);
     ORION_ASSERT(0 < size);
     bool result = orion_buffered_io_write(buffer, size);
+
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.calls), 1);
     if (result)
     {
+        orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.bytes), size);
         return (ORION_COM_ERROR_NONE);
     }
+    orion_statistics_add(&(me->tx_lock_), &(me->statistics_.tx.errors), 1);
     return (ORION_COM_ERROR_UNKNOWN);
 }
+
+orion_communication_error_t orion_communication_get_statistics(const orion_communication_t * me,
+  orion_communication_statistics_t * statistics)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(statistics);
+    orion_statistics_read(&(me->tx_lock_), &(me->statistics_.tx), &(statistics->tx), sizeof(statistics->tx));
+    orion_statistics_read(&(me->rx_lock_), &(me->statistics_.rx), &(statistics->rx), sizeof(statistics->rx));
+    return (ORION_COM_ERROR_NONE);
+}
@@ -24,14 +24,90 @@
 #include "orion_protocol/orion_minor.h"
 #include "orion_protocol/orion_assert.h"
 #include "orion_protocol/orion_memory.h"
+#include "orion_protocol/orion_framer.h"
+#include "orion_protocol/orion_stream.h"
+#include "orion_protocol/orion_delta.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+
+#define ORION_MICROSECONDS_IN_SECOND (1000000)
+
+typedef struct
+{
+  uint8_t message_id;
+  uint32_t cost;  // bytes on the wire of the biggest message
+  orion_minor_telemetry_callback_t callback;
+  void * context;
+  uint32_t period;
+  uint64_t next_time;
+  uint64_t first_time;
+  uint64_t last_time;
+  uint32_t published;
+  uint32_t decimated;
+  bool delta;
+  orion_delta_encoder_t encoder;
+}
+orion_minor_telemetry_source_t;
+
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+typedef struct
+{
+  uint16_t sequence_id;  // ORION_UNSOLICITED_SEQUENCE_ID marks empty entry
+  uint8_t message_id;
+  uint16_t command_crc;  // tells retransmitted command from a new one, e.g. after Major restarted its sequence ids
+  uint32_t size;
+  uint8_t frame[ORION_FRAMER_MAX_ENCODED_SIZE(ORION_MINOR_MAX_CACHED_RESULT_SIZE)];
+}
+orion_minor_cached_result_t;
+#endif
 
 struct orion_minor_struct_t
 {
   orion_transport_t * transport_;
+  orion_minor_telemetry_source_t sources_[ORION_MINOR_MAX_TELEMETRY_SOURCES];
+  uint32_t sources_count_;
+  uint32_t budget_rate_;
+  orion_token_bucket_t budget_;
+  uint8_t telemetry_buffer_[ORION_MINOR_MAX_TELEMETRY_SIZE];
+  bool delta_;  // agreed by handshake
+  uint8_t delta_buffer_[ORION_DELTA_MAX_PACKET_SIZE(ORION_MINOR_MAX_TELEMETRY_SIZE)];
+  bool result_cache_;
+  uint16_t command_sequence_id_;  // the last command passed to application
+  uint16_t command_crc_;
+  orion_stream_receiver_t stream_;
+  uint8_t * compression_buffer_;
+  uint32_t compression_size_;
+  uint32_t max_baud_;
+  orion_minor_baud_callback_t baud_callback_;
+  void * baud_context_;
+  uint32_t baud_;
+  uint32_t previous_baud_;  // returned to unless Major commits the switch
+  bool baud_pending_;
+  uint32_t baud_timeout_;
+  uint64_t baud_deadline_;  // 0 till the first update after switch
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+  orion_minor_cached_result_t results_[ORION_MINOR_RESULT_CACHE_SIZE];
+  uint32_t next_result_;
+#endif
 };
 
+static bool orion_minor_handle_control(orion_minor_t * me, const uint8_t * buffer, size_t size);
+static bool orion_minor_resend_result(orion_minor_t * me, const uint8_t * buffer, size_t size);
+static bool orion_minor_send_cached_result(orion_minor_t * me, uint8_t * buffer, size_t size,
+  orion_transport_error_t * status);
+static void orion_minor_clear_result_cache(orion_minor_t * me);
+static void orion_minor_handle_handshake(orion_minor_t * me, const orion_control_handshake_command_t * command);
+static void orion_minor_handle_link(orion_minor_t * me, const orion_control_link_command_t * command);
+static void orion_minor_handle_baud(orion_minor_t * me, const orion_control_baud_command_t * command);
+static void orion_minor_handle_subscribe(orion_minor_t * me, const orion_control_subscribe_command_t * command);
+static void orion_minor_handle_stream(orion_minor_t * me, const uint8_t * buffer, size_t size);
+// Index of telemetry source, sources_count_ when there is none
+static uint32_t orion_minor_find_source(const orion_minor_t * me, uint8_t message_id);
+static uint32_t orion_minor_grant_period(const orion_minor_t * me, const orion_minor_telemetry_source_t * source,
+  uint32_t period);
+static uint32_t orion_minor_achieved_period(const orion_minor_telemetry_source_t * source);
+
 orion_minor_error_t orion_minor_new(orion_minor_t ** me, orion_transport_t * transport)
 {
   ORION_ASSERT_NOT_NULL(me);
@@ -42,6 +118,23 @@ orion_minor_error_t orion_minor_new(orion_minor_t ** me, orion_transport_t * tra
       return (ORION_MINOR_ERROR_COULD_NOT_ALLOCATE_MEMORY);
   }
   (*me)->transport_ = transport;
+  (*me)->sources_count_ = 0;
+  (*me)->budget_rate_ = 0;
+  orion_token_bucket_init(&((*me)->budget_), 0, 0, 0);
+  (*me)->result_cache_ = false;
+  (*me)->delta_ = false;
+  orion_stream_receiver_init(&((*me)->stream_), NULL, 0);
+  (*me)->compression_buffer_ = NULL;
+  (*me)->compression_size_ = 0;
+  (*me)->max_baud_ = 0;
+  (*me)->baud_callback_ = NULL;
+  (*me)->baud_context_ = NULL;
+  (*me)->baud_ = 0;
+  (*me)->previous_baud_ = 0;
+  (*me)->baud_pending_ = false;
+  (*me)->baud_timeout_ = 0;
+  (*me)->baud_deadline_ = 0;
+  orion_minor_clear_result_cache(*me);
   return (ORION_MINOR_ERROR_NONE);
 }
 
@@ -64,7 +157,7 @@ ssize_t orion_minor_wait_and_receive_command(const orion_minor_t * me, uint8_t *
   return (ORION_MINOR_ERROR_UNKNOWN);
 }
 
-ssize_t orion_minor_receive_command(const orion_minor_t * me, uint8_t * buffer, size_t buffer_size)
+ssize_t orion_minor_receive_command(orion_minor_t * me, uint8_t * buffer, size_t buffer_size)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT_NOT_NULL(buffer);
@@ -74,10 +167,22 @@ ssize_t orion_minor_receive_command(const orion_minor_t * me, uint8_t * buffer,
     if (orion_transport_has_received_packet(me->transport_))
     {
         ssize_t received_size = orion_transport_receive_packet(me->transport_, buffer, buffer_size, 0);
-        if (0 > received_size)
+        if (ORION_TRAN_ERROR_INCOMPLETE_MESSAGE == received_size)
+        {
+            // Fragment of a bigger command was put aside, nothing to execute yet
+            result = 0;
+        }
+        else if (0 > received_size)
         {
             result = ORION_MINOR_ERROR_RECEIVING_PACKET;
-
+        }
+        else if (orion_minor_handle_control(me, buffer, received_size))
+        {
+            result = 0;
+        }
+        else if (orion_minor_resend_result(me, buffer, received_size))
+        {
+            result = 0;
         }
         else
         {
@@ -87,13 +192,18 @@ ssize_t orion_minor_receive_command(const orion_minor_t * me, uint8_t * buffer,
     return (result);
 }
 
-orion_minor_error_t orion_minor_send_result(const orion_minor_t * me, uint8_t * buffer, const size_t size)
+orion_minor_error_t orion_minor_send_result(orion_minor_t * me, uint8_t * buffer, const size_t size)
 {
     ORION_ASSERT_NOT_NULL(me);
     ORION_ASSERT_NOT_NULL(buffer);
     ORION_ASSERT(0 < size);
 
-    orion_transport_error_t status = orion_transport_send_packet(me->transport_, buffer, size, 0);
+    orion_transport_error_t status = ORION_TRAN_ERROR_NONE;
+    // Result is encoded right into cache, so that retransmission costs only a write
+    if (!orion_minor_send_cached_result(me, buffer, size, &status))
+    {
+        status = orion_transport_send_packet(me->transport_, buffer, size, 0);
+    }
 
     if (ORION_TRAN_ERROR_NONE == status)
     {
@@ -101,3 +211,570 @@ orion_minor_error_t orion_minor_send_result(const orion_minor_t * me, uint8_t *
     }
     return (ORION_MINOR_ERROR_SENDING_PACKET);
 }
+
+orion_minor_error_t orion_minor_send_results(const orion_minor_t * me, orion_transport_packet_t * packets,
+  uint32_t count)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(packets);
+    ORION_ASSERT(0 < count);
+
+    orion_transport_error_t status = orion_transport_send_packets(me->transport_, packets, count, 0);
+
+    if (ORION_TRAN_ERROR_NONE == status)
+    {
+        return (ORION_MINOR_ERROR_NONE);
+    }
+    return (ORION_MINOR_ERROR_SENDING_PACKET);
+}
+
+orion_minor_error_t orion_minor_publish(orion_minor_t * me, uint8_t * buffer, const size_t size)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(buffer);
+    ORION_ASSERT(sizeof(orion_command_header_t) <= size);
+
+    ((orion_command_header_t*)buffer)->common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+    orion_minor_error_t result = orion_minor_send_result(me, buffer, size);
+    return (result);
+}
+
+orion_minor_error_t orion_minor_add_telemetry(orion_minor_t * me, uint8_t message_id, size_t max_size,
+  orion_minor_telemetry_callback_t callback, void * context)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(callback);
+    ORION_ASSERT(sizeof(orion_command_header_t) <= max_size);
+    ORION_ASSERT(ORION_MINOR_MAX_TELEMETRY_SIZE >= max_size);
+    ORION_ASSERT(ORION_CONTROL_MESSAGE_ID_FIRST > message_id);
+
+    if ((ORION_MINOR_MAX_TELEMETRY_SOURCES <= me->sources_count_) ||
+        (me->sources_count_ != orion_minor_find_source(me, message_id)))
+    {
+        return (ORION_MINOR_ERROR_NO_ROOM);
+    }
+    orion_minor_telemetry_source_t * source = &(me->sources_[me->sources_count_++]);
+    memset(source, 0, sizeof(*source));
+    source->message_id = message_id;
+    source->cost = ORION_FRAMER_MAX_ENCODED_SIZE(max_size);
+    source->callback = callback;
+    source->context = context;
+    return (ORION_MINOR_ERROR_NONE);
+}
+
+orion_minor_error_t orion_minor_set_telemetry_delta(orion_minor_t * me, uint8_t message_id, uint8_t * keyframe,
+  uint32_t keyframe_interval)
+{
+    ORION_ASSERT_NOT_NULL(me);
+
+    uint32_t index = orion_minor_find_source(me, message_id);
+    if (me->sources_count_ == index)
+    {
+        return (ORION_MINOR_ERROR_NOT_FOUND);
+    }
+    orion_minor_telemetry_source_t * source = &(me->sources_[index]);
+    source->delta = (NULL != keyframe);
+    if (source->delta)
+    {
+        orion_delta_encoder_init(&(source->encoder), keyframe, ORION_MINOR_MAX_TELEMETRY_SIZE, keyframe_interval);
+    }
+    return (ORION_MINOR_ERROR_NONE);
+}
+
+orion_minor_error_t orion_minor_set_telemetry_budget(orion_minor_t * me, uint32_t bytes_per_second,
+  uint64_t time_now)
+{
+    ORION_ASSERT_NOT_NULL(me);
+
+    // Bursts up to a tenth of second, but at least the biggest message
+    uint32_t capacity = bytes_per_second / 10;
+    if (capacity < ORION_FRAMER_MAX_ENCODED_SIZE(ORION_MINOR_MAX_TELEMETRY_SIZE))
+    {
+        capacity = ORION_FRAMER_MAX_ENCODED_SIZE(ORION_MINOR_MAX_TELEMETRY_SIZE);
+    }
+    me->budget_rate_ = bytes_per_second;
+    orion_token_bucket_init(&(me->budget_), bytes_per_second, capacity, time_now);
+    return (ORION_MINOR_ERROR_NONE);
+}
+
+uint32_t orion_minor_publish_telemetry(orion_minor_t * me, uint64_t time_now)
+{
+    ORION_ASSERT_NOT_NULL(me);
+
+    uint32_t result = 0;
+    for (uint32_t index = 0; index < me->sources_count_; index++)
+    {
+        orion_minor_telemetry_source_t * source = &(me->sources_[index]);
+        if ((0 == source->period) || (time_now < source->next_time))
+        {
+            continue;
+        }
+        // Missed periods are not caught up, otherwise link would be flooded after a stall
+        source->next_time += source->period;
+        if (source->next_time <= time_now)
+        {
+            source->next_time = time_now + source->period;
+        }
+
+        if (!orion_token_bucket_consume(&(me->budget_), source->cost, time_now))
+        {
+            source->decimated++;
+            continue;
+        }
+        size_t size = source->callback(source->context, me->telemetry_buffer_, sizeof(me->telemetry_buffer_));
+        if (0 == size)
+        {
+            continue;
+        }
+        ORION_ASSERT(sizeof(orion_command_header_t) <= size);
+        ORION_ASSERT(sizeof(me->telemetry_buffer_) >= size);
+        ((orion_command_header_t*)me->telemetry_buffer_)->common.message_id = source->message_id;
+        orion_minor_error_t status = ORION_MINOR_ERROR_NONE;
+        if (me->delta_ && source->delta)
+        {
+            // Sequence id is a part of keyframe, so it is set before encoding
+            ((orion_command_header_t*)me->telemetry_buffer_)->common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+            ssize_t packet_size = orion_delta_encode(&(source->encoder), me->telemetry_buffer_, size,
+                me->delta_buffer_, sizeof(me->delta_buffer_));
+            status = orion_minor_publish(me, me->delta_buffer_, packet_size);
+        }
+        else
+        {
+            status = orion_minor_publish(me, me->telemetry_buffer_, size);
+        }
+        if (ORION_MINOR_ERROR_NONE == status)
+        {
+            if (0 == source->published)
+            {
+                source->first_time = time_now;
+            }
+            source->last_time = time_now;
+            source->published++;
+            result++;
+        }
+    }
+    return (result);
+}
+
+orion_minor_error_t orion_minor_get_telemetry_statistics(const orion_minor_t * me, uint8_t message_id,
+  orion_minor_telemetry_statistics_t * statistics)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    ORION_ASSERT_NOT_NULL(statistics);
+
+    uint32_t index = orion_minor_find_source(me, message_id);
+    if (me->sources_count_ == index)
+    {
+        return (ORION_MINOR_ERROR_NOT_FOUND);
+    }
+    const orion_minor_telemetry_source_t * source = &(me->sources_[index]);
+    statistics->period = source->period;
+    statistics->achieved_period = orion_minor_achieved_period(source);
+    statistics->published = source->published;
+    statistics->decimated = source->decimated;
+    return (ORION_MINOR_ERROR_NONE);
+}
+
+void orion_minor_set_stream_buffer(orion_minor_t * me, uint8_t * buffer, uint32_t size)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    orion_stream_receiver_init(&(me->stream_), buffer, size);
+}
+
+bool orion_minor_get_stream(const orion_minor_t * me, uint32_t * size)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    return (orion_stream_receiver_is_complete(&(me->stream_), size));
+}
+
+void orion_minor_set_compression_buffer(orion_minor_t * me, uint8_t * buffer, uint32_t size)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    me->compression_buffer_ = buffer;
+    me->compression_size_ = (NULL == buffer) ? 0 : size;
+}
+
+void orion_minor_set_max_baud(orion_minor_t * me, uint32_t baud)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    me->max_baud_ = baud;
+}
+
+void orion_minor_set_baud_callback(orion_minor_t * me, orion_minor_baud_callback_t callback, void * context,
+  uint32_t baud)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    me->baud_callback_ = callback;
+    me->baud_context_ = context;
+    me->baud_ = baud;
+    me->baud_pending_ = false;
+}
+
+uint32_t orion_minor_update_baud(orion_minor_t * me, uint64_t time_now)
+{
+    ORION_ASSERT_NOT_NULL(me);
+    if (me->baud_pending_)
+    {
+        if (0 == me->baud_deadline_)
+        {
+            // Switch happened since the last update, timeout runs from now
+            me->baud_deadline_ = time_now + me->baud_timeout_;
+        }
+        else if (time_now >= me->baud_deadline_)
+        {
+            // Major never committed, the new rate does not work for it
+            me->baud_pending_ = false;
+            me->baud_ = me->previous_baud_;
+            me->baud_callback_(me->baud_context_, me->baud_);
+        }
+    }
+    return (me->baud_);
+}
+
+bool orion_minor_handle_control(orion_minor_t * me, const uint8_t * buffer, size_t size)
+{
+    if (size < sizeof(orion_command_header_t))
+    {
+        return (false);
+    }
+    const orion_command_header_t * header = (const orion_command_header_t*)buffer;
+    if (ORION_CONTROL_MESSAGE_ID_FIRST > header->common.message_id)
+    {
+        return (false);
+    }
+
+    if ((ORION_CONTROL_MESSAGE_ID_HANDSHAKE == header->common.message_id) &&
+        (sizeof(orion_control_handshake_command_t) <= size))
+    {
+        orion_minor_handle_handshake(me, (const orion_control_handshake_command_t*)buffer);
+    }
+    else if ((ORION_CONTROL_MESSAGE_ID_LINK == header->common.message_id) &&
+        (sizeof(orion_control_link_command_t) <= size))
+    {
+        orion_minor_handle_link(me, (const orion_control_link_command_t*)buffer);
+    }
+    else if ((ORION_CONTROL_MESSAGE_ID_BAUD == header->common.message_id) &&
+        (sizeof(orion_control_baud_command_t) <= size))
+    {
+        orion_minor_handle_baud(me, (const orion_control_baud_command_t*)buffer);
+    }
+    else if ((ORION_CONTROL_MESSAGE_ID_SUBSCRIBE == header->common.message_id) &&
+        (sizeof(orion_control_subscribe_command_t) <= size))
+    {
+        orion_minor_handle_subscribe(me, (const orion_control_subscribe_command_t*)buffer);
+    }
+    else if (ORION_CONTROL_MESSAGE_ID_STREAM == header->common.message_id)
+    {
+        orion_minor_handle_stream(me, buffer, size);
+    }
+    // Reserved ids never reach application, even unknown ones
+    return (true);
+}
+
+void orion_minor_handle_handshake(orion_minor_t * me, const orion_control_handshake_command_t * command)
+{
+    orion_control_handshake_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+    result.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+    result.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+    result.header.common.sequence_id = command->header.common.sequence_id;
+    result.capabilities = command->capabilities & ORION_MINOR_CAPABILITIES;
+
+    // Major starts every session from default link settings
+    orion_transport_link_t link;
+    memset(&link, 0, sizeof(link));
+    link.capabilities = result.capabilities;
+    link.frame_size = orion_transport_get_frame_size(me->transport_);
+    link.checksum = ORION_CONTROL_CHECKSUM_CRC16;
+    orion_transport_set_link(me->transport_, &link);
+    // Result itself goes as a plain frame, Major enables containers only after receiving it
+    orion_transport_set_containers(me->transport_, 0 != (result.capabilities & ORION_CONTROL_CAPABILITY_CONTAINER));
+    orion_transport_set_fragments(me->transport_, 0 != (result.capabilities & ORION_CONTROL_CAPABILITY_FRAGMENTS));
+    bool compression = 0 != (result.capabilities & ORION_CONTROL_CAPABILITY_COMPRESSION);
+    orion_transport_set_compression_buffer(me->transport_, compression ? me->compression_buffer_ : NULL,
+        compression ? me->compression_size_ : 0);
+    // Results of previous session of Major should not answer its new commands
+    orion_minor_clear_result_cache(me);
+    me->result_cache_ = 0 != (result.capabilities & ORION_CONTROL_CAPABILITY_RESULT_CACHE);
+    // New session of Major has no keyframes
+    me->delta_ = 0 != (result.capabilities & ORION_CONTROL_CAPABILITY_DELTA);
+    for (uint32_t index = 0; index < me->sources_count_; index++)
+    {
+        orion_delta_encoder_reset(&(me->sources_[index].encoder));
+    }
+    // New session of Major numbers its streams from the beginning
+    orion_stream_receiver_reset(&(me->stream_));
+    orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+}
+
+void orion_minor_handle_link(orion_minor_t * me, const orion_control_link_command_t * command)
+{
+    orion_control_link_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+    result.header.common.version = ORION_CONTROL_LINK_VERSION;
+    result.header.common.oldest_compatible_version = ORION_CONTROL_LINK_VERSION;
+    result.header.common.sequence_id = command->header.common.sequence_id;
+    if (command->frame_size < ORION_CONTROL_LINK_MIN_FRAME_SIZE)
+    {
+        result.header.error_code = ORION_CONTROL_ERROR_MALFORMED_MESSAGE;
+        orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+        return;
+    }
+
+    orion_transport_link_t link;
+    orion_transport_get_link(me->transport_, &link);
+    uint32_t frame_size = orion_transport_get_frame_size(me->transport_);
+    link.frame_size = (command->frame_size < frame_size) ? command->frame_size : frame_size;
+    link.baud = (command->baud < me->max_baud_) ? command->baud : me->max_baud_;
+    link.window = (command->window < ORION_MINOR_STREAM_WINDOW) ? command->window : ORION_MINOR_STREAM_WINDOW;
+    bool fletcher = 0 != (command->checksums & ORION_MINOR_CHECKSUMS & ORION_CONTROL_CHECKSUM_FLETCHER16);
+    link.checksum = fletcher ? ORION_CONTROL_CHECKSUM_FLETCHER16 : ORION_CONTROL_CHECKSUM_CRC16;
+    result.frame_size = link.frame_size;
+    result.baud = link.baud;
+    result.window = link.window;
+    result.checksum = link.checksum;
+    orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+    // Result goes with previous settings, Major switches to the agreed ones once it receives it
+    orion_transport_set_link(me->transport_, &link);
+}
+
+void orion_minor_handle_baud(orion_minor_t * me, const orion_control_baud_command_t * command)
+{
+    orion_control_baud_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+    result.header.common.version = ORION_CONTROL_BAUD_VERSION;
+    result.header.common.oldest_compatible_version = ORION_CONTROL_BAUD_VERSION;
+    result.header.common.sequence_id = command->header.common.sequence_id;
+    result.step = command->step;
+    result.baud = me->baud_;
+
+    if (ORION_CONTROL_BAUD_SWITCH == command->step)
+    {
+        bool supported = (NULL != me->baud_callback_) && (0 != command->baud) && (command->baud <= me->max_baud_);
+        if (!supported)
+        {
+            result.header.error_code = ORION_CONTROL_ERROR_NOT_SUPPORTED;
+            orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+            return;
+        }
+        result.baud = command->baud;
+        orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+        // Result goes at the current rate, callback waits till it leaves UART
+        if (!me->baud_callback_(me->baud_context_, command->baud))
+        {
+            return;
+        }
+        if (!me->baud_pending_)
+        {
+            me->previous_baud_ = me->baud_;
+        }
+        me->baud_ = command->baud;
+        me->baud_pending_ = true;
+        me->baud_timeout_ = command->timeout;
+        me->baud_deadline_ = 0;
+    }
+    else if (ORION_CONTROL_BAUD_PROBE == command->step)
+    {
+        memcpy(result.pattern, command->pattern, sizeof(result.pattern));
+        orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+    }
+    else if (ORION_CONTROL_BAUD_COMMIT == command->step)
+    {
+        if (command->baud == me->baud_)
+        {
+            me->baud_pending_ = false;
+        }
+        else
+        {
+            result.header.error_code = ORION_CONTROL_ERROR_NOT_SUPPORTED;
+        }
+        orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+    }
+    else
+    {
+        result.header.error_code = ORION_CONTROL_ERROR_MALFORMED_MESSAGE;
+        orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+    }
+}
+
+void orion_minor_handle_subscribe(orion_minor_t * me, const orion_control_subscribe_command_t * command)
+{
+    orion_control_subscribe_result_t result;
+    memset(&result, 0, sizeof(result));
+    result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_SUBSCRIBE;
+    result.header.common.version = ORION_CONTROL_SUBSCRIBE_VERSION;
+    result.header.common.oldest_compatible_version = ORION_CONTROL_SUBSCRIBE_VERSION;
+    result.header.common.sequence_id = command->header.common.sequence_id;
+    result.message_id = command->message_id;
+
+    orion_minor_telemetry_source_t * source = NULL;
+    uint32_t index = orion_minor_find_source(me, command->message_id);
+    if (me->sources_count_ > index)
+    {
+        source = &(me->sources_[index]);
+    }
+    if (NULL == source)
+    {
+        result.header.error_code = ORION_CONTROL_ERROR_UNKNOWN_MESSAGE;
+    }
+    else if (command->period != source->period)
+    {
+        uint32_t period = 0;
+        if (0 != command->period)
+        {
+            period = orion_minor_grant_period(me, source, command->period);
+            if (0 == period)
+            {
+                result.header.error_code = ORION_CONTROL_ERROR_NO_BANDWIDTH;
+            }
+        }
+        source->period = period;
+        source->next_time = 0;
+        orion_delta_encoder_reset(&(source->encoder));
+        source->published = 0;
+        source->decimated = 0;
+    }
+    if (NULL != source)
+    {
+        result.period = source->period;
+        result.achieved_period = orion_minor_achieved_period(source);
+    }
+    orion_minor_send_result(me, (uint8_t*)&result, sizeof(result));
+}
+
+void orion_minor_handle_stream(orion_minor_t * me, const uint8_t * buffer, size_t size)
+{
+    orion_control_stream_ack_t ack;
+    if (orion_stream_receiver_on_segment(&(me->stream_), buffer, size, &ack))
+    {
+        // Lost acknowledgment is covered by the next one, it is not worth a retry
+        orion_transport_send_packet(me->transport_, (uint8_t*)&ack, sizeof(ack), 0);
+    }
+}
+
+bool orion_minor_resend_result(orion_minor_t * me, const uint8_t * buffer, size_t size)
+{
+    if (size < sizeof(orion_command_header_t))
+    {
+        return (false);
+    }
+    const orion_command_header_t * header = (const orion_command_header_t*)buffer;
+    me->command_sequence_id_ = header->common.sequence_id;
+    me->command_crc_ = header->frame.crc;
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+    if (!me->result_cache_ || (ORION_UNSOLICITED_SEQUENCE_ID == header->common.sequence_id))
+    {
+        return (false);
+    }
+    for (uint32_t index = 0; index < ORION_MINOR_RESULT_CACHE_SIZE; index++)
+    {
+        orion_minor_cached_result_t * entry = &(me->results_[index]);
+        if ((entry->sequence_id == header->common.sequence_id) && (entry->message_id == header->common.message_id) &&
+            (entry->command_crc == header->frame.crc))
+        {
+            orion_transport_send_frame(me->transport_, entry->frame, entry->size, 0);
+            return (true);
+        }
+    }
+#endif
+    return (false);
+}
+
+bool orion_minor_send_cached_result(orion_minor_t * me, uint8_t * buffer, size_t size,
+  orion_transport_error_t * status)
+{
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+    const orion_result_header_t * header = (const orion_result_header_t*)buffer;
+    // Only result of the command just received is known to belong to it
+    if (!me->result_cache_ || (size < sizeof(orion_result_header_t)) || (ORION_MINOR_MAX_CACHED_RESULT_SIZE < size) ||
+        (ORION_UNSOLICITED_SEQUENCE_ID == header->common.sequence_id) ||
+        (me->command_sequence_id_ != header->common.sequence_id))
+    {
+        return (false);
+    }
+    orion_minor_cached_result_t * entry = &(me->results_[me->next_result_]);
+    ssize_t frame_size = orion_transport_encode_packet(me->transport_, buffer, size, entry->frame,
+        sizeof(entry->frame));
+    if (frame_size < 0)
+    {
+        entry->sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+        *status = (orion_transport_error_t)frame_size;
+        return (true);
+    }
+    entry->sequence_id = header->common.sequence_id;
+    entry->message_id = header->common.message_id;
+    entry->command_crc = me->command_crc_;
+    entry->size = frame_size;
+    me->next_result_ = (me->next_result_ + 1) % ORION_MINOR_RESULT_CACHE_SIZE;
+    *status = orion_transport_send_frame(me->transport_, entry->frame, entry->size, 0);
+    return (true);
+#else
+    return (false);
+#endif
+}
+
+void orion_minor_clear_result_cache(orion_minor_t * me)
+{
+    me->command_sequence_id_ = ORION_UNSOLICITED_SEQUENCE_ID;
+    me->command_crc_ = 0;
+#if ORION_MINOR_RESULT_CACHE_SIZE > 0
+    for (uint32_t index = 0; index < ORION_MINOR_RESULT_CACHE_SIZE; index++)
+    {
+        me->results_[index].sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+    }
+    me->next_result_ = 0;
+#endif
+}
+
+uint32_t orion_minor_find_source(const orion_minor_t * me, uint8_t message_id)
+{
+    uint32_t index = 0;
+    while ((index < me->sources_count_) && (message_id != me->sources_[index].message_id))
+    {
+        index++;
+    }
+    return (index);
+}
+
+uint32_t orion_minor_grant_period(const orion_minor_t * me, const orion_minor_telemetry_source_t * source,
+  uint32_t period)
+{
+    if (0 == me->budget_rate_)
+    {
+        return (period);
+    }
+
+    // Bandwidth left by other subscriptions limits the shortest period of this one
+    uint64_t used = 0;
+    for (uint32_t index = 0; index < me->sources_count_; index++)
+    {
+        const orion_minor_telemetry_source_t * other = &(me->sources_[index]);
+        if ((other != source) && (0 != other->period))
+        {
+            used += (uint64_t)other->cost * ORION_MICROSECONDS_IN_SECOND / other->period;
+        }
+    }
+    if (used >= me->budget_rate_)
+    {
+        return (0);
+    }
+    uint64_t available = me->budget_rate_ - used;
+    uint64_t shortest = ((uint64_t)source->cost * ORION_MICROSECONDS_IN_SECOND + available - 1) / available;
+    if (shortest > period)
+    {
+        return ((shortest > UINT32_MAX) ? UINT32_MAX : (uint32_t)shortest);
+    }
+    return (period);
+}
+
+uint32_t orion_minor_achieved_period(const orion_minor_telemetry_source_t * source)
+{
+    if (source->published < 2)
+    {
+        return (0);
+    }
+    return ((uint32_t)((source->last_time - source->first_time) / (source->published - 1)));
+}
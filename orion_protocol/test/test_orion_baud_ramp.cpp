@@ -0,0 +1,413 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "orion_protocol/orion_serial_port.hpp"
+#include "orion_protocol/orion_transport.hpp"
+#include "orion_protocol/orion_major.hpp"
+#include "orion_protocol/orion_minor.hpp"
+#include "orion_protocol/orion_timeout.hpp"
+
+#pragma pack(push, 1)
+
+struct EchoCommand
+{
+  orion::CommandHeader header;
+  uint8_t data[200];
+};
+
+struct EchoResult
+{
+  orion::ResultHeader header;
+  uint8_t data[200];
+};
+
+#pragma pack(pop)
+
+static const uint8_t ECHO_ID = 7;
+
+static uint64_t now_microseconds()
+{
+  return (std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static uint32_t get_baud(int file_descriptor)
+{
+  static const struct
+  {
+    speed_t speed;
+    uint32_t baud;
+  }
+  bauds[] = { { B115200, 115200 }, { B230400, 230400 }, { B460800, 460800 }, { B921600, 921600 } };
+
+  struct termios tty;
+  tcgetattr(file_descriptor, &tty);
+  for (const auto &entry : bauds)
+  {
+    if (cfgetospeed(&tty) == entry.speed)
+    {
+      return (entry.baud);
+    }
+  }
+  return (0);
+}
+
+/*
+  Joins two pseudo terminals like a serial cable: bytes are paced by baud rate of the sending side,
+  turn to garbage when rates of both ends differ and get damaged now and then above the rate cable carries.
+  Master side of a pseudo terminal reports settings its slave was given by serial port.
+*/
+class LinkEmulator
+{
+public:
+  LinkEmulator(uint32_t cable_baud, uint32_t errors_per_mille) :
+    cable_baud_(cable_baud),
+    errors_per_mille_(errors_per_mille)
+  {
+    this->open(&(this->major_master_), this->major_name_);
+    this->open(&(this->minor_master_), this->minor_name_);
+    this->forward_ = std::thread(&LinkEmulator::run, this, this->major_master_, this->minor_master_);
+    this->backward_ = std::thread(&LinkEmulator::run, this, this->minor_master_, this->major_master_);
+  }
+
+  ~LinkEmulator()
+  {
+    this->stop_ = true;
+    this->forward_.join();
+    this->backward_.join();
+    close(this->major_master_);
+    close(this->minor_master_);
+  }
+
+  const char* getMajorPort() const
+  {
+    return (this->major_name_);
+  }
+
+  const char* getMinorPort() const
+  {
+    return (this->minor_name_);
+  }
+
+private:
+  struct Chunk
+  {
+    uint64_t arrival_time;
+    uint32_t baud;
+    std::vector<uint8_t> bytes;
+  };
+
+  void open(int *master, char *name)
+  {
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT_LE(0, *master);
+    ASSERT_EQ(0, grantpt(*master));
+    ASSERT_EQ(0, unlockpt(*master));
+    std::strncpy(name, ptsname(*master), NAME_SIZE - 1);
+  }
+
+  void run(int source, int destination)
+  {
+    std::deque<Chunk> chunks;
+    uint64_t free_time = 0;
+    uint64_t random = source;
+    while (!this->stop_)
+    {
+      fd_set set;
+      FD_ZERO(&set);
+      FD_SET(source, &set);
+      struct timeval interval = { 0, 200 };
+      if (0 < select(source + 1, &set, NULL, NULL, &interval))
+      {
+        Chunk chunk;
+        chunk.baud = get_baud(source);
+        chunk.bytes.resize(4096);
+        ssize_t size = read(source, chunk.bytes.data(), chunk.bytes.size());
+        if ((size > 0) && (chunk.baud > 0))
+        {
+          chunk.bytes.resize(size);
+          // 10 bits on the wire per byte: start, 8 data bits and stop
+          free_time = std::max(free_time, now_microseconds()) + size * 10 * 1000000ULL / chunk.baud;
+          chunk.arrival_time = free_time;
+          chunks.push_back(chunk);
+        }
+      }
+      while (!chunks.empty() && (chunks.front().arrival_time <= now_microseconds()))
+      {
+        Chunk &chunk = chunks.front();
+        bool mismatch = chunk.baud != get_baud(destination);
+        for (uint8_t &byte : chunk.bytes)
+        {
+          // Linear congruential generator keeps the errors the same from run to run
+          random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+          bool damaged = (chunk.baud > this->cable_baud_) && ((random >> 33) % 1000 < this->errors_per_mille_);
+          if (mismatch || damaged)
+          {
+            byte ^= static_cast<uint8_t>(0x5A ^ (random >> 40));
+          }
+        }
+        ssize_t written = write(destination, chunk.bytes.data(), chunk.bytes.size());
+        (void)written;
+        chunks.pop_front();
+      }
+    }
+  }
+
+  static const size_t NAME_SIZE = 64;
+
+  uint32_t cable_baud_;
+  uint32_t errors_per_mille_;
+  int major_master_ = -1;
+  int minor_master_ = -1;
+  char major_name_[NAME_SIZE] = {};
+  char minor_name_[NAME_SIZE] = {};
+  std::atomic<bool> stop_{false};
+  std::thread forward_;
+  std::thread backward_;
+};
+
+static bool switch_minor_baud(void * context, uint32_t baud)
+{
+  // UART of firmware would wait for transmit complete, emulator picks up written bytes within a fraction of it
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return (ORION_COM_ERROR_NONE == reinterpret_cast<orion::SerialPort*>(context)->setBaud(baud));
+}
+
+// Echoes commands back till stopped, as firmware main loop would
+static void run_minor(const char *port_name, uint32_t baud, std::atomic<bool> *stop)
+{
+  orion::SerialPort serial_port;
+  ASSERT_EQ(ORION_COM_ERROR_NONE, serial_port.connect(port_name, baud));
+  orion::Transport transport(&serial_port);
+  orion::Minor minor(&transport);
+  minor.setMaxBaud(921600);
+  minor.setBaudCallback(switch_minor_baud, &serial_port, baud);
+
+  uint8_t buffer[ORION_TRANSPORT_DEFAULT_FRAME_SIZE];
+  while (!(*stop))
+  {
+    ssize_t size = minor.receiveCommand(buffer, sizeof(buffer));
+    if (size >= static_cast<ssize_t>(sizeof(EchoCommand)))
+    {
+      EchoCommand *command = reinterpret_cast<EchoCommand*>(buffer);
+      EchoResult result;
+      std::memset(&result, 0, sizeof(result));
+      result.header.common = command->header.common;
+      std::memcpy(result.data, command->data, sizeof(result.data));
+      minor.sendResult(reinterpret_cast<uint8_t*>(&result), sizeof(result));
+    }
+    else if (0 == size)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    minor.updateBaud(now_microseconds());
+  }
+  serial_port.disconnect();
+}
+
+static EchoCommand make_echo_command()
+{
+  EchoCommand command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ECHO_ID;
+  command.header.common.version = 1;
+  command.header.common.oldest_compatible_version = 1;
+  return (command);
+}
+
+static EchoResult make_echo_result()
+{
+  EchoResult result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = ECHO_ID;
+  result.header.common.version = 1;
+  return (result);
+}
+
+static uint64_t thread_cpu_microseconds()
+{
+  struct timespec time_now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time_now);
+  return (static_cast<uint64_t>(time_now.tv_sec) * 1000000 + time_now.tv_nsec / 1000);
+}
+
+/*
+  Waits for result the way Major did before it blocked on communication: polls transport till a frame is there
+*/
+static bool poll_invoke(orion::Transport *transport, EchoCommand *command, EchoResult *result, uint32_t timeout)
+{
+  if (ORION_TRAN_ERROR_NONE != transport->sendPacket(reinterpret_cast<uint8_t*>(command), sizeof(*command), timeout))
+  {
+    return (false);
+  }
+  orion::Timeout duration(timeout);
+  while (duration.hasTime())
+  {
+    if (transport->hasReceivedPacket())
+    {
+      ssize_t size = transport->receivePacket(reinterpret_cast<uint8_t*>(result), sizeof(*result), 0);
+      if ((size == static_cast<ssize_t>(sizeof(*result))) &&
+        (result->header.common.sequence_id == command->header.common.sequence_id))
+      {
+        return (true);
+      }
+    }
+  }
+  return (false);
+}
+
+static double measure_throughput(orion::Major *major, uint32_t count)
+{
+  EchoCommand command = make_echo_command();
+  EchoResult result = make_echo_result();
+
+  uint32_t succeeded = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t index = 0; index < count; index++)
+  {
+    command.data[index % sizeof(command.data)] = static_cast<uint8_t>(index);
+    if ((ORION_MAJOR_ERROR_NONE == major->invoke(command, &result)) &&
+      (0 == std::memcmp(command.data, result.data, sizeof(command.data))))
+    {
+      succeeded++;
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  // Payload carried both ways
+  return (2.0 * succeeded * sizeof(command.data) / seconds);
+}
+
+TEST(TestSuite, rampUpBenchmark)
+{
+  // Cable carries 460800 cleanly and damages 1% of bytes above it, so 921600 agreed by peers does not hold
+  LinkEmulator link(460800, 10);
+  std::atomic<bool> stop(false);
+  std::thread minor(run_minor, link.getMinorPort(), 115200, &stop);
+
+  orion::SerialPort serial_port;
+  ASSERT_EQ(ORION_COM_ERROR_NONE, serial_port.connect(link.getMajorPort(), 115200));
+  orion::Transport transport(&serial_port);
+  orion::Major major(&transport, 100 * orion::Major::Interval::Millisecond, 3);
+  major.setLinkLimits(921600, ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16);
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, major.handshake(ORION_CONTROL_CAPABILITY_LINK));
+  ASSERT_EQ(921600, major.getLink().baud);
+
+  double slow_throughput = measure_throughput(&major, 40);
+
+  uint32_t baud = 115200;
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, major.rampBaud([&](uint32_t new_baud)
+    {
+      return (ORION_COM_ERROR_NONE == serial_port.setBaud(new_baud));
+    }, &baud));
+  double switchover = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(460800, baud);
+
+  double fast_throughput = measure_throughput(&major, 160);
+  std::printf("115200 baud: %.0f B/s, %u baud: %.0f B/s (%.1fx), switchover %.0f ms\n", slow_throughput, baud,
+    fast_throughput, fast_throughput / slow_throughput, switchover);
+  // Round trip latency of emulator and ports keeps gain below ratio of rates
+  EXPECT_GT(fast_throughput, 3 * slow_throughput);
+
+  stop = true;
+  minor.join();
+  serial_port.disconnect();
+}
+
+TEST(TestSuite, waitBenchmark)
+{
+  // Clean 921600 baud link, 200 byte echo takes about 2.2 ms each way
+  LinkEmulator link(921600, 0);
+  std::atomic<bool> stop(false);
+  std::thread minor(run_minor, link.getMinorPort(), 921600, &stop);
+
+  orion::SerialPort serial_port;
+  ASSERT_EQ(ORION_COM_ERROR_NONE, serial_port.connect(link.getMajorPort(), 921600));
+  orion::Transport transport(&serial_port);
+  orion::Major major(&transport, 100 * orion::Major::Interval::Millisecond, 1);
+
+  const uint32_t count = 200;
+  EchoCommand command = make_echo_command();
+  EchoResult result = make_echo_result();
+  uint32_t blocking_succeeded = 0;
+  uint64_t start_cpu = thread_cpu_microseconds();
+  uint64_t start_time = now_microseconds();
+  for (uint32_t index = 0; index < count; index++)
+  {
+    if (ORION_MAJOR_ERROR_NONE == major.invoke(command, &result))
+    {
+      blocking_succeeded++;
+    }
+  }
+  double blocking_latency = static_cast<double>(now_microseconds() - start_time) / count;
+  double blocking_cpu = static_cast<double>(thread_cpu_microseconds() - start_cpu) / count;
+
+  uint32_t polling_succeeded = 0;
+  start_cpu = thread_cpu_microseconds();
+  start_time = now_microseconds();
+  for (uint32_t index = 0; index < count; index++)
+  {
+    command.header.common.sequence_id = static_cast<uint16_t>(index + 1);
+    if (poll_invoke(&transport, &command, &result, 100 * orion::Major::Interval::Millisecond))
+    {
+      polling_succeeded++;
+    }
+  }
+  double polling_latency = static_cast<double>(now_microseconds() - start_time) / count;
+  double polling_cpu = static_cast<double>(thread_cpu_microseconds() - start_cpu) / count;
+
+  std::printf("Blocking wait: %.0f us per invoke, %.0f us CPU (%.0f%%)\n", blocking_latency, blocking_cpu,
+    100.0 * blocking_cpu / blocking_latency);
+  std::printf("Polling wait: %.0f us per invoke, %.0f us CPU (%.0f%%)\n", polling_latency, polling_cpu,
+    100.0 * polling_cpu / polling_latency);
+  EXPECT_EQ(count, blocking_succeeded);
+  EXPECT_EQ(count, polling_succeeded);
+  // Woken up by select() as soon as bytes arrive, blocking wait is hardly slower and leaves the core to others
+  EXPECT_LT(blocking_latency, 1.2 * polling_latency);
+  EXPECT_LT(blocking_cpu, 0.2 * polling_cpu);
+
+  stop = true;
+  minor.join();
+  serial_port.disconnect();
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,6 +26,7 @@
 #include "gmock-global/gmock-global.h"
 #include "orion_protocol/orion_circular_buffer.h"
 #include <stdexcept>
+#include <string.h>
 
 using ::testing::NotNull;
 using ::testing::Gt;
@@ -158,6 +159,77 @@ TEST(TestSuite, wordsParsing)
   ASSERT_TRUE(orion_circular_buffer_is_empty(&circular_buff_struct));
 }
 
+TEST(TestSuite, sizesAndDropping)
+{
+  uint8_t delimiter = static_cast<uint8_t>('z');
+  uint8_t buffer[] = "garbagezPacket1zzHelloz";
+  const uint32_t circular_buffer_length = sizeof(buffer) - 1;
+  uint8_t circular_buffer[circular_buffer_length] = { 0 };
+  uint8_t output_buffer[circular_buffer_length] = { 0 };
+  orion_circular_buffer_t circular_buff_struct;
+  uint32_t actual_size = 0;
+
+  ON_GLOBAL_CALL(__assert_fail, __assert_fail(NotNull(), NotNull(), Gt(0), NotNull())).WillByDefault(Throw(
+    std::exception()));
+  orion_circular_buffer_init(&circular_buff_struct, circular_buffer, circular_buffer_length);
+  ASSERT_EQ(0, orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_EQ(circular_buffer_length, orion_circular_buffer_get_free_size(&circular_buff_struct));
+  ASSERT_EQ(0, orion_circular_buffer_get_word_size(&circular_buff_struct, delimiter));
+
+  orion_circular_buffer_add(&circular_buff_struct, buffer, circular_buffer_length);
+  ASSERT_EQ(circular_buffer_length, orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_EQ(0, orion_circular_buffer_get_free_size(&circular_buff_struct));
+  ASSERT_EQ(strlen("zPacket1z"), orion_circular_buffer_get_word_size(&circular_buff_struct, delimiter));
+
+  ASSERT_TRUE(orion_circular_buffer_drop_word(&circular_buff_struct, delimiter));
+  ASSERT_EQ(strlen("zHelloz"), orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_EQ(strlen("zHelloz"), orion_circular_buffer_get_word_size(&circular_buff_struct, delimiter));
+
+  orion_circular_buffer_add(&circular_buff_struct, buffer, 7);
+  ASSERT_EQ(strlen("zHellozgarbage"), orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_TRUE(orion_circular_buffer_dequeue_word(&circular_buff_struct, delimiter, output_buffer,
+    circular_buffer_length, &actual_size));
+  ASSERT_EQ(strlen("zHelloz"), actual_size);
+  ASSERT_FALSE(orion_circular_buffer_drop_word(&circular_buff_struct, delimiter));
+  ASSERT_EQ(strlen("garbage"), orion_circular_buffer_get_size(&circular_buff_struct));
+}
+
+TEST(TestSuite, peekAndRelease)
+{
+  uint8_t delimiter = static_cast<uint8_t>('z');
+  uint8_t buffer[] = "gzPacket1zzHelloz";
+  const uint32_t circular_buffer_length = sizeof(buffer) - 1;
+  uint8_t circular_buffer[circular_buffer_length] = { 0 };
+  uint8_t output_buffer[circular_buffer_length] = { 0 };
+  orion_circular_buffer_t circular_buff_struct;
+  uint32_t actual_size = 0;
+
+  ON_GLOBAL_CALL(__assert_fail, __assert_fail(NotNull(), NotNull(), Gt(0), NotNull())).WillByDefault(Throw(
+    std::exception()));
+  orion_circular_buffer_init(&circular_buff_struct, circular_buffer, circular_buffer_length);
+  ASSERT_FALSE(orion_circular_buffer_peek_word(&circular_buff_struct, delimiter, output_buffer,
+    circular_buffer_length, &actual_size));
+  ASSERT_FALSE(orion_circular_buffer_release_word(&circular_buff_struct, delimiter));
+
+  // Wrap word around the end of buffer
+  orion_circular_buffer_add(&circular_buff_struct, buffer, 10);
+  ASSERT_EQ(10, orion_circular_buffer_dequeue(&circular_buff_struct, output_buffer, 10));
+  orion_circular_buffer_add(&circular_buff_struct, buffer, circular_buffer_length);
+
+  ASSERT_TRUE(orion_circular_buffer_peek_word(&circular_buff_struct, delimiter, output_buffer,
+    circular_buffer_length, &actual_size));
+  ASSERT_EQ(strlen("zPacket1z"), actual_size);
+  ASSERT_EQ(0, memcmp("zPacket1z", output_buffer, actual_size));
+  ASSERT_EQ(circular_buffer_length, orion_circular_buffer_get_size(&circular_buff_struct));
+
+  ASSERT_TRUE(orion_circular_buffer_release_word(&circular_buff_struct, delimiter));
+  ASSERT_EQ(strlen("zzHelloz"), orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_TRUE(orion_circular_buffer_release_word(&circular_buff_struct, delimiter));
+  ASSERT_EQ(strlen("z"), orion_circular_buffer_get_size(&circular_buff_struct));
+  ASSERT_FALSE(orion_circular_buffer_peek_word(&circular_buff_struct, delimiter, output_buffer,
+    circular_buffer_length, &actual_size));
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <string>
+#include <vector>
 #include "orion_protocol/orion_framer.h"
 
 TEST(TestSuite, positiveTestCase)
@@ -70,6 +71,88 @@ TEST(TestSuite, positiveTestCase)
   ASSERT_EQ(0, data_size);
 }
 
+TEST(TestSuite, jumboFrame)
+{
+  const size_t DATA_SIZE = 60000;
+  std::vector<uint8_t> data(DATA_SIZE);
+  for (size_t i = 0; i < DATA_SIZE; i++)
+  {
+    data[i] = static_cast<uint8_t>(i % 300);
+  }
+  std::vector<uint8_t> packet(ORION_FRAMER_MAX_ENCODED_SIZE(DATA_SIZE));
+  std::vector<uint8_t> result(DATA_SIZE);
+
+  ssize_t packet_size = orion_framer_encode_packet(data.data(), DATA_SIZE, packet.data(), packet.size());
+  ASSERT_GT(packet_size, 0);
+  ASSERT_LE(packet_size, packet.size());
+
+  ssize_t data_size = orion_framer_decode_packet(packet.data(), packet_size, result.data(), result.size());
+  ASSERT_EQ(DATA_SIZE, data_size);
+  ASSERT_EQ(data, result);
+}
+
+TEST(TestSuite, fullBlockAtTheEnd)
+{
+  const size_t DATA_SIZE = 254;
+  uint8_t data[DATA_SIZE];
+  memset(data, 0x55, DATA_SIZE);
+  uint8_t packet[ORION_FRAMER_MAX_ENCODED_SIZE(DATA_SIZE)];
+  uint8_t result[DATA_SIZE];
+
+  ssize_t packet_size = orion_framer_encode_packet(data, DATA_SIZE, packet, sizeof(packet));
+  ASSERT_GT(packet_size, 0);
+
+  ssize_t data_size = orion_framer_decode_packet(packet, packet_size, result, sizeof(result));
+  ASSERT_EQ(DATA_SIZE, data_size);
+  ASSERT_EQ(0, memcmp(data, result, DATA_SIZE));
+}
+
+TEST(TestSuite, buffersBoundaries)
+{
+  const char test[] = "Hello\0Test";
+  const size_t DATA_SIZE = sizeof(test);
+  uint8_t packet[ORION_FRAMER_MAX_ENCODED_SIZE(DATA_SIZE)];
+  uint8_t result[DATA_SIZE];
+
+  ASSERT_EQ(ORION_FRM_ERROR_BUFFER_TOO_SMALL, orion_framer_encode_packet(reinterpret_cast<const uint8_t*>(test),
+    DATA_SIZE, packet, sizeof(packet) - 1));
+
+  ssize_t packet_size = orion_framer_encode_packet(reinterpret_cast<const uint8_t*>(test), DATA_SIZE, packet,
+    sizeof(packet));
+  ASSERT_GT(packet_size, 0);
+
+  ASSERT_EQ(ORION_FRM_ERROR_BUFFER_TOO_SMALL, orion_framer_decode_packet(packet, packet_size, result,
+    DATA_SIZE - 1));
+  ASSERT_EQ(ORION_FRM_ERROR_DECODING_FAILED, orion_framer_decode_packet(packet, 2, result, DATA_SIZE));
+  ASSERT_EQ(DATA_SIZE, orion_framer_decode_packet(packet, packet_size, result, DATA_SIZE));
+  ASSERT_EQ(0, memcmp(test, result, DATA_SIZE));
+}
+
+TEST(TestSuite, corruptedFrames)
+{
+  const char test[] = "Damaged";
+  const size_t BUFFER_SIZE = 20;
+  uint8_t packet[BUFFER_SIZE];
+  uint8_t result[BUFFER_SIZE];
+
+  ssize_t packet_size = orion_framer_encode_packet(reinterpret_cast<const uint8_t*>(test), sizeof(test), packet,
+    BUFFER_SIZE);
+  ASSERT_GT(packet_size, 4);
+
+  // Missing closing delimiter
+  ASSERT_EQ(ORION_FRM_ERROR_DECODING_FAILED, orion_framer_decode_packet(packet, packet_size - 1, result,
+    BUFFER_SIZE));
+
+  // Bytes after closing delimiter
+  packet[packet_size] = 'x';
+  ASSERT_EQ(ORION_FRM_ERROR_DECODING_FAILED, orion_framer_decode_packet(packet, packet_size + 1, result,
+    BUFFER_SIZE));
+
+  // Delimiter inside of block
+  packet[3] = ORION_FRAMER_FRAME_DELIMETER;
+  ASSERT_EQ(ORION_FRM_ERROR_DECODING_FAILED, orion_framer_decode_packet(packet, packet_size, result, BUFFER_SIZE));
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
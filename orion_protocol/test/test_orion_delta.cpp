@@ -0,0 +1,230 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "orion_protocol/orion_header.h"
+#include "orion_protocol/orion_delta.h"
+
+#pragma pack(push, 1)
+
+// Typical periodic state of a robot: most fields stay the same or change in low bytes only
+typedef struct
+{
+  orion_command_header_t header;
+  uint32_t timestamp;
+  int32_t encoder_ticks[4];
+  int16_t wheel_speed[4];
+  float position[3];
+  float orientation[4];
+  uint16_t battery_voltage;
+  uint8_t motor_state[4];
+  uint8_t errors[8];
+}
+state_message_t;
+
+#pragma pack(pop)
+
+static state_message_t make_state(uint32_t sample)
+{
+  state_message_t result;
+  std::memset(&result, 0, sizeof(result));
+  result.header.common.message_id = 7;
+  result.header.common.version = 1;
+  result.header.common.oldest_compatible_version = 1;
+  result.header.common.sequence_id = ORION_UNSOLICITED_SEQUENCE_ID;
+  result.timestamp = 1000000 + sample * 20000;
+  for (int index = 0; index < 4; index++)
+  {
+    result.encoder_ticks[index] = 50000 + sample * (3 + index);
+    result.wheel_speed[index] = 300;
+    result.motor_state[index] = 1;
+  }
+  result.position[0] = 1.5f;
+  result.position[1] = -2.25f;
+  result.orientation[3] = 1.0f;
+  result.battery_voltage = static_cast<uint16_t>(12400 - sample / 50);
+  return (result);
+}
+
+static std::vector<uint8_t> encode(orion_delta_encoder_t *encoder, const state_message_t &message)
+{
+  std::vector<uint8_t> packet(ORION_DELTA_MAX_PACKET_SIZE(sizeof(message)));
+  ssize_t size = orion_delta_encode(encoder, reinterpret_cast<const uint8_t*>(&message), sizeof(message),
+    packet.data(), packet.size());
+  EXPECT_GT(size, 0);
+  packet.resize(size);
+  return (packet);
+}
+
+static bool is_keyframe(const std::vector<uint8_t> &packet)
+{
+  return (0 != (reinterpret_cast<const orion_control_delta_t*>(packet.data())->flags &
+    ORION_CONTROL_DELTA_FLAG_KEYFRAME));
+}
+
+TEST(TestSuite, reconstructsMessages)
+{
+  uint8_t encoder_keyframe[sizeof(state_message_t)];
+  uint8_t decoder_keyframe[sizeof(state_message_t)];
+  orion_delta_encoder_t encoder;
+  orion_delta_decoder_t decoder;
+  orion_delta_encoder_init(&encoder, encoder_keyframe, sizeof(encoder_keyframe), 5);
+  orion_delta_decoder_init(&decoder, decoder_keyframe, sizeof(decoder_keyframe));
+
+  for (uint32_t sample = 0; sample < 12; sample++)
+  {
+    state_message_t message = make_state(sample);
+    std::vector<uint8_t> packet = encode(&encoder, message);
+    const orion_control_delta_t *header = reinterpret_cast<const orion_control_delta_t*>(packet.data());
+    EXPECT_EQ(ORION_CONTROL_MESSAGE_ID_DELTA, header->header.common.message_id);
+    EXPECT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, header->header.common.sequence_id);
+    EXPECT_EQ(7, header->message_id);
+    EXPECT_EQ(0 == sample % 5, is_keyframe(packet));
+
+    state_message_t decoded;
+    ASSERT_EQ(sizeof(decoded), orion_delta_decode(&decoder, packet.data(), packet.size(),
+      reinterpret_cast<uint8_t*>(&decoded), sizeof(decoded)));
+    EXPECT_EQ(0, decoded.header.frame.crc);
+    EXPECT_EQ(0, std::memcmp(reinterpret_cast<const uint8_t*>(&message) + sizeof(orion_frame_header_t),
+      reinterpret_cast<const uint8_t*>(&decoded) + sizeof(orion_frame_header_t),
+      sizeof(message) - sizeof(orion_frame_header_t)));
+  }
+}
+
+TEST(TestSuite, keyframeFallbacks)
+{
+  uint8_t keyframe[sizeof(state_message_t)];
+  orion_delta_encoder_t encoder;
+  orion_delta_encoder_init(&encoder, keyframe, sizeof(keyframe), 100);
+
+  state_message_t message = make_state(0);
+  ASSERT_TRUE(is_keyframe(encode(&encoder, message)));
+  // Unchanged message is a bare header
+  ASSERT_EQ(sizeof(orion_control_delta_t), encode(&encoder, message).size());
+
+  // Delta which is not smaller than message goes as keyframe
+  state_message_t scrambled = message;
+  uint8_t *bytes = reinterpret_cast<uint8_t*>(&scrambled);
+  for (size_t index = sizeof(orion_command_header_t); index < sizeof(scrambled); index++)
+  {
+    bytes[index] ^= static_cast<uint8_t>(index | 0x80);
+  }
+  ASSERT_TRUE(is_keyframe(encode(&encoder, scrambled)));
+  ASSERT_FALSE(is_keyframe(encode(&encoder, scrambled)));
+
+  // Message of other size and receiver which starts over
+  std::vector<uint8_t> packet(ORION_DELTA_MAX_PACKET_SIZE(sizeof(message)));
+  ASSERT_GT(orion_delta_encode(&encoder, reinterpret_cast<const uint8_t*>(&message), sizeof(message) - 4,
+    packet.data(), packet.size()), 0);
+  ASSERT_TRUE(is_keyframe(packet));
+  orion_delta_encoder_reset(&encoder);
+  ASSERT_TRUE(is_keyframe(encode(&encoder, message)));
+}
+
+TEST(TestSuite, lostKeyframe)
+{
+  uint8_t encoder_keyframe[sizeof(state_message_t)];
+  uint8_t decoder_keyframe[sizeof(state_message_t)];
+  orion_delta_encoder_t encoder;
+  orion_delta_decoder_t decoder;
+  orion_delta_encoder_init(&encoder, encoder_keyframe, sizeof(encoder_keyframe), 3);
+  orion_delta_decoder_init(&decoder, decoder_keyframe, sizeof(decoder_keyframe));
+
+  state_message_t decoded;
+  uint8_t *output = reinterpret_cast<uint8_t*>(&decoded);
+  std::vector<uint8_t> packet = encode(&encoder, make_state(0));
+  packet = encode(&encoder, make_state(1));
+  // Delta before any keyframe is refused, lost deltas of samples 2 and 4 cost only themselves
+  ASSERT_EQ(ORION_DELTA_ERROR_NO_KEYFRAME, orion_delta_decode(&decoder, packet.data(), packet.size(), output,
+    sizeof(decoded)));
+  packet = encode(&encoder, make_state(2));
+  packet = encode(&encoder, make_state(3));
+  ASSERT_TRUE(is_keyframe(packet));
+  ASSERT_EQ(sizeof(decoded), orion_delta_decode(&decoder, packet.data(), packet.size(), output, sizeof(decoded)));
+  encode(&encoder, make_state(4));
+  packet = encode(&encoder, make_state(5));
+  ASSERT_EQ(sizeof(decoded), orion_delta_decode(&decoder, packet.data(), packet.size(), output, sizeof(decoded)));
+  ASSERT_EQ(make_state(5).encoder_ticks[2], decoded.encoder_ticks[2]);
+
+  // Keyframe is lost, its deltas are refused rather than applied to the previous one
+  encode(&encoder, make_state(6));
+  packet = encode(&encoder, make_state(7));
+  ASSERT_EQ(ORION_DELTA_ERROR_NO_KEYFRAME, orion_delta_decode(&decoder, packet.data(), packet.size(), output,
+    sizeof(decoded)));
+
+  packet = encode(&encoder, make_state(8));
+  packet = encode(&encoder, make_state(9));
+  ASSERT_TRUE(is_keyframe(packet));
+  ASSERT_EQ(sizeof(decoded), orion_delta_decode(&decoder, packet.data(), packet.size(), output, sizeof(decoded)));
+
+  // Runs which go past the message or are cut short
+  std::vector<uint8_t> malformed = encode(&encoder, make_state(10));
+  for (uint32_t run = 0; run < 3; run++)
+  {
+    malformed.push_back(0xF7);
+    malformed.insert(malformed.end(), 8, 1);
+  }
+  ASSERT_EQ(ORION_DELTA_ERROR_DECODING_FAILED, orion_delta_decode(&decoder, malformed.data(), malformed.size(),
+    output, sizeof(decoded)));
+  malformed.resize(malformed.size() - 25);
+  ASSERT_EQ(ORION_DELTA_ERROR_DECODING_FAILED, orion_delta_decode(&decoder, malformed.data(), malformed.size(),
+    output, sizeof(decoded)));
+  ASSERT_EQ(ORION_DELTA_ERROR_BUFFER_TOO_SMALL, orion_delta_decode(&decoder, packet.data(), packet.size(), output,
+    sizeof(decoded) - 1));
+}
+
+TEST(TestSuite, bytesOnWireBenchmark)
+{
+  const uint32_t SAMPLES = 1000;
+  uint8_t keyframe[sizeof(state_message_t)];
+  orion_delta_encoder_t encoder;
+
+  for (uint32_t keyframe_interval : {10, 50})
+  {
+    orion_delta_encoder_init(&encoder, keyframe, sizeof(keyframe), keyframe_interval);
+    uint32_t full_bytes = 0;
+    uint32_t delta_bytes = 0;
+    for (uint32_t sample = 0; sample < SAMPLES; sample++)
+    {
+      full_bytes += sizeof(state_message_t);
+      delta_bytes += encode(&encoder, make_state(sample)).size();
+    }
+    double ratio = static_cast<double>(full_bytes) / delta_bytes;
+    std::printf("Keyframe every %u: %u bytes of whole messages, %u bytes of deltas, %.1fx less\n",
+      keyframe_interval, full_bytes, delta_bytes, ratio);
+    EXPECT_GT(ratio, 2.5);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -25,10 +25,13 @@
 #include <gmock/gmock.h>
 #include "gmock-global/gmock-global.h"
 #include <string.h>
+#include <cstddef>
+#include <vector>
 #include "orion_protocol/orion_communication.hpp"
 #include "orion_protocol/orion_framer.h"
 #include "orion_protocol/orion_crc.h"
 #include "orion_protocol/orion_header.hpp"
+#include "orion_protocol/orion_control.h"
 #include "orion_protocol/orion_transport.hpp"
 #include "orion_protocol/orion_major.hpp"
 
@@ -46,11 +49,11 @@ using ::testing::DoAll;
 
 MOCK_GLOBAL_FUNC1(orion_communication_new, orion_communication_error_t(orion_communication_t ** me));
 MOCK_GLOBAL_FUNC1(orion_communication_delete, orion_communication_error_t(const orion_communication_t * me));
-MOCK_GLOBAL_FUNC4(orion_communication_send_buffer, orion_communication_error_t(const orion_communication_t * me,
+MOCK_GLOBAL_FUNC4(orion_communication_send_buffer, orion_communication_error_t(orion_communication_t * me,
   uint8_t *buffer, uint32_t size, uint32_t timeout));
 // NOLINTNEXTLINE(readability/casting)
-MOCK_GLOBAL_FUNC1(orion_communication_has_available_buffer, bool(const orion_communication_t * me));
-MOCK_GLOBAL_FUNC4(orion_communication_receive_buffer, ssize_t(const orion_communication_t * me, uint8_t * buffer,
+MOCK_GLOBAL_FUNC1(orion_communication_has_available_buffer, bool(orion_communication_t * me));
+MOCK_GLOBAL_FUNC4(orion_communication_receive_buffer, ssize_t(orion_communication_t * me, uint8_t * buffer,
   uint32_t size, uint32_t timeout));
 
 class MockCommunication: public orion::Communication
@@ -147,6 +150,806 @@ TEST(TestSuite, receivePacket)
   ASSERT_STREQ(reinterpret_cast<char*>(packet), decoded_packet);
 }
 
+TEST(TestSuite, sendPacketTooBig)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 16;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  ASSERT_EQ(FRAME_SIZE, frame_transport.getFrameSize());
+
+  uint8_t packet[FRAME_SIZE + 1] = { 0 };
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 200;
+
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, _, _)).Times(0);
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(_, _, _, _)).Times(0);
+
+  ASSERT_EQ(ORION_TRAN_ERROR_PACKET_TOO_BIG, frame_transport.sendPacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(1, frame_transport.getStatistics().tx.too_big_errors);
+  ASSERT_EQ(0, frame_transport.getStatistics().tx.frames);
+}
+
+// Converts test string to raw bytes replacing '|' with frame delimiter
+std::vector<uint8_t> makeChunk(const char * text)
+{
+  std::vector<uint8_t> result(text, text + strlen(text));
+  for (size_t i = 0; i < result.size(); i++)
+  {
+    if ('|' == result[i])
+    {
+      result[i] = ORION_FRAMER_FRAME_DELIMETER;
+    }
+  }
+  return result;
+}
+
+TEST(TestSuite, sendPackets)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  // Send buffer keeps two encoded frames of the test, third one goes with the next write
+  const uint32_t FRAME_SIZE = 16;
+  const size_t ENCODED_SIZE = 8;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+
+  uint8_t packets_data[3][10] = { { 0 } };
+  orion_transport_packet_t packets[3];
+  for (size_t index = 0; index < 3; index++)
+  {
+    packets[index].buffer = packets_data[index];
+    packets[index].size = sizeof(packets_data[index]);
+  }
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 200;
+
+  auto mock_encode_packet = [](const uint8_t*, size_t, uint8_t* packet, size_t buffer_length)
+    {
+      if (buffer_length < ENCODED_SIZE)
+      {
+        return static_cast<ssize_t>(ORION_FRM_ERROR_BUFFER_TOO_SMALL);
+      }
+      std::vector<uint8_t> chunk = makeChunk("|frames|");
+      std::copy(chunk.begin(), chunk.end(), packet);
+      return static_cast<ssize_t>(chunk.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, Eq(10), NotNull(), _)).
+    WillRepeatedly(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(),
+    Eq(2 * ENCODED_SIZE), Le(retry_timeout))).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(),
+    Eq(ENCODED_SIZE), Le(retry_timeout))).WillOnce(Return(ORION_COM_ERROR_NONE));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPackets(packets, 3, retry_timeout));
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(3, statistics.tx.frames);
+  ASSERT_EQ(3 * ENCODED_SIZE, statistics.tx.bytes);
+  ASSERT_EQ(0, statistics.tx.encode_errors);
+}
+
+struct OverflowPacket
+{
+  OverflowPacket()
+  {
+    strncpy(data, "  Decoded", sizeof(data));
+    orion::FrameHeader *header = reinterpret_cast<orion::FrameHeader*>(data);
+    header->crc = orion_crc_calculate_crc16(reinterpret_cast<uint8_t*>(data + sizeof(orion::FrameHeader)),
+      sizeof(data) - sizeof(orion::FrameHeader));
+  }
+
+  char data[10];
+};
+
+const uint32_t OVERFLOW_FRAME_SIZE = 16;
+const uint32_t OVERFLOW_QUEUE_SIZE = 24;
+
+TEST(TestSuite, sendEncodedFrame)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 16;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+
+  uint8_t packet[10] = { 0 };
+  uint8_t frame[ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(packet))] = { 0 };
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 200;
+
+  auto mock_encode_packet = [](const uint8_t*, size_t, uint8_t* packet, size_t)
+    {
+      std::vector<uint8_t> chunk = makeChunk("|frames|");
+      std::copy(chunk.begin(), chunk.end(), packet);
+      return static_cast<ssize_t>(chunk.size());
+    };
+  // Packet is encoded once and its frame is sent twice as is
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, Eq(sizeof(packet)), Eq(frame),
+    Eq(sizeof(frame)))).WillOnce(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), Eq(frame),
+    Eq(8), Eq(retry_timeout))).Times(2).WillRepeatedly(Return(ORION_COM_ERROR_NONE));
+
+  ssize_t frame_size = frame_transport.encodePacket(packet, sizeof(packet), frame, sizeof(frame));
+  ASSERT_EQ(8, frame_size);
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendFrame(frame, frame_size, retry_timeout));
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendFrame(frame, frame_size, retry_timeout));
+
+  uint8_t big_packet[FRAME_SIZE + 1] = { 0 };
+  ASSERT_EQ(ORION_TRAN_ERROR_PACKET_TOO_BIG, frame_transport.encodePacket(big_packet, sizeof(big_packet), frame,
+    sizeof(frame)));
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(2, statistics.tx.frames);
+  ASSERT_EQ(16, statistics.tx.bytes);
+  ASSERT_EQ(1, statistics.tx.too_big_errors);
+}
+
+TEST(TestSuite, overflowDropOldest)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  orion::Transport frame_transport(&mock_communication, OVERFLOW_FRAME_SIZE, OVERFLOW_QUEUE_SIZE);
+  frame_transport.setOverflowPolicy(ORION_TRAN_OVERFLOW_POLICY_DROP_OLDEST);
+
+  OverflowPacket decoded;
+  uint8_t packet[OVERFLOW_FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  std::vector<uint8_t> partial = makeChunk("|aaaaaaaaaaaa");
+  std::vector<uint8_t> complete = makeChunk("|bbbbbbbbbbbbbbbbb|");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(partial.begin(), partial.end()), Return(partial.size()))).
+    WillOnce(DoAll(SetArrayArgument<1>(complete.begin(), complete.end()), Return(complete.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(complete.size()), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_UNKNOWN, frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+
+  orion_transport_overflow_counters_t counters = frame_transport.getOverflowCounters();
+  ASSERT_EQ(1, counters.dropped_frames);
+  ASSERT_EQ(partial.size(), counters.dropped_bytes);
+  ASSERT_EQ(0, counters.backpressure_events);
+}
+
+TEST(TestSuite, overflowDropNewest)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  orion::Transport frame_transport(&mock_communication, OVERFLOW_FRAME_SIZE, OVERFLOW_QUEUE_SIZE);
+  frame_transport.setOverflowPolicy(ORION_TRAN_OVERFLOW_POLICY_DROP_NEWEST);
+
+  OverflowPacket decoded;
+  uint8_t packet[OVERFLOW_FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  std::vector<uint8_t> partial = makeChunk("|aaaaaaaaaaaa");
+  std::vector<uint8_t> overflow = makeChunk("aa||bbbbbbb||ccccc");
+  std::vector<uint8_t> rest = makeChunk("cc||dddd|");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(partial.begin(), partial.end()), Return(partial.size()))).
+    WillOnce(DoAll(SetArrayArgument<1>(overflow.begin(), overflow.end()), Return(overflow.size()))).
+    WillOnce(DoAll(SetArrayArgument<1>(rest.begin(), rest.end()), Return(rest.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), _, _, _)).
+    WillRepeatedly(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(16), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_UNKNOWN, frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(6), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+
+  // Dropped bytes span two frames
+  orion_transport_overflow_counters_t counters = frame_transport.getOverflowCounters();
+  ASSERT_EQ(2, counters.dropped_frames);
+  ASSERT_EQ(16, counters.dropped_bytes);
+  ASSERT_EQ(0, counters.backpressure_events);
+}
+
+TEST(TestSuite, overflowBackpressure)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  orion::Transport frame_transport(&mock_communication, OVERFLOW_FRAME_SIZE, OVERFLOW_QUEUE_SIZE);
+
+  OverflowPacket decoded;
+  uint8_t packet[OVERFLOW_FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  std::vector<uint8_t> partial = makeChunk("|aaaaaaaaaaaa");
+  std::vector<uint8_t> rest = makeChunk("aa|");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Eq(ORION_FRAMER_MAX_ENCODED_SIZE(OVERFLOW_FRAME_SIZE)), _)).WillOnce(DoAll(
+      SetArrayArgument<1>(partial.begin(), partial.end()), Return(partial.size())));
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Eq(OVERFLOW_QUEUE_SIZE - partial.size()), _)).WillOnce(DoAll(
+      SetArrayArgument<1>(rest.begin(), rest.end()), Return(rest.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(16), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_UNKNOWN, frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+
+  // Partial frame capped the read, but the read did not use all the room left
+  orion_transport_overflow_counters_t counters = frame_transport.getOverflowCounters();
+  ASSERT_EQ(0, counters.dropped_frames);
+  ASSERT_EQ(0, counters.dropped_bytes);
+  ASSERT_EQ(0, counters.backpressure_events);
+}
+
+TEST(TestSuite, overflowBackpressureFullQueue)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  orion::Transport frame_transport(&mock_communication, OVERFLOW_FRAME_SIZE, OVERFLOW_QUEUE_SIZE);
+
+  OverflowPacket decoded;
+  uint8_t packet[OVERFLOW_FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  std::vector<uint8_t> partial = makeChunk("|aaaaaaaaaaaa");
+  std::vector<uint8_t> rest = makeChunk("aa||bbbbbbb");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Eq(ORION_FRAMER_MAX_ENCODED_SIZE(OVERFLOW_FRAME_SIZE)), _)).WillOnce(DoAll(
+      SetArrayArgument<1>(partial.begin(), partial.end()), Return(partial.size())));
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Eq(OVERFLOW_QUEUE_SIZE - partial.size()), _)).WillOnce(DoAll(
+      SetArrayArgument<1>(rest.begin(), rest.end()), Return(rest.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(16), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_UNKNOWN, frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+
+  // Read took all the room left in queue, the link may have had more
+  orion_transport_overflow_counters_t counters = frame_transport.getOverflowCounters();
+  ASSERT_EQ(0, counters.dropped_frames);
+  ASSERT_EQ(0, counters.dropped_bytes);
+  ASSERT_EQ(1, counters.backpressure_events);
+}
+
+TEST(TestSuite, resynchronization)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  orion::Transport frame_transport(&mock_communication, OVERFLOW_FRAME_SIZE, OVERFLOW_QUEUE_SIZE);
+
+  OverflowPacket decoded;
+  uint8_t packet[OVERFLOW_FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  // Noise, frame which lost its tail together with closing delimiter, runt and valid frame
+  std::vector<uint8_t> chunk = makeChunk("noise|aaaaa|x|bbbbbb|");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(chunk.begin(), chunk.end()), Return(chunk.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(7), _, _)).
+    WillOnce(Return(ORION_FRM_ERROR_DECODING_FAILED));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(8), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(decoded.data, decoded.data + sizeof(decoded.data)),
+      Return(sizeof(decoded.data))));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_FAILED_TO_DECODE_PACKET, frame_transport.receivePacket(packet, sizeof(packet),
+    retry_timeout));
+  ASSERT_TRUE(frame_transport.hasReceivedPacket());
+  ASSERT_EQ(ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET, frame_transport.receivePacket(packet, sizeof(packet),
+    retry_timeout));
+  ASSERT_EQ(sizeof(decoded.data), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_FALSE(frame_transport.hasReceivedPacket());
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(1, statistics.rx.frames);
+  ASSERT_EQ(chunk.size(), statistics.rx.bytes);
+  ASSERT_EQ(1, statistics.rx.decode_errors);
+  ASSERT_EQ(1, statistics.rx.partial_frames);
+  ASSERT_EQ(strlen("noise"), statistics.rx.garbage_bytes);
+  ASSERT_EQ(chunk.size() - strlen("noise"), statistics.rx.queue_high_water_mark);
+  ASSERT_EQ(0, statistics.rx.crc_errors);
+  ASSERT_EQ(0, statistics.rx.overflow.dropped_frames);
+}
+
+TEST(TestSuite, sendContainer)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 32;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setContainers(true));
+
+  orion::CommandHeader commands[3];
+  orion_transport_packet_t packets[3];
+  for (uint8_t index = 0; index < 3; index++)
+  {
+    commands[index].common.message_id = index + 1;
+    commands[index].common.sequence_id = index + 10;
+    packets[index].buffer = reinterpret_cast<uint8_t*>(&commands[index]);
+    packets[index].size = sizeof(commands[index]);
+  }
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 200;
+
+  std::vector<uint8_t> container;
+  std::vector<uint8_t> chunk = makeChunk("|frames|");
+  auto mock_encode_packet = [&](const uint8_t* data, size_t length, uint8_t* packet, size_t)
+    {
+      container.assign(data, data + length);
+      std::copy(chunk.begin(), chunk.end(), packet);
+      return static_cast<ssize_t>(chunk.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, NotNull(), _)).
+    WillOnce(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(),
+    Eq(chunk.size()), Le(retry_timeout))).WillOnce(Return(ORION_COM_ERROR_NONE));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPackets(packets, 3, retry_timeout));
+
+  const size_t record_size = sizeof(orion::CommonHeader);
+  ASSERT_EQ(sizeof(orion_envelope_header_t) + 3 * (1 + record_size), container.size());
+  const orion_envelope_header_t *header = reinterpret_cast<const orion_envelope_header_t*>(container.data());
+  ASSERT_EQ(ORION_CONTROL_MESSAGE_ID_ENVELOPE, header->common.message_id);
+  ASSERT_EQ(ORION_ENVELOPE_FLAG_CONTAINER, header->flags);
+  for (size_t index = 0; index < 3; index++)
+  {
+    const uint8_t *record = container.data() + sizeof(orion_envelope_header_t) + index * (1 + record_size);
+    ASSERT_EQ(record_size, record[0]);
+    const orion::CommonHeader *common = reinterpret_cast<const orion::CommonHeader*>(record + 1);
+    ASSERT_EQ(index + 1, common->message_id);
+    ASSERT_EQ(index + 10, common->sequence_id);
+  }
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(1, statistics.tx.frames);
+  ASSERT_EQ(3, statistics.tx.packed_messages);
+}
+
+TEST(TestSuite, receiveContainer)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 32;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+
+  // Envelope followed by two records holding bare common headers
+  std::vector<uint8_t> container(sizeof(orion_envelope_header_t));
+  orion_envelope_header_t *header = reinterpret_cast<orion_envelope_header_t*>(container.data());
+  header->common.message_id = ORION_CONTROL_MESSAGE_ID_ENVELOPE;
+  header->common.version = ORION_ENVELOPE_VERSION;
+  header->common.oldest_compatible_version = ORION_ENVELOPE_VERSION;
+  header->common.sequence_id = 0;
+  header->flags = ORION_ENVELOPE_FLAG_CONTAINER;
+  for (uint8_t index = 0; index < 2; index++)
+  {
+    orion::CommonHeader common = { .message_id = static_cast<uint8_t>(index + 1), .version = 1,
+      .oldest_compatible_version = 1, .sequence_id = static_cast<uint16_t>(index + 10) };
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(&common);
+    container.push_back(sizeof(common));
+    container.insert(container.end(), data, data + sizeof(common));
+  }
+  header = reinterpret_cast<orion_envelope_header_t*>(container.data());
+  header->frame.crc = orion_crc_calculate_crc16(container.data() + sizeof(orion::FrameHeader),
+    container.size() - sizeof(orion::FrameHeader));
+
+  uint8_t packet[FRAME_SIZE];
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 300;
+  std::vector<uint8_t> chunk = makeChunk("|container|");
+
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(chunk.begin(), chunk.end()), Return(chunk.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), Eq(chunk.size()), _, _)).
+    WillOnce(DoAll(SetArrayArgument<2>(container.begin(), container.end()), Return(container.size())));
+
+  for (uint8_t index = 0; index < 2; index++)
+  {
+    ASSERT_EQ(sizeof(orion::CommandHeader), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+    const orion::CommandHeader *command = reinterpret_cast<const orion::CommandHeader*>(packet);
+    ASSERT_EQ(index + 1, command->common.message_id);
+    ASSERT_EQ(index + 10, command->common.sequence_id);
+  }
+  ASSERT_FALSE(frame_transport.hasReceivedPacket());
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(1, statistics.rx.frames);
+  ASSERT_EQ(2, statistics.rx.unpacked_messages);
+  ASSERT_EQ(0, statistics.rx.decode_errors);
+}
+
+TEST(TestSuite, fragmentedMessage)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 32;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, 4 * ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  uint8_t message[70];
+  for (size_t index = 0; index < sizeof(message); index++)
+  {
+    message[index] = static_cast<uint8_t>(index);
+  }
+  uint32_t retry_timeout = orion::Major::Interval::Millisecond;
+  ASSERT_EQ(ORION_TRAN_ERROR_PACKET_TOO_BIG, frame_transport.sendPacket(message, sizeof(message), retry_timeout));
+
+  // Fragments are kept as they are instead of being encoded, so that they could be fed back to receiving side
+  std::vector<std::vector<uint8_t>> fragments;
+  std::vector<uint8_t> word = makeChunk("|fragment");
+  auto mock_encode_packet = [&](const uint8_t* data, size_t length, uint8_t* packet, size_t buffer_length)
+    {
+      if (buffer_length < word.size())
+      {
+        return static_cast<ssize_t>(-1);
+      }
+      fragments.push_back(std::vector<uint8_t>(data, data + length));
+      std::copy(word.begin(), word.end(), packet);
+      return static_cast<ssize_t>(word.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, NotNull(), _)).
+    WillRepeatedly(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(), Gt(0),
+    Le(retry_timeout))).WillRepeatedly(Return(ORION_COM_ERROR_NONE));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setFragments(true));
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPacket(message, sizeof(message), retry_timeout));
+
+  const uint32_t max_fragment_size = FRAME_SIZE - sizeof(orion_fragment_header_t);
+  const uint32_t total_size = sizeof(message) - sizeof(orion::FrameHeader);
+  const size_t fragments_count = (total_size + max_fragment_size - 1) / max_fragment_size;
+  ASSERT_EQ(fragments_count, fragments.size());
+  for (size_t index = 0; index < fragments_count; index++)
+  {
+    const orion_fragment_header_t *header = reinterpret_cast<const orion_fragment_header_t*>(fragments[index].data());
+    ASSERT_EQ(ORION_CONTROL_MESSAGE_ID_ENVELOPE, header->envelope.common.message_id);
+    ASSERT_EQ(ORION_ENVELOPE_FLAG_FRAGMENT, header->envelope.flags);
+    ASSERT_EQ(index * max_fragment_size, header->offset);
+    ASSERT_EQ(total_size, header->total_size);
+    ASSERT_EQ(fragments[0][offsetof(orion_fragment_header_t, transfer_id)],
+      fragments[index][offsetof(orion_fragment_header_t, transfer_id)]);
+  }
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(fragments_count, statistics.tx.fragments);
+  ASSERT_EQ(fragments_count, statistics.tx.frames);
+
+  // All fragments arrive, then a transfer which loses its second fragment
+  std::vector<std::vector<uint8_t>> received = fragments;
+  received.push_back(fragments[0]);
+  received.push_back(fragments[2]);
+  std::vector<uint8_t> chunk;
+  for (size_t index = 0; index < received.size(); index++)
+  {
+    chunk.insert(chunk.end(), word.begin(), word.end());
+  }
+  chunk.push_back(ORION_FRAMER_FRAME_DELIMETER);
+  size_t decoded = 0;
+  auto mock_decode_packet = [&](const uint8_t*, size_t, uint8_t* data, size_t)
+    {
+      std::copy(received[decoded].begin(), received[decoded].end(), data);
+      return static_cast<ssize_t>(received[decoded++].size());
+    };
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(chunk.begin(), chunk.end()), Return(chunk.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), _, _, _)).
+    WillRepeatedly(Invoke(mock_decode_packet));
+
+  uint8_t reassembly[128];
+  uint8_t packet[128];
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setReassemblyBuffer(reassembly, sizeof(reassembly)));
+  for (size_t index = 0; index + 1 < fragments_count; index++)
+  {
+    ASSERT_EQ(ORION_TRAN_ERROR_INCOMPLETE_MESSAGE, frame_transport.receivePacket(packet, sizeof(packet),
+      retry_timeout));
+  }
+  ASSERT_EQ(sizeof(message), frame_transport.receivePacket(packet, sizeof(packet), retry_timeout));
+  ASSERT_EQ(0, memcmp(message + sizeof(orion::FrameHeader), packet + sizeof(orion::FrameHeader), total_size));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_INCOMPLETE_MESSAGE, frame_transport.receivePacket(packet, sizeof(packet),
+    retry_timeout));
+  ASSERT_EQ(ORION_TRAN_ERROR_FAILED_TO_RECEIVE_FULL_PACKET, frame_transport.receivePacket(packet, sizeof(packet),
+    retry_timeout));
+
+  statistics = frame_transport.getStatistics();
+  ASSERT_EQ(fragments_count + 1, statistics.rx.fragments);
+  ASSERT_EQ(1, statistics.rx.reassembly_errors);
+}
+
+TEST(TestSuite, fragmentedMessageInParts)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 32;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, 4 * ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  uint8_t message[70];
+  for (size_t index = 0; index < sizeof(message); index++)
+  {
+    message[index] = static_cast<uint8_t>(index);
+  }
+  uint32_t retry_timeout = orion::Major::Interval::Millisecond;
+
+  std::vector<std::vector<uint8_t>> fragments;
+  std::vector<uint8_t> word = makeChunk("|fragment");
+  auto mock_encode_packet = [&](const uint8_t* data, size_t length, uint8_t* packet, size_t buffer_length)
+    {
+      if (buffer_length < word.size())
+      {
+        return static_cast<ssize_t>(-1);
+      }
+      fragments.push_back(std::vector<uint8_t>(data, data + length));
+      std::copy(word.begin(), word.end(), packet);
+      return static_cast<ssize_t>(word.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, NotNull(), _)).
+    WillRepeatedly(Invoke(mock_encode_packet));
+  // Every part is a write of its own
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(), Gt(0),
+    Le(retry_timeout))).Times(4).WillRepeatedly(Return(ORION_COM_ERROR_NONE));
+
+  // Parts of two fragments each
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setFragments(true));
+  const uint32_t max_fragment_size = FRAME_SIZE - sizeof(orion_fragment_header_t);
+  ssize_t offset = frame_transport.sendPart(message, sizeof(message), 0, 2 * FRAME_SIZE, retry_timeout);
+  ASSERT_EQ(sizeof(orion::FrameHeader) + 2 * max_fragment_size, offset);
+  offset = frame_transport.sendPart(message, sizeof(message), offset, 2 * FRAME_SIZE, retry_timeout);
+  ASSERT_EQ(sizeof(orion::FrameHeader) + 4 * max_fragment_size, offset);
+  offset = frame_transport.sendPart(message, sizeof(message), offset, 2 * FRAME_SIZE, retry_timeout);
+  ASSERT_EQ(sizeof(message), offset);
+
+  // Parts make up a single transfer
+  const uint32_t total_size = sizeof(message) - sizeof(orion::FrameHeader);
+  ASSERT_EQ(5, fragments.size());
+  for (size_t index = 0; index < fragments.size(); index++)
+  {
+    const orion_fragment_header_t *header = reinterpret_cast<const orion_fragment_header_t*>(fragments[index].data());
+    ASSERT_EQ(index * max_fragment_size, header->offset);
+    ASSERT_EQ(total_size, header->total_size);
+    ASSERT_EQ(fragments[0][offsetof(orion_fragment_header_t, transfer_id)],
+      fragments[index][offsetof(orion_fragment_header_t, transfer_id)]);
+  }
+
+  // Packet which fits a frame goes whole
+  EXPECT_EQ(FRAME_SIZE, frame_transport.sendPart(message, FRAME_SIZE, 0, 2 * FRAME_SIZE, retry_timeout));
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  EXPECT_EQ(5, statistics.tx.fragments);
+  EXPECT_EQ(6, statistics.tx.frames);
+}
+
+TEST(TestSuite, compressedFrame)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 128;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, 4 * ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  uint16_t compression_buffer[ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(FRAME_SIZE, ORION_LZ_MIN_TABLE_BITS) / 2];
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setCompressionBuffer(
+    reinterpret_cast<uint8_t*>(compression_buffer), sizeof(compression_buffer)));
+
+  // Grid row repeats itself, scrambled bytes do not
+  uint8_t grid[100];
+  uint8_t noise[24];
+  for (size_t index = 0; index < sizeof(grid); index++)
+  {
+    grid[index] = static_cast<uint8_t>(index % 10 < 7 ? 0 : 100);
+  }
+  for (size_t index = 0; index < sizeof(noise); index++)
+  {
+    noise[index] = static_cast<uint8_t>(index * 167 + 13);
+  }
+
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<uint8_t> word = makeChunk("|frame");
+  auto mock_encode_packet = [&](const uint8_t* data, size_t length, uint8_t* packet, size_t)
+    {
+      frames.push_back(std::vector<uint8_t>(data, data + length));
+      std::copy(word.begin(), word.end(), packet);
+      return static_cast<ssize_t>(word.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, NotNull(), _)).
+    WillRepeatedly(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(), Gt(0),
+    _)).WillRepeatedly(Return(ORION_COM_ERROR_NONE));
+
+  uint32_t timeout = orion::Major::Interval::Millisecond;
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPacket(grid, sizeof(grid), timeout));
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPacket(noise, sizeof(noise), timeout));
+  ASSERT_EQ(2, frames.size());
+
+  const orion_envelope_header_t *header = reinterpret_cast<const orion_envelope_header_t*>(frames[0].data());
+  ASSERT_EQ(ORION_CONTROL_MESSAGE_ID_ENVELOPE, header->common.message_id);
+  ASSERT_EQ(ORION_ENVELOPE_FLAG_COMPRESSED, header->flags);
+  ASSERT_LT(frames[0].size(), sizeof(grid) / 2);
+  // Frame which does not shrink goes as it is
+  ASSERT_EQ(sizeof(noise), frames[1].size());
+  ASSERT_EQ(0, memcmp(noise + sizeof(orion::FrameHeader), frames[1].data() + sizeof(orion::FrameHeader),
+    sizeof(noise) - sizeof(orion::FrameHeader)));
+
+  orion_transport_statistics_t statistics = frame_transport.getStatistics();
+  ASSERT_EQ(1, statistics.tx.compressed_frames);
+  ASSERT_EQ(sizeof(grid) - frames[0].size(), statistics.tx.compression_saved_bytes);
+
+  // Receiving side decompresses without any buffer of its own
+  std::vector<uint8_t> chunk;
+  for (size_t index = 0; index < frames.size(); index++)
+  {
+    chunk.insert(chunk.end(), word.begin(), word.end());
+  }
+  chunk.push_back(ORION_FRAMER_FRAME_DELIMETER);
+  size_t decoded = 0;
+  auto mock_decode_packet = [&](const uint8_t*, size_t, uint8_t* data, size_t)
+    {
+      std::copy(frames[decoded].begin(), frames[decoded].end(), data);
+      return static_cast<ssize_t>(frames[decoded++].size());
+    };
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(chunk.begin(), chunk.end()), Return(chunk.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), _, _, _)).
+    WillRepeatedly(Invoke(mock_decode_packet));
+
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setCompressionBuffer(nullptr, 0));
+  uint8_t packet[FRAME_SIZE];
+  ASSERT_EQ(sizeof(grid), frame_transport.receivePacket(packet, sizeof(packet), timeout));
+  ASSERT_EQ(0, memcmp(grid + sizeof(orion::FrameHeader), packet + sizeof(orion::FrameHeader),
+    sizeof(grid) - sizeof(orion::FrameHeader)));
+  ASSERT_EQ(sizeof(noise), frame_transport.receivePacket(packet, sizeof(packet), timeout));
+  ASSERT_EQ(0, memcmp(noise + sizeof(orion::FrameHeader), packet + sizeof(orion::FrameHeader),
+    sizeof(noise) - sizeof(orion::FrameHeader)));
+
+  statistics = frame_transport.getStatistics();
+  ASSERT_EQ(1, statistics.rx.decompressed_frames);
+  ASSERT_EQ(2, statistics.rx.frames);
+}
+
+TEST(TestSuite, negotiatedLink)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  ON_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).WillByDefault(
+    Return(false));
+  MockCommunication mock_communication;
+
+  const uint32_t FRAME_SIZE = 128;
+  orion::Transport frame_transport(&mock_communication, FRAME_SIZE, 4 * ORION_FRAMER_MAX_ENCODED_SIZE(FRAME_SIZE));
+  orion_transport_link_t link = frame_transport.getLink();
+  EXPECT_EQ(0, link.capabilities);
+  EXPECT_EQ(FRAME_SIZE, link.frame_size);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, link.checksum);
+
+  link.capabilities = ORION_CONTROL_CAPABILITY_LINK;
+  link.frame_size = 64;
+  link.baud = 460800;
+  link.window = 8;
+  link.checksum = ORION_CONTROL_CHECKSUM_FLETCHER16;
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.setLink(link));
+  EXPECT_EQ(460800, frame_transport.getLink().baud);
+  EXPECT_EQ(8, frame_transport.getLink().window);
+  EXPECT_EQ(FRAME_SIZE, frame_transport.getFrameSize());
+
+  const uint8_t reference[] = { 'a', 'b', 'c', 'd', 'e' };
+  EXPECT_EQ(0xC8F0, orion_crc_calculate_fletcher16(reference, sizeof(reference)));
+
+  std::vector<std::vector<uint8_t>> frames;
+  std::vector<uint8_t> word = makeChunk("|frame");
+  auto mock_encode_packet = [&](const uint8_t* data, size_t length, uint8_t* packet, size_t)
+    {
+      frames.push_back(std::vector<uint8_t>(data, data + length));
+      std::copy(word.begin(), word.end(), packet);
+      return static_cast<ssize_t>(word.size());
+    };
+  EXPECT_GLOBAL_CALL(orion_framer_encode_packet, orion_framer_encode_packet(_, _, NotNull(), _)).
+    WillOnce(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_communication_send_buffer, orion_communication_send_buffer(NotNull(), NotNull(), Gt(0),
+    _)).WillOnce(Return(ORION_COM_ERROR_NONE));
+
+  // Frames are sent up to agreed size, which is smaller than the one of transport
+  uint32_t timeout = orion::Major::Interval::Millisecond;
+  uint8_t packet[FRAME_SIZE];
+  for (size_t index = 0; index < sizeof(packet); index++)
+  {
+    packet[index] = static_cast<uint8_t>(index * 7);
+  }
+  ASSERT_EQ(ORION_TRAN_ERROR_PACKET_TOO_BIG, frame_transport.sendPacket(packet, 65, timeout));
+  ASSERT_EQ(ORION_TRAN_ERROR_NONE, frame_transport.sendPacket(packet, 64, timeout));
+  ASSERT_EQ(1, frames.size());
+  EXPECT_EQ(orion_crc_calculate_fletcher16(packet + sizeof(orion::FrameHeader), 64 - sizeof(orion::FrameHeader)),
+    reinterpret_cast<const orion::FrameHeader*>(frames[0].data())->crc);
+
+  // CRC16 of peer which has not switched yet passes too, any other checksum does not
+  frames.push_back(frames[0]);
+  reinterpret_cast<orion::FrameHeader*>(frames[1].data())->crc = orion_crc_calculate_crc16(
+    packet + sizeof(orion::FrameHeader), 64 - sizeof(orion::FrameHeader));
+  frames.push_back(frames[0]);
+  reinterpret_cast<orion::FrameHeader*>(frames[2].data())->crc ^= 0x0101;
+  std::vector<uint8_t> chunk;
+  for (size_t index = 0; index < frames.size(); index++)
+  {
+    chunk.insert(chunk.end(), word.begin(), word.end());
+  }
+  chunk.push_back(ORION_FRAMER_FRAME_DELIMETER);
+  size_t decoded = 0;
+  auto mock_decode_packet = [&](const uint8_t*, size_t, uint8_t* data, size_t)
+    {
+      std::copy(frames[decoded].begin(), frames[decoded].end(), data);
+      return static_cast<ssize_t>(frames[decoded++].size());
+    };
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(NotNull(), NotNull(),
+    Gt(0), _)).WillOnce(DoAll(SetArrayArgument<1>(chunk.begin(), chunk.end()), Return(chunk.size())));
+  EXPECT_GLOBAL_CALL(orion_framer_decode_packet, orion_framer_decode_packet(NotNull(), _, _, _)).
+    WillRepeatedly(Invoke(mock_decode_packet));
+
+  uint8_t received[FRAME_SIZE];
+  ASSERT_EQ(64, frame_transport.receivePacket(received, sizeof(received), timeout));
+  ASSERT_EQ(64, frame_transport.receivePacket(received, sizeof(received), timeout));
+  ASSERT_EQ(ORION_TRAN_ERROR_CRC_CHECK_FAILED, frame_transport.receivePacket(received, sizeof(received), timeout));
+  EXPECT_EQ(1, frame_transport.getStatistics().rx.crc_errors);
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
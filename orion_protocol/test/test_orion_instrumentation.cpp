@@ -0,0 +1,132 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "orion_protocol/orion_instrumentation.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(TestSuite, histogramPercentiles)
+{
+  orion::LatencyHistogram histogram;
+  ASSERT_EQ(0, histogram.getCount());
+  ASSERT_EQ(0, histogram.getValueAtPercentile(50.0));
+
+  for (uint32_t value = 1; value <= 1000; value++)
+  {
+    histogram.record(value);
+  }
+  ASSERT_EQ(1000, histogram.getCount());
+  ASSERT_EQ(1000, histogram.getMax());
+  ASSERT_EQ(1, histogram.getValueAtPercentile(0.0));
+  ASSERT_EQ(1000, histogram.getValueAtPercentile(100.0));
+
+  // Values are reported with relative error below 1/16
+  uint32_t median = histogram.getValueAtPercentile(50.0);
+  ASSERT_GE(median, 500);
+  ASSERT_LE(median, 500 + 500 / 16);
+  uint32_t p99 = histogram.getValueAtPercentile(99.0);
+  ASSERT_GE(p99, 990);
+  ASSERT_LE(p99, 1000);
+
+  // Small values are exact
+  orion::LatencyHistogram small;
+  small.record(3);
+  small.record(7);
+  ASSERT_EQ(3, small.getValueAtPercentile(50.0));
+  ASSERT_EQ(7, small.getValueAtPercentile(51.0));
+
+  orion::LatencyHistogram huge;
+  huge.record(UINT32_MAX);
+  ASSERT_EQ(UINT32_MAX, huge.getValueAtPercentile(50.0));
+}
+
+TEST(TestSuite, recordPerMessage)
+{
+  orion::Instrumentation instrumentation;
+  ASSERT_EQ(nullptr, instrumentation.getMessage(5));
+
+  instrumentation.record(5, 800, 1, ORION_MAJOR_ERROR_NONE);
+  instrumentation.record(5, 1200, 2, ORION_MAJOR_ERROR_NONE);
+  instrumentation.record(5, 3000, 20, ORION_MAJOR_ERROR_TIMEOUT);
+  instrumentation.record(7, 100, 1, ORION_MAJOR_ERROR_APPLICATION_ERROR_RECEIVED);
+
+  const orion::Instrumentation::Message *message = instrumentation.getMessage(5);
+  ASSERT_NE(nullptr, message);
+  // Timeouts do not have response latency
+  ASSERT_EQ(2, message->latency.getCount());
+  ASSERT_EQ(1200, message->latency.getMax());
+  ASSERT_EQ(1, message->attempts[0]);
+  ASSERT_EQ(1, message->attempts[1]);
+  ASSERT_EQ(1, message->attempts[orion::Instrumentation::ATTEMPTS_COUNT - 1]);
+  ASSERT_EQ(2, message->outcomes[ORION_MAJOR_ERROR_NONE]);
+  ASSERT_EQ(1, message->outcomes[ORION_MAJOR_ERROR_TIMEOUT]);
+  ASSERT_EQ(nullptr, instrumentation.getMessage(6));
+
+  std::ostringstream output;
+  instrumentation.dump(output);
+  std::string dump = output.str();
+  ASSERT_NE(std::string::npos, dump.find("message_id 5: invokes 3, failed 1, timeouts 1"));
+  ASSERT_NE(std::string::npos, dump.find("message_id 7: invokes 1, failed 1, timeouts 0"));
+  ASSERT_EQ(std::string::npos, dump.find("message_id 6"));
+}
+
+TEST(TestSuite, concurrentRecording)
+{
+  orion::Instrumentation instrumentation;
+  const uint32_t THREAD_COUNT = 4;
+  const uint32_t RECORD_COUNT = 10000;
+
+  std::vector<std::thread> threads;
+  for (uint32_t thread = 0; thread < THREAD_COUNT; thread++)
+  {
+    threads.push_back(std::thread([&instrumentation, RECORD_COUNT]()
+      {
+        for (uint32_t index = 0; index < RECORD_COUNT; index++)
+        {
+          instrumentation.record(index % 3, index, 1, ORION_MAJOR_ERROR_NONE);
+        }
+      }));
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  uint32_t total = 0;
+  for (uint8_t message_id = 0; message_id < 3; message_id++)
+  {
+    ASSERT_NE(nullptr, instrumentation.getMessage(message_id));
+    total += instrumentation.getMessage(message_id)->latency.getCount();
+  }
+  ASSERT_EQ(THREAD_COUNT * RECORD_COUNT, total);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,227 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "gmock-global/gmock-global.h"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include "orion_protocol/orion_communication.hpp"
+#include "orion_protocol/orion_framer.h"
+#include "orion_protocol/orion_header.hpp"
+#include "orion_protocol/orion_transport.hpp"
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+MOCK_GLOBAL_FUNC1(orion_communication_new, orion_communication_error_t(orion_communication_t ** me));
+MOCK_GLOBAL_FUNC1(orion_communication_delete, orion_communication_error_t(const orion_communication_t * me));
+// NOLINTNEXTLINE(readability/casting)
+MOCK_GLOBAL_FUNC1(orion_communication_has_available_buffer, bool(orion_communication_t * me));
+MOCK_GLOBAL_FUNC4(orion_communication_receive_buffer, ssize_t(orion_communication_t * me, uint8_t * buffer,
+  uint32_t size, uint32_t timeout));
+MOCK_GLOBAL_FUNC3(orion_communication_receive_available_buffer, ssize_t(orion_communication_t * me,
+  uint8_t * buffer, uint32_t size));
+
+class MockCommunication: public orion::Communication
+{
+public:
+  MOCK_METHOD2(receiveAvailableBuffer, ssize_t(uint8_t *buffer, uint32_t size));
+  MOCK_METHOD3(receiveBuffer, ssize_t(uint8_t *buffer, uint32_t size, uint32_t timeout));
+  MOCK_METHOD0(hasAvailableBuffer, bool());
+  MOCK_METHOD3(sendBuffer, orion_communication_error_t(uint8_t *buffer, uint32_t size, uint32_t timeout));
+};
+
+#pragma pack(push, 1)
+
+struct SamplePacket
+{
+  orion::CommandHeader header;
+  uint32_t index;
+  uint8_t data[24];
+};
+
+#pragma pack(pop)
+
+static SamplePacket make_packet(uint32_t index)
+{
+  SamplePacket packet;
+  std::memset(&packet, 0, sizeof(packet));
+  packet.header.common.message_id = 1;
+  packet.index = index;
+  for (size_t offset = 0; offset < sizeof(packet.data); offset++)
+  {
+    packet.data[offset] = static_cast<uint8_t>(index * 7 + offset);
+  }
+  return (packet);
+}
+
+/*
+  Serial line which loses single bytes at random, receiver reads whatever arrived in chunks like a serial port
+*/
+class LossyLink
+{
+public:
+  explicit LossyLink(uint32_t loss_per_mille) : loss_per_mille_(loss_per_mille) {}
+
+  // Returns true when some bytes of the frame were lost
+  bool send(const uint8_t *frame, uint32_t size)
+  {
+    bool damaged = false;
+    for (uint32_t index = 0; index < size; index++)
+    {
+      // Linear congruential generator keeps the losses the same from run to run
+      this->random_ = this->random_ * 6364136223846793005ULL + 1442695040888963407ULL;
+      if ((this->random_ >> 33) % 1000 < this->loss_per_mille_)
+      {
+        damaged = true;
+      }
+      else
+      {
+        this->bytes_.push_back(frame[index]);
+      }
+    }
+    return (damaged);
+  }
+
+  ssize_t receive(uint8_t *buffer, uint32_t size)
+  {
+    uint32_t result = 0;
+    while ((result < size) && (result < READ_SIZE) && !this->bytes_.empty())
+    {
+      buffer[result++] = this->bytes_.front();
+      this->bytes_.pop_front();
+    }
+    return (result);
+  }
+
+  bool isEmpty() const
+  {
+    return (this->bytes_.empty());
+  }
+
+private:
+  static const uint32_t READ_SIZE = 64;
+
+  uint32_t loss_per_mille_;
+  uint64_t random_ = 1;
+  std::deque<uint8_t> bytes_;
+};
+
+TEST(TestSuite, recoveryBenchmark)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+  orion::Transport transport(&mock_communication);
+
+  // 0.5% of bytes lost, about every sixth frame is damaged
+  LossyLink link(5);
+  EXPECT_GLOBAL_CALL(orion_communication_has_available_buffer, orion_communication_has_available_buffer(_)).
+    WillRepeatedly(Invoke([&](orion_communication_t *) { return !link.isEmpty(); }));
+  EXPECT_GLOBAL_CALL(orion_communication_receive_buffer, orion_communication_receive_buffer(_, _, _, _)).
+    WillRepeatedly(Invoke([&](orion_communication_t *, uint8_t *buffer, uint32_t size, uint32_t)
+      {
+        return link.receive(buffer, size);
+      }));
+  EXPECT_GLOBAL_CALL(orion_communication_receive_available_buffer, orion_communication_receive_available_buffer(_, _,
+    _)).WillRepeatedly(Invoke([&](orion_communication_t *, uint8_t *buffer, uint32_t size)
+      {
+        return link.receive(buffer, size);
+      }));
+
+  const uint32_t count = 5000;
+  std::vector<bool> damaged(count, false);
+  std::vector<bool> received(count, false);
+  std::vector<uint8_t> frame(ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(SamplePacket)));
+  uint32_t wrong_packets = 0;
+  auto receive = [&]()
+    {
+      SamplePacket result;
+      ssize_t size = transport.receivePacket(reinterpret_cast<uint8_t*>(&result), sizeof(result), 0);
+      if (static_cast<ssize_t>(sizeof(result)) == size)
+      {
+        SamplePacket expected = make_packet(result.index);
+        if ((result.index < count) && (0 == std::memcmp(&expected.data, &result.data, sizeof(result.data))))
+        {
+          received[result.index] = true;
+        }
+        else
+        {
+          wrong_packets++;
+        }
+      }
+    };
+  for (uint32_t index = 0; index < count; index++)
+  {
+    SamplePacket packet = make_packet(index);
+    ssize_t frame_size = transport.encodePacket(reinterpret_cast<uint8_t*>(&packet), sizeof(packet), frame.data(),
+      frame.size());
+    ASSERT_LT(0, frame_size);
+    damaged[index] = link.send(frame.data(), frame_size);
+
+    // Receiver keeps up with sender, a few frames are in flight at any time
+    while (!link.isEmpty() && ((index % 4 == 3) || (count - 1 == index)))
+    {
+      receive();
+    }
+  }
+  while (transport.hasReceivedPacket())
+  {
+    receive();
+  }
+
+  uint32_t corruptions = 0;
+  uint32_t lost = 0;
+  uint32_t intact_lost = 0;
+  uint32_t retries_avoided = 0;
+  for (uint32_t index = 0; index < count; index++)
+  {
+    corruptions += damaged[index] ? 1 : 0;
+    lost += received[index] ? 0 : 1;
+    intact_lost += (!damaged[index] && !received[index]) ? 1 : 0;
+    // Frame right after damaged one used to lose its opening delimiter and cost a retry as well
+    retries_avoided += ((index > 0) && damaged[index - 1] && !damaged[index] && received[index]) ? 1 : 0;
+  }
+  std::printf("Byte loss: %u of %u frames damaged, %u lost, %.2f lost frames per corruption, %u retries avoided\n",
+    corruptions, count, lost, static_cast<double>(lost) / corruptions, retries_avoided);
+  EXPECT_LT(count / 10, corruptions);
+  // Recovery costs the damaged frame only, never the one which follows
+  EXPECT_EQ(0, intact_lost);
+  EXPECT_LE(lost, corruptions);
+  EXPECT_EQ(0, wrong_packets);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
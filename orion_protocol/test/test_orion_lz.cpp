@@ -0,0 +1,211 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "orion_protocol/orion_lz.h"
+
+static std::vector<uint8_t> make_grid(uint32_t size)
+{
+  // Occupancy grid of a map: long runs of free and unknown cells with walls here and there
+  std::vector<uint8_t> result(size);
+  for (uint32_t index = 0; index < size; index++)
+  {
+    uint32_t column = index % 64;
+    result[index] = (column < 20) ? 0xFF : ((column == 40 || index % 97 == 0) ? 100 : 0);
+  }
+  return (result);
+}
+
+static std::vector<uint8_t> make_log(uint32_t size)
+{
+  std::vector<uint8_t> result;
+  char line[64];
+  for (uint32_t index = 0; result.size() < size; index++)
+  {
+    int length = std::snprintf(line, sizeof(line), "[INFO] motor %u: speed %u rpm, current %u mA\n",
+      index % 4, 1000 + index * 13 % 200, 300 + index * 7 % 50);
+    result.insert(result.end(), line, line + length);
+  }
+  result.resize(size);
+  return (result);
+}
+
+static std::vector<uint8_t> make_noise(uint32_t size)
+{
+  std::vector<uint8_t> result(size);
+  uint32_t state = 12345;
+  for (uint32_t index = 0; index < size; index++)
+  {
+    state = state * 1103515245 + 12345;
+    result[index] = static_cast<uint8_t>(state >> 16);
+  }
+  return (result);
+}
+
+static std::vector<uint8_t> round_trip(const std::vector<uint8_t> &input, uint32_t table_bits)
+{
+  std::vector<uint16_t> table(1 << table_bits);
+  std::vector<uint8_t> compressed(ORION_LZ_MAX_COMPRESSED_SIZE(input.size()));
+  ssize_t compressed_size = orion_lz_compress(input.data(), input.size(), compressed.data(), compressed.size(),
+    table.data(), table_bits);
+  EXPECT_GE(compressed_size, 0);
+  std::vector<uint8_t> output(input.size());
+  EXPECT_EQ(input.size(), orion_lz_decompress(compressed.data(), compressed_size, output.data(), output.size()));
+  EXPECT_EQ(input, output);
+  compressed.resize(compressed_size);
+  return (compressed);
+}
+
+TEST(TestSuite, roundTrip)
+{
+  for (uint32_t table_bits : {ORION_LZ_MIN_TABLE_BITS, 10, ORION_LZ_MAX_TABLE_BITS})
+  {
+    EXPECT_LT(round_trip(make_grid(4096), table_bits).size(), 4096 / 4);
+    EXPECT_LT(round_trip(make_log(4096), table_bits).size(), 4096 / 2);
+    EXPECT_LE(round_trip(make_noise(4096), table_bits).size(), ORION_LZ_MAX_COMPRESSED_SIZE(4096));
+  }
+
+  // Lengths around nibble and length byte boundaries, overlapping matches, matches at the very end
+  for (uint32_t size : {0, 1, 4, 5, 15, 16, 19, 270, 271, 525, ORION_LZ_MAX_INPUT_SIZE})
+  {
+    round_trip(std::vector<uint8_t>(size, 0xAA), ORION_LZ_MIN_TABLE_BITS);
+    round_trip(make_noise(size), ORION_LZ_MIN_TABLE_BITS);
+    std::vector<uint8_t> mixed = make_noise(size);
+    for (uint32_t index = 0; index < size; index += 37)
+    {
+      std::memset(mixed.data() + index, 0, std::min<uint32_t>(size - index, 19));
+    }
+    round_trip(mixed, 12);
+  }
+}
+
+TEST(TestSuite, outputTooSmall)
+{
+  std::vector<uint8_t> input = make_noise(256);
+  std::vector<uint16_t> table(1 << ORION_LZ_MIN_TABLE_BITS);
+  std::vector<uint8_t> output(input.size());
+  // Data which does not compress could not fit into its own size
+  ASSERT_EQ(ORION_LZ_ERROR_BUFFER_TOO_SMALL, orion_lz_compress(input.data(), input.size(), output.data(),
+    output.size(), table.data(), ORION_LZ_MIN_TABLE_BITS));
+
+  std::vector<uint8_t> compressed = round_trip(make_grid(256), ORION_LZ_MIN_TABLE_BITS);
+  ASSERT_EQ(ORION_LZ_ERROR_BUFFER_TOO_SMALL, orion_lz_decompress(compressed.data(), compressed.size(),
+    output.data(), 255));
+}
+
+TEST(TestSuite, malformedInput)
+{
+  uint8_t output[64];
+  // Match before the start of output
+  const uint8_t far_match[] = { 0x10, 'a', 0x02, 0x00 };
+  ASSERT_EQ(ORION_LZ_ERROR_DECODING_FAILED, orion_lz_decompress(far_match, sizeof(far_match), output,
+    sizeof(output)));
+  const uint8_t zero_offset[] = { 0x10, 'a', 0x00, 0x00 };
+  ASSERT_EQ(ORION_LZ_ERROR_DECODING_FAILED, orion_lz_decompress(zero_offset, sizeof(zero_offset), output,
+    sizeof(output)));
+  // Literals and offset cut short
+  const uint8_t short_literals[] = { 0x30, 'a' };
+  ASSERT_EQ(ORION_LZ_ERROR_DECODING_FAILED, orion_lz_decompress(short_literals, sizeof(short_literals), output,
+    sizeof(output)));
+  const uint8_t short_offset[] = { 0x10, 'a', 0x01 };
+  ASSERT_EQ(ORION_LZ_ERROR_DECODING_FAILED, orion_lz_decompress(short_offset, sizeof(short_offset), output,
+    sizeof(output)));
+  const uint8_t short_length[] = { 0xF0, 0xFF };
+  ASSERT_EQ(ORION_LZ_ERROR_DECODING_FAILED, orion_lz_decompress(short_length, sizeof(short_length), output,
+    sizeof(output)));
+
+  // Garbage never makes decompressor step outside of its buffers
+  std::vector<uint8_t> garbage = make_noise(4096);
+  for (uint32_t offset = 0; offset + 64 <= garbage.size(); offset += 64)
+  {
+    ssize_t result = orion_lz_decompress(garbage.data() + offset, 64, output, sizeof(output));
+    ASSERT_LE(result, static_cast<ssize_t>(sizeof(output)));
+  }
+}
+
+TEST(TestSuite, compressionBenchmark)
+{
+  // Ratio against CPU cost for payloads typical for the link, and what ratio buys on slow serial links
+  const uint32_t FRAME_SIZE = 512;
+  const uint32_t FRAMES = 2000;
+  struct Payload
+  {
+    const char *name;
+    std::vector<uint8_t> data;
+  };
+  Payload payloads[] = { { "map grid", make_grid(FRAME_SIZE) }, { "log text", make_log(FRAME_SIZE) },
+    { "random", make_noise(FRAME_SIZE) } };
+
+  for (uint32_t table_bits : {ORION_LZ_MIN_TABLE_BITS, 12})
+  {
+    for (const Payload &payload : payloads)
+    {
+      std::vector<uint16_t> table(1 << table_bits);
+      std::vector<uint8_t> compressed(ORION_LZ_MAX_COMPRESSED_SIZE(FRAME_SIZE));
+      std::vector<uint8_t> output(FRAME_SIZE);
+
+      ssize_t compressed_size = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t index = 0; index < FRAMES; index++)
+      {
+        compressed_size = orion_lz_compress(payload.data.data(), FRAME_SIZE, compressed.data(), compressed.size(),
+          table.data(), table_bits);
+      }
+      auto middle = std::chrono::steady_clock::now();
+      for (uint32_t index = 0; index < FRAMES; index++)
+      {
+        ASSERT_EQ(FRAME_SIZE, orion_lz_decompress(compressed.data(), compressed_size, output.data(),
+          output.size()));
+      }
+      auto end = std::chrono::steady_clock::now();
+      ASSERT_EQ(payload.data, output);
+
+      double megabytes = static_cast<double>(FRAME_SIZE) * FRAMES / 1e6;
+      double compress_speed = megabytes / std::chrono::duration<double>(middle - start).count();
+      double decompress_speed = megabytes / std::chrono::duration<double>(end - middle).count();
+      // Frames which do not shrink are sent raw
+      double ratio = static_cast<double>(FRAME_SIZE) / std::min<ssize_t>(compressed_size, FRAME_SIZE);
+      std::printf("%-8s table 2^%-2u ratio %5.2f, compress %7.1f MB/s, decompress %7.1f MB/s, "
+        "57600 baud %6.0f B/s, 115200 baud %6.0f B/s\n", payload.name, table_bits, ratio, compress_speed,
+        decompress_speed, 5760 * ratio, 11520 * ratio);
+      if (0 != std::strcmp("random", payload.name))
+      {
+        EXPECT_GT(ratio, 2.0);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
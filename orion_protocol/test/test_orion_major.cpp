@@ -23,11 +23,23 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "gmock-global/gmock-global.h"
 #include "orion_protocol/orion_transport.hpp"
 #include "orion_protocol/orion_communication.hpp"
 #include "orion_protocol/orion_header.hpp"
 #include "orion_protocol/orion_major.hpp"
+#include "orion_protocol/orion_instrumentation.hpp"
+#include "orion_protocol/orion_scheduler.hpp"
+#include "orion_protocol/orion_multiplexer.hpp"
+#include "orion_protocol/orion_stream.h"
 
 using ::testing::Eq;
 using ::testing::Gt;
@@ -58,6 +70,48 @@ struct HandshakeResult
   };
 };
 
+struct StatusCommand
+{
+  orion::CommandHeader header =
+  {
+    .frame = { .crc = 0 },
+    .common = { .message_id = 3, .version = 1, .oldest_compatible_version = 1, .sequence_id = 0 }
+  };
+};
+
+struct StatusResult
+{
+  orion::ResultHeader header =
+  {
+    .frame = { .crc = 0 },
+    .common = { .message_id = 3, .version = 1, .oldest_compatible_version = 1, .sequence_id = 0 },
+    .error_code = 0
+  };
+  uint32_t uptime = 0;
+};
+
+// Takes several writes when link carries one status command per write
+struct LargeCommand
+{
+  orion::CommandHeader header =
+  {
+    .frame = { .crc = 0 },
+    .common = { .message_id = 3, .version = 1, .oldest_compatible_version = 1, .sequence_id = 0 }
+  };
+  uint8_t data[3 * sizeof(StatusCommand)] = {};
+};
+
+struct EncoderMessage
+{
+  orion::CommandHeader header =
+  {
+    .frame = { .crc = 0 },
+    .common = { .message_id = 5, .version = 1, .oldest_compatible_version = 1,
+      .sequence_id = ORION_UNSOLICITED_SEQUENCE_ID }
+  };
+  int32_t ticks = 0;
+};
+
 #pragma pack(pop)
 
 MOCK_GLOBAL_FUNC1(orion_communication_new, orion_communication_error_t(orion_communication_t ** me));
@@ -79,11 +133,33 @@ MOCK_GLOBAL_FUNC1(orion_transport_delete, orion_transport_error_t(const orion_tr
 class MockTransport: public orion::Transport
 {
 public:
-  explicit MockTransport(orion::Communication * communication) : orion::Transport(communication) {}
+  explicit MockTransport(orion::Communication * communication) : orion::Transport(communication)
+  {
+    // Major sizes its result buffer by frame size of transport
+    ON_CALL(*this, getFrameSize()).WillByDefault(Return(ORION_TRANSPORT_DEFAULT_FRAME_SIZE));
+  }
 
   MOCK_METHOD3(sendPacket, orion_transport_error_t(uint8_t *input_buffer, uint32_t input_size, uint32_t timeout));
+  MOCK_METHOD3(sendPackets, orion_transport_error_t(orion_transport_packet_t *packets, uint32_t count,
+    uint32_t timeout));
+  MOCK_METHOD5(sendPart, ssize_t(uint8_t *input_buffer, uint32_t input_size, uint32_t offset, uint32_t max_size,
+    uint32_t timeout));
+  MOCK_METHOD4(encodePacket, ssize_t(uint8_t *input_buffer, uint32_t input_size, uint8_t *frame,
+    uint32_t frame_size));
+  MOCK_METHOD3(sendFrame, orion_transport_error_t(uint8_t *frame, uint32_t size, uint32_t timeout));
   MOCK_METHOD3(receivePacket, ssize_t(uint8_t *output_buffer, uint32_t output_size, uint32_t timeout));
   MOCK_METHOD0(hasReceivedPacket, bool());
+  MOCK_METHOD1(setContainers, orion_transport_error_t(bool enabled));
+  MOCK_METHOD1(setFragments, orion_transport_error_t(bool enabled));
+  MOCK_METHOD2(setReassemblyBuffer, orion_transport_error_t(uint8_t *buffer, uint32_t size));
+  MOCK_METHOD2(setCompressionBuffer, orion_transport_error_t(uint8_t *buffer, uint32_t size));
+  MOCK_METHOD0(getFrameSize, uint32_t());
+  MOCK_METHOD1(setLink, orion_transport_error_t(const orion_transport_link_t &link));
+  MOCK_METHOD0(getLink, orion_transport_link_t());
+  MOCK_METHOD1(setOverflowPolicy, orion_transport_error_t(orion_transport_overflow_policy_t policy));
+  MOCK_METHOD0(getOverflowCounters, orion_transport_overflow_counters_t());
+  MOCK_METHOD0(getStatistics, orion_transport_statistics_t());
+  MOCK_METHOD0(getObject, orion_transport_t*());
 };
 
 TEST(TestSuite, sendPacketTimeoutExpiredException)
@@ -111,6 +187,13 @@ TEST(TestSuite, sendPacketTimeoutExpiredException)
 
   orion_major_error_t status = main.invoke(command, &result, retry_timeout, retry_count);
   EXPECT_EQ(ORION_MAJOR_ERROR_TIMEOUT, status);
+
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(1, statistics.invocations);
+  EXPECT_EQ(2, statistics.retries);
+  EXPECT_EQ(3, statistics.send_errors);
+  EXPECT_EQ(1, statistics.timeouts);
+  EXPECT_EQ(0, statistics.successes);
 }
 
 TEST(TestSuite, happyPath)
@@ -145,6 +228,12 @@ TEST(TestSuite, happyPath)
   EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Invoke(mock_receive_packet));
 
   main.invoke(command, &result, retry_timeout, retry_count);
+
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(1, statistics.invocations);
+  EXPECT_EQ(1, statistics.successes);
+  EXPECT_EQ(0, statistics.retries);
+  EXPECT_EQ(0, statistics.timeouts);
 }
 
 TEST(TestSuite, incompatibleVersion)
@@ -182,6 +271,7 @@ TEST(TestSuite, incompatibleVersion)
   EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Invoke(mock_receive_packet));
   orion_major_error_t status = main.invoke(command, &result, retry_timeout, retry_count);
   EXPECT_EQ(ORION_MAJOR_ERROR_NOT_COMPATIBLE_PACKET_VERSION, status);
+  EXPECT_EQ(1, main.getStatistics().validation_errors);
 }
 
 TEST(TestSuite, errorInReply)
@@ -216,11 +306,1809 @@ TEST(TestSuite, errorInReply)
   EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Invoke(mock_receive_packet));
   orion_major_error_t status = main.invoke(command, &result, retry_timeout, retry_count);
   EXPECT_EQ(ORION_MAJOR_ERROR_APPLICATION_ERROR_RECEIVED, status);
+  EXPECT_EQ(1, main.getStatistics().application_errors);
 
   // TODO(Andriy): How to pass error code?
   // EXPECT_EQ(12, result.header.error_code);
 }
 
+TEST(TestSuite, staleResultBeforeReply)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  HandshakeCommand command;
+  HandshakeResult result;
+
+  uint8_t retry_count = 1;
+  uint32_t retry_timeout = orion::Major::Interval::Second * 2;
+
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  // Waiting relies on blocking receive only, there is no polling of transport
+  EXPECT_CALL(mock_transport, hasReceivedPacket()).Times(0);
+  auto mock_receive_packet = [](uint16_t sequence_id)
+    {
+      return [sequence_id](uint8_t *output_buffer, uint32_t, uint32_t)
+        {
+          size_t size = sizeof(HandshakeResult);
+          HandshakeResult reply_result;
+          reply_result.header.common.sequence_id = sequence_id;
+          std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), size);
+          return size;
+        };
+    };
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillOnce(Invoke(mock_receive_packet(7))).
+    WillOnce(Return(ORION_TRAN_ERROR_CRC_CHECK_FAILED)).
+    WillOnce(Invoke(mock_receive_packet(1)));
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result, retry_timeout, retry_count));
+  EXPECT_EQ(1, main.getStatistics().foreign_packets);
+}
+
+TEST(TestSuite, instrumentation)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Instrumentation instrumentation;
+  orion::Major main(&mock_transport);
+  main.setInstrumentation(&instrumentation);
+
+  HandshakeCommand command;
+  HandshakeResult result;
+
+  uint8_t retry_count = 3;
+  uint32_t retry_timeout = orion::Major::Interval::Microsecond * 400;
+
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Return(
+    ORION_TRAN_ERROR_TIMEOUT)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_CALL(mock_transport, hasReceivedPacket()).Times(0);
+  auto mock_receive_packet = [](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      size_t size = sizeof(HandshakeResult);
+      HandshakeResult reply_result;
+      reply_result.header.common.sequence_id = 2;
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), size);
+      return size;
+    };
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).WillOnce(Invoke(mock_receive_packet));
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result, retry_timeout, retry_count));
+
+  const orion::Instrumentation::Message *message = instrumentation.getMessage(command.header.common.message_id);
+  ASSERT_NE(nullptr, message);
+  EXPECT_EQ(1, message->latency.getCount());
+  EXPECT_EQ(1, message->attempts[1]);
+  EXPECT_EQ(1, message->outcomes[ORION_MAJOR_ERROR_NONE]);
+}
+
+TEST(TestSuite, adaptiveTimeout)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  uint32_t min_timeout = orion::Major::Interval::Millisecond;
+  uint32_t max_timeout = orion::Major::Interval::Millisecond * 50;
+  orion::Major main(&mock_transport, orion::Major::Interval::Millisecond * 100, 3);
+  orion::RttStatistics rtt;
+  EXPECT_FALSE(main.getRttStatistics(&rtt));
+  main.setAdaptiveTimeout(min_timeout, max_timeout, true);
+
+  // Replies instantly unless told to lose the next result
+  uint16_t sequence_id = 0;
+  bool lose_result = false;
+  std::vector<uint32_t> timeouts;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t timeout)
+    {
+      sequence_id = reinterpret_cast<orion::CommandHeader*>(input_buffer)->common.sequence_id;
+      timeouts.push_back(timeout);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t timeout) -> ssize_t
+    {
+      if (lose_result)
+      {
+        lose_result = false;
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout));
+        return (-1);
+      }
+      HandshakeResult reply_result;
+      reply_result.header.common.sequence_id = sequence_id;
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(reply_result));
+      return (sizeof(reply_result));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  HandshakeCommand command;
+  HandshakeResult result;
+
+  // Default timeout is clamped till the first round trip is measured
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result));
+  EXPECT_EQ(max_timeout, timeouts.back());
+  for (int i = 0; i < 9; i++)
+  {
+    EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result));
+  }
+  ASSERT_TRUE(main.getRttStatistics(&rtt));
+  EXPECT_EQ(10, rtt.samples);
+  EXPECT_LT(rtt.srtt, min_timeout);
+  EXPECT_EQ(min_timeout, rtt.timeout);
+  EXPECT_EQ(min_timeout, timeouts.back());
+
+  ASSERT_TRUE(main.getRttStatistics(command.header.common.message_id, &rtt));
+  EXPECT_EQ(10, rtt.samples);
+  EXPECT_FALSE(main.getRttStatistics(3, &rtt));
+
+  // Lost result costs only estimated timeout, retry backs off and is not sampled
+  timeouts.clear();
+  lose_result = true;
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result));
+  ASSERT_EQ(2, timeouts.size());
+  EXPECT_EQ(min_timeout, timeouts[0]);
+  EXPECT_EQ(min_timeout * 2, timeouts[1]);
+  ASSERT_TRUE(main.getRttStatistics(&rtt));
+  EXPECT_EQ(10, rtt.samples);
+
+  // Explicit timeout is kept as is
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result, orion::Major::Interval::Millisecond * 7));
+  EXPECT_EQ(orion::Major::Interval::Millisecond * 7, timeouts.back());
+  ASSERT_TRUE(main.getRttStatistics(&rtt));
+  EXPECT_EQ(11, rtt.samples);
+}
+
+TEST(TestSuite, payloadInvoke)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  // Command carries three joint positions and result echoes them back after its header
+  const uint32_t JOINT_COUNT = 3;
+  std::vector<uint8_t> command_data(sizeof(StatusCommand) + JOINT_COUNT * sizeof(int32_t), 0);
+  StatusCommand header;
+  std::memcpy(command_data.data(), &header, sizeof(header));
+  for (uint32_t index = 0; index < JOINT_COUNT; index++)
+  {
+    int32_t position = 100 * (index + 1);
+    std::memcpy(command_data.data() + sizeof(header) + index * sizeof(position), &position, sizeof(position));
+  }
+
+  std::vector<uint8_t> reply;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      StatusResult result_header;
+      const orion::CommandHeader *command_header = reinterpret_cast<orion::CommandHeader*>(input_buffer);
+      result_header.header.common.sequence_id = command_header->common.sequence_id;
+      reply.assign(reinterpret_cast<uint8_t*>(&result_header.header),
+        reinterpret_cast<uint8_t*>(&result_header.header) + sizeof(result_header.header));
+      reply.insert(reply.end(), input_buffer + sizeof(StatusCommand), input_buffer + input_size);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      std::memcpy(output_buffer, reply.data(), reply.size());
+      return static_cast<ssize_t>(reply.size());
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Eq(command_data.size()), _)).Times(2).WillRepeatedly(
+    Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).Times(2).WillRepeatedly(
+    Invoke(mock_receive_packet));
+
+  std::vector<uint8_t> result_data(64, 0);
+  StatusResult expected;
+  std::memcpy(result_data.data(), &expected.header, sizeof(expected.header));
+  orion::Major::Payload command = { command_data.data(), static_cast<uint32_t>(command_data.size()) };
+  orion::Major::Payload result = { result_data.data(), static_cast<uint32_t>(result_data.size()) };
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result));
+  ASSERT_EQ(sizeof(orion::ResultHeader) + JOINT_COUNT * sizeof(int32_t), result.size);
+  int32_t last_position = 0;
+  std::memcpy(&last_position, result_data.data() + sizeof(orion::ResultHeader) + 2 * sizeof(int32_t),
+    sizeof(last_position));
+  EXPECT_EQ(300, last_position);
+
+  // Result bigger than buffer of caller is rejected
+  std::memcpy(result_data.data(), &expected.header, sizeof(expected.header));
+  result.size = sizeof(orion::ResultHeader) + sizeof(int32_t);
+  ASSERT_EQ(ORION_MAJOR_ERROR_RESULT_TOO_BIG, main.invoke(command, &result));
+  EXPECT_EQ(1, main.getStatistics().validation_errors);
+}
+
+TEST(TestSuite, concurrentInvokes)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  const size_t threads_count = 4;
+  const size_t invokes_count = 50;
+  uint32_t retry_timeout = orion::Major::Interval::Second * 2;
+
+  // Minor replies to pending commands newest first, so results arrive out of order
+  std::mutex pending_mutex;
+  std::deque<uint16_t> pending;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex);
+      pending.push_back(reinterpret_cast<HandshakeCommand*>(input_buffer)->header.common.sequence_id);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      HandshakeResult reply_result;
+      {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (pending.empty())
+        {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+          return static_cast<ssize_t>(ORION_TRAN_ERROR_TIMEOUT);
+        }
+        reply_result.header.common.sequence_id = pending.back();
+        pending.pop_back();
+      }
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(HandshakeResult));
+      return static_cast<ssize_t>(sizeof(HandshakeResult));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_receive_packet));
+
+  std::vector<std::thread> threads;
+  std::vector<size_t> succeeded(threads_count, 0);
+  for (size_t thread_index = 0; thread_index < threads_count; thread_index++)
+  {
+    threads.emplace_back([&, thread_index]()
+      {
+        for (size_t index = 0; index < invokes_count; index++)
+        {
+          HandshakeCommand command;
+          HandshakeResult result;
+          if (ORION_MAJOR_ERROR_NONE == main.invoke(command, &result, retry_timeout, 1))
+          {
+            succeeded[thread_index]++;
+          }
+        }
+      });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  for (size_t thread_index = 0; thread_index < threads_count; thread_index++)
+  {
+    EXPECT_EQ(invokes_count, succeeded[thread_index]);
+  }
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(threads_count * invokes_count, statistics.invocations);
+  EXPECT_EQ(threads_count * invokes_count, statistics.successes);
+  EXPECT_EQ(0, statistics.foreign_packets);
+}
+
+TEST(TestSuite, readerTimeoutWakesOtherCaller)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  // Only status command gets a reply, 100 ms after start. Handshake caller reads transport first and times out.
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point reply_time = start_time + std::chrono::milliseconds(100);
+  std::mutex pending_mutex;
+  bool status_pending = false;
+  uint16_t status_sequence_id = 0;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      const orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(input_buffer);
+      if (3 == header->common.message_id)
+      {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        status_pending = true;
+        status_sequence_id = header->common.sequence_id;
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t timeout)
+    {
+      std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+        std::chrono::microseconds(timeout);
+      while (std::chrono::steady_clock::now() < deadline)
+      {
+        {
+          std::lock_guard<std::mutex> lock(pending_mutex);
+          if (status_pending && (std::chrono::steady_clock::now() >= reply_time))
+          {
+            StatusResult reply_result;
+            reply_result.header.common.sequence_id = status_sequence_id;
+            status_pending = false;
+            std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(StatusResult));
+            return static_cast<ssize_t>(sizeof(StatusResult));
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      return static_cast<ssize_t>(ORION_TRAN_ERROR_TIMEOUT);
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  orion_major_error_t handshake_status = ORION_MAJOR_ERROR_NONE;
+  std::thread first([&]()
+    {
+      HandshakeCommand command;
+      HandshakeResult result;
+      handshake_status = main.invoke(command, &result, 50 * orion::Major::Interval::Millisecond, 1);
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  StatusCommand command;
+  StatusResult result;
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result, orion::Major::Interval::Second, 1));
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start_time;
+  first.join();
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_TIMEOUT, handshake_status);
+  // Second caller is woken up when first one gives up reading, not when its own timeout runs out
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 500);
+}
+
+/*
+  Fake link answering every command after a fixed round trip, commands in flight are answered in parallel
+*/
+class RoundTripLink
+{
+public:
+  explicit RoundTripLink(uint32_t round_trip) : round_trip_(round_trip) {}
+
+  orion_transport_error_t send(uint8_t *input_buffer)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->pending_.emplace(std::chrono::steady_clock::now() + std::chrono::microseconds(this->round_trip_),
+      reinterpret_cast<HandshakeCommand*>(input_buffer)->header.common.sequence_id);
+    return (ORION_TRAN_ERROR_NONE);
+  }
+
+  ssize_t receive(uint8_t *output_buffer, uint32_t timeout)
+  {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+      std::chrono::microseconds(timeout);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (!this->pending_.empty() && (this->pending_.begin()->first <= std::chrono::steady_clock::now()))
+        {
+          HandshakeResult reply_result;
+          reply_result.header.common.sequence_id = this->pending_.begin()->second;
+          this->pending_.erase(this->pending_.begin());
+          std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(HandshakeResult));
+          return (sizeof(HandshakeResult));
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return (ORION_TRAN_ERROR_TIMEOUT);
+  }
+
+private:
+  uint32_t round_trip_;
+  std::mutex mutex_;
+  std::multimap<std::chrono::steady_clock::time_point, uint16_t> pending_;  // by reply time
+};
+
+/*
+  Runs invokes from a number of threads, returns invokes completed per second
+*/
+double measure_invoke_rate(orion::Major *major, size_t threads_count, size_t invokes_count)
+{
+  std::vector<std::thread> threads;
+  std::vector<size_t> succeeded(threads_count, 0);
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  for (size_t thread_index = 0; thread_index < threads_count; thread_index++)
+  {
+    threads.emplace_back([&, thread_index]()
+      {
+        for (size_t index = 0; index < invokes_count; index++)
+        {
+          HandshakeCommand command;
+          HandshakeResult result;
+          if (ORION_MAJOR_ERROR_NONE == major->invoke(command, &result, orion::Major::Interval::Second, 1))
+          {
+            succeeded[thread_index]++;
+          }
+        }
+      });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+  double duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+    start_time).count();
+  for (size_t thread_index = 0; thread_index < threads_count; thread_index++)
+  {
+    EXPECT_EQ(invokes_count, succeeded[thread_index]);
+  }
+  return (threads_count * invokes_count * 1000000.0 / duration);
+}
+
+TEST(TestSuite, concurrentThroughputBenchmark)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  // 2 ms round trip, as with USB serial adapter polling every millisecond
+  RoundTripLink link(2 * orion::Major::Interval::Millisecond);
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(
+    [&](uint8_t *input_buffer, uint32_t, uint32_t) { return link.send(input_buffer); }));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(
+    [&](uint8_t *output_buffer, uint32_t, uint32_t timeout) { return link.receive(output_buffer, timeout); }));
+
+  const size_t invokes_count = 200;
+  double single_rate = measure_invoke_rate(&main, 1, invokes_count);
+  std::printf("1 caller: %.0f invokes/s\n", single_rate);
+  // Callers wait for their round trips at the same time, speedup depends on load of the machine though,
+  // so it is only printed, while concurrentInvokes checks the results
+  for (size_t threads_count : {2, 4, 8})
+  {
+    double rate = measure_invoke_rate(&main, threads_count, invokes_count);
+    std::printf("%zu callers: %.0f invokes/s, %.1fx\n", threads_count, rate, rate / single_rate);
+  }
+}
+
+TEST(TestSuite, batchInvoke)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  HandshakeCommand handshake_command;
+  HandshakeResult handshake_result;
+  StatusCommand status_command;
+  StatusResult status_result;
+  HandshakeCommand lost_command;
+  HandshakeResult lost_result;
+
+  orion::Major::Batch batch;
+  ASSERT_EQ(0, batch.add(&handshake_command, &handshake_result));
+  ASSERT_EQ(1, batch.add(&status_command, &status_result));
+  ASSERT_EQ(2, batch.add(&lost_command, &lost_result));
+
+  uint8_t retry_count = 2;
+  uint32_t retry_timeout = orion::Major::Interval::Millisecond * 20;
+
+  // Replies arrive in reverse order and the last command is lost, so only it is sent again
+  std::vector<std::vector<uint8_t>> replies;
+  auto mock_send_packets = [&](orion_transport_packet_t *packets, uint32_t count, uint32_t)
+    {
+      for (uint32_t index = 0; index < count; index++)
+      {
+        orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(packets[index].buffer);
+        if (3 == header->common.message_id)
+        {
+          StatusResult reply;
+          reply.header.common.sequence_id = header->common.sequence_id;
+          reply.uptime = 42;
+          const uint8_t *data = reinterpret_cast<const uint8_t*>(&reply);
+          replies.insert(replies.begin(), std::vector<uint8_t>(data, data + sizeof(reply)));
+        }
+        else if ((&lost_command != reinterpret_cast<HandshakeCommand*>(header)) || (1 == count))
+        {
+          HandshakeResult reply;
+          reply.header.common.sequence_id = header->common.sequence_id;
+          const uint8_t *data = reinterpret_cast<const uint8_t*>(&reply);
+          replies.insert(replies.begin(), std::vector<uint8_t>(data, data + sizeof(reply)));
+        }
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      if (replies.empty())
+      {
+        return static_cast<ssize_t>(ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::vector<uint8_t> reply = replies.front();
+      replies.erase(replies.begin());
+      std::memcpy(output_buffer, reply.data(), reply.size());
+      return static_cast<ssize_t>(reply.size());
+    };
+  EXPECT_CALL(mock_transport, sendPacket(_, _, _)).Times(0);
+  EXPECT_CALL(mock_transport, sendPackets(NotNull(), Eq(3), Le(retry_timeout))).WillOnce(Invoke(mock_send_packets));
+  EXPECT_CALL(mock_transport, sendPackets(NotNull(), Eq(1), Le(retry_timeout))).WillOnce(Invoke(mock_send_packets));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_receive_packet));
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(&batch, retry_timeout, retry_count));
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, batch.getStatus(0));
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, batch.getStatus(1));
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, batch.getStatus(2));
+  EXPECT_EQ(42, status_result.uptime);
+  EXPECT_EQ(status_command.header.common.sequence_id, status_result.header.common.sequence_id);
+  EXPECT_EQ(lost_command.header.common.sequence_id, lost_result.header.common.sequence_id);
+
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(3, statistics.invocations);
+  EXPECT_EQ(3, statistics.successes);
+  EXPECT_EQ(1, statistics.retries);
+  EXPECT_EQ(0, statistics.timeouts);
+}
+
+TEST(TestSuite, asyncInvoke)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  uint32_t retry_timeout = orion::Major::Interval::Millisecond * 5;
+  orion::Major main(&mock_transport, retry_timeout, 2);
+
+  // Status command is sent twice as its first result is lost, handshake is answered at once
+  uint32_t status_sends = 0;
+  std::deque<std::vector<uint8_t>> replies;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(input_buffer);
+      if (3 == header->common.message_id)
+      {
+        status_sends++;
+        if (1 == status_sends)
+        {
+          return ORION_TRAN_ERROR_NONE;
+        }
+        StatusResult reply;
+        reply.header.common.sequence_id = header->common.sequence_id;
+        reply.uptime = 42;
+        const uint8_t *data = reinterpret_cast<const uint8_t*>(&reply);
+        replies.push_back(std::vector<uint8_t>(data, data + sizeof(reply)));
+      }
+      else
+      {
+        HandshakeResult reply;
+        reply.header.common.sequence_id = header->common.sequence_id;
+        const uint8_t *data = reinterpret_cast<const uint8_t*>(&reply);
+        replies.push_back(std::vector<uint8_t>(data, data + sizeof(reply)));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t timeout) -> ssize_t
+    {
+      if (replies.empty())
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout));
+        return (ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::memcpy(output_buffer, replies.front().data(), replies.front().size());
+      ssize_t size = replies.front().size();
+      replies.pop_front();
+      return (size);
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), _, Le(retry_timeout))).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, hasReceivedPacket()).WillRepeatedly(Invoke([&]() { return !replies.empty(); }));
+
+  EXPECT_EQ(UINT32_MAX, main.getPollTimeout());
+
+  std::vector<orion_major_error_t> completed;
+  StatusCommand status_command;
+  StatusResult status_result;
+  main.invokeAsync(status_command, &status_result, [&](orion_major_error_t status)
+    {
+      completed.push_back(status);
+    });
+  HandshakeCommand handshake_command;
+  HandshakeResult handshake_result;
+  main.invokeAsync(handshake_command, &handshake_result, [&](orion_major_error_t status)
+    {
+      completed.push_back(status);
+    });
+  EXPECT_GE(retry_timeout, main.getPollTimeout());
+
+  // Handshake result is already waiting, so the first poll completes it without waiting
+  EXPECT_EQ(1, main.poll(retry_timeout));
+  ASSERT_EQ(1, completed.size());
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, completed[0]);
+  EXPECT_EQ(1, status_sends);
+
+  // Status command is resent when its deadline passes and completed by a later poll
+  size_t polls = 0;
+  while ((completed.size() < 2) && (polls < 10))
+  {
+    main.poll(main.getPollTimeout());
+    polls++;
+  }
+  ASSERT_EQ(2, completed.size());
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, completed[1]);
+  EXPECT_EQ(2, status_sends);
+  EXPECT_EQ(42, status_result.uptime);
+  EXPECT_EQ(UINT32_MAX, main.getPollTimeout());
+
+  // Command which is never answered completes with timeout once retries run out
+  status_sends = 0;
+  main.invokeAsync(status_command, &status_result, [&](orion_major_error_t status)
+    {
+      completed.push_back(status);
+    }, retry_timeout, 1);
+  EXPECT_EQ(0, main.poll(0));
+  std::this_thread::sleep_for(std::chrono::microseconds(retry_timeout));
+  EXPECT_EQ(1, main.poll(0));
+  ASSERT_EQ(3, completed.size());
+  EXPECT_EQ(ORION_MAJOR_ERROR_TIMEOUT, completed[2]);
+
+  // Blocking invoke keeps working alongside
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(handshake_command, &handshake_result));
+
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(4, statistics.invocations);
+  EXPECT_EQ(3, statistics.successes);
+  EXPECT_EQ(1, statistics.retries);
+  EXPECT_EQ(1, statistics.timeouts);
+}
+
+TEST(TestSuite, periodicScheduler)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  std::vector<uint32_t> writes;
+  std::deque<std::vector<uint8_t>> replies;
+  auto mock_send_packets = [&](orion_transport_packet_t *packets, uint32_t count, uint32_t)
+    {
+      writes.push_back(count);
+      for (uint32_t index = 0; index < count; index++)
+      {
+        orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(packets[index].buffer);
+        std::vector<uint8_t> reply;
+        if (3 == header->common.message_id)
+        {
+          StatusResult status_result;
+          status_result.header.common.sequence_id = header->common.sequence_id;
+          status_result.uptime = 42;
+          const uint8_t *data = reinterpret_cast<const uint8_t*>(&status_result);
+          reply.assign(data, data + sizeof(status_result));
+        }
+        else
+        {
+          HandshakeResult handshake_result;
+          handshake_result.header.common.sequence_id = header->common.sequence_id;
+          const uint8_t *data = reinterpret_cast<const uint8_t*>(&handshake_result);
+          reply.assign(data, data + sizeof(handshake_result));
+        }
+        replies.push_back(reply);
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      if (replies.empty())
+      {
+        return (ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::memcpy(output_buffer, replies.front().data(), replies.front().size());
+      ssize_t size = replies.front().size();
+      replies.pop_front();
+      return (size);
+    };
+  EXPECT_CALL(mock_transport, sendPacket(_, _, _)).Times(0);
+  EXPECT_CALL(mock_transport, sendPackets(NotNull(), _, _)).WillRepeatedly(Invoke(mock_send_packets));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  uint32_t tick = orion::Major::Interval::Millisecond;
+  orion::Scheduler scheduler(&main, tick, tick, 1);
+
+  uint32_t completed = 0;
+  auto callback = [&](orion_major_error_t status)
+    {
+      EXPECT_EQ(ORION_MAJOR_ERROR_NONE, status);
+      completed++;
+    };
+  StatusCommand fast_command;
+  StatusResult fast_result;
+  StatusCommand slow_command;
+  StatusResult slow_result;
+  HandshakeCommand handshake_command;
+  HandshakeResult handshake_result;
+  scheduler.add(&fast_command, &fast_result, 2 * tick, 0, callback);
+  scheduler.add(&slow_command, &slow_result, 4 * tick, 0, callback);
+
+  // Ticks 0 and 2 are taken, so handshake goes to the first idle one
+  size_t handshake = scheduler.add(&handshake_command, &handshake_result, 4 * tick, callback);
+  EXPECT_EQ(tick, scheduler.getPhase(handshake));
+
+  // Ticks 0 to 4 carry both status commands in one write, handshake, fast status and both again
+  EXPECT_EQ(2, scheduler.spinOnce());
+  EXPECT_EQ(1, scheduler.spinOnce());
+  EXPECT_EQ(1, scheduler.spinOnce());
+  EXPECT_EQ(2, scheduler.spinOnce());
+  EXPECT_EQ(std::vector<uint32_t>({ 2, 1, 1, 2 }), writes);
+  EXPECT_EQ(6, completed);
+  EXPECT_EQ(42, fast_result.uptime);
+  EXPECT_EQ(42, slow_result.uptime);
+
+  orion::SchedulerStatistics statistics = scheduler.getStatistics();
+  EXPECT_EQ(4, statistics.cycles);
+  EXPECT_EQ(6, statistics.transactions);
+  EXPECT_EQ(0, statistics.failures);
+  EXPECT_EQ(4, scheduler.getJitter().getCount());
+
+  // Cycles missed while caller was away are dropped instead of sent in a burst
+  std::this_thread::sleep_for(std::chrono::microseconds(4 * tick + tick / 2));
+  writes.clear();
+  scheduler.spinOnce();
+  EXPECT_EQ(1, writes.size());
+  EXPECT_LE(2, scheduler.getStatistics().overruns);
+}
+
+TEST(TestSuite, urgentPreemptsBulk)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+  main.setPriority(2, orion::Major::Urgent);
+  main.setPriority(3, orion::Major::Bulk);
+
+  // Link could carry one status command per write
+  main.setMaxWriteTime(orion::Major::Interval::Millisecond, sizeof(StatusCommand) * 1000);
+
+  uint32_t retry_timeout = orion::Major::Interval::Second;
+  std::mutex writes_mutex;
+  std::vector<uint8_t> writes;
+  std::deque<std::vector<uint8_t>> replies;
+  std::thread urgent;
+  orion_major_error_t urgent_status = ORION_MAJOR_ERROR_UNKNOW;
+  auto reply_to = [&](const orion::CommandHeader *header)
+    {
+      std::lock_guard<std::mutex> lock(writes_mutex);
+      writes.push_back(header->common.message_id);
+      std::vector<uint8_t> reply(sizeof(StatusResult));
+      if (3 == header->common.message_id)
+      {
+        StatusResult status_result;
+        status_result.header.common.sequence_id = header->common.sequence_id;
+        std::memcpy(reply.data(), &status_result, sizeof(status_result));
+      }
+      else
+      {
+        HandshakeResult handshake_result;
+        handshake_result.header.common.sequence_id = header->common.sequence_id;
+        reply.resize(sizeof(handshake_result));
+        std::memcpy(reply.data(), &handshake_result, sizeof(handshake_result));
+      }
+      replies.push_back(reply);
+    };
+  auto mock_send_packets = [&](orion_transport_packet_t *packets, uint32_t count, uint32_t)
+    {
+      EXPECT_EQ(1, count);
+      reply_to(reinterpret_cast<orion::CommandHeader*>(packets[0].buffer));
+      if (!urgent.joinable())
+      {
+        // Emergency command arrives while the first part of bulk transfer is being written
+        urgent = std::thread([&]()
+          {
+            HandshakeCommand command;
+            HandshakeResult result;
+            urgent_status = main.invoke(command, &result, retry_timeout);
+          });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_send_part = [&](uint8_t *input_buffer, uint32_t input_size, uint32_t offset, uint32_t max_size,
+    uint32_t) -> ssize_t
+    {
+      uint32_t next_offset = std::min(input_size, offset + max_size);
+      const orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(input_buffer);
+      if (next_offset < input_size)
+      {
+        std::lock_guard<std::mutex> lock(writes_mutex);
+        writes.push_back(header->common.message_id);
+      }
+      else
+      {
+        reply_to(header);
+      }
+      if (!urgent.joinable())
+      {
+        // Emergency command arrives while the first part of large command is being written
+        urgent = std::thread([&]()
+          {
+            HandshakeCommand command;
+            HandshakeResult result;
+            urgent_status = main.invoke(command, &result, retry_timeout);
+          });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      }
+      return (next_offset);
+    };
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      reply_to(reinterpret_cast<orion::CommandHeader*>(input_buffer));
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      std::lock_guard<std::mutex> lock(writes_mutex);
+      if (replies.empty())
+      {
+        return (ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::memcpy(output_buffer, replies.front().data(), replies.front().size());
+      ssize_t size = replies.front().size();
+      replies.pop_front();
+      return (size);
+    };
+  EXPECT_CALL(mock_transport, sendPackets(NotNull(), _, Le(retry_timeout))).Times(3).
+    WillRepeatedly(Invoke(mock_send_packets));
+  EXPECT_CALL(mock_transport, sendPart(NotNull(), Eq(sizeof(LargeCommand)), _, Eq(sizeof(StatusCommand)),
+    Le(retry_timeout))).Times(4).WillRepeatedly(Invoke(mock_send_part));
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Eq(sizeof(HandshakeCommand)), Le(retry_timeout))).Times(2).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  StatusCommand commands[3];
+  StatusResult results[3];
+  orion::Major::Batch batch;
+  for (size_t index = 0; index < 3; index++)
+  {
+    batch.add(&(commands[index]), &(results[index]));
+  }
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(&batch, retry_timeout, 1));
+  urgent.join();
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, urgent_status);
+  EXPECT_EQ(std::vector<uint8_t>({ 3, 2, 3, 3 }), writes);
+
+  // Single command bigger than a write goes in parts of its fragments, urgent command gets the link between them
+  writes.clear();
+  urgent_status = ORION_MAJOR_ERROR_UNKNOW;
+  LargeCommand large_command;
+  StatusResult large_result;
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(large_command, &large_result, retry_timeout, 1));
+  urgent.join();
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, urgent_status);
+  EXPECT_EQ(std::vector<uint8_t>({ 3, 2, 3, 3, 3 }), writes);
+}
+
+TEST(TestSuite, handshakeEnablesContainers)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  uint32_t requested = 0;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      const orion_control_handshake_command_t *command =
+        reinterpret_cast<const orion_control_handshake_command_t*>(input_buffer);
+      EXPECT_EQ(ORION_CONTROL_MESSAGE_ID_HANDSHAKE, command->header.common.message_id);
+      requested = command->capabilities;
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      orion_control_handshake_result_t reply_result;
+      std::memset(&reply_result, 0, sizeof(reply_result));
+      reply_result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+      reply_result.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply_result.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply_result.header.common.sequence_id = 1;
+      reply_result.capabilities = requested;
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(reply_result));
+      return static_cast<ssize_t>(sizeof(reply_result));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Eq(sizeof(orion_control_handshake_command_t)), _)).
+    WillOnce(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillOnce(Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, setContainers(true)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_CALL(mock_transport, getFrameSize()).WillOnce(Return(512));
+  EXPECT_CALL(mock_transport, setLink(_)).Times(2).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake());
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_CONTAINER, requested);
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_CONTAINER, main.getCapabilities());
+  // Link is not negotiated, transport keeps its defaults
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_CONTAINER, main.getLink().capabilities);
+  EXPECT_EQ(512, main.getLink().frame_size);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, main.getLink().checksum);
+}
+
+TEST(TestSuite, handshakeSizesCompressionBuffer)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      orion_control_handshake_result_t reply;
+      std::memset(&reply, 0, sizeof(reply));
+      reply.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+      reply.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply.header.common.sequence_id = 1;
+      reply.capabilities = ORION_CONTROL_CAPABILITY_COMPRESSION;
+      std::memcpy(output_buffer, &reply, sizeof(reply));
+      return static_cast<ssize_t>(sizeof(reply));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillOnce(Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, getFrameSize()).WillRepeatedly(Return(256));
+  EXPECT_CALL(mock_transport, setLink(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  // Buffer holds a frame of transport, not the largest frame any transport could have
+  EXPECT_CALL(mock_transport, setCompressionBuffer(NotNull(), Eq(ORION_TRANSPORT_COMPRESSION_BUFFER_SIZE(256, 12)))).
+    WillOnce(Return(ORION_TRAN_ERROR_NONE));
+
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake(ORION_CONTROL_CAPABILITY_COMPRESSION));
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_COMPRESSION, main.getCapabilities());
+}
+
+TEST(TestSuite, resultBufferTakesFrameSize)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  EXPECT_CALL(mock_transport, getFrameSize()).WillRepeatedly(Return(1024));
+  orion::Major main(&mock_transport);
+  orion::Major configured(&mock_transport, 100, 1);
+
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Eq(1024), _)).Times(2).
+    WillRepeatedly(Return(ORION_TRAN_ERROR_TIMEOUT));
+  EXPECT_FALSE(main.spinOnce(100));
+  EXPECT_FALSE(configured.spinOnce(100));
+}
+
+TEST(TestSuite, handshakeNegotiatesLink)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+  main.setLinkLimits(921600, ORION_CONTROL_CHECKSUM_FLETCHER16);
+
+  orion_control_link_command_t offer;
+  std::memset(&offer, 0, sizeof(offer));
+  orion_control_link_result_t answer;
+  std::memset(&answer, 0, sizeof(answer));
+  answer.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+  answer.header.common.version = ORION_CONTROL_LINK_VERSION;
+  answer.header.common.oldest_compatible_version = ORION_CONTROL_LINK_VERSION;
+  answer.frame_size = 256;
+  answer.baud = 460800;
+  answer.window = 8;
+  answer.checksum = ORION_CONTROL_CHECKSUM_FLETCHER16;
+
+  orion::CommandHeader sent;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      std::memcpy(&sent, input_buffer, sizeof(sent));
+      if (ORION_CONTROL_MESSAGE_ID_LINK == sent.common.message_id)
+      {
+        std::memcpy(&offer, input_buffer, sizeof(offer));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      if (ORION_CONTROL_MESSAGE_ID_LINK == sent.common.message_id)
+      {
+        answer.header.common.sequence_id = sent.common.sequence_id;
+        std::memcpy(output_buffer, &answer, sizeof(answer));
+        return (sizeof(answer));
+      }
+      orion_control_handshake_result_t reply;
+      std::memset(&reply, 0, sizeof(reply));
+      reply.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+      reply.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+      reply.header.common.sequence_id = sent.common.sequence_id;
+      reply.capabilities = ORION_CONTROL_CAPABILITY_LINK;
+      std::memcpy(output_buffer, &reply, sizeof(reply));
+      return (sizeof(reply));
+    };
+  std::vector<orion_transport_link_t> links;
+  auto mock_set_link = [&](const orion_transport_link_t &link)
+    {
+      links.push_back(link);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).Times(4).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).Times(4).WillRepeatedly(
+    Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, getFrameSize()).Times(2).WillRepeatedly(Return(512));
+  EXPECT_CALL(mock_transport, setLink(_)).Times(4).WillRepeatedly(Invoke(mock_set_link));
+
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake(ORION_CONTROL_CAPABILITY_LINK));
+  EXPECT_EQ(512, offer.frame_size);
+  EXPECT_EQ(921600, offer.baud);
+  EXPECT_EQ(ORION_STREAM_MAX_WINDOW, offer.window);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16, offer.checksums);
+
+  // Negotiation starts from defaults, so that restarted Minor understands it, and ends with agreed settings
+  ASSERT_EQ(2, links.size());
+  EXPECT_EQ(0, links[0].capabilities);
+  EXPECT_EQ(512, links[0].frame_size);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, links[0].checksum);
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_LINK, links[1].capabilities);
+  EXPECT_EQ(256, links[1].frame_size);
+  EXPECT_EQ(460800, links[1].baud);
+  EXPECT_EQ(8, links[1].window);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_FLETCHER16, links[1].checksum);
+  EXPECT_EQ(256, main.getLink().frame_size);
+
+  // Settings Major did not offer are not taken
+  answer.frame_size = 4096;
+  answer.baud = 2000000;
+  answer.checksum = ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16;
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake(ORION_CONTROL_CAPABILITY_LINK));
+  ASSERT_EQ(4, links.size());
+  EXPECT_EQ(512, links[3].frame_size);
+  EXPECT_EQ(921600, links[3].baud);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, links[3].checksum);
+}
+
+TEST(TestSuite, rampBaudFallsBack)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport, 2 * orion::Major::Interval::Millisecond, 1);
+  main.setLinkLimits(921600, ORION_CONTROL_CHECKSUM_CRC16);
+
+  // Minor agrees to 921600, but cable loses most of frames above 460800
+  const uint32_t CABLE_BAUD = 460800;
+  uint32_t major_baud = 115200;
+  uint32_t minor_baud = 115200;
+  uint32_t previous_baud = 115200;
+  bool pending = false;
+  std::chrono::steady_clock::time_point fallback_time;
+  std::deque<std::vector<uint8_t>> replies;
+  auto reply = [&](const void *data, size_t size)
+    {
+      const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+      replies.push_back(std::vector<uint8_t>(bytes, bytes + size));
+    };
+  auto minor = [&](uint8_t *input_buffer, uint32_t index)
+    {
+      if (pending && (std::chrono::steady_clock::now() >= fallback_time))
+      {
+        pending = false;
+        minor_baud = previous_baud;
+      }
+      bool damaged = (major_baud > CABLE_BAUD) && (0 != index % 4);
+      if ((major_baud != minor_baud) || damaged)
+      {
+        return;
+      }
+      orion::CommandHeader *header = reinterpret_cast<orion::CommandHeader*>(input_buffer);
+      if (ORION_CONTROL_MESSAGE_ID_HANDSHAKE == header->common.message_id)
+      {
+        orion_control_handshake_result_t result;
+        std::memset(&result, 0, sizeof(result));
+        result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+        result.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+        result.header.common.sequence_id = header->common.sequence_id;
+        result.capabilities = ORION_CONTROL_CAPABILITY_LINK;
+        reply(&result, sizeof(result));
+      }
+      else if (ORION_CONTROL_MESSAGE_ID_LINK == header->common.message_id)
+      {
+        orion_control_link_result_t result;
+        std::memset(&result, 0, sizeof(result));
+        result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+        result.header.common.version = ORION_CONTROL_LINK_VERSION;
+        result.header.common.sequence_id = header->common.sequence_id;
+        result.frame_size = 512;
+        result.baud = 921600;
+        result.checksum = ORION_CONTROL_CHECKSUM_CRC16;
+        reply(&result, sizeof(result));
+      }
+      else if (ORION_CONTROL_MESSAGE_ID_BAUD == header->common.message_id)
+      {
+        orion_control_baud_command_t *command = reinterpret_cast<orion_control_baud_command_t*>(input_buffer);
+        orion_control_baud_result_t result;
+        std::memset(&result, 0, sizeof(result));
+        result.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+        result.header.common.version = ORION_CONTROL_BAUD_VERSION;
+        result.header.common.sequence_id = header->common.sequence_id;
+        result.step = command->step;
+        result.baud = (ORION_CONTROL_BAUD_SWITCH == command->step) ? command->baud : minor_baud;
+        std::memcpy(result.pattern, command->pattern, sizeof(result.pattern));
+        reply(&result, sizeof(result));
+        if (ORION_CONTROL_BAUD_SWITCH == command->step)
+        {
+          previous_baud = minor_baud;
+          minor_baud = command->baud;
+          pending = true;
+          fallback_time = std::chrono::steady_clock::now() + std::chrono::microseconds(command->timeout);
+        }
+        else if (ORION_CONTROL_BAUD_COMMIT == command->step)
+        {
+          pending = false;
+        }
+      }
+    };
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      minor(input_buffer, 0);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  uint32_t bursts = 0;
+  auto mock_send_packets = [&](orion_transport_packet_t *packets, uint32_t count, uint32_t)
+    {
+      bursts++;
+      for (uint32_t index = 0; index < count; index++)
+      {
+        minor(packets[index].buffer, index);
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      if (replies.empty())
+      {
+        return static_cast<ssize_t>(ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::vector<uint8_t> packet = replies.front();
+      replies.pop_front();
+      std::memcpy(output_buffer, packet.data(), packet.size());
+      return static_cast<ssize_t>(packet.size());
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, sendPackets(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packets));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, getFrameSize()).WillRepeatedly(Return(512));
+  EXPECT_CALL(mock_transport, setLink(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake(ORION_CONTROL_CAPABILITY_LINK));
+  std::vector<uint32_t> switches;
+  auto set_baud = [&](uint32_t baud)
+    {
+      switches.push_back(baud);
+      major_baud = baud;
+      return (true);
+    };
+
+  // The agreed rate loses three probes of four, so both return to 115200 and the next standard rate is kept
+  uint32_t baud = 115200;
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.rampBaud(set_baud, &baud));
+  EXPECT_EQ(460800, baud);
+  ASSERT_EQ(3, switches.size());
+  EXPECT_EQ(921600, switches[0]);
+  EXPECT_EQ(115200, switches[1]);
+  EXPECT_EQ(460800, switches[2]);
+  EXPECT_EQ(2, bursts);
+  EXPECT_EQ(460800, minor_baud);
+  EXPECT_FALSE(pending);
+
+  // Link already at the agreed rate has nothing faster to try
+  baud = 921600;
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.rampBaud(set_baud, &baud));
+  EXPECT_EQ(921600, baud);
+  EXPECT_EQ(3, switches.size());
+}
+
+TEST(TestSuite, retransmitReusesFrame)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport, orion::Major::Interval::Millisecond * 2, 3);
+
+  uint16_t handshake_sequence_id = 0;
+  auto mock_send_handshake = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      handshake_sequence_id = reinterpret_cast<orion::CommandHeader*>(input_buffer)->common.sequence_id;
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Eq(sizeof(orion_control_handshake_command_t)), _)).WillOnce(
+    Invoke(mock_send_handshake));
+  EXPECT_CALL(mock_transport, setContainers(false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+
+  // Frame is faked by a copy of packet, so that sequence id of every send could be checked
+  std::vector<uint16_t> sent_sequence_ids;
+  auto mock_encode_packet = [&](uint8_t *input_buffer, uint32_t input_size, uint8_t *frame, uint32_t)
+    {
+      std::memcpy(frame, input_buffer, input_size);
+      return static_cast<ssize_t>(input_size);
+    };
+  auto mock_send_frame = [&](uint8_t *frame, uint32_t, uint32_t)
+    {
+      sent_sequence_ids.push_back(reinterpret_cast<orion::CommandHeader*>(frame)->common.sequence_id);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_CALL(mock_transport, encodePacket(NotNull(), Eq(sizeof(StatusCommand)), NotNull(),
+    Gt(sizeof(StatusCommand)))).WillOnce(Invoke(mock_encode_packet));
+  EXPECT_CALL(mock_transport, sendFrame(NotNull(), Eq(sizeof(StatusCommand)), _)).Times(2).WillRepeatedly(
+    Invoke(mock_send_frame));
+
+  // Result of the first attempt is lost
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t timeout) -> ssize_t
+    {
+      if (0 == sent_sequence_ids.size())
+      {
+        orion_control_handshake_result_t reply;
+        std::memset(&reply, 0, sizeof(reply));
+        reply.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+        reply.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+        reply.header.common.oldest_compatible_version = ORION_CONTROL_HANDSHAKE_VERSION;
+        reply.header.common.sequence_id = handshake_sequence_id;
+        reply.capabilities = ORION_CONTROL_CAPABILITY_RESULT_CACHE;
+        std::memcpy(output_buffer, &reply, sizeof(reply));
+        return (sizeof(reply));
+      }
+      if (1 == sent_sequence_ids.size())
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout));
+        return (-1);
+      }
+      StatusResult reply;
+      reply.header.common.sequence_id = sent_sequence_ids.back();
+      reply.uptime = 42;
+      std::memcpy(output_buffer, &reply, sizeof(reply));
+      return (sizeof(reply));
+    };
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.handshake(ORION_CONTROL_CAPABILITY_RESULT_CACHE));
+  ASSERT_EQ(ORION_CONTROL_CAPABILITY_RESULT_CACHE, main.getCapabilities());
+
+  StatusCommand command;
+  StatusResult result;
+  ASSERT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result));
+  EXPECT_EQ(42, result.uptime);
+  ASSERT_EQ(2, sent_sequence_ids.size());
+  EXPECT_EQ(sent_sequence_ids[0], sent_sequence_ids[1]);
+  EXPECT_EQ(1, main.getStatistics().retries);
+}
+
+TEST(TestSuite, unsolicitedMessages)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  std::vector<int32_t> received_ticks;
+  main.setHandler<EncoderMessage>(5, [&](const EncoderMessage &message)
+    {
+      received_ticks.push_back(message.ticks);
+    });
+
+  HandshakeCommand command;
+  HandshakeResult result;
+  uint32_t retry_timeout = orion::Major::Interval::Second * 2;
+
+  auto mock_encoder_message = [](int32_t ticks, uint8_t message_id)
+    {
+      return [ticks, message_id](uint8_t *output_buffer, uint32_t, uint32_t)
+        {
+          EncoderMessage message;
+          message.header.common.message_id = message_id;
+          message.ticks = ticks;
+          std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&message), sizeof(message));
+          return static_cast<ssize_t>(sizeof(message));
+        };
+    };
+  auto mock_receive_result = [](uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      HandshakeResult reply_result;
+      reply_result.header.common.sequence_id = 1;
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(reply_result));
+      return static_cast<ssize_t>(sizeof(reply_result));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  // Telemetry arrives before the result, then while nobody invokes and finally without handler
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).
+    WillOnce(Invoke(mock_encoder_message(100, 5))).
+    WillOnce(Invoke(mock_receive_result)).
+    WillOnce(Invoke(mock_encoder_message(200, 5))).
+    WillOnce(Invoke(mock_encoder_message(300, 6))).
+    WillOnce(Return(ORION_TRAN_ERROR_TIMEOUT));
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.invoke(command, &result, retry_timeout, 1));
+  EXPECT_TRUE(main.spinOnce(retry_timeout));
+  EXPECT_TRUE(main.spinOnce(retry_timeout));
+  EXPECT_FALSE(main.spinOnce(retry_timeout));
+
+  ASSERT_EQ(2, received_ticks.size());
+  EXPECT_EQ(100, received_ticks[0]);
+  EXPECT_EQ(200, received_ticks[1]);
+
+  orion::MajorStatistics statistics = main.getStatistics();
+  EXPECT_EQ(2, statistics.unsolicited_messages);
+  EXPECT_EQ(1, statistics.unhandled_messages);
+  EXPECT_EQ(0, statistics.foreign_packets);
+  EXPECT_EQ(1, statistics.successes);
+}
+
+TEST(TestSuite, sendStream)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  std::vector<uint8_t> data(1000);
+  for (size_t index = 0; index < data.size(); index++)
+  {
+    data[index] = static_cast<uint8_t>(index);
+  }
+  std::vector<uint8_t> buffer(data.size());
+  orion_stream_receiver_t receiver;
+  orion_stream_receiver_init(&receiver, buffer.data(), buffer.size());
+
+  // Minor is emulated by receiver, which loses the third segment once and answers every other one
+  std::mutex acks_mutex;
+  std::deque<orion_control_stream_ack_t> acks;
+  uint32_t segments = 0;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      if (3 != ++segments)
+      {
+        orion_control_stream_ack_t ack;
+        if (orion_stream_receiver_on_segment(&receiver, input_buffer, input_size, &ack))
+        {
+          std::lock_guard<std::mutex> lock(acks_mutex);
+          acks.push_back(ack);
+        }
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      std::lock_guard<std::mutex> lock(acks_mutex);
+      if (acks.empty())
+      {
+        return (ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::memcpy(output_buffer, &(acks.front()), sizeof(orion_control_stream_ack_t));
+      acks.pop_front();
+      return (sizeof(orion_control_stream_ack_t));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Le(sizeof(orion_control_stream_segment_t) + 100), _)).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  EXPECT_EQ(ORION_MAJOR_ERROR_NONE, main.sendStream(data.data(), data.size(), 100, 4,
+    orion::Major::Interval::Second));
+  EXPECT_EQ(11, segments);
+  uint32_t size = 0;
+  ASSERT_TRUE(orion_stream_receiver_is_complete(&receiver, &size));
+  EXPECT_EQ(data.size(), size);
+  EXPECT_EQ(data, buffer);
+  EXPECT_EQ(0, main.getStatistics().unhandled_messages);
+}
+
+TEST(TestSuite, concurrentStreams)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Major main(&mock_transport);
+
+  const size_t streams_count = 2;
+  std::vector<std::vector<uint8_t>> data(streams_count, std::vector<uint8_t>(500));
+  for (size_t stream = 0; stream < streams_count; stream++)
+  {
+    for (size_t index = 0; index < data[stream].size(); index++)
+    {
+      data[stream][index] = static_cast<uint8_t>(index + stream * 100);
+    }
+  }
+
+  // Minor is emulated by a receiver per stream id, acknowledgments of both streams arrive interleaved
+  std::mutex acks_mutex;
+  std::deque<orion_control_stream_ack_t> acks;
+  std::map<uint16_t, std::vector<uint8_t>> buffers;
+  std::map<uint16_t, orion_stream_receiver_t> receivers;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      // Slow link keeps both streams in flight at once
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      std::lock_guard<std::mutex> lock(acks_mutex);
+      uint16_t stream_id = reinterpret_cast<orion_control_stream_segment_t*>(input_buffer)->stream_id;
+      if (0 == receivers.count(stream_id))
+      {
+        buffers[stream_id].resize(data[0].size());
+        orion_stream_receiver_init(&(receivers[stream_id]), buffers[stream_id].data(), buffers[stream_id].size());
+      }
+      orion_control_stream_ack_t ack;
+      if (orion_stream_receiver_on_segment(&(receivers[stream_id]), input_buffer, input_size, &ack))
+      {
+        acks.push_back(ack);
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      std::lock_guard<std::mutex> lock(acks_mutex);
+      if (acks.empty())
+      {
+        return (ORION_TRAN_ERROR_TIMEOUT);
+      }
+      std::memcpy(output_buffer, &(acks.front()), sizeof(orion_control_stream_ack_t));
+      acks.pop_front();
+      return (sizeof(orion_control_stream_ack_t));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Le(sizeof(orion_control_stream_segment_t) + 50), _)).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+
+  std::vector<orion_major_error_t> statuses(streams_count, ORION_MAJOR_ERROR_UNKNOW);
+  std::vector<std::thread> threads;
+  for (size_t stream = 0; stream < streams_count; stream++)
+  {
+    threads.emplace_back([&, stream]()
+      {
+        statuses[stream] = main.sendStream(data[stream].data(), data[stream].size(), 50, 2,
+          orion::Major::Interval::Second);
+      });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  for (size_t stream = 0; stream < streams_count; stream++)
+  {
+    EXPECT_EQ(ORION_MAJOR_ERROR_NONE, statuses[stream]);
+  }
+  ASSERT_EQ(streams_count, receivers.size());
+  for (std::map<uint16_t, orion_stream_receiver_t>::value_type &item : receivers)
+  {
+    uint32_t size = 0;
+    ASSERT_TRUE(orion_stream_receiver_is_complete(&(item.second), &size));
+    EXPECT_EQ(data[0].size(), size);
+    EXPECT_TRUE((data[0] == buffers[item.first]) || (data[1] == buffers[item.first]));
+  }
+  EXPECT_NE(buffers.begin()->second, buffers.rbegin()->second);
+  EXPECT_EQ(0, main.getStatistics().unhandled_messages);
+}
+
+TEST(TestSuite, channelMultiplexing)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Multiplexer multiplexer(&mock_transport, ORION_TRANSPORT_DEFAULT_FRAME_SIZE, 4);
+  const uint8_t channels[] = { 1, 2 };
+  std::vector<std::unique_ptr<orion::Major>> majors;
+  std::vector<size_t> received_messages(2, 0);
+  for (size_t index = 0; index < 2; index++)
+  {
+    majors.emplace_back(new orion::Major(multiplexer.getChannel(channels[index])));
+    majors[index]->setChannel(channels[index]);
+    majors[index]->setHandler<EncoderMessage>(5, [&received_messages, index](const EncoderMessage &)
+      {
+        received_messages[index]++;
+      });
+  }
+
+  const size_t invokes_count = 50;
+  uint32_t retry_timeout = orion::Major::Interval::Second * 2;
+
+  // Minor replies to pending commands of both clients newest first and pushes a message before the first reply
+  std::mutex pending_mutex;
+  std::deque<uint16_t> pending;
+  bool pushed = false;
+  std::vector<size_t> wrong_channel(2, 0);
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex);
+      pending.push_back(reinterpret_cast<HandshakeCommand*>(input_buffer)->header.common.sequence_id);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      HandshakeResult reply_result;
+      {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (!pushed)
+        {
+          pushed = true;
+          EncoderMessage message;
+          std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&message), sizeof(message));
+          return (sizeof(message));
+        }
+        if (pending.empty())
+        {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+          return (ORION_TRAN_ERROR_TIMEOUT);
+        }
+        reply_result.header.common.sequence_id = pending.back();
+        pending.pop_back();
+      }
+      std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(HandshakeResult));
+      return (sizeof(HandshakeResult));
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_receive_packet));
+
+  std::vector<std::thread> threads;
+  std::vector<size_t> succeeded(2, 0);
+  for (size_t major_index = 0; major_index < 2; major_index++)
+  {
+    threads.emplace_back([&, major_index]()
+      {
+        for (size_t index = 0; index < invokes_count; index++)
+        {
+          HandshakeCommand command;
+          HandshakeResult result;
+          if (ORION_MAJOR_ERROR_NONE == majors[major_index]->invoke(command, &result, retry_timeout, 1))
+          {
+            succeeded[major_index]++;
+          }
+          if (ORION_CHANNEL_OF_SEQUENCE_ID(result.header.common.sequence_id) != channels[major_index])
+          {
+            wrong_channel[major_index]++;
+          }
+        }
+      });
+  }
+  for (std::thread &thread : threads)
+  {
+    thread.join();
+  }
+
+  for (size_t index = 0; index < 2; index++)
+  {
+    EXPECT_EQ(invokes_count, succeeded[index]);
+    EXPECT_EQ(0, wrong_channel[index]);
+    EXPECT_EQ(0, majors[index]->getStatistics().foreign_packets);
+    // Message pushed by Minor is copied to every channel
+    EXPECT_EQ(1, received_messages[index]);
+
+    orion::ChannelStatistics statistics = multiplexer.getStatistics(channels[index]);
+    EXPECT_EQ(invokes_count, statistics.sent);
+    EXPECT_EQ(invokes_count + 1, statistics.received);
+    EXPECT_EQ(0, statistics.dropped);
+  }
+  EXPECT_EQ(0, multiplexer.getUnroutedPackets());
+}
+
+TEST(TestSuite, channelPollWhileInvoke)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Multiplexer multiplexer(&mock_transport, ORION_TRANSPORT_DEFAULT_FRAME_SIZE, 4);
+  orion::Major polling_major(multiplexer.getChannel(1));
+  polling_major.setChannel(1);
+  orion::Major invoking_major(multiplexer.getChannel(2));
+  invoking_major.setChannel(2);
+
+  uint32_t retry_timeout = orion::Major::Interval::Second;
+
+  // Link reads from two threads at once would share receive buffer and queue of the transport
+  std::atomic<uint32_t> readers(0);
+  std::atomic<uint32_t> overlaps(0);
+  auto enter_link = [&]()
+    {
+      if (readers.fetch_add(1) > 0)
+      {
+        overlaps++;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    };
+  std::mutex pending_mutex;
+  std::deque<uint16_t> pending;
+  auto mock_send_packet = [&](uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex);
+      pending.push_back(reinterpret_cast<HandshakeCommand*>(input_buffer)->header.common.sequence_id);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_receive_packet = [&](uint8_t *output_buffer, uint32_t, uint32_t) -> ssize_t
+    {
+      enter_link();
+      ssize_t result = ORION_TRAN_ERROR_TIMEOUT;
+      {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (!pending.empty())
+        {
+          HandshakeResult reply_result;
+          reply_result.header.common.sequence_id = pending.front();
+          pending.pop_front();
+          std::memcpy(output_buffer, reinterpret_cast<const uint8_t*>(&reply_result), sizeof(reply_result));
+          result = sizeof(reply_result);
+        }
+      }
+      readers--;
+      return (result);
+    };
+  auto mock_has_received_packet = [&]()
+    {
+      enter_link();
+      readers--;
+      return (false);
+    };
+  EXPECT_CALL(mock_transport, sendPacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_CALL(mock_transport, receivePacket(NotNull(), Gt(0), Le(retry_timeout))).
+    WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_CALL(mock_transport, hasReceivedPacket()).WillRepeatedly(Invoke(mock_has_received_packet));
+
+  std::atomic<bool> done(false);
+  std::thread poll_thread([&]()
+    {
+      while (!done)
+      {
+        polling_major.poll(orion::Major::Interval::Millisecond);
+      }
+    });
+  const size_t invokes_count = 50;
+  size_t succeeded = 0;
+  for (size_t index = 0; index < invokes_count; index++)
+  {
+    HandshakeCommand command;
+    HandshakeResult result;
+    if (ORION_MAJOR_ERROR_NONE == invoking_major.invoke(command, &result, retry_timeout, 1))
+    {
+      succeeded++;
+    }
+  }
+  done = true;
+  poll_thread.join();
+
+  EXPECT_EQ(invokes_count, succeeded);
+  EXPECT_EQ(0, overlaps);
+}
+
+TEST(TestSuite, channelForwardsLinkQueries)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_transport(&mock_communication);
+
+  orion::Multiplexer multiplexer(&mock_transport, ORION_TRANSPORT_DEFAULT_FRAME_SIZE, 4);
+  orion::Transport *channel = multiplexer.getChannel(1);
+
+  orion_transport_t *link_object = reinterpret_cast<orion_transport_t*>(&mock_transport);
+  orion_transport_overflow_counters_t counters = { .dropped_frames = 2, .dropped_bytes = 30,
+    .backpressure_events = 1 };
+  orion_transport_statistics_t statistics = {};
+  statistics.rx.frames = 7;
+  EXPECT_CALL(mock_transport, getObject()).WillOnce(Return(link_object));
+  EXPECT_CALL(mock_transport, setOverflowPolicy(ORION_TRAN_OVERFLOW_POLICY_DROP_OLDEST)).
+    WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_CALL(mock_transport, getOverflowCounters()).WillOnce(Return(counters));
+  EXPECT_CALL(mock_transport, getStatistics()).WillOnce(Return(statistics));
+
+  EXPECT_EQ(link_object, channel->getObject());
+  EXPECT_EQ(ORION_TRAN_ERROR_NONE, channel->setOverflowPolicy(ORION_TRAN_OVERFLOW_POLICY_DROP_OLDEST));
+  EXPECT_EQ(2, channel->getOverflowCounters().dropped_frames);
+  EXPECT_EQ(7, channel->getStatistics().rx.frames);
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
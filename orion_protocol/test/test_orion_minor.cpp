@@ -23,17 +23,21 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <vector>
 #include "gmock-global/gmock-global.h"
 #include "orion_protocol/orion_transport.hpp"
 #include "orion_protocol/orion_header.hpp"
 #include "orion_protocol/orion_major.hpp"
 #include "orion_protocol/orion_minor.hpp"
+#include "orion_protocol/orion_stream.h"
+#include "orion_protocol/orion_delta.h"
 
 using ::testing::Eq;
 using ::testing::Gt;
 using ::testing::Le;
 using ::testing::NotNull;
 using ::testing::Invoke;
+using ::testing::IsNull;
 using ::testing::Return;
 using ::testing::DoAll;
 using ::testing::SaveArg;
@@ -64,17 +68,41 @@ struct SimpleResult
   uint8_t data2 = 0;
 };
 
+struct EncoderMessage
+{
+  orion::CommandHeader header =
+  {
+    .frame = { .crc = 0 },
+    .common = { .message_id = 5, .version = 1, .oldest_compatible_version = 1, .sequence_id = 0 }
+  };
+  int16_t ticks = 0;
+};
+
 #pragma pack(pop)
 
+size_t fillEncoderMessage(void * context, uint8_t * buffer, size_t)
+{
+  EncoderMessage message;
+  message.ticks = ++(*reinterpret_cast<int16_t*>(context));
+  std::memcpy(buffer, &message, sizeof(message));
+  return (sizeof(message));
+}
+
+bool recordBaud(void * context, uint32_t baud)
+{
+  reinterpret_cast<std::vector<uint32_t>*>(context)->push_back(baud);
+  return (true);
+}
+
 MOCK_GLOBAL_FUNC1(orion_communication_new, orion_communication_error_t(orion_communication_t ** me));
 MOCK_GLOBAL_FUNC1(orion_communication_delete, orion_communication_error_t(const orion_communication_t * me));
-MOCK_GLOBAL_FUNC4(orion_communication_send_buffer, orion_communication_error_t(const orion_communication_t * me,
+MOCK_GLOBAL_FUNC4(orion_communication_send_buffer, orion_communication_error_t(orion_communication_t * me,
   uint8_t *buffer, uint32_t size, uint32_t timeout));
 // NOLINTNEXTLINE(readability/casting)
-MOCK_GLOBAL_FUNC1(orion_communication_has_available_buffer, bool(const orion_communication_t * me));
-MOCK_GLOBAL_FUNC4(orion_communication_receive_buffer, ssize_t(const orion_communication_t * me, uint8_t * buffer,
+MOCK_GLOBAL_FUNC1(orion_communication_has_available_buffer, bool(orion_communication_t * me));
+MOCK_GLOBAL_FUNC4(orion_communication_receive_buffer, ssize_t(orion_communication_t * me, uint8_t * buffer,
   uint32_t size, uint32_t timeout));
-MOCK_GLOBAL_FUNC3(orion_communication_receive_available_buffer, ssize_t(const orion_communication_t * me,
+MOCK_GLOBAL_FUNC3(orion_communication_receive_available_buffer, ssize_t(orion_communication_t * me,
   uint8_t * buffer, uint32_t size));
 
 class MockCommunication: public orion::Communication
@@ -91,19 +119,65 @@ MOCK_GLOBAL_FUNC2(orion_transport_new, orion_transport_error_t(orion_transport_t
 MOCK_GLOBAL_FUNC1(orion_transport_delete, orion_transport_error_t(const orion_transport_t * me));
 MOCK_GLOBAL_FUNC4(orion_transport_send_packet, orion_transport_error_t(orion_transport_t * me, uint8_t *input_buffer,
   uint32_t input_size, uint32_t timeout));
+MOCK_GLOBAL_FUNC4(orion_transport_send_packets, orion_transport_error_t(orion_transport_t * me,
+  orion_transport_packet_t *packets, uint32_t count, uint32_t timeout));
+MOCK_GLOBAL_FUNC6(orion_transport_send_part, ssize_t(orion_transport_t * me, uint8_t *input_buffer,
+  uint32_t input_size, uint32_t offset, uint32_t max_size, uint32_t timeout));
+MOCK_GLOBAL_FUNC5(orion_transport_encode_packet, ssize_t(orion_transport_t * me, uint8_t *input_buffer,
+  uint32_t input_size, uint8_t *frame, uint32_t frame_size));
+MOCK_GLOBAL_FUNC4(orion_transport_send_frame, orion_transport_error_t(orion_transport_t * me, uint8_t *frame,
+  uint32_t size, uint32_t timeout));
+MOCK_GLOBAL_FUNC2(orion_transport_set_containers, orion_transport_error_t(orion_transport_t * me, bool enabled));
+MOCK_GLOBAL_FUNC2(orion_transport_set_fragments, orion_transport_error_t(orion_transport_t * me, bool enabled));
+MOCK_GLOBAL_FUNC3(orion_transport_set_reassembly_buffer, orion_transport_error_t(orion_transport_t * me,
+  uint8_t *buffer, uint32_t size));
+MOCK_GLOBAL_FUNC3(orion_transport_set_compression_buffer, orion_transport_error_t(orion_transport_t * me,
+  uint8_t *buffer, uint32_t size));
 MOCK_GLOBAL_FUNC4(orion_transport_receive_packet, ssize_t(orion_transport_t * me, uint8_t *output_buffer,
   uint32_t output_size, uint32_t timeout));
+MOCK_GLOBAL_FUNC1(orion_transport_get_frame_size, uint32_t(const orion_transport_t * me));
+MOCK_GLOBAL_FUNC2(orion_transport_set_link, orion_transport_error_t(orion_transport_t * me,
+  const orion_transport_link_t * link));
+MOCK_GLOBAL_FUNC2(orion_transport_get_link, orion_transport_error_t(const orion_transport_t * me,
+  orion_transport_link_t * link));
+MOCK_GLOBAL_FUNC2(orion_transport_set_overflow_policy, orion_transport_error_t(orion_transport_t * me,
+  orion_transport_overflow_policy_t policy));
+MOCK_GLOBAL_FUNC2(orion_transport_get_overflow_counters, orion_transport_error_t(const orion_transport_t * me,
+  orion_transport_overflow_counters_t * counters));
+MOCK_GLOBAL_FUNC2(orion_transport_get_statistics, orion_transport_error_t(const orion_transport_t * me,
+  orion_transport_statistics_t * statistics));
 // NOLINTNEXTLINE(readability/casting)
 MOCK_GLOBAL_FUNC1(orion_transport_has_received_packet, bool(orion_transport_t * me));
 
 class MockTransport: public orion::Transport
 {
 public:
-  explicit MockTransport(orion::Communication * communication) : orion::Transport(communication) {}
+  explicit MockTransport(orion::Communication * communication) : orion::Transport(communication)
+  {
+    // Major sizes its result buffer by frame size of transport
+    ON_CALL(*this, getFrameSize()).WillByDefault(Return(ORION_TRANSPORT_DEFAULT_FRAME_SIZE));
+  }
 
   MOCK_METHOD3(sendPacket, orion_transport_error_t(uint8_t *input_buffer, uint32_t input_size, uint32_t timeout));
+  MOCK_METHOD3(sendPackets, orion_transport_error_t(orion_transport_packet_t *packets, uint32_t count,
+    uint32_t timeout));
+  MOCK_METHOD5(sendPart, ssize_t(uint8_t *input_buffer, uint32_t input_size, uint32_t offset, uint32_t max_size,
+    uint32_t timeout));
+  MOCK_METHOD4(encodePacket, ssize_t(uint8_t *input_buffer, uint32_t input_size, uint8_t *frame,
+    uint32_t frame_size));
+  MOCK_METHOD3(sendFrame, orion_transport_error_t(uint8_t *frame, uint32_t size, uint32_t timeout));
   MOCK_METHOD3(receivePacket, ssize_t(uint8_t *output_buffer, uint32_t output_size, uint32_t timeout));
   MOCK_METHOD0(hasReceivedPacket, bool());
+  MOCK_METHOD1(setContainers, orion_transport_error_t(bool enabled));
+  MOCK_METHOD1(setFragments, orion_transport_error_t(bool enabled));
+  MOCK_METHOD2(setReassemblyBuffer, orion_transport_error_t(uint8_t *buffer, uint32_t size));
+  MOCK_METHOD2(setCompressionBuffer, orion_transport_error_t(uint8_t *buffer, uint32_t size));
+  MOCK_METHOD0(getFrameSize, uint32_t());
+  MOCK_METHOD1(setLink, orion_transport_error_t(const orion_transport_link_t &link));
+  MOCK_METHOD0(getLink, orion_transport_link_t());
+  MOCK_METHOD1(setOverflowPolicy, orion_transport_error_t(orion_transport_overflow_policy_t policy));
+  MOCK_METHOD0(getOverflowCounters, orion_transport_overflow_counters_t());
+  MOCK_METHOD0(getStatistics, orion_transport_statistics_t());
 };
 
 TEST(TestSuite, happyPath)
@@ -191,6 +265,763 @@ TEST(TestSuite, happyPath)
   ASSERT_EQ(command.data, result.data1);
 }
 
+TEST(TestSuite, handshakeHandledByMinor)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+
+  orion_control_handshake_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  command.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+  command.header.common.sequence_id = 7;
+  command.capabilities = ORION_CONTROL_CAPABILITY_CONTAINER | 0x80000000;
+
+  orion_control_handshake_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      std::memcpy(output_buffer, &command, sizeof(command));
+      return static_cast<ssize_t>(sizeof(command));
+    };
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      std::memcpy(&result, input_buffer, sizeof(result));
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillOnce(Return(true));
+  EXPECT_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillOnce(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_set_containers, orion_transport_set_containers(
+    mock_inbound_transport.getObject(), true)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_fragments, orion_transport_set_fragments(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_compression_buffer, orion_transport_set_compression_buffer(
+    mock_inbound_transport.getObject(), IsNull(), 0)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_get_frame_size, orion_transport_get_frame_size(
+    mock_inbound_transport.getObject())).WillOnce(Return(512));
+  EXPECT_GLOBAL_CALL(orion_transport_set_link, orion_transport_set_link(mock_inbound_transport.getObject(),
+    NotNull())).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(result)), _)).WillOnce(Invoke(mock_send_packet));
+
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(ORION_CONTROL_MESSAGE_ID_HANDSHAKE, result.header.common.message_id);
+  EXPECT_EQ(7, result.header.common.sequence_id);
+  EXPECT_EQ(0, result.header.error_code);
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_CONTAINER, result.capabilities);
+}
+
+TEST(TestSuite, linkNegotiatedByMinor)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+  minor_obj.setMaxBaud(460800);
+
+  orion_control_handshake_command_t handshake;
+  std::memset(&handshake, 0, sizeof(handshake));
+  handshake.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  handshake.header.common.sequence_id = 1;
+  handshake.capabilities = ORION_CONTROL_CAPABILITY_LINK;
+  orion_control_link_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_LINK;
+  command.header.common.sequence_id = 2;
+  command.frame_size = 1024;
+  command.baud = 921600;
+  command.window = 64;
+  command.checksums = ORION_CONTROL_CHECKSUM_CRC16 | ORION_CONTROL_CHECKSUM_FLETCHER16;
+
+  std::vector<uint8_t> received(reinterpret_cast<uint8_t*>(&handshake),
+    reinterpret_cast<uint8_t*>(&handshake) + sizeof(handshake));
+  orion_transport_link_t link;
+  std::memset(&link, 0, sizeof(link));
+  orion_control_link_result_t result;
+  std::memset(&result, 0, sizeof(result));
+  bool link_set_after_result = false;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      std::memcpy(output_buffer, received.data(), received.size());
+      return static_cast<ssize_t>(received.size());
+    };
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      if (sizeof(result) == input_size)
+      {
+        std::memcpy(&result, input_buffer, sizeof(result));
+        link_set_after_result = false;
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_set_link = [&](orion_transport_t *, const orion_transport_link_t * new_link)
+    {
+      link = *new_link;
+      link_set_after_result = ORION_CONTROL_MESSAGE_ID_LINK == result.header.common.message_id;
+      return ORION_TRAN_ERROR_NONE;
+    };
+  auto mock_get_link = [&](const orion_transport_t *, orion_transport_link_t * current_link)
+    {
+      *current_link = link;
+      return ORION_TRAN_ERROR_NONE;
+    };
+  ON_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillByDefault(Return(true));
+  ON_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillByDefault(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_set_containers, orion_transport_set_containers(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_fragments, orion_transport_set_fragments(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_compression_buffer, orion_transport_set_compression_buffer(
+    mock_inbound_transport.getObject(), IsNull(), 0)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_get_frame_size, orion_transport_get_frame_size(
+    mock_inbound_transport.getObject())).WillRepeatedly(Return(512));
+  EXPECT_GLOBAL_CALL(orion_transport_set_link, orion_transport_set_link(mock_inbound_transport.getObject(),
+    NotNull())).Times(3).WillRepeatedly(Invoke(mock_set_link));
+  EXPECT_GLOBAL_CALL(orion_transport_get_link, orion_transport_get_link(mock_inbound_transport.getObject(),
+    NotNull())).Times(2).WillRepeatedly(Invoke(mock_get_link));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_LINK, link.capabilities);
+  EXPECT_EQ(512, link.frame_size);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, link.checksum);
+
+  // The best settings of both, transport switches to them only after result is sent
+  received.assign(reinterpret_cast<uint8_t*>(&command), reinterpret_cast<uint8_t*>(&command) + sizeof(command));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(0, result.header.error_code);
+  EXPECT_EQ(2, result.header.common.sequence_id);
+  EXPECT_EQ(512, result.frame_size);
+  EXPECT_EQ(460800, result.baud);
+  EXPECT_EQ(ORION_MINOR_STREAM_WINDOW, result.window);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_FLETCHER16, result.checksum);
+  EXPECT_TRUE(link_set_after_result);
+  EXPECT_EQ(ORION_CONTROL_CAPABILITY_LINK, link.capabilities);
+  EXPECT_EQ(512, link.frame_size);
+  EXPECT_EQ(460800, link.baud);
+  EXPECT_EQ(ORION_MINOR_STREAM_WINDOW, link.window);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_FLETCHER16, link.checksum);
+
+  // Major which knows CRC16 only keeps it, frames too small for a fragment are refused
+  command.header.common.sequence_id = 3;
+  command.checksums = ORION_CONTROL_CHECKSUM_CRC16;
+  command.frame_size = 256;
+  received.assign(reinterpret_cast<uint8_t*>(&command), reinterpret_cast<uint8_t*>(&command) + sizeof(command));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(256, link.frame_size);
+  EXPECT_EQ(ORION_CONTROL_CHECKSUM_CRC16, link.checksum);
+  command.header.common.sequence_id = 4;
+  command.frame_size = ORION_CONTROL_LINK_MIN_FRAME_SIZE - 1;
+  received.assign(reinterpret_cast<uint8_t*>(&command), reinterpret_cast<uint8_t*>(&command) + sizeof(command));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(ORION_CONTROL_ERROR_MALFORMED_MESSAGE, result.header.error_code);
+  EXPECT_EQ(256, link.frame_size);
+}
+
+TEST(TestSuite, baudSwitchedByMinor)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+  minor_obj.setMaxBaud(921600);
+  std::vector<uint32_t> bauds;
+  minor_obj.setBaudCallback(recordBaud, &bauds, 115200);
+
+  orion_control_baud_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_BAUD;
+  command.header.common.sequence_id = 1;
+  command.step = ORION_CONTROL_BAUD_SWITCH;
+  command.baud = 2000000;
+  command.timeout = 1000;
+
+  std::vector<orion_control_baud_result_t> results;
+  size_t results_before_switch = 0;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      std::memcpy(output_buffer, &command, sizeof(command));
+      return static_cast<ssize_t>(sizeof(command));
+    };
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      results.push_back(*reinterpret_cast<orion_control_baud_result_t*>(input_buffer));
+      results_before_switch = bauds.size();
+      return ORION_TRAN_ERROR_NONE;
+    };
+  ON_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillByDefault(Return(true));
+  ON_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillByDefault(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(orion_control_baud_result_t)), _)).Times(5).WillRepeatedly(Invoke(mock_send_packet));
+
+  // Rate above max baud is refused and communication stays as it is
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(1, results.size());
+  EXPECT_EQ(ORION_CONTROL_ERROR_NOT_SUPPORTED, results[0].header.error_code);
+  EXPECT_EQ(115200, results[0].baud);
+  EXPECT_TRUE(bauds.empty());
+
+  // Result goes at the current rate, then communication switches
+  command.header.common.sequence_id = 2;
+  command.baud = 921600;
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ(0, results[1].header.error_code);
+  EXPECT_EQ(921600, results[1].baud);
+  EXPECT_EQ(0, results_before_switch);
+  ASSERT_EQ(1, bauds.size());
+  EXPECT_EQ(921600, bauds[0]);
+
+  // Probes are echoed
+  command.header.common.sequence_id = 3;
+  command.step = ORION_CONTROL_BAUD_PROBE;
+  for (uint32_t index = 0; index < sizeof(command.pattern); index++)
+  {
+    command.pattern[index] = static_cast<uint8_t>(0xAA ^ index);
+  }
+  EXPECT_EQ(921600, minor_obj.updateBaud(5000));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ(ORION_CONTROL_BAUD_PROBE, results[2].step);
+  EXPECT_EQ(0, std::memcmp(command.pattern, results[2].pattern, sizeof(command.pattern)));
+
+  // Without commit Minor returns to the previous rate once timeout since the first update passes
+  EXPECT_EQ(921600, minor_obj.updateBaud(5999));
+  EXPECT_EQ(115200, minor_obj.updateBaud(6000));
+  ASSERT_EQ(2, bauds.size());
+  EXPECT_EQ(115200, bauds[1]);
+
+  // Committed rate is kept
+  command.header.common.sequence_id = 4;
+  command.step = ORION_CONTROL_BAUD_SWITCH;
+  command.baud = 460800;
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(460800, minor_obj.updateBaud(10000));
+  command.header.common.sequence_id = 5;
+  command.step = ORION_CONTROL_BAUD_COMMIT;
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(5, results.size());
+  EXPECT_EQ(0, results[4].header.error_code);
+  EXPECT_EQ(460800, minor_obj.updateBaud(20000));
+  ASSERT_EQ(3, bauds.size());
+  EXPECT_EQ(460800, bauds[2]);
+}
+
+TEST(TestSuite, resultCacheAnswersRetransmission)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+
+  orion_control_handshake_command_t handshake;
+  std::memset(&handshake, 0, sizeof(handshake));
+  handshake.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  handshake.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+  handshake.header.common.sequence_id = 1;
+  handshake.capabilities = ORION_CONTROL_CAPABILITY_RESULT_CACHE;
+
+  SimpleCommand command;
+  command.header.frame.crc = 0x1234;
+  command.header.common.sequence_id = 2;
+
+  // Frame is faked by a copy of packet
+  std::vector<uint8_t> received = std::vector<uint8_t>(reinterpret_cast<uint8_t*>(&handshake),
+    reinterpret_cast<uint8_t*>(&handshake) + sizeof(handshake));
+  std::vector<uint8_t> sent_frame;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      std::memcpy(output_buffer, received.data(), received.size());
+      return static_cast<ssize_t>(received.size());
+    };
+  auto mock_encode_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t input_size, uint8_t *frame,
+    uint32_t)
+    {
+      std::memcpy(frame, input_buffer, input_size);
+      return static_cast<ssize_t>(input_size);
+    };
+  auto mock_send_frame = [&](orion_transport_t *, uint8_t *frame, uint32_t size, uint32_t)
+    {
+      sent_frame.assign(frame, frame + size);
+      return ORION_TRAN_ERROR_NONE;
+    };
+  ON_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillByDefault(Return(true));
+  ON_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillByDefault(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_set_containers, orion_transport_set_containers(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_fragments, orion_transport_set_fragments(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_compression_buffer, orion_transport_set_compression_buffer(
+    mock_inbound_transport.getObject(), IsNull(), 0)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_get_frame_size, orion_transport_get_frame_size(
+    mock_inbound_transport.getObject())).WillOnce(Return(512));
+  EXPECT_GLOBAL_CALL(orion_transport_set_link, orion_transport_set_link(mock_inbound_transport.getObject(),
+    NotNull())).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(orion_control_handshake_result_t)), _)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_encode_packet, orion_transport_encode_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(SimpleResult)), NotNull(), Gt(sizeof(SimpleResult)))).WillOnce(Invoke(mock_encode_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_send_frame, orion_transport_send_frame(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(SimpleResult)), _)).Times(2).WillRepeatedly(Invoke(mock_send_frame));
+
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+
+  received.assign(reinterpret_cast<uint8_t*>(&command), reinterpret_cast<uint8_t*>(&command) + sizeof(command));
+  ASSERT_EQ(sizeof(command), minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  SimpleResult result;
+  result.header.common.sequence_id = command.header.common.sequence_id;
+  result.data1 = 42;
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.sendResult(reinterpret_cast<uint8_t*>(&result), sizeof(result)));
+  ASSERT_EQ(sizeof(result), sent_frame.size());
+
+  // Retransmitted command is answered by the same frame and does not reach application
+  sent_frame.clear();
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(sizeof(result), sent_frame.size());
+  EXPECT_EQ(42, reinterpret_cast<SimpleResult*>(sent_frame.data())->data1);
+
+  // The same sequence id with other content is a new command
+  command.header.frame.crc = 0x4321;
+  received.assign(reinterpret_cast<uint8_t*>(&command), reinterpret_cast<uint8_t*>(&command) + sizeof(command));
+  ASSERT_EQ(sizeof(command), minor_obj.receiveCommand(buffer, sizeof(buffer)));
+}
+
+TEST(TestSuite, publishUnsolicited)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+
+  SimpleCommand message;
+  message.header.common.sequence_id = 15;
+  uint16_t sent_sequence_id = 15;
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      sent_sequence_id = reinterpret_cast<orion::CommandHeader*>(input_buffer)->common.sequence_id;
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(message)), _)).WillOnce(Invoke(mock_send_packet));
+
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.publish(reinterpret_cast<uint8_t*>(&message), sizeof(message)));
+  ASSERT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, sent_sequence_id);
+}
+
+TEST(TestSuite, telemetrySubscription)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+
+  const uint8_t ENCODER_ID = 5;
+  const uint32_t COST = ORION_FRAMER_MAX_ENCODED_SIZE(sizeof(EncoderMessage));
+  int16_t ticks = 0;
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.addTelemetry(ENCODER_ID, sizeof(EncoderMessage), fillEncoderMessage,
+    &ticks));
+  ASSERT_EQ(ORION_MINOR_ERROR_NO_ROOM, minor_obj.addTelemetry(ENCODER_ID, sizeof(EncoderMessage),
+    fillEncoderMessage, &ticks));
+
+  orion_control_subscribe_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_SUBSCRIBE;
+  command.header.common.sequence_id = 3;
+  command.message_id = ENCODER_ID;
+
+  orion_control_subscribe_result_t result;
+  std::vector<EncoderMessage> published;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      std::memcpy(output_buffer, &command, sizeof(command));
+      return static_cast<ssize_t>(sizeof(command));
+    };
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      if (sizeof(result) == input_size)
+      {
+        std::memcpy(&result, input_buffer, sizeof(result));
+      }
+      else
+      {
+        published.push_back(*reinterpret_cast<EncoderMessage*>(input_buffer));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillRepeatedly(Return(true));
+  EXPECT_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+
+  uint8_t buffer[64];
+
+  // Link budget of 10 messages per second makes Minor stretch requested 100 Hz
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.setTelemetryBudget(COST * 10, 0));
+  command.period = 10000;
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(0, result.header.error_code);
+  EXPECT_EQ(3, result.header.common.sequence_id);
+  EXPECT_EQ(100000, result.period);
+
+  // Without budget requested period is granted, but burst of the bucket limits publications once budget is set
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.setTelemetryBudget(0, 0));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(10000, result.period);
+  const uint32_t capacity = ORION_FRAMER_MAX_ENCODED_SIZE(ORION_MINOR_MAX_TELEMETRY_SIZE);
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.setTelemetryBudget(COST * 10, 0));
+  for (uint64_t time_now = 0; time_now < 100000; time_now += 5000)
+  {
+    minor_obj.publishTelemetry(time_now);
+  }
+
+  // Burst of the bucket plus one message refilled during the first 50 ms, the rest is decimated
+  orion_minor_telemetry_statistics_t statistics = minor_obj.getTelemetryStatistics(ENCODER_ID);
+  ASSERT_EQ(capacity / COST + 1, statistics.published);
+  ASSERT_EQ(10 - statistics.published, statistics.decimated);
+  ASSERT_EQ(statistics.published, published.size());
+  EXPECT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, published[0].header.common.sequence_id);
+  EXPECT_EQ(ENCODER_ID, published[0].header.common.message_id);
+  EXPECT_EQ(1, published[0].ticks);
+  EXPECT_EQ(10000, statistics.achieved_period);
+
+  // The same period only reports achieved one
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(10000, result.achieved_period);
+
+  command.message_id = ENCODER_ID + 1;
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_EQ(ORION_CONTROL_ERROR_UNKNOWN_MESSAGE, result.header.error_code);
+}
+
+TEST(TestSuite, telemetryDelta)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+
+  const uint8_t ENCODER_ID = 5;
+  int16_t ticks = 0;
+  uint8_t keyframe[ORION_MINOR_MAX_TELEMETRY_SIZE];
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.addTelemetry(ENCODER_ID, sizeof(EncoderMessage), fillEncoderMessage,
+    &ticks));
+  ASSERT_EQ(ORION_MINOR_ERROR_NOT_FOUND, minor_obj.setTelemetryDelta(ENCODER_ID + 1, keyframe, 3));
+  ASSERT_EQ(ORION_MINOR_ERROR_NONE, minor_obj.setTelemetryDelta(ENCODER_ID, keyframe, 3));
+
+  orion_control_handshake_command_t handshake;
+  std::memset(&handshake, 0, sizeof(handshake));
+  handshake.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  handshake.header.common.sequence_id = 1;
+  handshake.capabilities = ORION_CONTROL_CAPABILITY_DELTA;
+  orion_control_subscribe_command_t subscribe;
+  std::memset(&subscribe, 0, sizeof(subscribe));
+  subscribe.header.common.message_id = ORION_CONTROL_MESSAGE_ID_SUBSCRIBE;
+  subscribe.header.common.sequence_id = 2;
+  subscribe.message_id = ENCODER_ID;
+  subscribe.period = 10000;
+
+  bool handshake_received = false;
+  std::vector<std::vector<uint8_t>> published;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t) -> ssize_t
+    {
+      if (!handshake_received)
+      {
+        handshake_received = true;
+        std::memcpy(output_buffer, &handshake, sizeof(handshake));
+        return (sizeof(handshake));
+      }
+      std::memcpy(output_buffer, &subscribe, sizeof(subscribe));
+      return (sizeof(subscribe));
+    };
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      if (ORION_CONTROL_MESSAGE_ID_DELTA == reinterpret_cast<orion_command_header_t*>(input_buffer)->common.message_id)
+      {
+        published.push_back(std::vector<uint8_t>(input_buffer, input_buffer + input_size));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).WillRepeatedly(Return(true));
+  EXPECT_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_set_containers, orion_transport_set_containers(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_fragments, orion_transport_set_fragments(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_compression_buffer, orion_transport_set_compression_buffer(
+    mock_inbound_transport.getObject(), IsNull(), 0)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_get_frame_size, orion_transport_get_frame_size(
+    mock_inbound_transport.getObject())).WillOnce(Return(512));
+  EXPECT_GLOBAL_CALL(orion_transport_set_link, orion_transport_set_link(mock_inbound_transport.getObject(),
+    NotNull())).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).WillRepeatedly(Invoke(mock_send_packet));
+
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  for (uint64_t time_now = 0; time_now < 40000; time_now += 10000)
+  {
+    minor_obj.publishTelemetry(time_now);
+  }
+
+  // Keyframe, two deltas and keyframe again, each one reconstructs published message
+  ASSERT_EQ(4, published.size());
+  uint8_t decoder_keyframe[ORION_MINOR_MAX_TELEMETRY_SIZE];
+  orion_delta_decoder_t decoder;
+  orion_delta_decoder_init(&decoder, decoder_keyframe, sizeof(decoder_keyframe));
+  for (size_t index = 0; index < published.size(); index++)
+  {
+    const orion_control_delta_t *header = reinterpret_cast<const orion_control_delta_t*>(published[index].data());
+    EXPECT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, header->header.common.sequence_id);
+    EXPECT_EQ(ENCODER_ID, header->message_id);
+    EXPECT_EQ(0 == index % 3, 0 != (header->flags & ORION_CONTROL_DELTA_FLAG_KEYFRAME));
+    if (0 != index % 3)
+    {
+      EXPECT_LT(published[index].size(), published[0].size());
+    }
+
+    EncoderMessage message;
+    ASSERT_EQ(sizeof(message), orion_delta_decode(&decoder, published[index].data(), published[index].size(),
+      reinterpret_cast<uint8_t*>(&message), sizeof(message)));
+    EXPECT_EQ(ENCODER_ID, message.header.common.message_id);
+    EXPECT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, message.header.common.sequence_id);
+    EXPECT_EQ(index + 1, message.ticks);
+  }
+}
+
+TEST(TestSuite, streamReceivedByMinor)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+  uint8_t stream_buffer[16];
+  minor_obj.setStreamBuffer(stream_buffer, sizeof(stream_buffer));
+
+  // Two segments arrive in reverse order
+  const uint8_t data[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+  orion_stream_sender_t sender;
+  orion_stream_sender_init(&sender, 1, data, sizeof(data), 8, 2, 1000);
+  std::vector<std::vector<uint8_t>> segments(2, std::vector<uint8_t>(sizeof(orion_control_stream_segment_t) + 8));
+  for (std::vector<uint8_t> &segment : segments)
+  {
+    segment.resize(orion_stream_sender_poll(&sender, 0, segment.data(), segment.size()));
+  }
+  size_t next_segment = 1;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t,
+    uint32_t)
+    {
+      const std::vector<uint8_t> &segment = segments[next_segment--];
+      std::memcpy(output_buffer, segment.data(), segment.size());
+      return static_cast<ssize_t>(segment.size());
+    };
+  std::vector<orion_control_stream_ack_t> acks;
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t, uint32_t)
+    {
+      acks.push_back(*reinterpret_cast<orion_control_stream_ack_t*>(input_buffer));
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).Times(2).WillRepeatedly(Return(true));
+  EXPECT_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).Times(2).WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), Eq(sizeof(orion_control_stream_ack_t)), _)).Times(2).WillRepeatedly(Invoke(mock_send_packet));
+
+  uint8_t buffer[64];
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  EXPECT_FALSE(minor_obj.getStream(nullptr));
+  ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  uint32_t size = 0;
+  ASSERT_TRUE(minor_obj.getStream(&size));
+  EXPECT_EQ(sizeof(data), size);
+  EXPECT_EQ(0, std::memcmp(data, stream_buffer, sizeof(data)));
+
+  ASSERT_EQ(2, acks.size());
+  EXPECT_EQ(ORION_CONTROL_MESSAGE_ID_STREAM_ACK, acks[0].header.common.message_id);
+  EXPECT_EQ(0, acks[0].cumulative);
+  EXPECT_EQ(0x1, acks[0].selective);
+  EXPECT_EQ(2, acks[1].cumulative);
+  EXPECT_EQ(0, acks[1].selective);
+}
+
+TEST(TestSuite, streamAfterMajorRestart)
+{
+  EXPECT_GLOBAL_CALL(orion_communication_new, orion_communication_new(_)).WillOnce(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_communication_struct_t*>(0xBCBCAAAA)),
+    Return(ORION_COM_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_communication_delete, orion_communication_delete(_)).WillOnce(Return(ORION_COM_ERROR_NONE));
+  MockCommunication mock_communication;
+
+  EXPECT_GLOBAL_CALL(orion_transport_new, orion_transport_new(_, _)).WillRepeatedly(DoAll(
+    SetArgPointee<0>(reinterpret_cast<orion_transport_struct_t*>(0xDDDDBBBB)),
+    Return(ORION_TRAN_ERROR_NONE)));
+  EXPECT_GLOBAL_CALL(orion_transport_delete, orion_transport_delete(_)).WillRepeatedly(Return(ORION_TRAN_ERROR_NONE));
+  MockTransport mock_inbound_transport(&mock_communication);
+  orion::Minor minor_obj(&mock_inbound_transport);
+  uint8_t stream_buffer[16];
+  minor_obj.setStreamBuffer(stream_buffer, sizeof(stream_buffer));
+
+  auto make_segment = [](uint16_t stream_id, const uint8_t *data, uint32_t size)
+    {
+      orion_stream_sender_t sender;
+      orion_stream_sender_init(&sender, stream_id, data, size, 16, 1, 1000);
+      std::vector<uint8_t> segment(sizeof(orion_control_stream_segment_t) + size);
+      segment.resize(orion_stream_sender_poll(&sender, 0, segment.data(), segment.size()));
+      return (segment);
+    };
+  orion_control_handshake_command_t command;
+  std::memset(&command, 0, sizeof(command));
+  command.header.common.message_id = ORION_CONTROL_MESSAGE_ID_HANDSHAKE;
+  command.header.common.version = ORION_CONTROL_HANDSHAKE_VERSION;
+  command.header.common.sequence_id = 7;
+  const uint8_t *command_bytes = reinterpret_cast<const uint8_t*>(&command);
+
+  // The first session of Major ends with stream 2, the second one starts from stream 1 of the same size
+  const uint8_t old_data[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+  const uint8_t new_data[12] = { 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32 };
+  std::vector<std::vector<uint8_t>> packets = {
+    make_segment(1, old_data, sizeof(old_data)),
+    make_segment(2, old_data, sizeof(old_data)),
+    std::vector<uint8_t>(command_bytes, command_bytes + sizeof(command)),
+    make_segment(1, new_data, sizeof(new_data)) };
+  size_t next_packet = 0;
+  auto mock_receive_packet = [&](orion_transport_t *, uint8_t *output_buffer, uint32_t, uint32_t)
+    {
+      const std::vector<uint8_t> &packet = packets[next_packet++];
+      std::memcpy(output_buffer, packet.data(), packet.size());
+      return static_cast<ssize_t>(packet.size());
+    };
+  std::vector<orion_control_stream_ack_t> acks;
+  auto mock_send_packet = [&](orion_transport_t *, uint8_t *input_buffer, uint32_t input_size, uint32_t)
+    {
+      if (sizeof(orion_control_stream_ack_t) == input_size)
+      {
+        acks.push_back(*reinterpret_cast<orion_control_stream_ack_t*>(input_buffer));
+      }
+      return ORION_TRAN_ERROR_NONE;
+    };
+  EXPECT_GLOBAL_CALL(orion_transport_has_received_packet, orion_transport_has_received_packet(
+    mock_inbound_transport.getObject())).Times(4).WillRepeatedly(Return(true));
+  EXPECT_GLOBAL_CALL(orion_transport_receive_packet, orion_transport_receive_packet(mock_inbound_transport.getObject(),
+    NotNull(), Gt(0), _)).Times(4).WillRepeatedly(Invoke(mock_receive_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_send_packet, orion_transport_send_packet(mock_inbound_transport.getObject(),
+    NotNull(), _, _)).Times(4).WillRepeatedly(Invoke(mock_send_packet));
+  EXPECT_GLOBAL_CALL(orion_transport_set_containers, orion_transport_set_containers(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_fragments, orion_transport_set_fragments(
+    mock_inbound_transport.getObject(), false)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_set_compression_buffer, orion_transport_set_compression_buffer(
+    mock_inbound_transport.getObject(), IsNull(), 0)).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+  EXPECT_GLOBAL_CALL(orion_transport_get_frame_size, orion_transport_get_frame_size(
+    mock_inbound_transport.getObject())).WillOnce(Return(512));
+  EXPECT_GLOBAL_CALL(orion_transport_set_link, orion_transport_set_link(mock_inbound_transport.getObject(),
+    NotNull())).WillOnce(Return(ORION_TRAN_ERROR_NONE));
+
+  uint8_t buffer[64];
+  for (size_t index = 0; index < packets.size(); index++)
+  {
+    ASSERT_EQ(0, minor_obj.receiveCommand(buffer, sizeof(buffer)));
+  }
+  uint32_t size = 0;
+  ASSERT_TRUE(minor_obj.getStream(&size));
+  EXPECT_EQ(sizeof(new_data), size);
+  EXPECT_EQ(0, std::memcmp(new_data, stream_buffer, sizeof(new_data)));
+
+  ASSERT_EQ(3, acks.size());
+  EXPECT_EQ(1, acks[2].stream_id);
+  EXPECT_EQ(1, acks[2].cumulative);
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
@@ -0,0 +1,221 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <cstring>
+#include <vector>
+#include "orion_protocol/orion_minor.h"
+#include "orion_protocol/orion_registry.hpp"
+
+#pragma pack(push, 1)
+
+struct SetSpeedCommand
+{
+  orion::CommandHeader header;
+  int16_t left;
+  int16_t right;
+};
+
+struct SetSpeedResult
+{
+  orion::ResultHeader header;
+};
+
+struct GetStatusCommand
+{
+  orion::CommandHeader header;
+};
+
+struct GetStatusResult
+{
+  orion::ResultHeader header;
+  uint32_t uptime;
+  uint8_t mode;
+};
+
+#pragma pack(pop)
+
+typedef orion::MessageRegistry<
+  orion::MessageDefinition<10, SetSpeedCommand, SetSpeedResult>,
+  orion::MessageDefinition<11, GetStatusCommand, GetStatusResult, 3, 2>> Messages;
+
+static_assert(sizeof(SetSpeedCommand) == Messages::MAX_COMMAND_SIZE, "Biggest command is SetSpeedCommand");
+static_assert(sizeof(GetStatusResult) == Messages::MAX_RESULT_SIZE, "Biggest result is GetStatusResult");
+
+struct Handler
+{
+  void handle(const SetSpeedCommand &command, SetSpeedResult *)
+  {
+    left = command.left;
+    right = command.right;
+  }
+
+  void handle(const GetStatusCommand &, GetStatusResult *result)
+  {
+    result->uptime = 1234;
+    result->mode = 2;
+  }
+
+  int16_t left = 0;
+  int16_t right = 0;
+};
+
+// Stands for Major, keeps what would be sent
+struct FakeMajor
+{
+  template<class Command, class Result>
+  int invoke(Command command, Result *result, uint32_t retry_timeout)
+  {
+    command_header = command.header;
+    result_header = result->header;
+    timeout = retry_timeout;
+    return (0);
+  }
+
+  orion::CommandHeader command_header;
+  orion::ResultHeader result_header;
+  uint32_t timeout = 0;
+};
+
+// Stands for Minor, returns prepared command once and keeps sent result
+struct FakeMinor
+{
+  ssize_t receiveCommand(uint8_t *buffer, size_t)
+  {
+    size_t size = command.size();
+    std::memcpy(buffer, command.data(), size);
+    command.clear();
+    return (size);
+  }
+
+  orion_minor_error_t sendResult(uint8_t *buffer, const size_t size)
+  {
+    result.assign(buffer, buffer + size);
+    return (ORION_MINOR_ERROR_NONE);
+  }
+
+  std::vector<uint8_t> command;
+  std::vector<uint8_t> result;
+};
+
+TEST(TestSuite, invokeFillsHeaders)
+{
+  FakeMajor major;
+  GetStatusCommand command;
+  std::memset(&command, 0, sizeof(command));
+  GetStatusResult result;
+  std::memset(&result, 0, sizeof(result));
+
+  ASSERT_EQ(0, Messages::invoke(major, command, &result, 500));
+  EXPECT_EQ(500, major.timeout);
+  EXPECT_EQ(11, major.command_header.common.message_id);
+  EXPECT_EQ(3, major.command_header.common.version);
+  EXPECT_EQ(2, major.command_header.common.oldest_compatible_version);
+  EXPECT_EQ(11, major.result_header.common.message_id);
+  EXPECT_EQ(3, major.result_header.common.version);
+}
+
+TEST(TestSuite, dispatchByMessageId)
+{
+  Handler handler;
+  uint8_t result[Messages::MAX_RESULT_SIZE];
+
+  SetSpeedCommand set_speed;
+  SetSpeedResult set_speed_expected;
+  Messages::prepare(&set_speed, &set_speed_expected);
+  set_speed.header.common.sequence_id = 7;
+  set_speed.left = -100;
+  set_speed.right = 200;
+  ASSERT_EQ(sizeof(SetSpeedResult), Messages::Dispatcher<Handler>::dispatch(handler,
+    reinterpret_cast<uint8_t*>(&set_speed), sizeof(set_speed), result));
+  EXPECT_EQ(-100, handler.left);
+  EXPECT_EQ(200, handler.right);
+  const SetSpeedResult *set_speed_result = reinterpret_cast<const SetSpeedResult*>(result);
+  EXPECT_EQ(10, set_speed_result->header.common.message_id);
+  EXPECT_EQ(7, set_speed_result->header.common.sequence_id);
+  EXPECT_EQ(0, set_speed_result->header.error_code);
+
+  GetStatusCommand get_status;
+  GetStatusResult expected;
+  Messages::prepare(&get_status, &expected);
+  get_status.header.common.sequence_id = 8;
+  ASSERT_EQ(sizeof(GetStatusResult), Messages::Dispatcher<Handler>::dispatch(handler,
+    reinterpret_cast<uint8_t*>(&get_status), sizeof(get_status), result));
+  const GetStatusResult *get_status_result = reinterpret_cast<const GetStatusResult*>(result);
+  EXPECT_EQ(11, get_status_result->header.common.message_id);
+  EXPECT_EQ(3, get_status_result->header.common.version);
+  EXPECT_EQ(8, get_status_result->header.common.sequence_id);
+  EXPECT_EQ(1234, get_status_result->uptime);
+  EXPECT_EQ(2, get_status_result->mode);
+}
+
+TEST(TestSuite, dispatchErrors)
+{
+  Handler handler;
+  uint8_t result[Messages::MAX_RESULT_SIZE];
+
+  // Unknown message id
+  GetStatusCommand unknown;
+  std::memset(&unknown, 0, sizeof(unknown));
+  unknown.header.common.message_id = 12;
+  unknown.header.common.sequence_id = 9;
+  ASSERT_EQ(sizeof(orion::ResultHeader), Messages::Dispatcher<Handler>::dispatch(handler,
+    reinterpret_cast<uint8_t*>(&unknown), sizeof(unknown), result));
+  const orion::ResultHeader *header = reinterpret_cast<const orion::ResultHeader*>(result);
+  EXPECT_EQ(12, header->common.message_id);
+  EXPECT_EQ(9, header->common.sequence_id);
+  EXPECT_EQ(ORION_CONTROL_ERROR_UNKNOWN_MESSAGE, header->error_code);
+
+  // Command shorter than its type
+  SetSpeedCommand set_speed;
+  SetSpeedResult expected;
+  Messages::prepare(&set_speed, &expected);
+  ASSERT_EQ(sizeof(orion::ResultHeader), Messages::Dispatcher<Handler>::dispatch(handler,
+    reinterpret_cast<uint8_t*>(&set_speed), sizeof(set_speed) - 1, result));
+  EXPECT_EQ(ORION_CONTROL_ERROR_MALFORMED_MESSAGE, header->error_code);
+  EXPECT_EQ(0, handler.left);
+}
+
+TEST(TestSuite, spinMinor)
+{
+  Handler handler;
+  FakeMinor minor;
+  ASSERT_EQ(0, Messages::Dispatcher<Handler>::spinOnce(minor, handler));
+  EXPECT_EQ(0, minor.result.size());
+
+  GetStatusCommand get_status;
+  GetStatusResult expected;
+  Messages::prepare(&get_status, &expected);
+  minor.command.assign(reinterpret_cast<uint8_t*>(&get_status),
+    reinterpret_cast<uint8_t*>(&get_status) + sizeof(get_status));
+  ASSERT_EQ(sizeof(get_status), Messages::Dispatcher<Handler>::spinOnce(minor, handler));
+  ASSERT_EQ(sizeof(GetStatusResult), minor.result.size());
+  EXPECT_EQ(1234, reinterpret_cast<const GetStatusResult*>(minor.result.data())->uptime);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "orion_protocol/orion_rtt_estimator.hpp"
+
+TEST(TestSuite, initialTimeout)
+{
+  orion::RttEstimator estimator(100000, 1000, 50000);
+  EXPECT_EQ(50000, estimator.getTimeout(0));
+  EXPECT_EQ(50000, estimator.getTimeout(3));
+  EXPECT_EQ(0, estimator.getStatistics().samples);
+
+  orion::RttEstimator small(10, 1000, 50000);
+  EXPECT_EQ(1000, small.getTimeout(0));
+}
+
+TEST(TestSuite, jacobsonKarels)
+{
+  orion::RttEstimator estimator(100000, 100, 1000000);
+
+  // First sample: SRTT = RTT, RTTVAR = RTT / 2
+  estimator.addSample(2000);
+  orion::RttStatistics statistics = estimator.getStatistics();
+  EXPECT_EQ(2000, statistics.srtt);
+  EXPECT_EQ(1000, statistics.rttvar);
+  EXPECT_EQ(6000, statistics.timeout);
+  EXPECT_EQ(1, statistics.samples);
+
+  // RTTVAR = 3/4 * 1000 + 1/4 * |2000 - 4000|, SRTT = 7/8 * 2000 + 1/8 * 4000
+  estimator.addSample(4000);
+  statistics = estimator.getStatistics();
+  EXPECT_EQ(2250, statistics.srtt);
+  EXPECT_EQ(1250, statistics.rttvar);
+  EXPECT_EQ(2250 + 4 * 1250, statistics.timeout);
+
+  // Steady round trip shrinks deviation, so timeout approaches SRTT
+  for (int i = 0; i < 100; i++)
+  {
+    estimator.addSample(2000);
+  }
+  statistics = estimator.getStatistics();
+  EXPECT_NEAR(2000, statistics.srtt, 10);
+  EXPECT_LT(statistics.rttvar, 10);
+  EXPECT_LT(statistics.timeout, 2100);
+
+  estimator.reset();
+  EXPECT_EQ(0, estimator.getStatistics().samples);
+  EXPECT_EQ(100000, estimator.getTimeout(0));
+}
+
+TEST(TestSuite, backoffAndClamps)
+{
+  orion::RttEstimator estimator(100000, 1000, 20000);
+  estimator.addSample(100);
+  EXPECT_EQ(1000, estimator.getTimeout(0));
+  EXPECT_EQ(2000, estimator.getTimeout(1));
+  EXPECT_EQ(16000, estimator.getTimeout(4));
+  EXPECT_EQ(20000, estimator.getTimeout(5));
+  EXPECT_EQ(20000, estimator.getTimeout(255));
+
+  estimator.addSample(UINT32_MAX);
+  EXPECT_EQ(20000, estimator.getTimeout(0));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,341 @@
+/**
+* Copyright 2021 ROS Ukraine
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom
+* the Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "orion_protocol/orion_stream.h"
+
+#define SEGMENT_PACKET_SIZE(segment_size) (sizeof(orion_control_stream_segment_t) + (segment_size))
+
+static std::vector<uint8_t> make_data(uint32_t size)
+{
+  std::vector<uint8_t> result(size);
+  for (uint32_t index = 0; index < size; index++)
+  {
+    result[index] = static_cast<uint8_t>(index * 7 + index / 256);
+  }
+  return (result);
+}
+
+static uint32_t get_offset(const std::vector<uint8_t> &packet)
+{
+  return (reinterpret_cast<const orion_control_stream_segment_t*>(packet.data())->offset);
+}
+
+TEST(TestSuite, selectiveRetransmit)
+{
+  std::vector<uint8_t> data = make_data(95);
+  orion_stream_sender_t sender;
+  orion_stream_sender_init(&sender, 1, data.data(), data.size(), 10, 4, 1000);
+  std::vector<uint8_t> buffer(100);
+  orion_stream_receiver_t receiver;
+  orion_stream_receiver_init(&receiver, buffer.data(), buffer.size());
+
+  std::vector<std::vector<uint8_t>> packets;
+  for (uint32_t index = 0; index < 4; index++)
+  {
+    std::vector<uint8_t> packet(SEGMENT_PACKET_SIZE(10));
+    ASSERT_EQ(packet.size(), orion_stream_sender_poll(&sender, index, packet.data(), packet.size()));
+    EXPECT_EQ(index * 10, get_offset(packet));
+    packets.push_back(packet);
+  }
+  // Window is full till acknowledgment or retransmit timeout
+  std::vector<uint8_t> packet(SEGMENT_PACKET_SIZE(10));
+  EXPECT_EQ(0, orion_stream_sender_poll(&sender, 10, packet.data(), packet.size()));
+  EXPECT_EQ(990, orion_stream_sender_get_wait_time(&sender, 10));
+
+  // Segment 1 is lost, the rest is acknowledged selectively
+  orion_control_stream_ack_t ack;
+  ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packets[0].data(), packets[0].size(), &ack));
+  EXPECT_EQ(1, ack.cumulative);
+  EXPECT_EQ(0, ack.selective);
+  orion_stream_sender_on_ack(&sender, &ack);
+  ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packets[2].data(), packets[2].size(), &ack));
+  ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packets[3].data(), packets[3].size(), &ack));
+  EXPECT_EQ(ORION_CONTROL_MESSAGE_ID_STREAM_ACK, ack.header.common.message_id);
+  EXPECT_EQ(ORION_UNSOLICITED_SEQUENCE_ID, ack.header.common.sequence_id);
+  EXPECT_EQ(1, ack.cumulative);
+  EXPECT_EQ(0x3, ack.selective);
+
+  // Segments sent after the missing one arrived, so it is sent again at once, and only it
+  orion_stream_sender_on_ack(&sender, &ack);
+  EXPECT_EQ(0, orion_stream_sender_get_wait_time(&sender, 20));
+  ASSERT_EQ(packet.size(), orion_stream_sender_poll(&sender, 20, packet.data(), packet.size()));
+  EXPECT_EQ(10, get_offset(packet));
+  ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+  EXPECT_EQ(4, ack.cumulative);
+  EXPECT_EQ(0, ack.selective);
+  orion_stream_sender_on_ack(&sender, &ack);
+
+  // The rest of data, the last segment is shorter
+  ssize_t size = 0;
+  while (!orion_stream_sender_is_complete(&sender))
+  {
+    size = orion_stream_sender_poll(&sender, 30, packet.data(), packet.size());
+    ASSERT_GT(size, 0);
+    ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packet.data(), size, &ack));
+    orion_stream_sender_on_ack(&sender, &ack);
+  }
+  EXPECT_EQ(SEGMENT_PACKET_SIZE(5), size);
+  uint32_t stream_size = 0;
+  ASSERT_TRUE(orion_stream_receiver_is_complete(&receiver, &stream_size));
+  EXPECT_EQ(data.size(), stream_size);
+  EXPECT_TRUE(std::equal(data.begin(), data.end(), buffer.begin()));
+
+  orion_stream_statistics_t statistics = orion_stream_sender_get_statistics(&sender);
+  EXPECT_EQ(11, statistics.segments);
+  EXPECT_EQ(1, statistics.retransmissions);
+  EXPECT_EQ(UINT32_MAX, orion_stream_sender_get_wait_time(&sender, 30));
+}
+
+TEST(TestSuite, retransmitTimeout)
+{
+  std::vector<uint8_t> data = make_data(20);
+  orion_stream_sender_t sender;
+  orion_stream_sender_init(&sender, 1, data.data(), data.size(), 10, 4, 1000);
+
+  std::vector<uint8_t> packet(SEGMENT_PACKET_SIZE(10));
+  ASSERT_GT(orion_stream_sender_poll(&sender, 0, packet.data(), packet.size()), 0);
+  ASSERT_GT(orion_stream_sender_poll(&sender, 100, packet.data(), packet.size()), 0);
+  EXPECT_EQ(0, orion_stream_sender_poll(&sender, 999, packet.data(), packet.size()));
+  EXPECT_EQ(1, orion_stream_sender_get_wait_time(&sender, 999));
+
+  // Tail segments have nothing sent after them, only timeout tells they are lost
+  ASSERT_GT(orion_stream_sender_poll(&sender, 1000, packet.data(), packet.size()), 0);
+  EXPECT_EQ(0, get_offset(packet));
+  EXPECT_EQ(100, orion_stream_sender_get_wait_time(&sender, 1000));
+  ASSERT_GT(orion_stream_sender_poll(&sender, 1100, packet.data(), packet.size()), 0);
+  EXPECT_EQ(10, get_offset(packet));
+  EXPECT_EQ(2, orion_stream_sender_get_statistics(&sender).retransmissions);
+
+  // Stale and foreign acknowledgments change nothing
+  orion_control_stream_ack_t ack;
+  std::memset(&ack, 0, sizeof(ack));
+  ack.stream_id = 2;
+  ack.cumulative = 2;
+  orion_stream_sender_on_ack(&sender, &ack);
+  EXPECT_FALSE(orion_stream_sender_is_complete(&sender));
+  ack.stream_id = 1;
+  ack.cumulative = 3;
+  orion_stream_sender_on_ack(&sender, &ack);
+  EXPECT_FALSE(orion_stream_sender_is_complete(&sender));
+  ack.cumulative = 2;
+  orion_stream_sender_on_ack(&sender, &ack);
+  EXPECT_TRUE(orion_stream_sender_is_complete(&sender));
+  EXPECT_EQ(1, orion_stream_sender_get_statistics(&sender).acks);
+}
+
+TEST(TestSuite, receiverValidation)
+{
+  std::vector<uint8_t> data = make_data(30);
+  std::vector<uint8_t> buffer(30);
+  orion_stream_receiver_t receiver;
+  orion_stream_receiver_init(&receiver, buffer.data(), buffer.size());
+  orion_control_stream_ack_t ack;
+
+  orion_stream_sender_t sender;
+  orion_stream_sender_init(&sender, 0xFFFF, data.data(), data.size(), 10, 4, 1000);
+  std::vector<uint8_t> packet(SEGMENT_PACKET_SIZE(10));
+  ASSERT_GT(orion_stream_sender_poll(&sender, 0, packet.data(), packet.size()), 0);
+
+  EXPECT_FALSE(orion_stream_receiver_on_segment(&receiver, packet.data(), sizeof(orion_control_stream_segment_t) - 1,
+    &ack));
+  EXPECT_FALSE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size() - 1, &ack));
+  reinterpret_cast<orion_control_stream_segment_t*>(packet.data())->offset = 5;
+  EXPECT_FALSE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+  reinterpret_cast<orion_control_stream_segment_t*>(packet.data())->offset = 0;
+  EXPECT_TRUE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+  EXPECT_FALSE(orion_stream_receiver_is_complete(&receiver, nullptr));
+
+  // Duplicate is acknowledged again, segment of older stream is ignored
+  EXPECT_TRUE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+  EXPECT_EQ(1, ack.cumulative);
+  reinterpret_cast<orion_control_stream_segment_t*>(packet.data())->stream_id = 0xFFFE;
+  EXPECT_FALSE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+
+  // Stream which does not fit the buffer is not started
+  std::vector<uint8_t> big_data = make_data(40);
+  orion_stream_sender_init(&sender, 3, big_data.data(), big_data.size(), 10, 4, 1000);
+  ASSERT_GT(orion_stream_sender_poll(&sender, 0, packet.data(), packet.size()), 0);
+  EXPECT_FALSE(orion_stream_receiver_on_segment(&receiver, packet.data(), packet.size(), &ack));
+
+  // Newer stream replaces the current one, ids wrap around
+  orion_stream_sender_init(&sender, 0, data.data(), data.size(), 10, 4, 1000);
+  while (!orion_stream_sender_is_complete(&sender))
+  {
+    ssize_t size = orion_stream_sender_poll(&sender, 0, packet.data(), packet.size());
+    ASSERT_GT(size, 0);
+    ASSERT_TRUE(orion_stream_receiver_on_segment(&receiver, packet.data(), size, &ack));
+    EXPECT_EQ(0, ack.stream_id);
+    orion_stream_sender_on_ack(&sender, &ack);
+  }
+  EXPECT_TRUE(orion_stream_receiver_is_complete(&receiver, nullptr));
+  EXPECT_TRUE(std::equal(data.begin(), data.end(), buffer.begin()));
+}
+
+/*
+  Event driven emulator of a serial link: every direction carries one frame at a time at given rate,
+  frame arrives after propagation delay or is lost with given probability, time is virtual.
+*/
+class LinkEmulator
+{
+public:
+  LinkEmulator(uint32_t bytes_per_second, uint32_t delay, uint32_t loss_per_mille) :
+    bytes_per_second_(bytes_per_second), delay_(delay), loss_per_mille_(loss_per_mille) {}
+
+  /*
+    Sends stream over the link, returns microseconds till the sender got all acknowledgments
+  */
+  uint64_t transfer(const std::vector<uint8_t> &data, uint16_t segment_size, uint32_t window,
+    uint32_t retransmit_timeout, orion_stream_statistics_t *statistics)
+  {
+    orion_stream_sender_t sender;
+    orion_stream_sender_init(&sender, 1, data.data(), data.size(), segment_size, window, retransmit_timeout);
+    std::vector<uint8_t> buffer(data.size());
+    orion_stream_receiver_t receiver;
+    orion_stream_receiver_init(&receiver, buffer.data(), buffer.size());
+
+    Direction forward;
+    Direction backward;
+    std::vector<uint8_t> packet(SEGMENT_PACKET_SIZE(segment_size));
+    uint64_t time_now = 0;
+    while (true)
+    {
+      while (!forward.frames.empty() && (forward.frames.begin()->first <= time_now))
+      {
+        std::vector<uint8_t> &frame = forward.frames.begin()->second;
+        orion_control_stream_ack_t ack;
+        if (orion_stream_receiver_on_segment(&receiver, frame.data(), frame.size(), &ack))
+        {
+          this->send(&backward, time_now, reinterpret_cast<uint8_t*>(&ack), sizeof(ack));
+        }
+        forward.frames.erase(forward.frames.begin());
+      }
+      while (!backward.frames.empty() && (backward.frames.begin()->first <= time_now))
+      {
+        orion_stream_sender_on_ack(&sender,
+          reinterpret_cast<const orion_control_stream_ack_t*>(backward.frames.begin()->second.data()));
+        backward.frames.erase(backward.frames.begin());
+      }
+      if (orion_stream_sender_is_complete(&sender))
+      {
+        break;
+      }
+
+      // Sender writes to the link only when previous frame is out, like blocking write to serial port
+      if (forward.free_time <= time_now)
+      {
+        ssize_t size = orion_stream_sender_poll(&sender, time_now, packet.data(), packet.size());
+        if (size > 0)
+        {
+          this->send(&forward, time_now, packet.data(), size);
+          continue;
+        }
+      }
+
+      uint64_t next_time = UINT64_MAX;
+      uint32_t wait_time = orion_stream_sender_get_wait_time(&sender, time_now);
+      if (UINT32_MAX != wait_time)
+      {
+        next_time = std::max(time_now + wait_time, forward.free_time);
+      }
+      if (!forward.frames.empty())
+      {
+        next_time = std::min(next_time, forward.frames.begin()->first);
+      }
+      if (!backward.frames.empty())
+      {
+        next_time = std::min(next_time, backward.frames.begin()->first);
+      }
+      time_now = std::max(time_now + 1, next_time);
+    }
+
+    EXPECT_TRUE(orion_stream_receiver_is_complete(&receiver, nullptr));
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), buffer.begin()));
+    *statistics = orion_stream_sender_get_statistics(&sender);
+    return (time_now);
+  }
+
+private:
+  struct Direction
+  {
+    uint64_t free_time = 0;
+    std::multimap<uint64_t, std::vector<uint8_t>> frames;  // by arrival time
+  };
+
+  void send(Direction *direction, uint64_t time_now, const uint8_t *frame, uint32_t size)
+  {
+    uint64_t start_time = std::max(time_now, direction->free_time);
+    direction->free_time = start_time + static_cast<uint64_t>(size) * 1000000 / this->bytes_per_second_;
+    // Linear congruential generator keeps the losses the same from run to run
+    this->random_ = this->random_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    if ((this->random_ >> 33) % 1000 >= this->loss_per_mille_)
+    {
+      direction->frames.insert(std::make_pair(direction->free_time + this->delay_,
+        std::vector<uint8_t>(frame, frame + size)));
+    }
+  }
+
+  uint32_t bytes_per_second_;
+  uint32_t delay_;
+  uint32_t loss_per_mille_;
+  uint64_t random_ = 1;
+};
+
+TEST(TestSuite, throughputBenchmark)
+{
+  // 115200 baud link with 50 ms round trip and 1% of frames lost in each direction
+  const uint32_t bytes_per_second = 11520;
+  const uint16_t segment_size = 240;
+  LinkEmulator link(bytes_per_second, 25000, 10);
+  std::vector<uint8_t> data = make_data(200000);
+
+  orion_stream_statistics_t statistics;
+  uint64_t duration = link.transfer(data, segment_size, ORION_STREAM_MAX_WINDOW, 200000, &statistics);
+  double throughput = data.size() * 1000000.0 / duration;
+  double capacity = bytes_per_second * static_cast<double>(segment_size) / SEGMENT_PACKET_SIZE(segment_size);
+  std::printf("Sliding window: %.0f B/s of %.0f B/s capacity, %u segments, %u retransmitted\n", throughput, capacity,
+    statistics.segments, statistics.retransmissions);
+  EXPECT_GT(throughput, 0.95 * capacity);
+  // Only lost segments are sent again
+  EXPECT_LT(statistics.retransmissions, statistics.segments / 25);
+
+  orion_stream_statistics_t stop_and_wait_statistics;
+  uint64_t stop_and_wait_duration = link.transfer(data, segment_size, 1, 200000, &stop_and_wait_statistics);
+  double stop_and_wait_throughput = data.size() * 1000000.0 / stop_and_wait_duration;
+  std::printf("Stop and wait: %.0f B/s\n", stop_and_wait_throughput);
+  // Waiting for every acknowledgment leaves the link idle for a round trip after every segment
+  EXPECT_GT(throughput, 3 * stop_and_wait_throughput);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  return RUN_ALL_TESTS();
+}